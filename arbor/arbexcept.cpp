@@ -161,5 +161,9 @@ bad_catalogue_error::bad_catalogue_error(const std::string &fn, const std::strin
       failed_call{call}
 {}
 
+bad_checkpoint::bad_checkpoint(const std::string& what)
+    : arbor_exception(pprintf("bad checkpoint: {}", what))
+{}
+
 } // namespace arb
 
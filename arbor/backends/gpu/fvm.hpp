@@ -12,6 +12,7 @@
 #include "backends/event.hpp"
 
 #include "backends/gpu/gpu_store_types.hpp"
+#include "backends/gpu/mechanism_pipeline.hpp"
 #include "backends/gpu/shared_state.hpp"
 
 #include "threshold_watcher.hpp"
@@ -47,6 +48,7 @@ struct backend {
     using sample_event_stream = arb::gpu::sample_event_stream;
 
     using shared_state = arb::gpu::shared_state;
+    using mechanism_pipeline = arb::gpu::mechanism_pipeline;
     using ion_state = arb::gpu::ion_state;
 
     static threshold_watcher voltage_watcher(
@@ -8,6 +8,7 @@
 #include <arbor/common_types.hpp>
 
 #include "memory/memory.hpp"
+#include "threading/threading.hpp"
 #include "util/partition.hpp"
 #include "util/rangeutil.hpp"
 #include "util/span.hpp"
@@ -465,6 +466,10 @@ public:
 
     }
 
+    // The cells are solved in parallel on the device: there is no division of
+    // the matrix over host threads.
+    void set_thread_blocks(threading::task_system*, unsigned) {}
+
     // Assemble the matrix
     // Afterwards the diagonal and RHS will have been set given dt, voltage, current, and conductivity.
     //   dt_intdom [ms] (per integration domain)
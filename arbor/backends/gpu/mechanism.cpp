@@ -16,6 +16,7 @@
 #include "util/index_into.hpp"
 #include "util/maputil.hpp"
 #include "util/range.hpp"
+#include "util/rangeutil.hpp"
 #include "util/span.hpp"
 
 #include "backends/gpu/mechanism.hpp"
@@ -210,6 +211,29 @@ fvm_value_type* mechanism::field_data(const std::string& field_var) {
     return nullptr;
 }
 
+std::vector<fvm_value_type> mechanism::get_state() {
+    std::vector<fvm_value_type> values;
+    if (width_>0) {
+        for (auto& entry: state_table()) {
+            util::append(values, memory::on_host(device_view(*entry.second, width_)));
+        }
+    }
+    return values;
+}
+
+void mechanism::set_state(const std::vector<fvm_value_type>& values) {
+    auto table = state_table();
+    if (values.size()!=table.size()*width_) {
+        throw arbor_internal_error("gpu/mechanism: mechanism state size mismatch");
+    }
+
+    for (auto i: util::count_along(table)) {
+        value_type* field_ptr = *table[i].second;
+        std::vector<fvm_value_type> field(values.begin()+i*width_, values.begin()+(i+1)*width_);
+        memory::copy(make_const_view(field), device_view(field_ptr, width_));
+    }
+}
+
 void multiply_in_place(fvm_value_type* s, const fvm_index_type* p, int n);
 
 void mechanism::initialize() {
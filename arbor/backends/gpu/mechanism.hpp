@@ -67,6 +67,9 @@ public:
     // Returns pointer to GPU memory corresponding to state variable data.
     fvm_value_type* field_data(const std::string& state_var) override;
 
+    std::vector<fvm_value_type> get_state() override;
+    void set_state(const std::vector<fvm_value_type>& values) override;
+
     void initialize() override;
 
 protected:
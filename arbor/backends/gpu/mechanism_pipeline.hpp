@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <arbor/fvm_types.hpp>
+#include <arbor/mechanism.hpp>
+
+namespace arb {
+namespace gpu {
+
+// Current and state updates of the mechanisms of a cell group, in the order
+// of the mechanisms. Mechanisms are not fused on the GPU back-end: the tile
+// size is ignored, and each mechanism is updated by its own kernels.
+
+class mechanism_pipeline {
+public:
+    mechanism_pipeline() = default;
+    mechanism_pipeline(const std::vector<mechanism_ptr>& mechs, fvm_size_type) {
+        for (auto& m: mechs) {
+            mechs_.push_back(m.get());
+        }
+    }
+
+    void update_current() {
+        for (auto m: mechs_) {
+            m->deliver_events();
+            m->update_current();
+        }
+    }
+
+    void update_state() {
+        for (auto m: mechs_) {
+            m->update_state();
+        }
+    }
+
+    std::size_t n_fused() const { return 0; }
+    std::vector<std::size_t> tile_counts() const { return {}; }
+
+private:
+    std::vector<mechanism*> mechs_;
+};
+
+} // namespace gpu
+} // namespace arb
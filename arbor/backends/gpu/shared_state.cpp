@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <cstddef>
+#include <string>
 #include <vector>
 
+#include <arbor/assert.hpp>
 #include <arbor/constants.hpp>
 #include <arbor/fvm_types.hpp>
 
@@ -149,6 +152,47 @@ void shared_state::reset() {
     }
 }
 
+template <typename State, typename F>
+static void for_each_state_array(State& s, F f) {
+    f(s.time);
+    f(s.time_to);
+    f(s.voltage);
+    f(s.current_density);
+    f(s.conductivity);
+    f(s.time_since_spike);
+
+    std::vector<std::string> ions;
+    for (auto& i: s.ion_data) {
+        ions.push_back(i.first);
+    }
+    util::sort(ions);
+    for (auto& name: ions) {
+        auto& ion = s.ion_data.at(name);
+        f(ion.iX_);
+        f(ion.eX_);
+        f(ion.Xi_);
+        f(ion.Xo_);
+    }
+}
+
+std::vector<fvm_value_type> shared_state::get_state() const {
+    std::vector<fvm_value_type> state;
+    for_each_state_array(*this, [&](const array& a) { util::append(state, memory::on_host(a)); });
+    return state;
+}
+
+void shared_state::set_state(const std::vector<fvm_value_type>& state) {
+    auto p = state.begin();
+    for_each_state_array(*this,
+        [&](array& a) {
+            arb_assert(state.end()-p>=(std::ptrdiff_t)a.size());
+            std::vector<fvm_value_type> values(p, p+a.size());
+            memory::copy(memory::make_const_view(values), a);
+            p += a.size();
+        });
+    arb_assert(p==state.end());
+}
+
 void shared_state::zero_currents() {
     memory::fill(current_density, 0);
     memory::fill(conductivity, 0);
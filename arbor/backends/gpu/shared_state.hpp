@@ -135,7 +135,15 @@ struct shared_state {
         array& sample_time,
         array& sample_value);
 
+    // Mechanisms are updated on the device: host threads are not used.
+    void set_thread_blocks(threading::task_system*, unsigned) {}
+
     void reset();
+
+    // Copy the dynamic state to or from a host vector, for checkpointing,
+    // in the same order as the multicore back-end.
+    std::vector<fvm_value_type> get_state() const;
+    void set_state(const std::vector<fvm_value_type>& state);
 };
 
 // For debugging only
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <vector>
+
 #include <arbor/arbexcept.hpp>
+#include <arbor/assert.hpp>
 #include <arbor/common_types.hpp>
 #include <arbor/fvm_types.hpp>
 
@@ -86,6 +89,25 @@ public:
         }
     }
 
+    /// Detector state, for checkpointing: the crossed flag of each detector,
+    /// followed by the value of each detector at the last test.
+    std::vector<fvm_value_type> get_state() const {
+        auto crossed = memory::on_host(is_crossed_);
+        auto v_prev = memory::on_host(v_prev_);
+        std::vector<fvm_value_type> state(crossed.begin(), crossed.end());
+        state.insert(state.end(), v_prev.begin(), v_prev.end());
+        return state;
+    }
+
+    void set_state(const std::vector<fvm_value_type>& state) {
+        arb_assert(state.size()==2*size());
+        clear_crossings();
+        std::vector<fvm_index_type> crossed(state.begin(), state.begin()+size());
+        std::vector<fvm_value_type> v_prev(state.begin()+size(), state.end());
+        memory::copy(memory::make_const_view(crossed), is_crossed_);
+        memory::copy(memory::make_const_view(v_prev), v_prev_);
+    }
+
     // Testing-only interface.
     bool is_crossed(int i) const {
         return is_crossed_[i];
@@ -7,6 +7,7 @@
 
 #include "backends/event.hpp"
 #include "backends/multicore/matrix_state.hpp"
+#include "backends/multicore/mechanism_pipeline.hpp"
 #include "backends/multicore/multi_event_stream.hpp"
 #include "backends/multicore/multicore_common.hpp"
 #include "backends/multicore/shared_state.hpp"
@@ -45,6 +46,7 @@ struct backend {
     using sample_event_stream = arb::multicore::sample_event_stream;
 
     using shared_state = arb::multicore::shared_state;
+    using mechanism_pipeline = arb::multicore::mechanism_pipeline;
     using ion_state = arb::multicore::ion_state;
 
     static threshold_watcher voltage_watcher(
@@ -53,7 +55,7 @@ struct backend {
         const std::vector<value_type>& thresholds,
         const execution_context& context)
     {
-        return threshold_watcher(
+        threshold_watcher watcher(
             state.cv_to_intdom.data(),
             state.voltage.data(),
             state.src_to_spike.data(),
@@ -62,6 +64,8 @@ struct backend {
             cv,
             thresholds,
             context);
+        watcher.set_thread_blocks(state.thread_pool, state.n_thread_blocks);
+        return watcher;
     }
 
     static fvm_value_type* mechanism_field_data(arb::mechanism* mptr, const std::string& field);
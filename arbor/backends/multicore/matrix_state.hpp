@@ -1,21 +1,47 @@
 #pragma once
 
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include <arbor/simd/simd.hpp>
+
 #include <util/partition.hpp>
 #include <util/span.hpp>
 
 #include <memory/memory.hpp>
 
 #include "multicore_common.hpp"
+#include "threading/threading.hpp"
 
 namespace arb {
 namespace multicore {
 
+// The matrices of the cells are stored, assembled and solved in units: either
+// a batch of up to simd_width cells, interleaved so that the lanes of a SIMD
+// value hold the same row of each cell of the batch, or a single cell, stored
+// contiguously.
+//
+// The rows of a batch follow a template tree, the union of the trees of its
+// cells aligned from the root: the k-th child of a CV maps to the k-th child
+// of the row its parent maps to. Cells of the same structure share the
+// template exactly; cells of different structure, such as unbranched cells of
+// different lengths, are batched if each fills at least 4/5 of the template.
+// Rows of the template that a cell does not fill are the identity, and leave
+// the solution of the other rows unchanged.
+//
+// Batches of fewer than simd_width/2 cells are solved no faster than one cell
+// at a time, and are split into single cells.
+
 template <typename T, typename I>
 struct matrix_state {
 public:
     using value_type = T;
     using index_type = I;
 
+    static constexpr unsigned simd_width = simd::simd_abi::native_width<value_type>::value;
+    using simd_value = simd::simd<value_type, simd_width, simd::simd_abi::default_abi>;
+
     using array = padded_vector<value_type>;
     using const_view = const array&;
 
@@ -23,9 +49,12 @@ public:
     iarray parent_index;
     iarray cell_cv_divs;
 
+    // Diagonal, upper diagonal and rhs, in the layout of the solution units;
+    // the entry for CV i is at cv_slot[i].
     array d;     // [μS]
     array u;     // [μS]
     array rhs;   // [nA]
+    iarray cv_slot;
 
     array cv_capacitance;      // [pF]
     array face_conductance;    // [μS]
@@ -36,6 +65,27 @@ public:
     // the invariant part of the matrix diagonal
     array invariant_d;         // [μS]
 
+    // Solution units: unit k comprises cells unit_cells[unit_divs[k]] to
+    // unit_cells[unit_divs[k+1]-1], with template rows unit_row_divs[k] to
+    // unit_row_divs[k+1]-1 of unit_parent (relative to the first row of the
+    // unit), stored from unit_offset[k]. Units [0, num_batches) are batches.
+    std::vector<index_type> unit_cells;
+    std::vector<index_type> unit_divs;
+    std::vector<index_type> unit_parent;
+    std::vector<index_type> unit_row_divs;
+    std::vector<index_type> unit_offset;
+    index_type num_batches = 0;
+
+    // Partition of cells into blocks that are assembled in parallel, and of
+    // solution units into blocks that are solved in parallel, over the
+    // threads of thread_pool; empty if serial.
+    threading::task_system* thread_pool = nullptr;
+    std::vector<index_type> block_cell_divs;
+    std::vector<index_type> block_unit_divs;
+
+    // Minimum number of CVs in a block.
+    static constexpr index_type min_block_cvs = 256;
+
     matrix_state() = default;
 
     matrix_state(const std::vector<index_type>& p,
@@ -46,7 +96,6 @@ public:
                  const std::vector<index_type>& cell_to_intdom):
         parent_index(p.begin(), p.end()),
         cell_cv_divs(cell_cv_divs.begin(), cell_cv_divs.end()),
-        d(size(), 0), u(size(), 0), rhs(size()),
         cv_capacitance(cap.begin(), cap.end()),
         face_conductance(cond.begin(), cond.end()),
         cv_area(area.begin(), area.end()),
@@ -56,12 +105,14 @@ public:
         arb_assert(cond.size() == size());
         arb_assert(cell_cv_divs.back() == (index_type)size());
 
+        make_solution_units();
+
         auto n = size();
         invariant_d = array(n, 0);
         for (auto i: util::make_span(1u, n)) {
             auto gij = face_conductance[i];
 
-            u[i] = -gij;
+            u[cv_slot[i]] = -gij;
             invariant_d[i] += gij;
             if (p[i]!=-1) {
                 invariant_d[p[i]] += gij;
@@ -69,13 +120,6 @@ public:
         }
     }
 
-    const_view solution() const {
-        // In this back end the solution is a simple view of the rhs, which
-        // contains the solution after the matrix_solve is performed.
-        return rhs;
-    }
-
-
     // Assemble the matrix
     // Afterwards the diagonal and RHS will have been set given dt, voltage and current.
     //   dt_intdom       [ms]      (per integration domain)
@@ -83,11 +127,97 @@ public:
     //   current density [A.m^-2]  (per control volume)
     //   conductivity    [kS.m^-2] (per control volume)
     void assemble(const_view dt_intdom, const_view voltage, const_view current, const_view conductivity) {
+        for_each_block([&](index_type first, index_type last) {
+            assemble_cells(first, last, dt_intdom, voltage, current, conductivity);
+        });
+    }
+
+    void solve() {
+        // Nothing to solve for an empty or default-constructed matrix.
+        if (unit_divs.size()<2) return;
+
+        if (block_unit_divs.empty()) {
+            solve_units(0, unit_divs.size()-1);
+            return;
+        }
+
+        threading::parallel_for::apply(0, block_unit_divs.size()-1, 1, thread_pool,
+            [&](int b) { solve_units(block_unit_divs[b], block_unit_divs[b+1]); });
+    }
+
+    template<typename VTo>
+    void solve(VTo& to) {
+        solve();
+        for_each_block([&](index_type first, index_type last) {
+            for (auto i: util::make_span(cell_cv_divs[first], cell_cv_divs[last])) {
+                to[i] = rhs[cv_slot[i]];
+            }
+        });
+    }
+
+    // Split the cells into at most n blocks of approximately equal numbers
+    // of CVs for assembly and solution over the threads of ts.
+    void set_thread_blocks(threading::task_system* ts, unsigned n) {
+        thread_pool = ts;
+        block_cell_divs.clear();
+        block_unit_divs.clear();
+        if (unit_divs.size()<2) return;
+
+        const index_type ncells = cell_cv_divs.size()-1;
+        const index_type ncv = size();
+        index_type nblock = std::min<index_type>({index_type(n), ncv/min_block_cvs, ncells});
+        if (!ts || nblock<2) return;
+
+        // Each block ends with the first cell that starts at or past its share of the CVs.
+        block_cell_divs.push_back(0);
+        for (index_type b = 1; b<nblock; ++b) {
+            auto c = std::lower_bound(cell_cv_divs.begin(), cell_cv_divs.end()-1, ncv*b/nblock)-cell_cv_divs.begin();
+            if (c>block_cell_divs.back()) block_cell_divs.push_back(c);
+        }
+        block_cell_divs.push_back(ncells);
+
+        // Units are divided by their share of the template rows, the number
+        // of steps of their sweeps.
+        const index_type nunit = unit_divs.size()-1;
+        const index_type nrow = unit_row_divs.back();
+        block_unit_divs.push_back(0);
+        for (index_type k = 0, b = 1; k<nunit && b<nblock; ++k) {
+            if (unit_row_divs[k+1]>=nrow*b/nblock) {
+                block_unit_divs.push_back(k+1);
+                ++b;
+            }
+        }
+        if (block_unit_divs.back()<nunit) block_unit_divs.push_back(nunit);
+    }
+
+private:
+
+    std::size_t size() const {
+        return parent_index.size();
+    }
+
+    // Apply f to the range of cells [first, last) of each block, in parallel.
+    template <typename F>
+    void for_each_block(F&& f) {
+        if (cell_cv_divs.size()<2) return;
+
+        if (block_cell_divs.empty()) {
+            f(0, index_type(cell_cv_divs.size()-1));
+            return;
+        }
+
+        threading::parallel_for::apply(0, block_cell_divs.size()-1, 1, thread_pool,
+            [&](int b) { f(block_cell_divs[b], block_cell_divs[b+1]); });
+    }
+
+    // Assemble the submatrices of cells [first_cell, last_cell); see assemble().
+    void assemble_cells(index_type first_cell, index_type last_cell,
+        const_view dt_intdom, const_view voltage, const_view current, const_view conductivity)
+    {
         auto cell_cv_part = util::partition_view(cell_cv_divs);
-        const index_type ncells = cell_cv_part.size();
 
         // loop over submatrices
-        for (auto m: util::make_span(0, ncells)) {
+        for (auto m: util::make_span(first_cell, last_cell)) {
             auto dt = dt_intdom[cell_to_intdom[m]];
 
             if (dt>0) {
@@ -97,54 +227,258 @@ public:
 
                     auto gi = oodt_factor*cv_capacitance[i] + area_factor*conductivity[i]; // [μS]
 
-                    d[i] = gi + invariant_d[i];
+                    auto j = cv_slot[i];
+                    d[j] = gi + invariant_d[i];
                     // convert current to units nA
-                    rhs[i] = gi*voltage[i] - area_factor*current[i];
+                    rhs[j] = gi*voltage[i] - area_factor*current[i];
                 }
             }
             else {
                 for (auto i: util::make_span(cell_cv_part[m])) {
-                    d[i] = 0;
-                    rhs[i] = voltage[i];
+                    auto j = cv_slot[i];
+                    d[j] = 0;
+                    rhs[j] = voltage[i];
                 }
             }
         }
     }
 
-    void solve() {
-        // loop over submatrices
-        for (auto cv_span: util::partition_view(cell_cv_divs)) {
-            auto first = cv_span.first;
-            auto last = cv_span.second; // one past the end
-
-            if (d[first]!=0) {
-                // backward sweep
-                for(auto i=last-1; i>first; --i) {
-                    auto factor = u[i] / d[i];
-                    d[parent_index[i]]   -= factor * u[i];
-                    rhs[parent_index[i]] -= factor * rhs[i];
+    // Tree of CV parents of a cell, relative to its first CV.
+    std::vector<index_type> cell_tree(index_type cell) const {
+        auto first = cell_cv_divs[cell];
+        std::vector<index_type> tree = {0};
+        for (auto i: util::make_span(first+1, cell_cv_divs[cell+1])) {
+            tree.push_back(parent_index[i]-first);
+        }
+        return tree;
+    }
+
+    // Group cells into solution units, and lay out the matrix storage.
+    void make_solution_units() {
+        const index_type ncells = cell_cv_divs.size()-1;
+
+        std::vector<std::vector<index_type>> trees;
+        for (auto c: util::make_span(ncells)) {
+            trees.push_back(cell_tree(c));
+        }
+
+        // Candidate batches are filled in order of decreasing size, so that
+        // cells of the same structure are adjacent, as are cells whose trees
+        // are prefixes of one another.
+        std::vector<index_type> order(ncells);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+            [&](index_type a, index_type b) {
+                return trees[a].size()!=trees[b].size()? trees[a].size()>trees[b].size(): trees[a]<trees[b];
+            });
+
+        // A batch: its cells, the template parent and children of each row,
+        // and the template row of each CV of each cell.
+        struct batch {
+            std::vector<index_type> cells;
+            std::vector<index_type> parent;
+            std::vector<std::vector<index_type>> children;
+            std::vector<std::vector<index_type>> rows;
+        };
+
+        // Rows of the template b for the CVs of tree, with -1 for CVs that
+        // need a new row, and the number of new rows.
+        auto align = [](const batch& b, const std::vector<index_type>& tree, std::vector<index_type>& rows) {
+            rows.assign(tree.size(), -1);
+            std::vector<index_type> nchild(tree.size(), 0);
+            index_type nnew = 0;
+            for (auto i: util::make_span(tree.size())) {
+                if (i==0) {
+                    rows[i] = b.parent.empty()? -1: 0;
+                }
+                else {
+                    auto pr = rows[tree[i]];
+                    auto k = nchild[tree[i]]++;
+                    if (pr>=0 && k<(index_type)b.children[pr].size()) {
+                        rows[i] = b.children[pr][k];
+                    }
                 }
-                rhs[first] /= d[first];
+                nnew += rows[i]<0;
+            }
+            return nnew;
+        };
 
-                // forward sweep
-                for(auto i=first+1; i<last; ++i) {
-                    rhs[i] -= u[i] * rhs[parent_index[i]];
-                    rhs[i] /= d[i];
+        std::vector<batch> batches;
+        std::vector<index_type> rows;
+        for (auto c: order) {
+            const auto& tree = trees[c];
+            index_type ncv = tree.size();
+
+            bool open = !batches.empty() && batches.back().cells.size()<simd_width;
+            index_type nnew = open? align(batches.back(), tree, rows): ncv;
+            if (!open || 4*index_type(batches.back().parent.size()+nnew)>5*ncv) {
+                batches.emplace_back();
+                align(batches.back(), tree, rows);
+            }
+
+            auto& b = batches.back();
+            for (auto i: util::make_span(ncv)) {
+                if (rows[i]<0) {
+                    rows[i] = b.parent.size();
+                    b.parent.push_back(i? rows[tree[i]]: 0);
+                    b.children.emplace_back();
+                    if (i) b.children[rows[tree[i]]].push_back(rows[i]);
                 }
             }
+            b.cells.push_back(c);
+            b.rows.push_back(rows);
+        }
+
+        // Lay out the batches of at least simd_width/2 cells first, then the
+        // remaining cells one at a time, in cell order.
+        unit_cells.clear();
+        unit_divs.assign(1, 0);
+        unit_parent.clear();
+        unit_row_divs.assign(1, 0);
+        unit_offset.clear();
+
+        std::vector<index_type> slot(size());
+        index_type nslot = 0;
+        std::vector<index_type> single_cells;
+        for (auto& b: batches) {
+            if (simd_width==1 || 2*b.cells.size()<simd_width) {
+                single_cells.insert(single_cells.end(), b.cells.begin(), b.cells.end());
+                continue;
+            }
+
+            for (auto lane: util::make_span(b.cells.size())) {
+                auto first = cell_cv_divs[b.cells[lane]];
+                for (auto i: util::make_span(b.rows[lane].size())) {
+                    slot[first+i] = nslot + b.rows[lane][i]*simd_width + lane;
+                }
+            }
+            unit_cells.insert(unit_cells.end(), b.cells.begin(), b.cells.end());
+            unit_divs.push_back(unit_cells.size());
+            unit_parent.insert(unit_parent.end(), b.parent.begin(), b.parent.end());
+            unit_row_divs.push_back(unit_parent.size());
+            unit_offset.push_back(nslot);
+            nslot += b.parent.size()*simd_width;
+        }
+        num_batches = unit_offset.size();
+
+        std::sort(single_cells.begin(), single_cells.end());
+        for (auto c: single_cells) {
+            auto first = cell_cv_divs[c];
+            for (auto i: util::make_span(trees[c].size())) {
+                slot[first+i] = nslot+i;
+            }
+            unit_cells.push_back(c);
+            unit_divs.push_back(unit_cells.size());
+            unit_parent.insert(unit_parent.end(), trees[c].begin(), trees[c].end());
+            unit_row_divs.push_back(unit_parent.size());
+            unit_offset.push_back(nslot);
+            nslot += trees[c].size();
+        }
+
+        // Rows of the template left empty by a cell are the identity; the
+        // diagonal of the rows of the cells is set by assemble().
+        cv_slot = iarray(slot.begin(), slot.end());
+        d = array(nslot, 1);
+        u = array(nslot, 0);
+        rhs = array(nslot, 0);
+        for (auto j: slot) {
+            d[j] = 0;
         }
     }
 
-    template<typename VTo>
-    void solve(VTo& to) {
-        solve();
-        memory::copy(rhs, to);
+    // Solve units [first_unit, last_unit).
+    void solve_units(index_type first_unit, index_type last_unit) {
+        for (auto k: util::make_span(first_unit, last_unit)) {
+            if (k<num_batches) {
+                solve_batch(k);
+            }
+            else {
+                solve_cell(k);
+            }
+        }
     }
 
-private:
+    // Solve the single cell of unit k.
+    void solve_cell(index_type k) {
+        value_type* D = d.data()+unit_offset[k];
+        const value_type* U = u.data()+unit_offset[k];
+        value_type* R = rhs.data()+unit_offset[k];
+        const index_type* p = unit_parent.data()+unit_row_divs[k];
+        const index_type n = unit_row_divs[k+1]-unit_row_divs[k];
 
-    std::size_t size() const {
-        return parent_index.size();
+        if (D[0]!=0) {
+            // backward sweep
+            for (index_type i = n-1; i>0; --i) {
+                auto factor = U[i] / D[i];
+                D[p[i]] -= factor * U[i];
+                R[p[i]] -= factor * R[i];
+            }
+            R[0] /= D[0];
+
+            // forward sweep
+            for (index_type i = 1; i<n; ++i) {
+                R[i] -= U[i] * R[p[i]];
+                R[i] /= D[i];
+            }
+        }
+    }
+
+    // Solve the cells of batch k in lockstep. A cell with a zero diagonal is
+    // not to be solved: it is taken to be the identity, which leaves its rhs
+    // as-is.
+    void solve_batch(index_type k) {
+        const value_type* D = d.data()+unit_offset[k];
+
+        bool unsolved = false;
+        for (unsigned lane = 0; lane<simd_width; ++lane) {
+            unsolved |= D[lane]==0;
+        }
+
+        if (unsolved) {
+            auto skip = simd_value(D)==0;
+            sweep_batch(k, [&skip](simd_value& ui, simd_value& di) {
+                simd::where(skip, ui) = 0;
+                simd::where(skip, di) = 1;
+            });
+        }
+        else {
+            sweep_batch(k, [](simd_value&, simd_value&) {});
+        }
+    }
+
+    // Sweeps of the Hines algorithm over the rows of batch k, with the
+    // upper diagonal and diagonal entries of each row passed through
+    // identity() on loading.
+    template <typename F>
+    void sweep_batch(index_type k, F&& identity) {
+        constexpr unsigned W = simd_width;
+        value_type* D = d.data()+unit_offset[k];
+        const value_type* U = u.data()+unit_offset[k];
+        value_type* R = rhs.data()+unit_offset[k];
+        const index_type* p = unit_parent.data()+unit_row_divs[k];
+        const index_type n = unit_row_divs[k+1]-unit_row_divs[k];
+
+        // backward sweep
+        for (index_type i = n-1; i>0; --i) {
+            index_type pi = p[i]*W;
+            simd_value ui(U+i*W), di(D+i*W), ri(R+i*W);
+            identity(ui, di);
+            simd_value factor = ui/di;
+            simd_value dp(D+pi), rp(R+pi);
+            (dp-factor*ui).copy_to(D+pi);
+            (rp-factor*ri).copy_to(R+pi);
+        }
+        simd_value u0(U), d0(D);
+        identity(u0, d0);
+        (simd_value(R)/d0).copy_to(R);
+
+        // forward sweep
+        for (index_type i = 1; i<n; ++i) {
+            index_type pi = p[i]*W;
+            simd_value ui(U+i*W), di(D+i*W), ri(R+i*W), rp(R+pi);
+            identity(ui, di);
+            ((ri-ui*rp)/di).copy_to(R+i*W);
+        }
     }
 };
 
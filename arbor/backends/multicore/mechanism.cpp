@@ -6,6 +6,7 @@
 #include <utility>
 #include <vector>
 
+#include <arbor/arbexcept.hpp>
 #include <arbor/fvm_types.hpp>
 #include <arbor/common_types.hpp>
 #include <arbor/math.hpp>
@@ -16,6 +17,7 @@
 #include "util/padded_alloc.hpp"
 #include "util/range.hpp"
 #include "util/rangeutil.hpp"
+#include "util/span.hpp"
 
 #include "backends/multicore/mechanism.hpp"
 #include "backends/multicore/multicore_common.hpp"
@@ -98,6 +100,9 @@ void mechanism::instantiate(unsigned id, backend::shared_state& shared, const me
     vec_t_ptr_        = &shared.time;
     event_stream_ptr_ = &shared.deliverable_events;
 
+    thread_pool_ = shared.thread_pool;
+    views_.clear();
+
     // If there are no sites (is this ever meaningful?) there is nothing more to do.
     if (width_==0) {
         return;
@@ -124,6 +129,17 @@ void mechanism::instantiate(unsigned id, backend::shared_state& shared, const me
     }
     weight_ = data_.data();
 
+    auto float_states = float_state_table();
+    fdata_ = padded_vector<float>(float_states.size()*width_padded_, NAN, pad);
+    for (std::size_t i = 0; i<float_states.size(); ++i) {
+        float*& state_ptr = *(float_states[i].second);
+        state_ptr = fdata_.data()+i*width_padded_;
+
+        if (auto opt_value = value_by_key(field_default_table(), float_states[i].first)) {
+            std::fill(state_ptr, state_ptr+width_padded_, *opt_value);
+        }
+    }
+
     // Allocate and copy local state: weight, node indices, ion indices.
     // The tail comprises those elements between width_ and width_padded_:
     //
@@ -174,6 +190,114 @@ void mechanism::instantiate(unsigned id, backend::shared_state& shared, const me
             arb_assert(compatible_index_constraints(node_index, ion_index, simd_width()));
         }
     }
+
+    if (thread_pool_ && shared.n_thread_blocks>1) {
+        make_views(shared.n_thread_blocks);
+    }
+}
+
+// Split the instances into at most n_view views of approximately equal width.
+// View boundaries are multiples of the SIMD width, and do not divide the
+// instances on any one CV, which requires that the node indices are sorted.
+
+void mechanism::make_views(unsigned n_view) {
+    const fvm_size_type simd_w = simd_width();
+    n_view = std::min<fvm_size_type>(n_view, width_/min_view_width);
+
+    if (n_view<2 || !std::is_sorted(node_index_, node_index_+width_)) {
+        return;
+    }
+
+    std::vector<fvm_size_type> divs = {0};
+    for (unsigned b = 1; b<n_view; ++b) {
+        auto d = math::round_up(fvm_size_type(std::size_t(width_)*b/n_view), simd_w);
+        while (d<width_ && node_index_[d]==node_index_[d-1]) {
+            d += simd_w;
+        }
+        if (d>divs.back() && d<width_) {
+            divs.push_back(d);
+        }
+    }
+    divs.push_back(width_);
+
+    if (divs.size()<3) {
+        return;
+    }
+
+    set_views(divs);
+}
+
+void mechanism::set_views(const std::vector<fvm_size_type>& divs) {
+    const fvm_size_type simd_w = simd_width();
+    views_.clear();
+
+    auto fields = field_table();
+    auto float_states = float_state_table();
+    auto globals = global_table();
+    auto ion_states = ion_state_table();
+    auto ion_indices = ion_index_table();
+
+    for (std::size_t i = 0; i+1<divs.size(); ++i) {
+        auto offset = divs[i];
+        auto width = divs[i+1]-offset;
+        bool last = i+2==divs.size();
+
+        std::unique_ptr<mechanism> view(dynamic_cast<mechanism*>(clone().release()));
+        if (!view) {
+            throw arbor_internal_error("multicore/mechanism: mechanism clone has different back-end");
+        }
+
+        view->mechanism_id_ = mechanism_id_;
+        view->width_ = width;
+        view->width_padded_ = last? width_padded_-offset: width;
+        view->n_ion_ = n_ion_;
+        view->n_detectors_ = n_detectors_;
+
+        view->vec_ci_ = vec_ci_;
+        view->vec_di_ = vec_di_;
+        view->vec_dt_ = vec_dt_;
+        view->vec_v_ = vec_v_;
+        view->vec_i_ = vec_i_;
+        view->vec_g_ = vec_g_;
+        view->temperature_degC_ = temperature_degC_;
+        view->diam_um_ = diam_um_;
+        view->time_since_spike_ = time_since_spike_;
+        view->vec_t_ptr_ = vec_t_ptr_;
+        view->event_stream_ptr_ = event_stream_ptr_;
+
+        view->node_index_ = node_index_+offset;
+        view->weight_ = weight_+offset;
+        view->mult_in_place_ = false;
+        view->index_constraints_ = make_constraint_partition(
+            make_range(view->node_index_, view->node_index_+view->width_padded_), width, simd_w);
+
+        auto view_fields = view->field_table();
+        for (auto j: util::count_along(fields)) {
+            *view_fields[j].second = *fields[j].second+offset;
+        }
+
+        auto view_float_states = view->float_state_table();
+        for (auto j: util::count_along(float_states)) {
+            *view_float_states[j].second = *float_states[j].second+offset;
+        }
+
+        auto view_globals = view->global_table();
+        for (auto j: util::count_along(globals)) {
+            *view_globals[j].second = *globals[j].second;
+        }
+
+        auto view_ion_states = view->ion_state_table();
+        for (auto j: util::count_along(ion_states)) {
+            *view_ion_states[j].second = *ion_states[j].second;
+        }
+
+        auto view_ion_indices = view->ion_index_table();
+        for (auto j: util::count_along(ion_indices)) {
+            *view_ion_indices[j].second = *ion_indices[j].second+offset;
+        }
+
+        views_.push_back(std::move(view));
+    }
 }
 
 void mechanism::set_parameter(const std::string& key, const std::vector<fvm_value_type>& values) {
@@ -197,6 +321,10 @@ void mechanism::set_parameter(const std::string& key, const std::vector<fvm_valu
 
 void mechanism::initialize() {
     vec_t_ = vec_t_ptr_->data();
+    init_tables();
+    for (auto& view: views_) {
+        view->init_tables();
+    }
     init();
 
     auto states = state_table();
@@ -207,6 +335,11 @@ void mechanism::initialize() {
                 (*state.second)[j] *= multiplicity_[j];
             }
         }
+        for (auto& state: float_state_table()) {
+            for (std::size_t j = 0; j < width_; ++j) {
+                (*state.second)[j] *= multiplicity_[j];
+            }
+        }
     }
 }
 
@@ -215,9 +348,47 @@ fvm_value_type* mechanism::field_data(const std::string& field_var) {
         return *opt_ptr.value();
     }
 
+    if (value_by_key(float_state_table(), field_var)) {
+        throw arbor_exception("multicore/mechanism: state variable '"+field_var+"' of mechanism '"
+            +internal_name()+"' is held in single precision, and can not be accessed directly");
+    }
+
     return nullptr;
 }
 
+std::vector<fvm_value_type> mechanism::get_state() {
+    std::vector<fvm_value_type> values;
+    if (width_>0) {
+        for (auto& entry: state_table()) {
+            const fvm_value_type* field_ptr = *entry.second;
+            values.insert(values.end(), field_ptr, field_ptr+width_);
+        }
+        for (auto& entry: float_state_table()) {
+            const float* field_ptr = *entry.second;
+            values.insert(values.end(), field_ptr, field_ptr+width_);
+        }
+    }
+    return values;
+}
+
+void mechanism::set_state(const std::vector<fvm_value_type>& values) {
+    auto table = state_table();
+    auto float_table = float_state_table();
+    if (values.size()!=(table.size()+float_table.size())*width_) {
+        throw arbor_internal_error("multicore/mechanism: mechanism state size mismatch");
+    }
+
+    auto p = values.begin();
+    for (auto& entry: table) {
+        std::copy(p, p+width_, *entry.second);
+        p += width_;
+    }
+    for (auto& entry: float_table) {
+        std::copy(p, p+width_, *entry.second);
+        p += width_;
+    }
+}
+
 
 } // namespace multicore
 } // namespace arb
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -14,13 +15,18 @@
 #include "backends/multicore/fvm.hpp"
 #include "backends/multicore/multicore_common.hpp"
 #include "backends/multicore/partition_by_constraint.hpp"
+#include "threading/threading.hpp"
 
 namespace arb {
 namespace multicore {
 
+class mechanism_pipeline;
+
 // Base class for all generated mechanisms for multicore back-end.
 
 class mechanism: public arb::concrete_mechanism<arb::multicore::backend> {
+    friend class mechanism_pipeline;
+
 protected:
     using array  = arb::multicore::array;
     using iarray = arb::multicore::iarray;
@@ -33,6 +39,7 @@ public:
     std::size_t memory() const override {
         std::size_t s = object_sizeof();
         s += sizeof(data_[0])    * data_.size();
+        s += sizeof(fdata_[0])   * fdata_.size();
         s += sizeof(indices_[0]) * indices_.size();
         return s;
     }
@@ -46,22 +53,26 @@ public:
     }
     void update_current() override {
         vec_t_ = vec_t_ptr_->data();
-        compute_currents();
+        for_each_view([](mechanism& m) { m.compute_currents(); });
     }
     void update_state() override {
         vec_t_ = vec_t_ptr_->data();
-        advance_state();
+        for_each_view([](mechanism& m) { m.advance_state(); });
     }
     void update_ions() override {
         vec_t_ = vec_t_ptr_->data();
-        write_ions();
+        for_each_view([](mechanism& m) { m.write_ions(); });
     }
 
     void set_parameter(const std::string& key, const std::vector<fvm_value_type>& values) override;
 
     // Peek into mechanism state variable; implements arb::multicore::backend::mechanism_field_data.
+    // Throws arbor_exception if the state variable is held in single precision.
     fvm_value_type* field_data(const std::string& state_var) override;
 
+    std::vector<fvm_value_type> get_state() override;
+    void set_state(const std::vector<fvm_value_type>& values) override;
+
 protected:
     fvm_size_type width_ = 0;        // Instance width (number of CVs/sites)
     fvm_size_type width_padded_ = 0; // Width rounded up to multiple of pad/alignment.
@@ -95,9 +106,68 @@ protected:
     // Bulk storage for state and parameter variables.
 
     array data_;
+    padded_vector<float> fdata_;
     iarray indices_;
 
+    // STATE variables held in single precision, by mechanisms generated by
+    // modcc in mixed precision mode. These are not in the field and state
+    // tables: they are stored in fdata_, and are included in get_state() and
+    // set_state() after the double precision state variables.
+
+    using float_state_entry = std::pair<const char*, float**>;
+    using mechanism_float_state_table = std::vector<float_state_entry>;
+
+    virtual mechanism_float_state_table float_state_table() { return {}; }
+
+    // Views onto contiguous ranges of instances, over which the state and
+    // current updates are split between the threads of thread_pool_. The
+    // views share the storage of this mechanism, and ranges are divided only
+    // between CVs, so that no two views write to the same CV.
+
+    threading::task_system* thread_pool_ = nullptr;
+    std::vector<std::unique_ptr<mechanism>> views_;
+
+    // Minimum number of instances in a view.
+    static constexpr fvm_size_type min_view_width = 64;
+
+    void make_views(unsigned n_view);
+
+    // Replace the views with views onto the instances [divs[i], divs[i+1]).
+    // The divisions must be increasing multiples of the SIMD width, excepting
+    // the last, which must equal width_.
+    void set_views(const std::vector<fvm_size_type>& divs);
+
+    // Apply f to this mechanism, or to each of its views, in parallel if
+    // there is a thread pool.
+    template <typename F>
+    void for_each_view(F f) {
+        if (views_.empty()) {
+            f(*this);
+            return;
+        }
+
+        if (!thread_pool_) {
+            for (auto& view: views_) {
+                view->vec_t_ = vec_t_;
+                f(*view);
+            }
+            return;
+        }
+
+        threading::parallel_for::apply(0, views_.size(), 1, thread_pool_,
+            [&](int i) {
+                auto& view = *views_[i];
+                view.vec_t_ = vec_t_;
+                f(view);
+            });
+    }
+
     virtual unsigned simd_width() const { return 1; }
+
+    // Look up or fill the tables of any tabulated functions, which depend on
+    // the global parameters and possibly the temperature; the mechanism and
+    // its views share the tables with any instance with the same values.
+    virtual void init_tables() {}
 };
 
 } // namespace multicore
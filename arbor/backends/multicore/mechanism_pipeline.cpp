@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <arbor/fvm_types.hpp>
+#include <arbor/math.hpp>
+#include <arbor/mechanism.hpp>
+
+#include "backends/multicore/mechanism.hpp"
+#include "backends/multicore/mechanism_pipeline.hpp"
+#include "threading/threading.hpp"
+
+namespace arb {
+namespace multicore {
+
+namespace {
+multicore::mechanism* fusable(arb::mechanism* m) {
+    auto mc = dynamic_cast<multicore::mechanism*>(m);
+    return mc && mc->kind()==mechanismKind::density && mc->size()? mc: nullptr;
+}
+}
+
+mechanism_pipeline::mechanism_pipeline(const std::vector<mechanism_ptr>& mechs, fvm_size_type tile_cvs) {
+    for (auto& m: mechs) {
+        bool fuse_with_last = tile_cvs && !stages_.empty() && fusable(m.get()) && fusable(stages_.back().mechs.back());
+        if (fuse_with_last) {
+            stages_.back().mechs.push_back(m.get());
+        }
+        else {
+            stages_.push_back({{m.get()}, {}});
+        }
+    }
+
+    for (auto& s: stages_) {
+        if (s.mechs.size()>1) {
+            fuse(s, tile_cvs);
+        }
+    }
+}
+
+// Cut the CVs of the mechanisms of a run into tiles, and make the views of
+// each mechanism onto its instances in each tile.
+//
+// A cut at CV c divides the instances of each mechanism at the first instance
+// on a CV not before c, rounded up to the SIMD width of the mechanism. The cut
+// is accepted only if every instance before it is on a CV before those of every
+// instance after it, over all of the mechanisms; otherwise c is advanced past
+// the CVs that straddle the cut, and the cut is tried again.
+
+void mechanism_pipeline::fuse(stage& s, fvm_size_type tile_cvs) {
+    std::vector<mechanism*> ms;
+    for (auto m: s.mechs) {
+        auto mc = static_cast<mechanism*>(m);
+        if (!std::is_sorted(mc->node_index_, mc->node_index_+mc->width_)) return;
+        ms.push_back(mc);
+    }
+    const std::size_t n = ms.size();
+
+    fvm_index_type lo = std::numeric_limits<fvm_index_type>::max();
+    fvm_index_type hi = std::numeric_limits<fvm_index_type>::min();
+    for (auto m: ms) {
+        lo = std::min(lo, m->node_index_[0]);
+        hi = std::max(hi, m->node_index_[m->width_-1]);
+    }
+
+    // Instance divisions of each mechanism at each accepted cut.
+    std::vector<std::vector<fvm_size_type>> divs(n, std::vector<fvm_size_type>{0});
+    std::vector<fvm_size_type> b(n);
+
+    for (std::int64_t c = std::int64_t(lo)+tile_cvs; c<=hi; ) {
+        for (std::size_t i = 0; i<n; ++i) {
+            auto& m = *ms[i];
+            fvm_size_type k = std::lower_bound(m.node_index_, m.node_index_+m.width_, c)-m.node_index_;
+            b[i] = std::min(math::round_up(k, fvm_size_type(m.simd_width())), m.width_);
+        }
+
+        std::int64_t left = std::numeric_limits<std::int64_t>::min();
+        std::int64_t right = std::numeric_limits<std::int64_t>::max();
+        for (std::size_t i = 0; i<n; ++i) {
+            auto& m = *ms[i];
+            if (b[i]>0) left = std::max<std::int64_t>(left, m.node_index_[b[i]-1]);
+            if (b[i]<m.width_) right = std::min<std::int64_t>(right, m.node_index_[b[i]]);
+        }
+
+        if (left>=right) {
+            c = left+1;
+            continue;
+        }
+
+        bool advances = false;
+        for (std::size_t i = 0; i<n; ++i) {
+            advances |= b[i]>divs[i].back();
+        }
+        if (advances) {
+            for (std::size_t i = 0; i<n; ++i) {
+                divs[i].push_back(b[i]);
+            }
+        }
+        c += tile_cvs;
+    }
+
+    for (std::size_t i = 0; i<n; ++i) {
+        divs[i].push_back(ms[i]->width_);
+    }
+
+    const std::size_t n_tile = divs[0].size()-1;
+    s.tiles.resize(n_tile);
+
+    for (std::size_t i = 0; i<n; ++i) {
+        // Views are made only for tiles that hold instances of the mechanism.
+        std::vector<fvm_size_type> view_divs = divs[i];
+        view_divs.erase(std::unique(view_divs.begin(), view_divs.end()), view_divs.end());
+        ms[i]->set_views(view_divs);
+
+        std::size_t v = 0;
+        for (std::size_t t = 0; t<n_tile; ++t) {
+            if (divs[i][t]<divs[i][t+1]) {
+                s.tiles[t].views.push_back(ms[i]->views_[v++].get());
+            }
+        }
+    }
+
+    thread_pool_ = ms[0]->thread_pool_;
+}
+
+template <typename F>
+void mechanism_pipeline::for_each_tile(stage& s, F f) {
+    auto update_tile = [&](int t) {
+        for (auto view: s.tiles[t].views) {
+            view->vec_t_ = view->vec_t_ptr_->data();
+            f(*view);
+        }
+    };
+
+    if (thread_pool_) {
+        threading::parallel_for::apply(0, s.tiles.size(), 1, thread_pool_, update_tile);
+    }
+    else {
+        for (std::size_t t = 0; t<s.tiles.size(); ++t) {
+            update_tile(t);
+        }
+    }
+}
+
+void mechanism_pipeline::update_current() {
+    for (auto& s: stages_) {
+        if (s.tiles.empty()) {
+            for (auto m: s.mechs) {
+                m->deliver_events();
+                m->update_current();
+            }
+        }
+        else {
+            for (auto m: s.mechs) {
+                m->deliver_events();
+            }
+            for_each_tile(s, [](mechanism& m) { m.compute_currents(); });
+        }
+    }
+}
+
+void mechanism_pipeline::update_state() {
+    for (auto& s: stages_) {
+        if (s.tiles.empty()) {
+            for (auto m: s.mechs) {
+                m->update_state();
+            }
+        }
+        else {
+            for_each_tile(s, [](mechanism& m) { m.advance_state(); });
+        }
+    }
+}
+
+std::size_t mechanism_pipeline::n_fused() const {
+    std::size_t n = 0;
+    for (auto& s: stages_) {
+        if (!s.tiles.empty()) n += s.mechs.size();
+    }
+    return n;
+}
+
+std::vector<std::size_t> mechanism_pipeline::tile_counts() const {
+    std::vector<std::size_t> counts;
+    for (auto& s: stages_) {
+        if (!s.tiles.empty()) counts.push_back(s.tiles.size());
+    }
+    return counts;
+}
+
+} // namespace multicore
+} // namespace arb
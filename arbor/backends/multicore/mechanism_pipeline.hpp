@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <arbor/fvm_types.hpp>
+#include <arbor/mechanism.hpp>
+
+#include "threading/threading.hpp"
+
+namespace arb {
+namespace multicore {
+
+class mechanism;
+
+// Current and state updates of the mechanisms of a cell group, in the order
+// of the mechanisms.
+//
+// If tile_cvs is non-zero, each run of two or more consecutive density
+// mechanisms is fused: the CVs covered by the run are divided into tiles of
+// approximately tile_cvs CVs, and the current (or state) update runs over
+// each tile in turn, for every mechanism in the run, so that the voltage,
+// current density and conductivity of a tile are loaded once per step
+// rather than once per mechanism. Tiles are divided only between CVs, and
+// may be updated in parallel over the thread pool of the mechanisms.
+//
+// The contributions to the current of each CV are summed in the order of the
+// mechanisms, as when the mechanisms are updated one after another, so the
+// results are the same.
+//
+// Fused mechanisms are updated over views onto the instances in each tile,
+// which replace any views made for the division of the work over threads.
+// A run that includes a mechanism with unsorted node indices is not fused.
+
+class mechanism_pipeline {
+public:
+    mechanism_pipeline() = default;
+    mechanism_pipeline(const std::vector<mechanism_ptr>& mechs, fvm_size_type tile_cvs);
+
+    // Deliver events and update the current contributions of the mechanisms.
+    void update_current();
+
+    // Integrate the mechanism state.
+    void update_state();
+
+    // Number of mechanisms that are updated in fused tiles.
+    std::size_t n_fused() const;
+
+    // Number of tiles in each fused run of mechanisms.
+    std::vector<std::size_t> tile_counts() const;
+
+private:
+    struct tile {
+        std::vector<mechanism*> views; // One for each mechanism with instances in the tile.
+    };
+
+    // A single mechanism updated by itself (tiles empty), or a fused run.
+    struct stage {
+        std::vector<arb::mechanism*> mechs;
+        std::vector<tile> tiles;
+    };
+
+    std::vector<stage> stages_;
+    threading::task_system* thread_pool_ = nullptr;
+
+    void fuse(stage& s, fvm_size_type tile_cvs);
+
+    template <typename F>
+    void for_each_tile(stage& s, F f);
+};
+
+} // namespace multicore
+} // namespace arb
@@ -168,6 +168,51 @@ void shared_state::reset() {
     }
 }
 
+// The dynamic state comprises the integration times, voltage, current
+// density, conductivity and time since spike, followed by the current
+// density, reversal potential and concentrations of each ion in order of
+// ion name. Parameters and the initial state are not included.
+
+template <typename State, typename F>
+static void for_each_state_array(State& s, F f) {
+    f(s.time);
+    f(s.time_to);
+    f(s.voltage);
+    f(s.current_density);
+    f(s.conductivity);
+    f(s.time_since_spike);
+
+    std::vector<std::string> ions;
+    for (auto& i: s.ion_data) {
+        ions.push_back(i.first);
+    }
+    util::sort(ions);
+    for (auto& name: ions) {
+        auto& ion = s.ion_data.at(name);
+        f(ion.iX_);
+        f(ion.eX_);
+        f(ion.Xi_);
+        f(ion.Xo_);
+    }
+}
+
+std::vector<fvm_value_type> shared_state::get_state() const {
+    std::vector<fvm_value_type> state;
+    for_each_state_array(*this, [&](const array& a) { util::append(state, a); });
+    return state;
+}
+
+void shared_state::set_state(const std::vector<fvm_value_type>& state) {
+    auto p = state.begin();
+    for_each_state_array(*this,
+        [&](array& a) {
+            arb_assert(state.end()-p>=(std::ptrdiff_t)a.size());
+            std::copy(p, p+a.size(), a.begin());
+            p += a.size();
+        });
+    arb_assert(p==state.end());
+}
+
 void shared_state::zero_currents() {
     util::fill(current_density, 0);
     util::fill(conductivity, 0);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include <iosfwd>
 #include <string>
@@ -105,6 +106,12 @@ struct shared_state {
 
     deliverable_event_stream deliverable_events;
 
+    // Mechanisms instantiated on this state and the threshold watcher split
+    // their work into up to n_thread_blocks blocks over the threads of
+    // thread_pool; see set_thread_blocks.
+    threading::task_system* thread_pool = nullptr;
+    unsigned n_thread_blocks = 1;
+
     shared_state() = default;
 
     shared_state(
@@ -155,6 +162,18 @@ struct shared_state {
         array& sample_value);
 
     void reset();
+
+    // Copy the dynamic state to or from a vector, for checkpointing: see
+    // shared_state.cpp for the order of the values.
+    std::vector<fvm_value_type> get_state() const;
+    void set_state(const std::vector<fvm_value_type>& state);
+
+    // Set the thread pool and maximum number of blocks of work for
+    // mechanisms that are subsequently instantiated.
+    void set_thread_blocks(threading::task_system* ts, unsigned n) {
+        thread_pool = ts;
+        n_thread_blocks = ts? std::max(n, 1u): 1u;
+    }
 };
 
 // For debugging only:
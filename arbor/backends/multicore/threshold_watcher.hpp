@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <vector>
+
 #include <arbor/assert.hpp>
 #include <arbor/fvm_types.hpp>
 #include <arbor/math.hpp>
@@ -42,6 +45,21 @@ public:
         reset();
     }
 
+    /// Split the detectors into at most n contiguous blocks that are tested
+    /// in parallel over the threads of ts.
+    void set_thread_blocks(threading::task_system* ts, unsigned n) {
+        thread_pool_ = ts;
+        block_divs_.clear();
+
+        fvm_size_type nblock = std::min<fvm_size_type>(n, n_cv_/min_block_size);
+        if (!ts || nblock<2) return;
+
+        for (fvm_size_type b = 0; b<=nblock; ++b) {
+            block_divs_.push_back(n_cv_*b/nblock);
+        }
+        block_crossings_.resize(nblock);
+    }
+
     /// Remove all stored crossings that were detected in previous calls
     /// to the test() member function.
     void clear_crossings() {
@@ -66,10 +84,55 @@ public:
     /// Crossing events are recorded for each threshold that
     /// is crossed since the last call to test
     void test(array* time_since_spike) {
+        if (block_divs_.empty()) {
+            test_range(0, n_cv_, time_since_spike, crossings_);
+            return;
+        }
+
+        // Crossings are collected per block and appended in block order, so
+        // that their order is independent of the number of blocks.
+        threading::parallel_for::apply(0, block_crossings_.size(), 1, thread_pool_,
+            [&](int b) {
+                block_crossings_[b].clear();
+                test_range(block_divs_[b], block_divs_[b+1], time_since_spike, block_crossings_[b]);
+            });
+
+        for (const auto& c: block_crossings_) {
+            crossings_.insert(crossings_.end(), c.begin(), c.end());
+        }
+    }
+
+    /// Detector state, for checkpointing: the crossed flag of each detector,
+    /// followed by the value of each detector at the last test.
+    std::vector<fvm_value_type> get_state() const {
+        std::vector<fvm_value_type> state(is_crossed_.begin(), is_crossed_.end());
+        state.insert(state.end(), v_prev_.begin(), v_prev_.end());
+        return state;
+    }
+
+    void set_state(const std::vector<fvm_value_type>& state) {
+        arb_assert(state.size()==2*n_cv_);
+        clear_crossings();
+        std::copy(state.begin(), state.begin()+n_cv_, is_crossed_.begin());
+        std::copy(state.begin()+n_cv_, state.end(), v_prev_.begin());
+    }
+
+    bool is_crossed(fvm_size_type i) const {
+        return is_crossed_[i];
+    }
+
+    /// The number of threshold values that are monitored.
+    std::size_t size() const {
+        return n_cv_;
+    }
+
+private:
+    /// Test detectors [first, last), appending crossings to out.
+    void test_range(fvm_size_type first, fvm_size_type last, array* time_since_spike, std::vector<threshold_crossing>& out) {
         // Reset all spike times to -1.0 indicating no spike has been recorded on the detector
         const fvm_value_type* t_before = t_before_ptr_->data();
         const fvm_value_type* t_after  = t_after_ptr_->data();
-        for (fvm_size_type i = 0; i<n_cv_; ++i) {
+        for (fvm_size_type i = first; i<last; ++i) {
             auto cv     = cv_index_[i];
             auto intdom = cv_to_intdom_[cv];
             auto v_prev = v_prev_[i];
@@ -88,7 +151,7 @@ public:
                     // linear interpolation.
                     auto pos = (thresh - v_prev)/(v - v_prev);
                     auto crossing_time = math::lerp(t_before[intdom], t_after[intdom], pos);
-                    crossings_.push_back({i, crossing_time});
+                    out.push_back({i, crossing_time});
 
                     if (!time_since_spike->empty()) {
                         (*time_since_spike)[spike_idx] = t_after[intdom] - crossing_time;
@@ -107,16 +170,6 @@ public:
         }
     }
 
-    bool is_crossed(fvm_size_type i) const {
-        return is_crossed_[i];
-    }
-
-    /// The number of threshold values that are monitored.
-    std::size_t size() const {
-        return n_cv_;
-    }
-
-private:
     /// Non-owning pointers to cv-to-intdom map,
     /// the values for to test against thresholds,
     /// and pointers to the time arrays
@@ -133,6 +186,14 @@ private:
     std::vector<fvm_value_type> thresholds_;
     std::vector<fvm_value_type> v_prev_;
     std::vector<threshold_crossing> crossings_;
+
+    /// Partition of detectors into blocks tested in parallel; empty if serial.
+    threading::task_system* thread_pool_ = nullptr;
+    std::vector<fvm_size_type> block_divs_;
+    std::vector<std::vector<threshold_crossing>> block_crossings_;
+
+    /// Minimum number of detectors in a block.
+    static constexpr fvm_size_type min_block_size = 128;
 };
 
 } // namespace multicore
@@ -87,6 +87,21 @@ void benchmark_cell_group::clear_spikes() {
     spikes_.clear();
 }
 
+void benchmark_cell_group::checkpoint(checkpoint_writer& out) const {
+    out.write(t_);
+}
+
+void benchmark_cell_group::restore(checkpoint_reader& in) {
+    t_ = in.read<time_type>();
+
+    // Replay the time sequences up to t_ to recover their positions.
+    for (auto& c: cells_) {
+        c.time_sequence.reset();
+        c.time_sequence.events(0, t_);
+    }
+    clear_spikes();
+}
+
 void benchmark_cell_group::add_sampler(sampler_association_handle h,
                                    cell_member_predicate probe_ids,
                                    schedule sched,
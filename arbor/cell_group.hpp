@@ -5,11 +5,13 @@
 #include <vector>
 
 #include <arbor/common_types.hpp>
+#include <arbor/sample_buffer.hpp>
 #include <arbor/sampling.hpp>
 #include <arbor/schedule.hpp>
 #include <arbor/spike.hpp>
 #include <arbor/spike_event.hpp>
 
+#include "checkpoint.hpp"
 #include "epoch.hpp"
 #include "event_binner.hpp"
 #include "util/rangeutil.hpp"
@@ -31,10 +33,22 @@ public:
     virtual const std::vector<spike>& spikes() const = 0;
     virtual void clear_spikes() = 0;
 
+    // Write the dynamic state of the cells to a checkpoint, or restore it from
+    // one written by a group of the same cells. Called between epochs, when no
+    // spikes are held; sampler associations are not part of the state.
+    virtual void checkpoint(checkpoint_writer&) const = 0;
+    virtual void restore(checkpoint_reader&) = 0;
+
     // Sampler association methods below should be thread-safe, as they might be invoked
     // from a sampler call back called from a different cell group running on a different thread.
 
     virtual void add_sampler(sampler_association_handle, cell_member_predicate, schedule, sampler_function, sampling_policy) = 0;
+
+    // Columnar sampling: samples are written directly into the columns of the
+    // buffer, one column per concrete probe. Cell groups without probes need
+    // not override this.
+    virtual void add_sampler(sampler_association_handle, cell_member_predicate, schedule, sample_buffer_ptr, sampling_policy) {}
+
     virtual void remove_sampler(sampler_association_handle) = 0;
     virtual void remove_all_samplers() = 0;
 
@@ -7,6 +7,7 @@
 // back-end.
 
 #include <functional>
+#include <memory>
 #include <vector>
 
 #include <arbor/common_types.hpp>
@@ -20,8 +21,13 @@ namespace arb {
 using cell_group_factory = std::function<
         cell_group_ptr(const std::vector<cell_gid_type>&, const recipe&)>;
 
+class fvm_discretization_cache;
+
+// Cable cell groups made by the factory share the discretizations of cells
+// through the cache, if supplied.
 cell_group_factory cell_kind_implementation(
-        cell_kind, backend_kind, const execution_context&);
+        cell_kind, backend_kind, const execution_context&,
+        std::shared_ptr<fvm_discretization_cache> cache = {});
 
 inline bool cell_kind_supported(
         cell_kind c, backend_kind b, const execution_context& ctx)
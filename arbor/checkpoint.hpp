@@ -0,0 +1,131 @@
+#pragma once
+
+// Binary serialization of simulation state for checkpoints.
+//
+// Values are written in native byte order, without padding; vectors are
+// prefixed by their length. Checkpoints are intended to be restored by the
+// same build of arbor on the same platform, so there is no conversion of
+// representation, but the reader checks the length of each vector against
+// the state that it is restored into, and throws bad_checkpoint on a mismatch
+// or a truncated stream.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <arbor/arbexcept.hpp>
+
+namespace arb {
+
+class checkpoint_writer {
+public:
+    explicit checkpoint_writer(std::ostream& out): out_(out) {}
+
+    template <typename T>
+    void write(const T& v) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values must be trivially copyable");
+        put(&v, sizeof(T));
+    }
+
+    template <typename T>
+    void write(const std::optional<T>& v) {
+        write<std::uint8_t>(!!v);
+        write(v? *v: T{});
+    }
+
+    template <typename T, typename A>
+    void write(const std::vector<T, A>& v) {
+        write_values(v.data(), v.size());
+    }
+
+    template <typename T>
+    void write_values(const T* p, std::size_t n) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values must be trivially copyable");
+        write<std::uint64_t>(n);
+        put(p, n*sizeof(T));
+    }
+
+private:
+    std::ostream& out_;
+
+    void put(const void* p, std::size_t n) {
+        out_.write(static_cast<const char*>(p), n);
+        if (!out_) {
+            throw bad_checkpoint("write failed");
+        }
+    }
+};
+
+class checkpoint_reader {
+public:
+    explicit checkpoint_reader(std::istream& in): in_(in) {}
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values must be trivially copyable");
+        T v;
+        get(&v, sizeof(T));
+        return v;
+    }
+
+    template <typename T>
+    std::optional<T> read_optional() {
+        bool engaged = read<std::uint8_t>();
+        T v = read<T>();
+        return engaged? std::optional<T>(v): std::nullopt;
+    }
+
+    // Read a vector of any length. Storage grows with the data read, so that
+    // a corrupt length cannot provoke an arbitrarily large allocation.
+    template <typename T>
+    std::vector<T> read_vector() {
+        auto n = read<std::uint64_t>();
+        std::vector<T> v;
+        for (std::uint64_t i = 0; i<n; i = v.size()) {
+            std::size_t m = std::min<std::uint64_t>(n-i, block_size/sizeof(T)+1);
+            v.resize(i+m);
+            get(v.data()+i, m*sizeof(T));
+        }
+        return v;
+    }
+
+    // Read a vector of n values, describing the state named what.
+    template <typename T>
+    std::vector<T> read_vector(std::size_t n, const char* what) {
+        auto m = read<std::uint64_t>();
+        if (m!=n) {
+            throw bad_checkpoint(std::string("size of ")+what+" does not match simulation: "
+                +std::to_string(m)+" in checkpoint, expected "+std::to_string(n));
+        }
+        std::vector<T> v(n);
+        get(v.data(), n*sizeof(T));
+        return v;
+    }
+
+    // Read a value that must equal the corresponding value of the simulation.
+    template <typename T>
+    void expect(const T& v, const char* what) {
+        if (!(read<T>()==v)) {
+            throw bad_checkpoint(std::string(what)+" does not match simulation");
+        }
+    }
+
+private:
+    static constexpr std::size_t block_size = 1<<20;
+    std::istream& in_;
+
+    void get(void* p, std::size_t n) {
+        in_.read(static_cast<char*>(p), n);
+        if (!in_) {
+            throw bad_checkpoint("unexpected end of stream");
+        }
+    }
+};
+
+} // namespace arb
@@ -1,3 +1,8 @@
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -9,11 +14,13 @@
 #include <include/arbor/arbexcept.hpp>
 
 #include "communication/gathered_vector.hpp"
+#include "communication/spike_codec.hpp"
 #include "connection.hpp"
 #include "distributed_context.hpp"
 #include "execution_context.hpp"
 #include "profile/profiler_macro.hpp"
 #include "threading/threading.hpp"
+#include "util/maputil.hpp"
 #include "util/partition.hpp"
 #include "util/rangeutil.hpp"
 #include "util/span.hpp"
@@ -26,6 +33,7 @@ communicator::communicator(const recipe& rec,
                           const domain_decomposition& dom_dec,
                           execution_context& ctx)
 {
+    PE(init_communicator);
     distributed_ = ctx.distributed;
     thread_pool_ = ctx.thread_pool;
 
@@ -34,99 +42,242 @@ communicator::communicator(const recipe& rec,
     num_local_cells_ = dom_dec.num_local_cells;
     auto num_total_cells = rec.num_cells();
 
-    // For caching information about each cell
-    struct gid_info {
-        using connection_list = decltype(std::declval<recipe>().connections_on(0));
-        cell_gid_type gid;              // global identifier of cell
-        cell_size_type index_on_domain; // index of cell in this domain
-        connection_list conns;          // list of connections terminating at this cell
-        gid_info() = default;           // so we can in a std::vector
-        gid_info(cell_gid_type g, cell_size_type di, connection_list c):
-            gid(g), index_on_domain(di), conns(std::move(c)) {}
-    };
-
-    // Make a list of local gid with their group index and connections
-    //   -> gid_infos
-    // Count the number of local connections (i.e. connections terminating on this domain)
-    //   -> n_cons: scalar
-    // Calculate and store domain id of the presynaptic cell on each local connection
-    //   -> src_domains: array with one entry for every local connection
-    // Also the count of presynaptic sources from each domain
-    //   -> src_counts: array with one entry for each domain
+    using connection_list = decltype(std::declval<recipe>().connections_on(0));
 
     // Record all the gid in a flat vector.
     // These are used to map from local index to gid in the parallel loop
-    // that populates gid_infos.
-    std::vector<cell_gid_type> gids;
-    gids.reserve(num_local_cells_);
+    // that queries the connections of each cell, and in event generation.
+    local_gids_.reserve(num_local_cells_);
     for (auto g: dom_dec.groups) {
-        util::append(gids, g.gids);
+        util::append(local_gids_, g.gids);
     }
-    // Build the connection information for local cells in parallel.
-    std::vector<gid_info> gid_infos;
-    gid_infos.resize(num_local_cells_);
-    threading::parallel_for::apply(0, gids.size(), thread_pool_.get(),
-        [&](cell_size_type i) {
-            auto gid = gids[i];
-            gid_infos[i] = gid_info(gid, i, rec.connections_on(gid));
-        });
-
-    cell_local_size_type n_cons =
-        util::sum_by(gid_infos, [](const gid_info& g){ return g.conns.size(); });
-    std::vector<unsigned> src_domains;
-    src_domains.reserve(n_cons);
-    std::vector<cell_size_type> src_counts(num_domains_);
 
-    for (const auto& cell: gid_infos) {
-        auto num_targets = rec.num_targets(cell.gid);
-        for (auto c: cell.conns) {
-            auto num_sources = rec.num_sources(c.source.gid);
+    // Query and validate the connections of local cells in parallel, once.
+    // The local cells are split into contiguous chunks, a few per thread, and
+    // the connections of the cells of each chunk are appended to a buffer of
+    // the chunk. Once all the cells have been queried the table is allocated
+    // at its final size, and the buffers are moved into it, in order of
+    // target cell, and released.
+    //
+    // The recipe is queried concurrently, so its methods must be thread
+    // safe. If any connection is invalid, the error of the lowest local
+    // index is rethrown, so that the error reported does not depend on
+    // scheduling.
+
+    auto validate = [&](cell_gid_type gid, const connection_list& conns) {
+        auto num_targets = rec.num_targets(gid);
+        for (const auto& c: conns) {
             if (c.source.gid >= num_total_cells) {
-                throw arb::bad_connection_source_gid(cell.gid, c.source.gid, num_total_cells);
+                throw arb::bad_connection_source_gid(gid, c.source.gid, num_total_cells);
             }
+            auto num_sources = rec.num_sources(c.source.gid);
             if (c.source.index >= num_sources) {
-                throw arb::bad_connection_source_lid(cell.gid, c.source.index, num_sources);
+                throw arb::bad_connection_source_lid(gid, c.source.index, num_sources);
             }
-            if (c.dest.gid != cell.gid) {
-                throw arb::bad_connection_target_gid(cell.gid, c.dest.gid);
+            if (c.dest.gid != gid) {
+                throw arb::bad_connection_target_gid(gid, c.dest.gid);
             }
             if (c.dest.index >= num_targets) {
-                throw arb::bad_connection_target_lid(cell.gid, c.dest.index, num_targets);
+                throw arb::bad_connection_target_lid(gid, c.dest.index, num_targets);
             }
-            const auto src = dom_dec.gid_domain(c.source.gid);
-            src_domains.push_back(src);
-            src_counts[src]++;
         }
+    };
+
+    const cell_size_type num_chunks =
+        std::min<cell_size_type>(num_local_cells_, 4*thread_pool_->get_num_threads());
+    auto chunk_first = [&](cell_size_type k) {
+        return cell_size_type((std::size_t)num_local_cells_*k/num_chunks);
+    };
+
+    // Connections of the cells of each chunk, and the number for each cell.
+    std::vector<connection_list> chunk_connections(num_chunks);
+    std::vector<std::size_t> cell_connection_divs(num_local_cells_+1, 0);
+
+    std::mutex error_mutex;
+    cell_size_type error_index = num_local_cells_;
+    std::exception_ptr error;
+    threading::parallel_for::apply(0, num_chunks, 1, thread_pool_.get(),
+        [&](cell_size_type k) {
+            auto& buf = chunk_connections[k];
+            for (auto i: util::make_span(chunk_first(k), chunk_first(k+1))) {
+                try {
+                    auto gid = local_gids_[i];
+                    connection_list conns = rec.connections_on(gid);
+                    validate(gid, conns);
+                    cell_connection_divs[i+1] = conns.size();
+                    util::append(buf, conns);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> guard(error_mutex);
+                    if (i<error_index) {
+                        error_index = i;
+                        error = std::current_exception();
+                    }
+                    return;
+                }
+            }
+        });
+    if (error) {
+        std::rethrow_exception(error);
     }
+    std::partial_sum(cell_connection_divs.begin(), cell_connection_divs.end(), cell_connection_divs.begin());
+    const std::size_t n_cons = cell_connection_divs.back();
 
-    // Construct the connections.
-    // The loop above gave the information required to construct in place
-    // the connections as partitioned by the domain of their source gid.
+    // The source of each connection, until the connections are sorted by
+    // source and the sources are run-length encoded.
+    std::vector<cell_member_type> connection_sources(n_cons);
     connections_.resize(n_cons);
-    util::make_partition(connection_part_, src_counts);
-    auto offsets = connection_part_;
-    std::size_t pos = 0;
-    for (const auto& cell: gid_infos) {
-        for (auto c: cell.conns) {
-            const auto i = offsets[src_domains[pos]]++;
-            connections_[i] = {c.source, c.dest, c.weight, c.delay, cell.index_on_domain};
-            ++pos;
+    threading::parallel_for::apply(0, num_chunks, 1, thread_pool_.get(),
+        [&](cell_size_type k) {
+            auto c = chunk_connections[k].begin();
+            for (auto i: util::make_span(chunk_first(k), chunk_first(k+1))) {
+                for (auto pos: util::make_span(cell_connection_divs[i], cell_connection_divs[i+1])) {
+                    connection_sources[pos] = c->source;
+                    connections_.cell[pos] = i;
+                    connections_.target[pos] = c->dest.index;
+                    connections_.weight[pos] = c->weight;
+                    connections_.delay[pos] = c->delay;
+                    ++c;
+                }
+            }
+            connection_list().swap(chunk_connections[k]);
+        });
+
+    // Split the local cells into contiguous blocks with approximately equal
+    // numbers of incoming connections, one block per thread. Events for the
+    // cells in each block are generated independently in make_event_queues.
+    const cell_size_type n_blocks =
+        std::max<cell_size_type>(1, std::min<cell_size_type>(thread_pool_->get_num_threads(), num_local_cells_));
+    block_divisions_.assign(1, 0);
+    std::vector<cell_size_type> block_counts;
+    {
+        std::size_t acc = 0, last = 0;
+        for (cell_size_type i = 0; i<num_local_cells_; ++i) {
+            acc += cell_connection_divs[i+1]-cell_connection_divs[i];
+            if (block_divisions_.size()<n_blocks && acc*n_blocks>=(std::size_t)n_cons*block_divisions_.size()) {
+                block_divisions_.push_back(i+1);
+                block_counts.push_back(acc-last);
+                last = acc;
+            }
+        }
+        if (block_divisions_.back()<num_local_cells_ || block_counts.empty()) {
+            block_divisions_.push_back(num_local_cells_);
+            block_counts.push_back(acc-last);
         }
     }
 
+    // The connections are partitioned by the block of their target.
+    util::make_partition(block_connection_part_, block_counts);
+
     // Build cell partition by group for passing events to cell groups
     index_part_ = util::make_partition(index_divisions_,
         util::transform_view(
             dom_dec.groups,
             [](const group_description& g){return g.gids.size();}));
 
-    // Sort the connections for each domain.
-    // This is num_domains_ independent sorts, so it can be parallelized trivially.
-    const auto& cp = connection_part_;
-    threading::parallel_for::apply(0, num_domains_, thread_pool_.get(),
-        [&](cell_size_type i) {
-            util::sort(util::subrange_view(connections_, cp[i], cp[i+1]));
+    // Sort the connections for each block by source, and by position for
+    // connections from the same source.
+    // This is num_blocks independent sorts, so it can be parallelized trivially.
+    // The sorting permutation of each block is applied to the columns of the
+    // table in place, by following its cycles.
+    const auto& cp = block_connection_part_;
+    const cell_size_type num_blocks = block_counts.size();
+    threading::parallel_for::apply(0, num_blocks, 1, thread_pool_.get(),
+        [&](cell_size_type b) {
+            const std::size_t first = cp[b], n = cp[b+1]-cp[b];
+            std::vector<cell_size_type> perm(n);
+            std::iota(perm.begin(), perm.end(), 0);
+            util::sort(perm, [&](cell_size_type i, cell_size_type j) {
+                return std::tie(connection_sources[first+i], i)<std::tie(connection_sources[first+j], j);
+            });
+
+            auto& t = connections_;
+            for (std::size_t i = 0; i<n; ++i) {
+                if (perm[i]==i) continue;
+
+                auto src = connection_sources[first+i];
+                auto cell = t.cell[first+i];
+                auto target = t.target[first+i];
+                auto weight = t.weight[first+i];
+                auto delay = t.delay[first+i];
+
+                std::size_t j = i;
+                for (std::size_t k = perm[j]; k!=i; j = k, k = perm[j]) {
+                    connection_sources[first+j] = connection_sources[first+k];
+                    t.cell[first+j] = t.cell[first+k];
+                    t.target[first+j] = t.target[first+k];
+                    t.weight[first+j] = t.weight[first+k];
+                    t.delay[first+j] = t.delay[first+k];
+                    perm[j] = j;
+                }
+                connection_sources[first+j] = src;
+                t.cell[first+j] = cell;
+                t.target[first+j] = target;
+                t.weight[first+j] = weight;
+                t.delay[first+j] = delay;
+                perm[j] = j;
+            }
+        });
+
+    // Find the runs of connections from each source in each block, in
+    // parallel, and assign dense indices to the distinct sources in ascending
+    // order, by merging the sources of the runs of each block.
+    std::vector<std::vector<cell_member_type>> block_sources(num_blocks);
+    std::vector<std::vector<cell_size_type>> block_run_ends(num_blocks);
+    threading::parallel_for::apply(0, num_blocks, 1, thread_pool_.get(),
+        [&](cell_size_type b) {
+            auto& s = block_sources[b];
+            auto& e = block_run_ends[b];
+            for (auto i = cp[b]; i<cp[b+1]; ++i) {
+                auto src = connection_sources[i];
+                if (s.empty() || s.back()!=src) {
+                    s.push_back(src);
+                    e.push_back(i+1);
+                }
+                else {
+                    e.back() = i+1;
+                }
+            }
+        });
+    std::vector<cell_member_type>().swap(connection_sources);
+
+    std::vector<cell_size_type> block_run_counts;
+    std::vector<cell_member_type> sources;
+    for (auto& s: block_sources) {
+        block_run_counts.push_back(s.size());
+        auto mid = sources.size();
+        util::append(sources, s);
+        std::inplace_merge(sources.begin(), sources.begin()+mid, sources.end());
+        sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+    }
+    sources.shrink_to_fit();
+
+    const cell_size_type num_sources = sources.size();
+    source_domains_.resize(num_sources);
+    threading::parallel_for::apply(0, num_sources, thread_pool_.get(),
+        [&](cell_size_type i) { source_domains_[i] = dom_dec.gid_domain(sources[i].gid); });
+
+    source_index_.reserve(num_sources);
+    for (cell_size_type i = 0; i<num_sources; ++i) {
+        source_index_[sources[i]] = i;
+    }
+
+    util::make_partition(block_run_part_, block_run_counts);
+    source_runs_.resize(block_run_part_.back());
+    threading::parallel_for::apply(0, num_blocks, 1, thread_pool_.get(),
+        [&](cell_size_type b) {
+            auto s = sources.begin();
+            auto run = source_runs_.begin()+block_run_part_[b];
+            for (std::size_t r = 0; r<block_sources[b].size(); ++r, ++run) {
+                s = std::lower_bound(s, sources.end(), block_sources[b][r]);
+                *run = {cell_size_type(s-sources.begin()), block_run_ends[b][r]};
+            }
+            std::vector<cell_member_type>().swap(block_sources[b]);
+            std::vector<cell_size_type>().swap(block_run_ends[b]);
         });
+
+    last_event_counts_.assign(num_local_cells_, 0);
+    PL();
 }
 
 std::pair<cell_size_type, cell_size_type> communicator::group_queue_range(cell_size_type i) {
@@ -134,10 +285,19 @@ std::pair<cell_size_type, cell_size_type> communicator::group_queue_range(cell_s
     return index_part_[i];
 }
 
-time_type communicator::min_delay() {
+time_type communicator::min_delay(source_domain sources) {
     auto local_min = std::numeric_limits<time_type>::max();
-    for (auto& con : connections_) {
-        local_min = std::min(local_min, con.delay());
+    const int domain_id = distributed_->id();
+    cell_size_type begin = 0;
+    for (const auto& run: source_runs_) {
+        if (sources==source_domain::any ||
+            (source_domains_[run.source]==domain_id)==(sources==source_domain::local))
+        {
+            for (auto c = begin; c<run.end; ++c) {
+                local_min = std::min(local_min, connections_.delay_of(c));
+            }
+        }
+        begin = run.end;
     }
 
     return distributed_->min(local_min);
@@ -145,77 +305,259 @@ time_type communicator::min_delay() {
 
 gathered_vector<spike> communicator::exchange(std::vector<spike> local_spikes) {
     PE(communication_exchange_sort);
-    // sort the spikes in ascending order of source gid
-    util::sort_by(local_spikes, [](spike s){return s.source;});
+    // sort the spikes in ascending order of source gid, and by time for each
+    // source, so that the events generated from each source's spikes are
+    // in time order.
+    util::sort(local_spikes, [](const spike& a, const spike& b) {
+        return std::tie(a.source, a.time)<std::tie(b.source, b.time);
+    });
     PL();
 
+    if (sparse_exchange_) {
+        // Pack the spikes for each destination domain, preserving their order.
+        PE(communication_exchange_pack);
+        std::vector<unsigned> send_partition, counts(num_domains_);
+        for (const auto& spk: local_spikes) {
+            if (auto d = util::ptr_by_key(spike_destinations_, spk.source.gid)) {
+                for (auto dom: *d) ++counts[dom];
+            }
+        }
+        util::make_partition(send_partition, counts);
+
+        std::vector<spike> send(send_partition.back());
+        std::vector<unsigned> pos(send_partition.begin(), send_partition.end()-1);
+        for (const auto& spk: local_spikes) {
+            if (auto d = util::ptr_by_key(spike_destinations_, spk.source.gid)) {
+                for (auto dom: *d) send[pos[dom]++] = spk;
+            }
+        }
+        PL();
+
+        PE(communication_exchange_alltoall);
+        auto global_spikes = distributed_->alltoall_spikes(send, send_partition);
+        const auto domain_id = distributed_->id();
+        num_local_spikes_ += local_spikes.size();
+        num_bytes_sent_ += (send.size()-counts[domain_id])*sizeof(spike);
+        num_bytes_received_ += (global_spikes.size()-global_spikes.count(domain_id))*sizeof(spike);
+        PL();
+
+        return global_spikes;
+    }
+
+    if (compact_encoding_) {
+        PE(communication_exchange_encode);
+        std::vector<char> local_encoded;
+        encode_spikes(local_spikes, spike_time_quantum_, local_encoded);
+        PL();
+
+        PE(communication_exchange_gather);
+        auto global_encoded = distributed_->gather_encoded_spikes(local_encoded);
+        num_bytes_sent_ += local_encoded.size()*(num_domains_-1);
+        num_bytes_received_ += global_encoded.size()-local_encoded.size();
+        PL();
+
+        PE(communication_exchange_decode);
+        auto global_spikes = decode_gathered_spikes(global_encoded);
+        num_spikes_ += global_spikes.size();
+        PL();
+
+        return global_spikes;
+    }
+
     PE(communication_exchange_gather);
     // global all-to-all to gather a local copy of the global spike list on each node.
     auto global_spikes = distributed_->gather_spikes(local_spikes);
     num_spikes_ += global_spikes.size();
+    num_bytes_sent_ += local_spikes.size()*(num_domains_-1)*sizeof(spike);
+    num_bytes_received_ += (global_spikes.size()-local_spikes.size())*sizeof(spike);
     PL();
 
     return global_spikes;
 }
 
+void communicator::set_sparse_exchange(bool sparse) {
+    sparse_exchange_ = sparse;
+    if (!sparse || has_spike_destinations_) return;
+
+    // Send to each domain the gids of its cells that are sources of local
+    // connections, and receive the gids of local cells required by each domain.
+    std::vector<std::pair<int, cell_gid_type>> required;
+    required.reserve(source_index_.size());
+    for (const auto& entry: source_index_) {
+        required.emplace_back(source_domains_[entry.second], entry.first.gid);
+    }
+    util::sort(required);
+    required.erase(std::unique(required.begin(), required.end()), required.end());
+
+    std::vector<cell_gid_type> send;
+    std::vector<unsigned> send_partition, counts(num_domains_);
+    send.reserve(required.size());
+    for (const auto& r: required) {
+        send.push_back(r.second);
+        ++counts[r.first];
+    }
+    util::make_partition(send_partition, counts);
+
+    auto received = distributed_->alltoall_gids(send, send_partition);
+    const auto& part = received.partition();
+    for (unsigned dom = 0; dom<num_domains_; ++dom) {
+        for (auto i = part[dom]; i<part[dom+1]; ++i) {
+            spike_destinations_[received.values()[i]].push_back(dom);
+        }
+    }
+    has_spike_destinations_ = true;
+}
+
+void communicator::set_compact_encoding(bool compact, time_type quantum) {
+    compact_encoding_ = compact;
+    spike_time_quantum_ = quantum;
+}
+
+void communicator::update_num_spikes() {
+    if (!sparse_exchange_) return;
+    num_spikes_ += distributed_->sum(num_local_spikes_);
+    num_local_spikes_ = 0;
+}
+
 void communicator::make_event_queues(
         const gathered_vector<spike>& global_spikes,
+        std::vector<pse_vector>& queues,
+        source_domain sources)
+{
+    generate_events(global_spikes.values(), queues, sources);
+}
+
+void communicator::make_local_event_queues(
+        std::vector<spike> local_spikes,
         std::vector<pse_vector>& queues)
+{
+    // Order as exchange(), so that the events from each source are in time order.
+    util::sort(local_spikes, [](const spike& a, const spike& b) {
+        return std::tie(a.source, a.time)<std::tie(b.source, b.time);
+    });
+    generate_events(local_spikes, queues, source_domain::local);
+}
+
+void communicator::generate_events(
+        const std::vector<spike>& spikes,
+        std::vector<pse_vector>& queues,
+        source_domain sources)
 {
     arb_assert(queues.size()==num_local_cells_);
 
-    using util::subrange_view;
-    using util::make_span;
-    using util::make_range;
-
-    const auto& sp = global_spikes.partition();
-    const auto& cp = connection_part_;
-    for (auto dom: make_span(num_domains_)) {
-        auto cons = subrange_view(connections_, cp[dom], cp[dom+1]);
-        auto spks = subrange_view(global_spikes.values(), sp[dom], sp[dom+1]);
-
-        struct spike_pred {
-            bool operator()(const spike& spk, const cell_member_type& src)
-                {return spk.source<src;}
-            bool operator()(const cell_member_type& src, const spike& spk)
-                {return src<spk.source;}
-        };
-
-        // We have a choice of whether to walk spikes or connections:
-        // i.e., we can iterate over the spikes, and for each spike search
-        // the for connections that have the same source; or alternatively
-        // for each connection, we can search the list of spikes for spikes
-        // with the same source.
-        //
-        // We iterate over whichever set is the smallest, which has
-        // complexity of order max(S log(C), C log(S)), where S is the
-        // number of spikes, and C is the number of connections.
-        if (cons.size()<spks.size()) {
-            auto sp = spks.begin();
-            auto cn = cons.begin();
-            while (cn!=cons.end() && sp!=spks.end()) {
-                auto sources = std::equal_range(sp, spks.end(), cn->source(), spike_pred());
-                for (auto s: make_range(sources)) {
-                    queues[cn->index_on_domain()].push_back(cn->make_event(s));
-                }
+    const cell_size_type n_spikes = spikes.size();
+    constexpr cell_size_type no_source = -1;
 
-                sp = sources.first;
-                ++cn;
+    // Map each spike to the dense index of its source, with one hash lookup
+    // per spike; spikes from sources with no local connections, or not in
+    // the requested class, are marked.
+    const int domain_id = distributed_->id();
+    spike_source_indices_.resize(n_spikes);
+    threading::parallel_for::apply(0, n_spikes, thread_pool_.get(),
+        [&](cell_size_type i) {
+            auto it = source_index_.find(spikes[i].source);
+            auto s = it==source_index_.end()? no_source: it->second;
+            if (s!=no_source && sources!=source_domain::any &&
+                (source_domains_[s]==domain_id)!=(sources==source_domain::local))
+            {
+                s = no_source;
             }
+            spike_source_indices_[i] = s;
+        });
+
+    // Bucket the times of the spikes from the sources of local connections by
+    // the dense index of their source. The spikes of each source are in time
+    // order, which the stable sort preserves.
+    spike_buckets_.clear();
+    for (cell_size_type k = 0; k<n_spikes; ++k) {
+        if (auto s = spike_source_indices_[k]; s!=no_source) {
+            spike_buckets_.emplace_back(s, spikes[k].time);
+        }
+    }
+    std::stable_sort(spike_buckets_.begin(), spike_buckets_.end(),
+        [](const auto& a, const auto& b) { return a.first<b.first; });
+
+    bucket_sources_.clear();
+    bucket_divisions_.assign(1, 0);
+    for (std::size_t k = 0; k<spike_buckets_.size(); ++k) {
+        if (bucket_sources_.empty() || bucket_sources_.back()!=spike_buckets_[k].first) {
+            if (k) bucket_divisions_.push_back(k);
+            bucket_sources_.push_back(spike_buckets_[k].first);
         }
-        else {
-            auto cn = cons.begin();
-            auto sp = spks.begin();
-            while (cn!=cons.end() && sp!=spks.end()) {
-                auto targets = std::equal_range(cn, cons.end(), sp->source);
-                for (auto c: make_range(targets)) {
-                    queues[c.index_on_domain()].push_back(c.make_event(*sp));
+    }
+    if (!spike_buckets_.empty()) bucket_divisions_.push_back(spike_buckets_.size());
+
+    // Generate the events for each block of target cells in parallel. Each
+    // block writes only to the queues of its own cells, which are first grown
+    // by the number of events they received in the previous call.
+    //
+    // The runs of a block and the buckets are both sorted by source index:
+    // they are matched by searching each list for the current entry of the
+    // other, so that the cost for a block is bounded by the length of the
+    // shorter list, times the logarithm of the length of the longer.
+    //
+    // The loop over the connections from each source is instantiated for each
+    // storage of weights and delays, so that it reads the columns of the
+    // table without branches.
+    const cell_size_type n_blocks = block_run_part_.empty()? 0: block_run_part_.size()-1;
+    const auto& t = connections_;
+
+    auto generate = [&](auto weight_of, auto delay_of) {
+        threading::parallel_for::apply(0, n_blocks, 1, thread_pool_.get(),
+            [&](cell_size_type b) {
+                const auto cells = util::make_span(block_divisions_[b], block_divisions_[b+1]);
+
+                for (auto i: cells) {
+                    queues[i].reserve(queues[i].size()+last_event_counts_[i]);
+                    last_event_counts_[i] = queues[i].size();
                 }
 
-                cn = targets.first;
-                ++sp;
-            }
-        }
+                auto by_source = [](const source_run& r, cell_size_type s) { return r.source<s; };
+                auto run = source_runs_.begin()+block_run_part_[b];
+                auto run_end = source_runs_.begin()+block_run_part_[b+1];
+                auto bucket = bucket_sources_.begin();
+                auto bucket_end = bucket_sources_.end();
+
+                while (run!=run_end && bucket!=bucket_end) {
+                    if (run->source<*bucket) {
+                        run = std::lower_bound(run, run_end, *bucket, by_source);
+                    }
+                    else if (*bucket<run->source) {
+                        bucket = std::lower_bound(bucket, bucket_end, run->source);
+                    }
+                    else {
+                        const cell_size_type begin = run==source_runs_.begin()? 0: (run-1)->end;
+                        const auto k = bucket-bucket_sources_.begin();
+                        for (auto j = bucket_divisions_[k]; j<bucket_divisions_[k+1]; ++j) {
+                            const time_type time = spike_buckets_[j].second;
+                            for (auto c = begin; c<run->end; ++c) {
+                                auto i = t.cell[c];
+                                queues[i].push_back({{local_gids_[i], t.target[c]}, time+delay_of(c), weight_of(c)});
+                            }
+                        }
+                        ++run;
+                        ++bucket;
+                    }
+                }
+
+                for (auto i: cells) {
+                    last_event_counts_[i] = queues[i].size()-last_event_counts_[i];
+                }
+            });
+    };
+
+    auto exact_weight = [&t](std::size_t c) { return t.weight[c]; };
+    auto coded_weight = [&t](std::size_t c) { return t.weight_codebook[t.weight_code[c]]; };
+    auto exact_delay = [&t](std::size_t c) { return time_type(t.delay[c]); };
+    auto coded_delay = [&t](std::size_t c) { return t.delay_steps[c]*t.delay_quantum; };
+
+    if (t.quantized_weights()) {
+        if (t.quantized_delays()) generate(coded_weight, coded_delay);
+        else generate(coded_weight, exact_delay);
+    }
+    else {
+        if (t.quantized_delays()) generate(exact_weight, coded_delay);
+        else generate(exact_weight, exact_delay);
     }
 }
 
@@ -223,16 +565,32 @@ std::uint64_t communicator::num_spikes() const {
     return num_spikes_;
 }
 
+void communicator::set_num_spikes(std::uint64_t n) {
+    num_spikes_ = n;
+    num_local_spikes_ = 0;
+}
+
 cell_size_type communicator::num_local_cells() const {
     return num_local_cells_;
 }
 
-const std::vector<connection>& communicator::connections() const {
-    return connections_;
+std::size_t communicator::num_connections() const {
+    return connections_.size();
+}
+
+void communicator::quantize_connection_weights() {
+    connections_.quantize_weights();
+}
+
+void communicator::quantize_connection_delays(time_type delay_quantum) {
+    connections_.quantize_delays(delay_quantum);
 }
 
 void communicator::reset() {
     num_spikes_ = 0;
+    num_local_spikes_ = 0;
+    num_bytes_sent_ = 0;
+    num_bytes_received_ = 0;
 }
 
 } // namespace arb
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <arbor/common_types.hpp>
@@ -25,6 +28,15 @@ namespace arb {
 // to build the data structures required for efficient spike communication and
 // event generation.
 
+// Connections are classed by the domain of their source. The events from
+// spikes of sources on the local domain can be generated without a spike
+// exchange.
+enum class source_domain {
+    any,    // => sources on any domain.
+    local,  // => sources on this domain.
+    remote, // => sources on other domains.
+};
+
 class communicator {
 public:
     communicator() {}
@@ -36,33 +48,81 @@ public:
     /// The range of event queues that belong to cells in group i.
     std::pair<cell_size_type, cell_size_type> group_queue_range(cell_size_type i);
 
-    /// The minimum delay of all connections in the global network.
-    time_type min_delay();
+    /// The minimum delay of all connections in the global network, or of those
+    /// connections whose source is in the given class relative to the domain
+    /// of their target.
+    time_type min_delay(source_domain sources = source_domain::any);
 
     /// Perform exchange of spikes.
     ///
     /// Takes as input the list of local_spikes that were generated on the calling domain.
-    /// Returns the full global set of vectors, along with meta data about their partition
+    /// Returns the full global set of vectors, along with meta data about their partition.
+    /// With sparse exchange, only the spikes from sources with connections to
+    /// cells on the calling domain are returned.
     gathered_vector<spike> exchange(std::vector<spike> local_spikes);
 
+    /// Select between the all-gather of spikes and sparse exchange, where
+    /// each spike is sent only to the domains with connections from its
+    /// source. The destinations of the local spikes are determined on first
+    /// use of sparse exchange, so this is a collective operation.
+    void set_sparse_exchange(bool sparse);
+
+    /// Send spikes in the all-gather in the compact encoding of encode_spikes,
+    /// with spike times rounded to multiples of quantum if it is positive.
+    void set_compact_encoding(bool compact, time_type quantum = 0);
+
+    /// With sparse exchange, the global number of spikes is not known after
+    /// each exchange: bring num_spikes() up to date. A collective operation.
+    void update_num_spikes();
+
     /// Check each global spike in turn to see it generates local events.
     /// If so, make the events and insert them into the appropriate event list.
     ///
+    /// Spikes are mapped to the dense index of their source by a hash lookup,
+    /// and bucketed by source. Events are generated in parallel over blocks of
+    /// local cells, by matching the buckets against the runs of connections
+    /// from each source in the block.
+    ///
     /// Takes reference to a vector of event lists as an argument, with one list
     /// for each local cell group. On completion, the events in each list are
     /// all events that must be delivered to targets in that cell group as a
     /// result of the global spike exchange, plus any events that were already
     /// in the list.
+    ///
+    /// Only the spikes from sources in the given class are considered.
     void make_event_queues(
             const gathered_vector<spike>& global_spikes,
+            std::vector<pse_vector>& queues,
+            source_domain sources = source_domain::any);
+
+    /// Make the events generated by spikes from sources on the local domain,
+    /// without spike exchange, as make_event_queues.
+    void make_local_event_queues(
+            std::vector<spike> local_spikes,
             std::vector<pse_vector>& queues);
 
     /// Returns the total number of global spikes over the duration of the simulation
     std::uint64_t num_spikes() const;
 
+    /// Set the number of spikes, e.g. on restoring a checkpoint.
+    void set_num_spikes(std::uint64_t n);
+
+    /// The volume of spike data sent to and received from other domains in exchanges.
+    std::uint64_t num_bytes_sent() const { return num_bytes_sent_; }
+    std::uint64_t num_bytes_received() const { return num_bytes_received_; }
+
     cell_size_type num_local_cells() const;
 
-    const std::vector<connection>& connections() const;
+    /// The number of connections to local cells.
+    std::size_t num_connections() const;
+
+    /// Store connection weights as 16-bit codes into a codebook of the
+    /// distinct weights. See connection_table::quantize_weights.
+    void quantize_connection_weights();
+
+    /// Store connection delays as 16-bit multiples of delay_quantum, rounded
+    /// up. See connection_table::quantize_delays.
+    void quantize_connection_delays(time_type delay_quantum);
 
     void reset();
 
@@ -70,14 +130,68 @@ private:
     cell_size_type num_local_cells_;
     cell_size_type num_local_groups_;
     cell_size_type num_domains_;
-    std::vector<connection> connections_;
-    std::vector<cell_size_type> connection_part_;
+
+    // Gid of each local cell, by local index.
+    std::vector<cell_gid_type> local_gids_;
+
+    // Connections are partitioned into blocks by the local index of their
+    // target cell, and sorted by source within each block.
+    connection_table connections_;
+    std::vector<cell_size_type> block_divisions_;       // partition of local cells by block
+    std::vector<cell_size_type> block_connection_part_; // partition of connections_ by block
+
+    // Dense index of each distinct source of a local connection, in
+    // ascending order of source.
+    std::unordered_map<cell_member_type, cell_size_type> source_index_;
+
+    // The connections from each source within a block form a run, which ends
+    // at index end of connections_ and starts at the end of the previous run.
+    // The runs of each block are in ascending order of source index, so that
+    // a block holds entries only for the sources of its connections.
+    struct source_run {
+        cell_size_type source;
+        cell_size_type end;
+    };
+    std::vector<source_run> source_runs_;
+    std::vector<cell_size_type> block_run_part_; // partition of source_runs_ by block
+
+    // The domain of each source, by dense index.
+    std::vector<int> source_domains_;
+
+    // For sparse exchange, the domains with connections from each local
+    // source cell, in ascending order.
+    bool sparse_exchange_ = false;
+    bool has_spike_destinations_ = false;
+    std::unordered_map<cell_gid_type, std::vector<unsigned>> spike_destinations_;
+
+    // Compact encoding of spikes in the all-gather.
+    bool compact_encoding_ = false;
+    time_type spike_time_quantum_ = 0;
+
+    // Scratch space for make_event_queues: the dense source index of each
+    // global spike; the source index and time of the spikes from sources of
+    // local connections, sorted by source, with the distinct sources and the
+    // partition of the spikes by source; and the number of events generated
+    // for each local cell.
+    std::vector<cell_size_type> spike_source_indices_;
+    std::vector<std::pair<cell_size_type, time_type>> spike_buckets_;
+    std::vector<cell_size_type> bucket_sources_;
+    std::vector<cell_size_type> bucket_divisions_;
+    std::vector<cell_size_type> last_event_counts_;
     std::vector<cell_size_type> index_divisions_;
     util::partition_view_type<std::vector<cell_size_type>> index_part_;
 
+    void generate_events(
+            const std::vector<spike>& spikes,
+            std::vector<pse_vector>& queues,
+            source_domain sources);
+
     distributed_context_handle distributed_;
     task_system_handle thread_pool_;
     std::uint64_t num_spikes_ = 0u;
+    std::uint64_t num_local_spikes_ = 0u; // Not yet counted in num_spikes_.
+    std::uint64_t num_bytes_sent_ = 0u;
+    std::uint64_t num_bytes_received_ = 0u;
 };
 
 } // namespace arb
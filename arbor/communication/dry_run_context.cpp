@@ -4,6 +4,7 @@
 
 #include <arbor/spike.hpp>
 
+#include <communication/spike_codec.hpp>
 #include <distributed_context.hpp>
 #include <threading/threading.hpp>
 
@@ -68,6 +69,65 @@ struct dry_run_context_impl {
         return gathered_vector<cell_gid_type>(std::move(gathered_gids), std::move(partition));
     }
 
+    // The spikes of domain i are those of this domain translated by i
+    // tiles, encoded with the same time quantum.
+    gathered_vector<char>
+    gather_encoded_spikes(const std::vector<char>& local_spikes) const {
+        using count_type = typename gathered_vector<char>::count_type;
+
+        std::vector<arb::spike> spikes;
+        decode_spikes(local_spikes.data(), local_spikes.data()+local_spikes.size(), spikes);
+        const auto quantum = local_spikes.empty()? time_type(0): encoded_spike_quantum(local_spikes.data());
+
+        std::vector<char> gathered;
+        std::vector<count_type> partition = {0};
+        for (count_type i = 0; i < num_ranks_; i++) {
+            auto translated = spikes;
+            for (auto& s: translated) {
+                s.source.gid += num_cells_per_tile_*i;
+            }
+            encode_spikes(translated, quantum, gathered);
+            partition.push_back(gathered.size());
+        }
+
+        return gathered_vector<char>(std::move(gathered), std::move(partition));
+    }
+
+    // Domain i sends to this domain what this domain sends to domain -i,
+    // translated by i tiles.
+    template <typename T, typename Translate>
+    gathered_vector<T> alltoall(const std::vector<T>& send, const std::vector<unsigned>& send_partition, Translate translate) const {
+        using count_type = typename gathered_vector<T>::count_type;
+
+        std::vector<T> received;
+        std::vector<count_type> partition = {0};
+        for (count_type i = 0; i < num_ranks_; i++) {
+            auto j = (num_ranks_-i)%num_ranks_;
+            for (auto k = send_partition[j]; k < send_partition[j+1]; k++) {
+                received.push_back(translate(send[k], i));
+            }
+            partition.push_back(received.size());
+        }
+
+        return gathered_vector<T>(std::move(received), std::move(partition));
+    }
+
+    cell_gid_type translate_gid(cell_gid_type gid, unsigned tiles) const {
+        return (gid + num_cells_per_tile_*tiles) % (num_cells_per_tile_*num_ranks_);
+    }
+
+    gathered_vector<arb::spike>
+    alltoall_spikes(const std::vector<arb::spike>& send, const std::vector<unsigned>& send_partition) const {
+        return alltoall(send, send_partition,
+            [this](arb::spike s, unsigned tiles) { s.source.gid = translate_gid(s.source.gid, tiles); return s; });
+    }
+
+    gathered_vector<cell_gid_type>
+    alltoall_gids(const std::vector<cell_gid_type>& send, const std::vector<unsigned>& send_partition) const {
+        return alltoall(send, send_partition,
+            [this](cell_gid_type gid, unsigned tiles) { return translate_gid(gid, tiles); });
+    }
+
     int id() const { return 0; }
 
     int size() const { return num_ranks_; }
@@ -180,6 +180,48 @@ gathered_vector<T> gather_all_with_partition(const std::vector<T>& values, MPI_C
     );
 }
 
+/// Send partition i of values to rank i, returning the received values
+/// along with their partition by sending rank.
+template <typename T>
+gathered_vector<T> alltoall_with_partition(const std::vector<T>& values, const std::vector<unsigned>& partition, MPI_Comm comm) {
+    using gathered_type = gathered_vector<T>;
+    using count_type = typename gathered_vector<T>::count_type;
+    using traits = mpi_traits<T>;
+
+    const int nranks = size(comm);
+    arb_assert(partition.size()==unsigned(nranks+1));
+
+    // As for gather_all_with_partition, counts and displacements are int.
+    std::vector<int> send_counts(nranks), send_displs(nranks);
+    for (int i=0; i<nranks; ++i) {
+        send_counts[i] = (partition[i+1]-partition[i])*traits::count();
+        send_displs[i] = partition[i]*traits::count();
+    }
+
+    std::vector<int> recv_counts(nranks), recv_displs;
+    MPI_OR_THROW(MPI_Alltoall,
+            send_counts.data(), 1, MPI_INT, // send buffer
+            recv_counts.data(), 1, MPI_INT, // receive buffer
+            comm);
+    util::make_partition(recv_displs, recv_counts);
+
+    std::vector<T> buffer(recv_displs.back()/traits::count());
+    MPI_OR_THROW(MPI_Alltoallv,
+            // const_cast required for MPI implementations that don't use const* in their interfaces
+            const_cast<T*>(values.data()), send_counts.data(), send_displs.data(), traits::mpi_type(), // send buffer
+            buffer.data(), recv_counts.data(), recv_displs.data(), traits::mpi_type(), // receive buffer
+            comm);
+
+    for (auto& d : recv_displs) {
+        d /= traits::count();
+    }
+
+    return gathered_type(
+        std::move(buffer),
+        std::vector<count_type>(recv_displs.begin(), recv_displs.end())
+    );
+}
+
 template <typename T>
 T reduce(T value, MPI_Op op, int root, MPI_Comm comm) {
     using traits = mpi_traits<T>;
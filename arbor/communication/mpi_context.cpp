@@ -38,6 +38,21 @@ struct mpi_context_impl {
         return mpi::gather_all_with_partition(local_gids, comm_);
     }
 
+    gathered_vector<char>
+    gather_encoded_spikes(const std::vector<char>& local_spikes) const {
+        return mpi::gather_all_with_partition(local_spikes, comm_);
+    }
+
+    gathered_vector<arb::spike>
+    alltoall_spikes(const std::vector<arb::spike>& send, const std::vector<unsigned>& send_partition) const {
+        return mpi::alltoall_with_partition(send, send_partition, comm_);
+    }
+
+    gathered_vector<cell_gid_type>
+    alltoall_gids(const std::vector<cell_gid_type>& send, const std::vector<unsigned>& send_partition) const {
+        return mpi::alltoall_with_partition(send, send_partition, comm_);
+    }
+
     std::string name() const { return "MPI"; }
     int id() const { return rank_; }
     int size() const { return size_; }
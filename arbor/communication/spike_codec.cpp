@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <arbor/assert.hpp>
+#include <arbor/common_types.hpp>
+#include <arbor/spike.hpp>
+
+#include "communication/gathered_vector.hpp"
+#include "communication/spike_codec.hpp"
+
+namespace arb {
+
+namespace {
+
+struct encoding_header {
+    std::uint32_t count;
+    std::uint8_t time_width; // Bytes per spike time: 2, 4 or 8 (unquantised).
+    time_type base;
+    time_type quantum;
+};
+
+constexpr std::size_t header_size =
+    sizeof(std::uint32_t)+sizeof(std::uint8_t)+2*sizeof(time_type);
+
+template <typename T>
+void put(std::vector<char>& buf, T value) {
+    auto n = buf.size();
+    buf.resize(n+sizeof(T));
+    std::memcpy(buf.data()+n, &value, sizeof(T));
+}
+
+template <typename T>
+T get(const char*& p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+void put_varint(std::vector<char>& buf, std::uint32_t value) {
+    while (value>=0x80) {
+        buf.push_back(char((value&0x7f)|0x80));
+        value >>= 7;
+    }
+    buf.push_back(char(value));
+}
+
+std::uint32_t get_varint(const char*& p) {
+    std::uint32_t value = 0;
+    for (unsigned shift = 0; ; shift += 7) {
+        auto byte = static_cast<unsigned char>(*p++);
+        value |= std::uint32_t(byte&0x7f)<<shift;
+        if (!(byte&0x80)) return value;
+    }
+}
+
+encoding_header read_header(const char*& p) {
+    encoding_header h;
+    h.count = get<std::uint32_t>(p);
+    h.time_width = get<std::uint8_t>(p);
+    h.base = get<time_type>(p);
+    h.quantum = get<time_type>(p);
+    return h;
+}
+
+} // anonymous namespace
+
+void encode_spikes(const std::vector<spike>& spikes, time_type quantum, std::vector<char>& buf) {
+    if (spikes.empty()) return;
+
+    time_type t_min = spikes.front().time, t_max = t_min;
+    for (const auto& s: spikes) {
+        t_min = std::min(t_min, s.time);
+        t_max = std::max(t_max, s.time);
+    }
+
+    std::uint8_t width = 8;
+    if (quantum>0) {
+        auto span = std::round((t_max-t_min)/quantum);
+        if (span<=UINT16_MAX) width = 2;
+        else if (span<=UINT32_MAX) width = 4;
+    }
+
+    buf.reserve(buf.size()+header_size+spikes.size()*(width+2));
+    put(buf, std::uint32_t(spikes.size()));
+    put(buf, width);
+    put(buf, t_min);
+    put(buf, width==8? time_type(0): quantum);
+
+    cell_gid_type gid = 0;
+    for (const auto& s: spikes) {
+        arb_assert(s.source.gid>=gid);
+        put_varint(buf, s.source.gid-gid);
+        put_varint(buf, s.source.index);
+        gid = s.source.gid;
+
+        switch (width) {
+        case 2:
+            put(buf, std::uint16_t(std::round((s.time-t_min)/quantum)));
+            break;
+        case 4:
+            put(buf, std::uint32_t(std::round((s.time-t_min)/quantum)));
+            break;
+        default:
+            put(buf, s.time);
+        }
+    }
+}
+
+void decode_spikes(const char* begin, const char* end, std::vector<spike>& out) {
+    const char* p = begin;
+    while (p!=end) {
+        auto h = read_header(p);
+        out.reserve(out.size()+h.count);
+
+        cell_gid_type gid = 0;
+        for (std::uint32_t i = 0; i<h.count; ++i) {
+            spike s;
+            gid += get_varint(p);
+            s.source.gid = gid;
+            s.source.index = get_varint(p);
+
+            switch (h.time_width) {
+            case 2:
+                s.time = h.base+get<std::uint16_t>(p)*h.quantum;
+                break;
+            case 4:
+                s.time = h.base+get<std::uint32_t>(p)*h.quantum;
+                break;
+            default:
+                s.time = get<time_type>(p);
+            }
+            out.push_back(s);
+        }
+        arb_assert(p<=end);
+    }
+}
+
+time_type encoded_spike_quantum(const char* begin) {
+    return read_header(begin).quantum;
+}
+
+gathered_vector<spike> decode_gathered_spikes(const gathered_vector<char>& encoded) {
+    using count_type = gathered_vector<spike>::count_type;
+
+    const auto& part = encoded.partition();
+    const char* data = encoded.values().data();
+
+    std::vector<spike> spikes;
+    std::vector<count_type> partition = {0};
+    for (std::size_t i = 0; i+1<part.size(); ++i) {
+        decode_spikes(data+part[i], data+part[i+1], spikes);
+        partition.push_back(spikes.size());
+    }
+
+    return gathered_vector<spike>(std::move(spikes), std::move(partition));
+}
+
+} // namespace arb
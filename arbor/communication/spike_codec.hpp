@@ -0,0 +1,40 @@
+#pragma once
+
+// Compact encoding of spikes for exchange between domains.
+//
+// An encoding comprises a header with the number of spikes, the time base
+// and the time quantum, followed by one record per spike:
+//   * the difference between the source gid and that of the previous spike,
+//     as a variable length unsigned integer (7 bits per byte);
+//   * the source index, as a variable length unsigned integer;
+//   * the spike time, as a 16 or 32 bit multiple of the quantum relative to
+//     the time base, or as a double if the quantum is zero or the times span
+//     too many quanta for 32 bits.
+//
+// The time base is the earliest spike time, so that quantised times are
+// never earlier than the first spike of the encoded set, and spike times
+// are rounded to the nearest multiple of the quantum from the base.
+// Encodings can be concatenated; decode_spikes decodes each in turn.
+
+#include <vector>
+
+#include <arbor/common_types.hpp>
+#include <arbor/spike.hpp>
+
+#include "communication/gathered_vector.hpp"
+
+namespace arb {
+
+// Append the encoding of spikes to buf. The spikes must be sorted by source.
+void encode_spikes(const std::vector<spike>& spikes, time_type quantum, std::vector<char>& buf);
+
+// Append the spikes of the encodings in [begin, end) to out.
+void decode_spikes(const char* begin, const char* end, std::vector<spike>& out);
+
+// The time quantum of the encoding that starts at begin.
+time_type encoded_spike_quantum(const char* begin);
+
+// Decode each partition of gathered encodings, preserving the partition by domain.
+gathered_vector<spike> decode_gathered_spikes(const gathered_vector<char>& encoded);
+
+} // namespace arb
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <arbor/arbexcept.hpp>
+#include <arbor/common_types.hpp>
+
+#include "connection.hpp"
+#include "util/rangeutil.hpp"
+
+namespace arb {
+
+void connection_table::resize(std::size_t n) {
+    cell.resize(n);
+    target.resize(n);
+    weight.resize(n);
+    delay.resize(n);
+}
+
+namespace {
+constexpr std::size_t max_codes = std::numeric_limits<std::uint16_t>::max()+std::size_t(1);
+}
+
+void connection_table::quantize_weights() {
+    if (quantized_weights()) return;
+
+    const std::size_t n = size();
+    auto values = weight;
+    util::sort(values);
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    if (values.size()>max_codes) {
+        throw arbor_exception("cannot quantize "+std::to_string(values.size())
+            +" distinct connection weights: at most "+std::to_string(max_codes)+" can be coded");
+    }
+
+    weight_code.resize(n);
+    for (std::size_t i = 0; i<n; ++i) {
+        weight_code[i] = std::lower_bound(values.begin(), values.end(), weight[i])-values.begin();
+    }
+    weight_codebook = std::move(values);
+    weight_codebook.shrink_to_fit();
+    std::vector<float>().swap(weight);
+}
+
+void connection_table::quantize_delays(time_type quantum) {
+    const std::size_t n = size();
+
+    if (!(quantum>0)) {
+        throw arbor_exception("connection delay quantum must be positive");
+    }
+
+    // Delays are checked before any change is made to the table.
+    std::vector<std::uint16_t> steps(n);
+    for (std::size_t i = 0; i<n; ++i) {
+        // Round up, so that no delay is reduced below the minimum delay
+        // of the network.
+        const time_type d = delay_of(i);
+        double k = std::ceil(d/quantum);
+        if (k>0 && (k-1)*quantum>=d) --k;
+        if (k*quantum<d) ++k;
+        if (!(k<max_codes)) {
+            throw arbor_exception("connection delay "+std::to_string(d)
+                +" ms is too large to quantize with delay quantum "+std::to_string(quantum)+" ms");
+        }
+        steps[i] = k;
+    }
+
+    delay_steps = std::move(steps);
+    delay_quantum = quantum;
+    std::vector<float>().swap(delay);
+}
+
+std::size_t connection_table::memory() const {
+    return cell.capacity()*sizeof(cell_size_type)
+        + target.capacity()*sizeof(cell_lid_type)
+        + (weight.capacity()+delay.capacity()+weight_codebook.capacity())*sizeof(float)
+        + (weight_code.capacity()+delay_steps.capacity())*sizeof(std::uint16_t);
+}
+
+} // namespace arb
@@ -1,66 +1,65 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
 #include <arbor/common_types.hpp>
-#include <arbor/spike.hpp>
 
 namespace arb {
 
-class connection {
-public:
-    connection() = default;
-    connection( cell_member_type src,
-                cell_member_type dest,
-                float w,
-                float d,
-                cell_gid_type didx=cell_gid_type(-1)):
-        source_(src),
-        destination_(dest),
-        weight_(w),
-        delay_(d),
-        index_on_domain_(didx)
-    {}
+// The connections to the cells of a domain, stored as one array per field.
+//
+// The source of each connection is not stored: the communicator sorts the
+// connections by source, and records the run of connections from each source.
+//
+// Weights and delays are stored as floats, or after quantize_weights() and
+// quantize_delays(), as 16-bit codes: weights as indices into a codebook, and
+// delays as multiples of a delay quantum.
+struct connection_table {
+    std::vector<cell_size_type> cell;   // Local index of the target cell.
+    std::vector<cell_lid_type> target;  // Index of the target on its cell.
 
-    float weight() const { return weight_; }
-    time_type delay() const { return delay_; }
+    std::vector<float> weight;          // Empty if quantized.
+    std::vector<float> delay;           // Empty if delays are quantized.
 
-    cell_member_type source() const { return source_; }
-    cell_member_type destination() const { return destination_; }
-    cell_size_type index_on_domain() const { return index_on_domain_; }
+    std::vector<std::uint16_t> weight_code;
+    std::vector<float> weight_codebook;
+    std::vector<std::uint16_t> delay_steps;
+    time_type delay_quantum = 0;
 
-    spike_event make_event(const spike& s) {
-        return {destination_, s.time + delay_, weight_};
+    std::size_t size() const { return cell.size(); }
+
+    bool quantized_weights() const { return !weight_codebook.empty(); }
+    bool quantized_delays() const { return delay_quantum>0; }
+
+    float weight_of(std::size_t i) const {
+        return quantized_weights()? weight_codebook[weight_code[i]]: weight[i];
     }
 
-private:
-    cell_member_type source_;
-    cell_member_type destination_;
-    float weight_;
-    float delay_;
-    cell_size_type index_on_domain_;
-};
+    time_type delay_of(std::size_t i) const {
+        return quantized_delays()? delay_steps[i]*delay_quantum: delay[i];
+    }
 
-// connections are sorted by source id
-// these operators make for easy interopability with STL algorithms
+    void resize(std::size_t n);
 
-static inline bool operator<(const connection& lhs, const connection& rhs) {
-    return lhs.source() < rhs.source();
-}
+    // Replace the weights by codes into a codebook of the distinct weights.
+    // The floating point weights are released.
+    //
+    // Throws arbor_exception, leaving the table unchanged, if there are more
+    // than 2^16 distinct weights.
+    void quantize_weights();
 
-static inline bool operator<(const connection& lhs, cell_member_type rhs) {
-    return lhs.source() < rhs;
-}
+    // Replace the delays by the number of multiples of delay_quantum, rounded
+    // up. The floating point delays are released.
+    //
+    // Throws arbor_exception, leaving the table unchanged, if delay_quantum
+    // is not positive, or if a delay is 2^16 or more multiples of
+    // delay_quantum.
+    void quantize_delays(time_type delay_quantum);
 
-static inline bool operator<(cell_member_type lhs, const connection& rhs) {
-    return lhs < rhs.source();
-}
+    // Bytes of storage held by the table.
+    std::size_t memory() const;
+};
 
 } // namespace arb
-
-static inline std::ostream& operator<<(std::ostream& o, arb::connection const& con) {
-    return o << "con [" << con.source() << " -> " << con.destination()
-             << " : weight " << con.weight()
-             << ", delay " << con.delay()
-             << ", index " << con.index_on_domain() << "]";
-}
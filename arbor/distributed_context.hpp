@@ -43,6 +43,8 @@ class distributed_context {
 public:
     using spike_vector = std::vector<arb::spike>;
     using gid_vector = std::vector<cell_gid_type>;
+    using count_vector = std::vector<gathered_vector<arb::spike>::count_type>;
+    using encoded_spike_vector = std::vector<char>;
 
     // default constructor uses a local context: see below.
     distributed_context();
@@ -63,6 +65,22 @@ public:
         return impl_->gather_gids(local_gids);
     }
 
+    // Gather the local spikes in the compact encoding of encode_spikes
+    // (see communication/spike_codec.hpp), partitioned by domain in bytes.
+    gathered_vector<char> gather_encoded_spikes(const encoded_spike_vector& local_spikes) const {
+        return impl_->gather_encoded_spikes(local_spikes);
+    }
+
+    // Send the values in partition i of send to domain i, returning the
+    // values received, partitioned by the domain that sent them.
+    gathered_vector<arb::spike> alltoall_spikes(const spike_vector& send, const count_vector& send_partition) const {
+        return impl_->alltoall_spikes(send, send_partition);
+    }
+
+    gathered_vector<cell_gid_type> alltoall_gids(const gid_vector& send, const count_vector& send_partition) const {
+        return impl_->alltoall_gids(send, send_partition);
+    }
+
     int id() const {
         return impl_->id();
     }
@@ -91,6 +109,12 @@ private:
             gather_spikes(const spike_vector& local_spikes) const = 0;
         virtual gathered_vector<cell_gid_type>
             gather_gids(const gid_vector& local_gids) const = 0;
+        virtual gathered_vector<char>
+            gather_encoded_spikes(const encoded_spike_vector& local_spikes) const = 0;
+        virtual gathered_vector<arb::spike>
+            alltoall_spikes(const spike_vector& send, const count_vector& send_partition) const = 0;
+        virtual gathered_vector<cell_gid_type>
+            alltoall_gids(const gid_vector& send, const count_vector& send_partition) const = 0;
         virtual int id() const = 0;
         virtual int size() const = 0;
         virtual void barrier() const = 0;
@@ -115,6 +139,18 @@ private:
         gather_gids(const gid_vector& local_gids) const override {
             return wrapped.gather_gids(local_gids);
         }
+        gathered_vector<char>
+        gather_encoded_spikes(const encoded_spike_vector& local_spikes) const override {
+            return wrapped.gather_encoded_spikes(local_spikes);
+        }
+        gathered_vector<arb::spike>
+        alltoall_spikes(const spike_vector& send, const count_vector& send_partition) const override {
+            return wrapped.alltoall_spikes(send, send_partition);
+        }
+        gathered_vector<cell_gid_type>
+        alltoall_gids(const gid_vector& send, const count_vector& send_partition) const override {
+            return wrapped.alltoall_gids(send, send_partition);
+        }
         int id() const override {
             return wrapped.id();
         }
@@ -157,6 +193,28 @@ struct local_context {
                 {0u, static_cast<count_type>(local_gids.size())}
         );
     }
+    gathered_vector<char>
+    gather_encoded_spikes(const std::vector<char>& local_spikes) const {
+        using count_type = typename gathered_vector<char>::count_type;
+        return gathered_vector<char>(
+                std::vector<char>(local_spikes),
+                {0u, static_cast<count_type>(local_spikes.size())}
+        );
+    }
+    gathered_vector<arb::spike>
+    alltoall_spikes(const std::vector<arb::spike>& send, const std::vector<unsigned>& send_partition) const {
+        return gathered_vector<arb::spike>(
+            std::vector<arb::spike>(send),
+            std::vector<unsigned>(send_partition)
+        );
+    }
+    gathered_vector<cell_gid_type>
+    alltoall_gids(const std::vector<cell_gid_type>& send, const std::vector<unsigned>& send_partition) const {
+        return gathered_vector<cell_gid_type>(
+            std::vector<cell_gid_type>(send),
+            std::vector<unsigned>(send_partition)
+        );
+    }
 
     int id() const { return 0; }
 
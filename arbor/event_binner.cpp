@@ -9,6 +9,7 @@
 #include <arbor/common_types.hpp>
 #include <arbor/spike.hpp>
 
+#include "checkpoint.hpp"
 #include "event_binner.hpp"
 
 namespace arb {
@@ -17,6 +18,14 @@ void event_binner::reset() {
     last_event_time_ = std::nullopt;
 }
 
+void event_binner::checkpoint(checkpoint_writer& out) const {
+    out.write(last_event_time_);
+}
+
+void event_binner::restore(checkpoint_reader& in) {
+    last_event_time_ = in.read_optional<time_type>();
+}
+
 time_type event_binner::bin(time_type t, time_type t_min) {
     time_type t_binned = t;
 
@@ -7,6 +7,8 @@
 #include <arbor/common_types.hpp>
 #include <arbor/spike.hpp>
 
+#include "checkpoint.hpp"
+
 namespace arb {
 
 class event_binner {
@@ -19,6 +21,11 @@ public:
 
     void reset();
 
+    // Only the time of the last binned event is written: the policy is part
+    // of the configuration of the simulation, not its state.
+    void checkpoint(checkpoint_writer&) const;
+    void restore(checkpoint_reader&);
+
     // Determine binned time for an event based on policy.
     // If `t_min` is specified, the binned time will be no lower than `t_min`.
     // Otherwise the returned binned time will be less than or equal to the parameter `t`,
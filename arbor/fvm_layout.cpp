@@ -2,6 +2,8 @@
 #include <optional>
 #include <set>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <unordered_set>
 #include <vector>
 
@@ -701,10 +703,12 @@ fvm_voltage_interpolant fvm_axial_current(const cable_cell& cell, const fvm_cv_d
 // FVM mechanism data
 // ------------------
 
-// CVs are absolute (taken from combined discretization) so do not need to be shifted.
-// Only target numbers need to be shifted.
+// CVs taken from a combined discretization are absolute, and do not need to
+// be shifted; CVs taken from the discretization of a single cell are shifted
+// by cv_offset, the number of CVs preceding the cell. Target numbers are
+// always shifted.
 
-fvm_mechanism_data& append(fvm_mechanism_data& left, const fvm_mechanism_data& right) {
+fvm_mechanism_data& append(fvm_mechanism_data& left, const fvm_mechanism_data& right, fvm_size_type cv_offset = 0) {
     using impl::append_offset;
     using impl::append_divs;
 
@@ -714,7 +718,7 @@ fvm_mechanism_data& append(fvm_mechanism_data& left, const fvm_mechanism_data& r
         fvm_ion_config& L = left.ions[kv.first];
         const fvm_ion_config& R = kv.second;
 
-        append(L.cv, R.cv);
+        append_offset(L.cv, cv_offset, R.cv);
         append(L.init_iconc, R.init_iconc);
         append(L.init_econc, R.init_econc);
         append(L.reset_iconc, R.reset_iconc);
@@ -728,13 +732,14 @@ fvm_mechanism_data& append(fvm_mechanism_data& left, const fvm_mechanism_data& r
 
             L = kv.second;
             for (auto& t: L.target) t += target_offset;
+            for (auto& cv: L.cv) cv += cv_offset;
         }
         else {
             fvm_mechanism_config& L = left.mechanisms[kv.first];
             const fvm_mechanism_config& R = kv.second;
 
             L.kind = R.kind;
-            append(L.cv, R.cv);
+            append_offset(L.cv, cv_offset, R.cv);
             append(L.multiplicity, R.multiplicity);
             append(L.norm_area, R.norm_area);
             append_offset(L.target, target_offset, R.target);
@@ -1250,4 +1255,174 @@ fvm_mechanism_data fvm_build_mechanism_data(const cable_cell_global_properties&
     return M;
 }
 
+// Discretization cache
+// --------------------
+
+namespace {
+// Serialization of the contents of a cable cell on which its discretization
+// depends. Unordered maps are written in key order, so that cells built from
+// equal descriptions have equal fingerprints.
+
+struct cell_fingerprint {
+    std::string bytes;
+
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+    void operator()(T v) {
+        bytes.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    void operator()(const std::string& v) {
+        (*this)(v.size());
+        bytes.append(v);
+    }
+
+    template <typename T>
+    void operator()(const std::optional<T>& v) {
+        (*this)(!!v);
+        if (v) (*this)(*v);
+    }
+
+    template <typename T>
+    void operator()(const std::vector<T>& v) {
+        (*this)(v.size());
+        for (const auto& x: v) (*this)(x);
+    }
+
+    template <typename V>
+    void operator()(const std::unordered_map<std::string, V>& m) {
+        std::vector<const std::pair<const std::string, V>*> entries;
+        for (const auto& kv: m) entries.push_back(&kv);
+        sort_by(entries, [](auto* e) { return e->first; });
+
+        (*this)(entries.size());
+        for (auto* e: entries) {
+            (*this)(e->first);
+            (*this)(e->second);
+        }
+    }
+
+    template <typename T>
+    void operator()(const mcable_map<T>& m) {
+        (*this)(m.size());
+        for (const auto& [cable, v]: m) {
+            (*this)(cable);
+            (*this)(v);
+        }
+    }
+
+    template <typename T>
+    void operator()(const placed<T>& p) {
+        (*this)(p.loc);
+        (*this)(p.lid);
+        (*this)(p.item);
+    }
+
+    void operator()(const mpoint& p) { (*this)(p.x), (*this)(p.y), (*this)(p.z), (*this)(p.radius); }
+    void operator()(const msegment& s) { (*this)(s.prox), (*this)(s.dist), (*this)(s.tag); }
+    void operator()(const mlocation& l) { (*this)(l.branch), (*this)(l.pos); }
+    void operator()(const mcable& c) { (*this)(c.branch), (*this)(c.prox_pos), (*this)(c.dist_pos); }
+
+    void operator()(const mechanism_desc& d) { (*this)(d.name()), (*this)(d.values()); }
+    void operator()(const cable_cell_ion_data& d) {
+        (*this)(d.init_int_concentration), (*this)(d.init_ext_concentration), (*this)(d.init_reversal_potential);
+    }
+
+    void operator()(const init_membrane_potential& v) { (*this)(v.value); }
+    void operator()(const axial_resistivity& v) { (*this)(v.value); }
+    void operator()(const temperature_K& v) { (*this)(v.value); }
+    void operator()(const membrane_capacitance& v) { (*this)(v.value); }
+    void operator()(const init_int_concentration& v) { (*this)(v.ion), (*this)(v.value); }
+    void operator()(const init_ext_concentration& v) { (*this)(v.ion), (*this)(v.value); }
+    void operator()(const init_reversal_potential& v) { (*this)(v.ion), (*this)(v.value); }
+
+    void operator()(const i_clamp& v) { (*this)(v.delay), (*this)(v.duration), (*this)(v.amplitude); }
+    void operator()(const threshold_detector& v) { (*this)(v.threshold); }
+    void operator()(const gap_junction_site&) {}
+
+    template <typename... T>
+    void all(const T&... v) { ((*this)(v), ...); }
+};
+
+std::string fingerprint(const cable_cell& cell, const cable_cell_parameter_set& global_dflt) {
+    cell_fingerprint f;
+
+    const auto& morph = cell.morphology();
+    f(morph.num_branches());
+    for (msize_t b = 0; b<morph.num_branches(); ++b) {
+        f(morph.branch_parent(b));
+        f(morph.branch_segments(b));
+    }
+
+    const auto& dflt = cell.default_parameters();
+    const auto& policy = dflt.discretization? *dflt.discretization:
+        global_dflt.discretization? *global_dflt.discretization: default_cv_policy();
+    f(cell.concrete_locset(policy.cv_boundary_points(cell)));
+
+    f.all(dflt.init_membrane_potential, dflt.temperature_K, dflt.axial_resistivity,
+        dflt.membrane_capacitance, dflt.ion_data, dflt.reversal_potential_method);
+
+    const auto& regions = cell.region_assignments();
+    f.all(regions.get<mechanism_desc>(), regions.get<init_membrane_potential>(),
+        regions.get<axial_resistivity>(), regions.get<temperature_K>(),
+        regions.get<membrane_capacitance>(), regions.get<init_int_concentration>(),
+        regions.get<init_ext_concentration>(), regions.get<init_reversal_potential>());
+
+    const auto& locations = cell.location_assignments();
+    f.all(locations.get<mechanism_desc>(), locations.get<i_clamp>(),
+        locations.get<gap_junction_site>(), locations.get<threshold_detector>());
+
+    return std::move(f.bytes);
+}
+
+fvm_discretization discretize_cell(const cable_cell& cell, const cable_cell_global_properties& gprop) {
+    fvm_discretization d;
+    d.D = fvm_cv_discretize(cell, gprop.default_parameters);
+    d.M = fvm_build_mechanism_data(gprop, cell, d.D, 0);
+    return d;
+}
+} // anonymous namespace
+
+std::shared_ptr<const fvm_discretization> fvm_discretization_cache::get(
+    const cable_cell& cell, const cable_cell_global_properties& gprop)
+{
+    auto key = fingerprint(cell, gprop.default_parameters);
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (auto i = entries_.find(key); i!=entries_.end()) {
+            ++hits_;
+            return i->second;
+        }
+    }
+
+    // Discretize outside the lock; if another thread has meanwhile added
+    // the same cell, its entry is kept.
+    auto d = std::make_shared<const fvm_discretization>(discretize_cell(cell, gprop));
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    return entries_.emplace(std::move(key), std::move(d)).first->second;
+}
+
+std::size_t fvm_discretization_cache::size() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return entries_.size();
+}
+
+std::size_t fvm_discretization_cache::hits() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return hits_;
+}
+
+std::shared_ptr<const fvm_discretization> fvm_discretize_cell(const cable_cell& cell,
+    const cable_cell_global_properties& gprop, fvm_discretization_cache* cache)
+{
+    return cache? cache->get(cell, gprop): std::make_shared<const fvm_discretization>(discretize_cell(cell, gprop));
+}
+
+fvm_discretization& append(fvm_discretization& left, const fvm_discretization& right) {
+    fvm_size_type cv_offset = left.D.size();
+    append(left.D, right.D);
+    append(left.M, right.M, cv_offset);
+    return left;
+}
+
 } // namespace arb
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -287,4 +290,45 @@ struct fvm_mechanism_data {
 
 fvm_mechanism_data fvm_build_mechanism_data(const cable_cell_global_properties& gprop, const std::vector<cable_cell>& cells, const fvm_cv_discretization& D, const arb::execution_context& ctx={});
 
+// Discretization and mechanism data of one or more cells.
+
+struct fvm_discretization {
+    fvm_cv_discretization D;
+    fvm_mechanism_data M;
+};
+
+// Cache of the discretizations of single cells, so that cells with the same
+// contents are discretized only once, e.g. across the cell groups of a
+// simulation. Cells are identified by a fingerprint of the data on which
+// their discretization depends: morphology, CV boundary points, default
+// parameters, paintings and placements. The global properties must be the
+// same for all cells discretized with one cache.
+//
+// Cached mechanism data CV indices are relative to the first CV of the cell.
+// Lookups are thread safe.
+
+class fvm_discretization_cache {
+public:
+    std::shared_ptr<const fvm_discretization> get(const cable_cell&, const cable_cell_global_properties&);
+
+    // Number of distinct cells discretized, and of lookups that found a
+    // cell discretized before.
+    std::size_t size() const;
+    std::size_t hits() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const fvm_discretization>> entries_;
+    std::size_t hits_ = 0;
+};
+
+// Discretization and mechanism data of a single cell, taken from the cache
+// if supplied, with CV indices relative to the first CV of the cell.
+std::shared_ptr<const fvm_discretization> fvm_discretize_cell(const cable_cell& cell, const cable_cell_global_properties& gprop, fvm_discretization_cache* cache = nullptr);
+
+// Combine the discretizations of two groups of cells in-place, where the CV
+// indices of each are relative to the first CV of its group.
+// (Returns reference to first argument.)
+fvm_discretization& append(fvm_discretization&, const fvm_discretization&);
+
 } // namespace arb
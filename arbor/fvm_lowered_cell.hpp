@@ -17,6 +17,7 @@
 
 #include "backends/event.hpp"
 #include "backends/threshold_crossing.hpp"
+#include "checkpoint.hpp"
 #include "execution_context.hpp"
 #include "sampler_map.hpp"
 #include "util/meta.hpp"
@@ -191,11 +192,21 @@ struct fvm_lowered_cell {
 
     virtual fvm_value_type time() const = 0;
 
+    // Write the dynamic state of the cells to a checkpoint, or restore it:
+    // voltages, ion and mechanism state, and spike detector state.
+    virtual void checkpoint(checkpoint_writer&) const = 0;
+    virtual void restore(checkpoint_reader&) = 0;
+
     virtual ~fvm_lowered_cell() {}
 };
 
 using fvm_lowered_cell_ptr = std::unique_ptr<fvm_lowered_cell>;
 
-fvm_lowered_cell_ptr make_fvm_lowered_cell(backend_kind p, const execution_context& ctx);
+class fvm_discretization_cache;
+
+// Cells are discretized with the cache, if supplied, to share the
+// discretizations of cells with the same contents between cell groups.
+fvm_lowered_cell_ptr make_fvm_lowered_cell(backend_kind p, const execution_context& ctx,
+    std::shared_ptr<fvm_discretization_cache> cache = {});
 
 } // namespace arb
@@ -12,13 +12,15 @@
 
 namespace arb {
 
-fvm_lowered_cell_ptr make_fvm_lowered_cell(backend_kind p, const execution_context& ctx) {
+fvm_lowered_cell_ptr make_fvm_lowered_cell(backend_kind p, const execution_context& ctx,
+    std::shared_ptr<fvm_discretization_cache> cache)
+{
     switch (p) {
     case backend_kind::multicore:
-        return fvm_lowered_cell_ptr(new fvm_lowered_cell_impl<multicore::backend>(ctx));
+        return fvm_lowered_cell_ptr(new fvm_lowered_cell_impl<multicore::backend>(ctx, std::move(cache)));
     case backend_kind::gpu:
 #ifdef ARB_HAVE_GPU
-        return fvm_lowered_cell_ptr(new fvm_lowered_cell_impl<gpu::backend>(ctx));
+        return fvm_lowered_cell_ptr(new fvm_lowered_cell_impl<gpu::backend>(ctx, std::move(cache)));
 #endif
         ; // fall through
     default:
@@ -7,6 +7,7 @@
 // implementation details may be tested in the unit tests.
 // It should otherwise only be used in `fvm_lowered_cell.cpp`.
 
+#include <algorithm>
 #include <cmath>
 #include <iterator>
 #include <memory>
@@ -47,7 +48,8 @@ public:
     using index_type = fvm_index_type;
     using size_type = fvm_size_type;
 
-    fvm_lowered_cell_impl(execution_context ctx): context_(ctx), threshold_watcher_(ctx) {};
+    fvm_lowered_cell_impl(execution_context ctx, std::shared_ptr<fvm_discretization_cache> cache = {}):
+        context_(ctx), discretization_cache_(std::move(cache)), threshold_watcher_(ctx) {};
 
     void reset() override;
 
@@ -70,6 +72,13 @@ public:
         const recipe& rec,
         const fvm_cv_discretization& D);
 
+    // As above, given the CVs of the gap junction sites of each cell.
+    std::vector<fvm_gap_junction> fvm_gap_junctions(
+        const std::vector<std::vector<index_type>>& cell_gj_cv,
+        const std::vector<cell_gid_type>& gids,
+        const recipe& rec,
+        const fvm_cv_discretization& D);
+
     // Generates indom index for every gid, guarantees that gids belonging to the same supercell are in the same intdom
     // Fills cell_to_intdom map; returns number of intdoms
     fvm_size_type fvm_intdom(
@@ -79,11 +88,19 @@ public:
 
     value_type time() const override { return tmin_; }
 
+    void checkpoint(checkpoint_writer& out) const override;
+
+    void restore(checkpoint_reader& in) override;
+
     //Exposed for testing purposes
     std::vector<mechanism_ptr>& mechanisms() {
         return mechanisms_;
     }
 
+    const typename backend::mechanism_pipeline& pipeline() const {
+        return mech_pipeline_;
+    }
+
 private:
     // Host or GPU-side back-end dependent storage.
     using array = typename backend::array;
@@ -93,6 +110,9 @@ private:
 
     execution_context context_;
 
+    // Discretizations shared with other cell groups, released after initialization.
+    std::shared_ptr<fvm_discretization_cache> discretization_cache_;
+
     std::unique_ptr<shared_state> state_; // Cell state shared across mechanisms.
 
     // TODO: Can we move the backend-dependent data structures below into state_?
@@ -106,6 +126,10 @@ private:
     std::vector<mechanism_ptr> mechanisms_; // excludes reversal potential calculators.
     std::vector<mechanism_ptr> revpot_mechanisms_;
 
+    // Current and state updates of mechanisms_, fused over tiles of CVs
+    // where requested and supported by the back-end.
+    typename backend::mechanism_pipeline mech_pipeline_;
+
     // Non-physical voltage check threshold, 0 => no check.
     value_type check_voltage_mV_ = 0;
 
@@ -145,7 +169,7 @@ private:
     // Translate cell probe descriptions into probe handles etc.
     void resolve_probe_address(
         std::vector<fvm_probe_data>& probe_data, // out parameter
-        const std::vector<cable_cell>& cells,
+        const cable_cell& cell,
         std::size_t cell_idx,
         const std::any& paddr,
         const fvm_cv_discretization& D,
@@ -197,6 +221,32 @@ void fvm_lowered_cell_impl<Backend>::reset() {
     threshold_watcher_.reset();
 }
 
+template <typename Backend>
+void fvm_lowered_cell_impl<Backend>::checkpoint(checkpoint_writer& out) const {
+    out.write(tmin_);
+    out.write(state_->get_state());
+    out.write(threshold_watcher_.get_state());
+
+    out.write<std::uint64_t>(mechanisms_.size());
+    for (auto& m: mechanisms_) {
+        out.write(m->get_state());
+    }
+}
+
+template <typename Backend>
+void fvm_lowered_cell_impl<Backend>::restore(checkpoint_reader& in) {
+    auto t = in.read<value_type>();
+    state_->set_state(in.read_vector<value_type>(state_->get_state().size(), "cell state"));
+    threshold_watcher_.set_state(in.read_vector<value_type>(threshold_watcher_.get_state().size(), "spike detector state"));
+
+    in.expect<std::uint64_t>(mechanisms_.size(), "number of mechanisms");
+    for (auto& m: mechanisms_) {
+        m->set_state(in.read_vector<value_type>(m->get_state().size(), "mechanism state"));
+    }
+
+    set_tmin(t);
+}
+
 template <typename Backend>
 fvm_integration_result fvm_lowered_cell_impl<Backend>::integrate(
     value_type tfinal,
@@ -243,10 +293,7 @@ fvm_integration_result fvm_lowered_cell_impl<Backend>::integrate(
         PE(advance_integrate_current_zero);
         state_->zero_currents();
         PL();
-        for (auto& m: mechanisms_) {
-            m->deliver_events();
-            m->update_current();
-        }
+        mech_pipeline_.update_current();
 
         // Add current contribution from gap_junctions
         state_->add_gj_current();
@@ -280,9 +327,7 @@ fvm_integration_result fvm_lowered_cell_impl<Backend>::integrate(
 
         // Integrate mechanism state.
 
-        for (auto& m: mechanisms_) {
-            m->update_state();
-        }
+        mech_pipeline_.update_state();
 
         // Update ion concentrations.
 
@@ -374,21 +419,8 @@ void fvm_lowered_cell_impl<Backend>::initialize(
 
     set_gpu();
 
-    std::vector<cable_cell> cells;
     const std::size_t ncell = gids.size();
 
-    cells.resize(ncell);
-    threading::parallel_for::apply(0, gids.size(), context_.thread_pool.get(),
-           [&](cell_size_type i) {
-               auto gid = gids[i];
-               try {
-                   cells[i] = any_cast<cable_cell&&>(rec.get_cell_description(gid));
-               }
-               catch (std::bad_any_cast&) {
-                   throw bad_cell_description(rec.get_cell_kind(gid), gid);
-               }
-           });
-
     cable_cell_global_properties global_props;
     try {
         std::any rec_props = rec.get_global_properties(cell_kind::cable);
@@ -404,24 +436,65 @@ void fvm_lowered_cell_impl<Backend>::initialize(
     // (Throws cable_cell_error on failure.)
     check_global_properties(global_props);
 
-    // Sanity check recipe; find max num_sources and
-    // create a list of the global identifiers for the spike sources
+    // Fetch, check and discretize the cells in parallel. Each cell
+    // description is released as soon as it is discretized, keeping only
+    // the CVs of its detectors and gap junction sites, relative to the
+    // first CV of the cell; the descriptions of cells with probes are kept
+    // until the probes are resolved.
+
+    struct cell_data {
+        std::shared_ptr<const fvm_discretization> discretization;
+        std::vector<index_type> detector_cv;
+        std::vector<value_type> detector_threshold;
+        std::vector<index_type> gj_cv;
+        std::vector<probe_info> probes;
+        std::optional<cable_cell> cell; // Only if the cell has probes.
+    };
+    std::vector<cell_data> cell_info(ncell);
 
-    std::vector<fvm_size_type> nsources;
-    for (auto cell_idx: make_span(ncell)) {
-        cell_gid_type gid = gids[cell_idx];
-        auto& cell = cells[cell_idx];
+    threading::parallel_for::apply(0, gids.size(), context_.thread_pool.get(),
+           [&](cell_size_type i) {
+               auto gid = gids[i];
+               cable_cell cell;
+               try {
+                   cell = any_cast<cable_cell&&>(rec.get_cell_description(gid));
+               }
+               catch (std::bad_any_cast&) {
+                   throw bad_cell_description(rec.get_cell_kind(gid), gid);
+               }
+
+               // Sanity check recipe.
+               auto num_sources = rec.num_sources(gid);
+               if (num_sources != cell.detectors().size()) {
+                   throw arb::bad_source_description(gid, num_sources, cell.detectors().size());
+               }
+               auto cell_targets = util::sum_by(cell.synapses(), [](auto& syn) { return syn.second.size(); });
+               if (rec.num_targets(gid) > cell_targets) {
+                   throw arb::bad_target_description(gid, rec.num_targets(gid), cell_targets);
+               }
 
-        auto num_sources = rec.num_sources(gid);
-        nsources.push_back(num_sources);
+               auto& info = cell_info[i];
+               info.discretization = fvm_discretize_cell(cell, global_props, discretization_cache_.get());
 
-        if (num_sources != cell.detectors().size()) {
-            throw arb::bad_source_description(gid, num_sources, cell.detectors().size());
-        }
-        auto cell_targets = util::sum_by(cell.synapses(), [](auto& syn) { return syn.second.size(); });
-        if (rec.num_targets(gid) > cell_targets) {
-            throw arb::bad_target_description(gid, rec.num_targets(gid), cell_targets);
-        }
+               const auto& geometry = info.discretization->D.geometry;
+               for (auto entry: cell.detectors()) {
+                   info.detector_cv.push_back(geometry.location_cv(0, entry.loc, cv_prefer::cv_empty));
+                   info.detector_threshold.push_back(entry.item.threshold);
+               }
+               for (auto entry: cell.gap_junction_sites()) {
+                   info.gj_cv.push_back(geometry.location_cv(0, entry.loc, cv_prefer::cv_nonempty));
+               }
+
+               info.probes = rec.get_probes(gid);
+               if (!info.probes.empty()) {
+                   info.cell = std::move(cell);
+               }
+           });
+    discretization_cache_.reset();
+
+    std::vector<fvm_size_type> nsources;
+    for (auto& info: cell_info) {
+        nsources.push_back(info.detector_cv.size());
     }
 
     const mechanism_catalogue* catalogue = global_props.catalogue;
@@ -440,7 +513,12 @@ void fvm_lowered_cell_impl<Backend>::initialize(
 
     // Discretize cells, build matrix.
 
-    fvm_cv_discretization D = fvm_cv_discretize(cells, global_props.default_parameters, context_);
+    fvm_discretization discretization;
+    for (auto& info: cell_info) {
+        append(discretization, *info.discretization);
+        info.discretization.reset();
+    }
+    const fvm_cv_discretization& D = discretization.D;
 
     std::vector<index_type> cv_to_intdom(D.size());
     std::transform(D.geometry.cv_to_cell.begin(), D.geometry.cv_to_cell.end(), cv_to_intdom.begin(),
@@ -453,11 +531,16 @@ void fvm_lowered_cell_impl<Backend>::initialize(
 
     // Discretize mechanism data.
 
-    fvm_mechanism_data mech_data = fvm_build_mechanism_data(global_props, cells, D, context_);
+    const fvm_mechanism_data& mech_data = discretization.M;
 
     // Discretize and build gap junction info.
 
-    auto gj_vector = fvm_gap_junctions(cells, gids, rec, D);
+    std::vector<std::vector<index_type>> cell_gj_cv(ncell);
+    for (auto cell_idx: make_span(ncell)) {
+        auto cv_offset = D.geometry.cell_cv_divs[cell_idx];
+        util::assign_by(cell_gj_cv[cell_idx], cell_info[cell_idx].gj_cv, [&](auto cv) { return cv+cv_offset; });
+    }
+    auto gj_vector = fvm_gap_junctions(cell_gj_cv, gids, rec, D);
 
     // Fill src_to_spike and cv_to_cell vectors only if mechanisms with post_events implemented are present.
     post_events_ = mech_data.post_events;
@@ -486,6 +569,18 @@ void fvm_lowered_cell_impl<Backend>::initialize(
                 D.init_membrane_potential, D.temperature_K, D.diam_um, std::move(src_to_spike),
                 data_alignment? data_alignment: 1u);
 
+    // Split the matrix solution, mechanism updates and threshold tests of
+    // the cell group over threads, if requested.
+
+    unsigned n_thread = context_.thread_pool->get_num_threads();
+    unsigned n_block = global_props.max_group_threads?
+        std::min(global_props.max_group_threads, n_thread): n_thread;
+
+    if (n_block>1) {
+        state_->set_thread_blocks(context_.thread_pool.get(), n_block);
+        matrix_.set_thread_blocks(context_.thread_pool.get(), n_block);
+    }
+
     // Instantiate mechanisms and ions.
 
     for (auto& i: mech_data.ions) {
@@ -573,6 +668,8 @@ void fvm_lowered_cell_impl<Backend>::initialize(
         }
     }
 
+    mech_pipeline_ = typename backend::mechanism_pipeline(mechanisms_, global_props.mechanism_tile_cvs);
+
 
     std::vector<index_type> detector_cv;
     std::vector<value_type> detector_threshold;
@@ -580,17 +677,19 @@ void fvm_lowered_cell_impl<Backend>::initialize(
 
     for (auto cell_idx: make_span(ncell)) {
         cell_gid_type gid = gids[cell_idx];
+        auto& info = cell_info[cell_idx];
 
         // Collect detectors, probe handles.
-        for (auto entry: cells[cell_idx].detectors()) {
-            detector_cv.push_back(D.geometry.location_cv(cell_idx, entry.loc, cv_prefer::cv_empty));
-            detector_threshold.push_back(entry.item.threshold);
+        auto cv_offset = D.geometry.cell_cv_divs[cell_idx];
+        for (auto cv: info.detector_cv) {
+            detector_cv.push_back(cv+cv_offset);
         }
+        util::append(detector_threshold, info.detector_threshold);
 
-        std::vector<probe_info> rec_probes = rec.get_probes(gid);
+        std::vector<probe_info>& rec_probes = info.probes;
         for (cell_lid_type i: count_along(rec_probes)) {
             probe_info& pi = rec_probes[i];
-            resolve_probe_address(probe_data, cells, cell_idx, std::move(pi.address),
+            resolve_probe_address(probe_data, *info.cell, cell_idx, std::move(pi.address),
                 D, mech_data, target_handles, mechptr_by_name);
 
             if (!probe_data.empty()) {
@@ -602,6 +701,7 @@ void fvm_lowered_cell_impl<Backend>::initialize(
                 }
             }
         }
+        info = cell_data{};
     }
 
     threshold_watcher_ = backend::voltage_watcher(*state_, detector_cv, detector_threshold, context_);
@@ -616,6 +716,21 @@ std::vector<fvm_gap_junction> fvm_lowered_cell_impl<Backend>::fvm_gap_junctions(
         const std::vector<cell_gid_type>& gids,
         const recipe& rec, const fvm_cv_discretization& D) {
 
+    std::vector<std::vector<index_type>> cell_gj_cv(D.n_cell());
+    for (auto cell_idx: util::make_span(0, D.n_cell())) {
+        for (auto gj : cells[cell_idx].gap_junction_sites()) {
+            cell_gj_cv[cell_idx].push_back(D.geometry.location_cv(cell_idx, gj.loc, cv_prefer::cv_nonempty));
+        }
+    }
+    return fvm_gap_junctions(cell_gj_cv, gids, rec, D);
+}
+
+template <typename Backend>
+std::vector<fvm_gap_junction> fvm_lowered_cell_impl<Backend>::fvm_gap_junctions(
+        const std::vector<std::vector<index_type>>& cell_gj_cv,
+        const std::vector<cell_gid_type>& gids,
+        const recipe& rec, const fvm_cv_discretization& D) {
+
     std::vector<fvm_gap_junction> v;
 
     std::unordered_map<cell_gid_type, std::vector<unsigned>> gid_to_cvs;
@@ -623,10 +738,7 @@ std::vector<fvm_gap_junction> fvm_lowered_cell_impl<Backend>::fvm_gap_junctions(
         if (!rec.num_gap_junction_sites(gids[cell_idx])) continue;
 
         gid_to_cvs[gids[cell_idx]].reserve(rec.num_gap_junction_sites(gids[cell_idx]));
-        const auto& cell_gj = cells[cell_idx].gap_junction_sites();
-
-        for (auto gj : cell_gj) {
-            auto cv = D.geometry.location_cv(cell_idx, gj.loc, cv_prefer::cv_nonempty);
+        for (auto cv: cell_gj_cv[cell_idx]) {
             gid_to_cvs[gids[cell_idx]].push_back(cv);
         }
     }
@@ -756,7 +868,7 @@ struct probe_resolution_data {
 template <typename Backend>
 void fvm_lowered_cell_impl<Backend>::resolve_probe_address(
     std::vector<fvm_probe_data>& probe_data,
-    const std::vector<cable_cell>& cells,
+    const cable_cell& cell,
     std::size_t cell_idx,
     const std::any& paddr,
     const fvm_cv_discretization& D,
@@ -766,7 +878,7 @@ void fvm_lowered_cell_impl<Backend>::resolve_probe_address(
 {
     probe_data.clear();
     probe_resolution_data<Backend> prd{
-        probe_data, state_.get(), cells[cell_idx], cell_idx, D, M, handles, mech_instance_by_name};
+        probe_data, state_.get(), cell, cell_idx, D, M, handles, mech_instance_by_name};
 
     using V = util::any_visitor<
         cable_probe_membrane_voltage,
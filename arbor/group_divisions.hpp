@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+
+#include <arbor/common_types.hpp>
+
+namespace arb {
+
+// Partition the sequence of group costs into at most n contiguous chunks of
+// approximately equal total cost, returning the chunk divisions.
+// Zero total cost is treated as uniform cost.
+std::vector<cell_size_type> balanced_group_divisions(const std::vector<double>& cost, unsigned n);
+
+} // namespace arb
@@ -182,4 +182,11 @@ struct bad_catalogue_error: arbor_exception {
     std::string failed_call;
 };
 
+// Checkpoint errors: the stream is truncated or unreadable, or the checkpoint
+// was written by a simulation with a different model or decomposition.
+
+struct bad_checkpoint: arbor_exception {
+    explicit bad_checkpoint(const std::string& what);
+};
+
 } // namespace arb
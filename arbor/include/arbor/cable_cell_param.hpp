@@ -247,6 +247,16 @@ struct cable_cell_global_properties {
     // True => combine linear synapses for performance.
     bool coalesce_synapses = true;
 
+    // Maximum number of threads over which the integration of the cells in
+    // one cell group is split, where supported by the back-end; 0 => all
+    // threads of the execution context.
+    unsigned max_group_threads = 1;
+
+    // Number of CVs in a tile of the fused update of consecutive density
+    // mechanisms, where supported by the back-end; 0 => each mechanism is
+    // updated over all of its CVs in turn.
+    unsigned mechanism_tile_cvs = 0;
+
     // Available ion species, together with charge.
     std::unordered_map<std::string, int> ion_species = {
         {"na", 1},
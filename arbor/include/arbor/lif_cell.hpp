@@ -14,4 +14,14 @@ struct lif_cell {
     double t_ref = 2;     // Refractory period [ms].
 };
 
+// LIF probe metadata, to be passed to sampler callbacks. Intentionally left blank.
+struct lif_probe_metadata {};
+
+// Probe for membrane potential. Sample value: double [mV].
+struct lif_probe_voltage {};
+
+// Probe for refractory state: the time remaining in the refractory period,
+// or zero if the cell is not refractory. Sample value: double [ms].
+struct lif_probe_refractory {};
+
 } // namespace arb
@@ -56,6 +56,11 @@ public:
     // Peek into state variable
     virtual fvm_value_type* field_data(const std::string& var) = 0;
 
+    // Copy the values of the state variables to or from host memory, for
+    // checkpointing: size() values for each state variable in turn.
+    virtual std::vector<fvm_value_type> get_state() { return {}; }
+    virtual void set_state(const std::vector<fvm_value_type>& values) {}
+
     // Simulation interfaces:
     virtual void initialize() {};
     virtual void update_state() {};
@@ -0,0 +1,151 @@
+#pragma once
+
+/*
+ * Columnar storage of sample data, written directly by cell groups.
+ *
+ * A sample_buffer attached to a simulation with simulation::add_sampler
+ * holds one column for each concrete probe matched by the association:
+ * a ring of preallocated storage for the times and values of the most
+ * recent samples. Cell groups write samples into the columns during
+ * integration without intermediate copies or per-probe callbacks; the
+ * buffer's notification function is called once per integration epoch,
+ * when the samples of that epoch are complete.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <arbor/common_types.hpp>
+#include <arbor/sampling.hpp>
+
+namespace arb {
+
+// Sample data of one concrete probe: each sample comprises a time and a
+// fixed number (the width) of values. Values of vector probes, e.g. the
+// membrane potential across a whole cable cell, are stored contiguously.
+//
+// When the column is full, each new sample overwrites the oldest one.
+
+class sample_column {
+public:
+    sample_column(probe_metadata meta, unsigned width, std::size_t capacity):
+        meta_(meta), width_(width), times_(capacity), values_(capacity*width)
+    {}
+
+    // Probe metadata as passed to sampler functions. The probe-specific
+    // metadata is owned by the simulation.
+    const probe_metadata& metadata() const { return meta_; }
+
+    // Number of values per sample.
+    unsigned width() const { return width_; }
+
+    // Maximum number of samples held.
+    std::size_t capacity() const { return times_.size(); }
+
+    // Number of samples held.
+    std::size_t size() const { return size_; }
+    bool empty() const { return !size_; }
+
+    // Number of samples overwritten since the column was last cleared.
+    std::size_t dropped() const { return dropped_; }
+
+    // Time and values of the ith oldest sample held, i < size().
+    time_type time(std::size_t i) const { return times_[slot(i)]; }
+    const double* values(std::size_t i) const { return values_.data()+slot(i)*width_; }
+
+    // Discard all samples.
+    void clear() {
+        first_ = 0;
+        size_ = 0;
+        dropped_ = 0;
+    }
+
+    // Append a sample at time t, returning a pointer to storage for its
+    // width() values. Used by cell groups.
+    double* push(time_type t) {
+        std::size_t cap = capacity();
+        if (!cap) {
+            ++dropped_;
+            return nullptr;
+        }
+
+        std::size_t s;
+        if (size_<cap) {
+            s = slot(size_++);
+        }
+        else {
+            s = first_;
+            first_ = first_+1==cap? 0: first_+1;
+            ++dropped_;
+        }
+        times_[s] = t;
+        return values_.data()+s*width_;
+    }
+
+private:
+    probe_metadata meta_;
+    unsigned width_;
+    std::vector<time_type> times_;
+    std::vector<double> values_;
+
+    std::size_t first_ = 0;
+    std::size_t size_ = 0;
+    std::size_t dropped_ = 0;
+
+    std::size_t slot(std::size_t i) const {
+        i += first_;
+        return i<capacity()? i: i-capacity();
+    }
+};
+
+class sample_buffer;
+
+using sample_notify_function = std::function<void (sample_buffer&)>;
+
+class sample_buffer {
+public:
+    // Each column holds up to capacity samples. If provided, notify is
+    // called after each integration epoch; it may consume and clear the
+    // columns.
+    explicit sample_buffer(std::size_t capacity, sample_notify_function notify = sample_notify_function{}):
+        capacity_(capacity), notify_(std::move(notify))
+    {}
+
+    sample_buffer(const sample_buffer&) = delete;
+    sample_buffer& operator=(const sample_buffer&) = delete;
+
+    std::size_t capacity() const { return capacity_; }
+
+    // Columns in order of probe id and index.
+    std::size_t size() const { return columns_.size(); }
+    const sample_column& operator[](std::size_t i) const { return *columns_[i]; }
+    sample_column& operator[](std::size_t i) { return *columns_[i]; }
+
+    // The column for a probe id and index, or nullptr if there is none.
+    const sample_column* find(cell_member_type probe_id, unsigned index = 0) const;
+
+    // Discard the samples in all columns.
+    void clear();
+
+    // Invoke the notification function, if any.
+    void notify() {
+        if (notify_) notify_(*this);
+    }
+
+    // Add a column for the concrete probe described by meta, with the given
+    // number of values per sample. Used by cell groups; thread safe.
+    sample_column* add_column(probe_metadata meta, unsigned width);
+
+private:
+    std::size_t capacity_;
+    sample_notify_function notify_;
+    std::vector<std::unique_ptr<sample_column>> columns_;
+    std::mutex mutex_;
+};
+
+using sample_buffer_ptr = std::shared_ptr<sample_buffer>;
+
+} // namespace arb
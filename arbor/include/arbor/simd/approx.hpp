@@ -81,6 +81,61 @@ constexpr double Q2log = 8.29875266912776603211e1;
 constexpr double Q3log = 4.52279145837532221105e1;
 constexpr double Q4log = 1.12873587189167450590e1;
 
+// Fast approximations:
+//
+// Constants for the polynomial approximations of the fast
+// exponential and logarithm functions (see implbase.hpp).
+
+constexpr double ln2 = 6.93147180559945309417E-1;
+
+// Adding and then subtracting 1.5·2^52 rounds a double x
+// to the nearest integer, for |x| < 2^51.
+
+constexpr double round_magic = 6755399441055744.0;
+
+// Single precision:
+//
+// Constants for the single precision exponential and logarithm
+// (see float_approx in implbase.hpp), with the polynomial
+// coefficients of the Cephes expf and logf.
+
+// Min and max argument values for the single-precision
+// exponential: exp_minargf is log(FLT_MIN) rounded to
+// float, and its exponential is just below FLT_MIN.
+
+constexpr float exp_minargf = -0x1.5d58a0p+6f;  // -87.3365479
+constexpr float exp_maxargf = 0x1.62e42ep+6f;   // 88.7228317
+
+// For expm1, argument below which the result rounds to -1.
+
+constexpr float expm1_minargf = -0x1.154246p+4f; // -17.32868
+
+// e^g = 1 + g + g^2·P(g), for |g| ≤ ln(2)/2.
+
+constexpr float P0expf = 5.0000001201E-1f;
+constexpr float P1expf = 1.6666665459E-1f;
+constexpr float P2expf = 4.1665795894E-2f;
+constexpr float P3expf = 8.3334519073E-3f;
+constexpr float P4expf = 1.3981999507E-3f;
+constexpr float P5expf = 1.9875691500E-4f;
+
+// ln(1+z) = z - z^2/2 + z^3·P(z), for 1+z in [sqrt(2)/2, sqrt(2)).
+
+constexpr float P0logf = 3.3333331174E-1f;
+constexpr float P1logf = -2.4999993993E-1f;
+constexpr float P2logf = 2.0000714765E-1f;
+constexpr float P3logf = -1.6668057665E-1f;
+constexpr float P4logf = 1.4249322787E-1f;
+constexpr float P5logf = -1.2420140846E-1f;
+constexpr float P6logf = 1.1676998740E-1f;
+constexpr float P7logf = -1.1514610310E-1f;
+constexpr float P8logf = 7.0376836292E-2f;
+
+// Adding and then subtracting 1.5·2^23 rounds a float x
+// to the nearest integer, for |x| < 2^22.
+
+constexpr float round_magicf = 12582912.0f;
+
 } // namespace detail
 } // namespace simd
 } // namespace arb
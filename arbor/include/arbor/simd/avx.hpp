@@ -198,6 +198,8 @@ struct avx_double4: implbase<avx_double4> {
     //     element, set_element, fma.
 
     using implbase<avx_double4>::cast_from;
+    using implbase<avx_double4>::convert_from;
+    using implbase<avx_double4>::convert_to;
 
     using int64 = std::int64_t;
 
@@ -241,6 +243,14 @@ struct avx_double4: implbase<avx_double4> {
         return _mm256_cvtepi32_pd(v);
     }
 
+    static __m256d convert_from(const float* p) {
+        return _mm256_cvtps_pd(_mm_loadu_ps(p));
+    }
+
+    static void convert_to(const __m256d& v, float* p) {
+        _mm_storeu_ps(p, _mm256_cvtpd_ps(v));
+    }
+
     static double element0(const __m256d& a) {
         return _mm_cvtsd_f64(_mm256_castpd256_pd128(a));
     }
@@ -690,6 +700,7 @@ protected:
 
 struct avx2_int4;
 struct avx2_double4;
+struct avx2_float8;
 
 template <>
 struct simd_traits<avx2_int4> {
@@ -707,6 +718,14 @@ struct simd_traits<avx2_double4> {
     using mask_impl = avx2_double4;
 };
 
+template <>
+struct simd_traits<avx2_float8> {
+    static constexpr unsigned width = 8;
+    using scalar_type = float;
+    using vector_type = __m256;
+    using mask_impl = avx2_float8;
+};
+
 // Note: we derive from avx_int4 only as an implementation shortcut.
 // Because `avx2_int4` does not derive from `implbase<avx2_int4>`,
 // any fallback methods in `implbase` will use the `avx_int4`
@@ -893,6 +912,40 @@ struct avx2_double4: avx_double4 {
                 r)));
     }
 
+    // ldexp and logb for positive, finite and normal x and results,
+    // as required by fast_approx.
+
+    static __m256d ldexp(const __m256d& x, const __m256d& n) {
+        return ldexp_positive(x, _mm256_cvtpd_epi32(n));
+    }
+
+    static __m256d logb(const __m256d& x) {
+        return _mm256_cvtepi32_pd(logb_normal(x));
+    }
+
+    // Fast approximations, with fma.
+
+    static __m256d fast_exp(const __m256d& x) {
+        return fast_approx<avx2_double4, true>::exp(x);
+    }
+
+    static __m256d fast_expm1(const __m256d& x) {
+        return fast_approx<avx2_double4, true>::expm1(x);
+    }
+
+    // The full accuracy log is no slower than the approximation.
+    static __m256d fast_log(const __m256d& x) {
+        return log(x);
+    }
+
+    static __m256d fast_exprelr(const __m256d& x) {
+        return fast_approx<avx2_double4, true>::exprelr(x);
+    }
+
+    static __m256d fast_pow(const __m256d& x, const __m256d& y) {
+        return fast_approx<avx2_double4, true>::pow(x, y);
+    }
+
 protected:
     static __m128i lo_epi32(__m256i a) {
         a = _mm256_shuffle_epi32(a, 0x08);
@@ -966,6 +1019,248 @@ protected:
         return _mm_sub_epi32(ebiased, _mm_set1_epi32(1023));
     }
 };
+
+// Single precision, for the mixed precision kernels of mechanisms. Masks are
+// represented as for avx2_double4, with all bits set in a true lane.
+
+struct avx2_float8: implbase<avx2_float8> {
+    // Use default implementations for:
+    //     element, set_element, pow.
+
+    using implbase<avx2_float8>::cast_from;
+    using implbase<avx2_float8>::convert_from;
+    using implbase<avx2_float8>::convert_to;
+    using implbase<avx2_float8>::convert_to_masked;
+    using implbase<avx2_float8>::convert_gather;
+
+    using int32 = std::int32_t;
+
+    // CMPPS predicates (as for CMPPD):
+    static constexpr int cmp_eq_oq =    0;
+    static constexpr int cmp_neq_uq =   4;
+    static constexpr int cmp_lt_oq =   17;
+    static constexpr int cmp_le_oq =   18;
+    static constexpr int cmp_ge_oq =   29;
+    static constexpr int cmp_gt_oq =   30;
+
+    static __m256 broadcast(float v) {
+        return _mm256_set1_ps(v);
+    }
+
+    static void copy_to(const __m256& v, float* p) {
+        _mm256_storeu_ps(p, v);
+    }
+
+    static void copy_to_masked(const __m256& v, float* p, const __m256& mask) {
+        _mm256_maskstore_ps(p, _mm256_castps_si256(mask), v);
+    }
+
+    static __m256 copy_from(const float* p) {
+        return _mm256_loadu_ps(p);
+    }
+
+    static __m256 copy_from_masked(const float* p, const __m256& mask) {
+        return _mm256_maskload_ps(p, _mm256_castps_si256(mask));
+    }
+
+    static __m256 copy_from_masked(const __m256& v, const float* p, const __m256& mask) {
+        __m256 d = _mm256_maskload_ps(p, _mm256_castps_si256(mask));
+        return ifelse(mask, d, v);
+    }
+
+    // Conversions from and to double precision, four lanes at a time.
+
+    static __m256 convert_from(const double* p) {
+        __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(p));
+        __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(p+4));
+        return combine_m128(hi, lo);
+    }
+
+    static void convert_to(const __m256& v, double* p) {
+        _mm256_storeu_pd(p, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+        _mm256_storeu_pd(p+4, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    }
+
+    static void convert_to_masked(const __m256& v, double* p, const __m256& mask) {
+        __m256i m = _mm256_castps_si256(mask);
+        __m256i mlo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(m));
+        __m256i mhi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(m, 1));
+        _mm256_maskstore_pd(p, mlo, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+        _mm256_maskstore_pd(p+4, mhi, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    }
+
+    template <typename Impl>
+    using is_int8_simd = std::integral_constant<bool, std::is_same<int, typename Impl::scalar_type>::value && Impl::width==8>;
+
+    template <typename ImplIndex, typename = std::enable_if_t<is_int8_simd<ImplIndex>::value>>
+    static __m256 convert_gather(tag<ImplIndex>, const double* p, const typename ImplIndex::vector_type& index) {
+        int32 o[8];
+        ImplIndex::copy_to(index, o);
+        __m256i i = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(o));
+        __m128 lo = _mm256_cvtpd_ps(_mm256_i32gather_pd(p, _mm256_castsi256_si128(i), 8));
+        __m128 hi = _mm256_cvtpd_ps(_mm256_i32gather_pd(p, _mm256_extracti128_si256(i, 1), 8));
+        return combine_m128(hi, lo);
+    }
+
+    static float element0(const __m256& a) {
+        return _mm256_cvtss_f32(a);
+    }
+
+    static __m256 neg(const __m256& a) {
+        return _mm256_sub_ps(_mm256_setzero_ps(), a);
+    }
+
+    static __m256 add(const __m256& a, const __m256& b) {
+        return _mm256_add_ps(a, b);
+    }
+
+    static __m256 sub(const __m256& a, const __m256& b) {
+        return _mm256_sub_ps(a, b);
+    }
+
+    static __m256 mul(const __m256& a, const __m256& b) {
+        return _mm256_mul_ps(a, b);
+    }
+
+    static __m256 div(const __m256& a, const __m256& b) {
+        return _mm256_div_ps(a, b);
+    }
+
+    static __m256 fma(const __m256& a, const __m256& b, const __m256& c) {
+        return _mm256_fmadd_ps(a, b, c);
+    }
+
+    static __m256 logical_not(const __m256& a) {
+        __m256i ones = {};
+        return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_cmpeq_epi32(ones, ones)));
+    }
+
+    static __m256 logical_and(const __m256& a, const __m256& b) {
+        return _mm256_and_ps(a, b);
+    }
+
+    static __m256 logical_or(const __m256& a, const __m256& b) {
+        return _mm256_or_ps(a, b);
+    }
+
+    static __m256 cmp_eq(const __m256& a, const __m256& b) {
+        return _mm256_cmp_ps(a, b, cmp_eq_oq);
+    }
+
+    static __m256 cmp_neq(const __m256& a, const __m256& b) {
+        return _mm256_cmp_ps(a, b, cmp_neq_uq);
+    }
+
+    static __m256 cmp_gt(const __m256& a, const __m256& b) {
+        return _mm256_cmp_ps(a, b, cmp_gt_oq);
+    }
+
+    static __m256 cmp_geq(const __m256& a, const __m256& b) {
+        return _mm256_cmp_ps(a, b, cmp_ge_oq);
+    }
+
+    static __m256 cmp_lt(const __m256& a, const __m256& b) {
+        return _mm256_cmp_ps(a, b, cmp_lt_oq);
+    }
+
+    static __m256 cmp_leq(const __m256& a, const __m256& b) {
+        return _mm256_cmp_ps(a, b, cmp_le_oq);
+    }
+
+    static __m256 ifelse(const __m256& m, const __m256& u, const __m256& v) {
+        return _mm256_blendv_ps(v, u, m);
+    }
+
+    static __m256 mask_broadcast(bool b) {
+        return _mm256_castsi256_ps(_mm256_set1_epi32(-(int32)b));
+    }
+
+    static bool mask_element(const __m256& u, int i) {
+        return (_mm256_movemask_ps(u)>>i)&1;
+    }
+
+    static void mask_set_element(__m256& u, int i, bool b) {
+        int32 data[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), _mm256_castps_si256(u));
+        data[i] = -(int32)b;
+        u = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)));
+    }
+
+    static __m256 mask_unpack(unsigned long long k) {
+        // Only care about bottom eight bits of k.
+        __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        __m256i b = _mm256_and_si256(_mm256_set1_epi32((int32)k), bits);
+        return _mm256_castsi256_ps(_mm256_cmpeq_epi32(b, bits));
+    }
+
+    static void mask_copy_to(const __m256& m, bool* y) {
+        int k = _mm256_movemask_ps(m);
+        for (unsigned i = 0; i<8; ++i) {
+            y[i] = (k>>i)&1;
+        }
+    }
+
+    static __m256 mask_copy_from(const bool* w) {
+        __m128i r;
+        std::memcpy(&r, w, 8);
+        __m256i zero = _mm256_setzero_si256();
+        return _mm256_castsi256_ps(_mm256_sub_epi32(zero, _mm256_cvtepu8_epi32(r)));
+    }
+
+    static __m256 max(const __m256& a, const __m256& b) {
+        return _mm256_max_ps(a, b);
+    }
+
+    static __m256 min(const __m256& a, const __m256& b) {
+        return _mm256_min_ps(a, b);
+    }
+
+    static __m256 abs(const __m256& x) {
+        __m256i m = _mm256_set1_epi32(0x7fffffff);
+        return _mm256_and_ps(x, _mm256_castsi256_ps(m));
+    }
+
+    static float reduce_add(const __m256& a) {
+        // add [a7|a6|a5|a4] to [a3|a2|a1|a0]
+        __m128 b = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+        // add [b3|b2] to [b1|b0]
+        __m128 c = _mm_add_ps(b, _mm_movehl_ps(b, b));
+        // add c1 to c0
+        __m128 d = _mm_add_ss(c, _mm_shuffle_ps(c, c, 0x01));
+
+        return _mm_cvtss_f32(d);
+    }
+
+    static __m256 exp(const __m256& x) {
+        return float_approx<avx2_float8>::exp(x);
+    }
+
+    static __m256 expm1(const __m256& x) {
+        return float_approx<avx2_float8>::expm1(x);
+    }
+
+    static __m256 log(const __m256& x) {
+        return float_approx<avx2_float8>::log(x);
+    }
+
+    // Compute 2^n·x by addition to the exponent bits, for x and 2^n·x
+    // positive, finite and normal.
+    static __m256 ldexp(const __m256& x, const __m256& n) {
+        __m256i nshift = _mm256_slli_epi32(_mm256_cvtps_epi32(n), 23);
+        return _mm256_castsi256_ps(_mm256_add_epi32(nshift, _mm256_castps_si256(x)));
+    }
+
+    // Unbiased exponent of x, for x positive, finite and normal.
+    static __m256 logb(const __m256& x) {
+        __m256i ebiased = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+        return _mm256_cvtepi32_ps(_mm256_sub_epi32(ebiased, _mm256_set1_epi32(127)));
+    }
+
+protected:
+    static __m256 combine_m128(__m128 hi, __m128 lo) {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    }
+};
 #endif // defined(__AVX2__) && defined(__FMA__)
 
 } // namespace detail
@@ -981,6 +1276,7 @@ namespace simd_abi {
 
     template <> struct avx2<int, 4> { using type = detail::avx2_int4; };
     template <> struct avx2<double, 4> { using type = detail::avx2_double4; };
+    template <> struct avx2<float, 8> { using type = detail::avx2_float8; };
 #endif
 } // namespace simd_abi
 
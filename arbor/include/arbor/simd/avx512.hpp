@@ -18,6 +18,8 @@ namespace detail {
 struct avx512_double8;
 struct avx512_int8;
 struct avx512_mask8;
+struct avx512_float16;
+struct avx512_mask16;
 
 template <>
 struct simd_traits<avx512_mask8> {
@@ -43,6 +45,22 @@ struct simd_traits<avx512_int8> {
     using mask_impl = avx512_mask8;
 };
 
+template <>
+struct simd_traits<avx512_mask16> {
+    static constexpr unsigned width = 16;
+    using scalar_type = bool;
+    using vector_type = __mmask16;
+    using mask_impl = avx512_mask16;
+};
+
+template <>
+struct simd_traits<avx512_float16> {
+    static constexpr unsigned width = 16;
+    using scalar_type = float;
+    using vector_type = __m512;
+    using mask_impl = avx512_mask16;
+};
+
 struct avx512_mask8: implbase<avx512_mask8> {
     using implbase<avx512_mask8>::gather;
     using implbase<avx512_mask8>::scatter;
@@ -405,6 +423,8 @@ struct avx512_double8: implbase<avx512_double8> {
     using implbase<avx512_double8>::gather;
     using implbase<avx512_double8>::scatter;
     using implbase<avx512_double8>::cast_from;
+    using implbase<avx512_double8>::convert_from;
+    using implbase<avx512_double8>::convert_to;
 
     // CMPPD predicates:
     static constexpr int cmp_eq_oq =    0;
@@ -441,6 +461,14 @@ struct avx512_double8: implbase<avx512_double8> {
         return _mm512_mask_loadu_pd(v, mask, p);
     }
 
+    static __m512d convert_from(const float* p) {
+        return _mm512_cvtps_pd(_mm256_loadu_ps(p));
+    }
+
+    static void convert_to(const __m512d& v, float* p) {
+        _mm256_storeu_ps(p, _mm512_cvtpd_ps(v));
+    }
+
     static double element0(const __m512d& a) {
         return _mm_cvtsd_f64(_mm512_castpd512_pd128(a));
     }
@@ -718,6 +746,37 @@ auto odd = mul(g, horner(gg, P0exp, P1exp, P2exp));
     }
 #endif
 
+    static __m512d ldexp(const __m512d& x, const __m512d& n) {
+        return _mm512_scalef_pd(x, n);
+    }
+
+    static __m512d logb(const __m512d& x) {
+        return _mm512_getexp_pd(x);
+    }
+
+    // Fast approximations, with fma.
+
+    static __m512d fast_exp(const __m512d& x) {
+        return fast_approx<avx512_double8, true>::exp(x);
+    }
+
+    static __m512d fast_expm1(const __m512d& x) {
+        return fast_approx<avx512_double8, true>::expm1(x);
+    }
+
+    // The full accuracy log is no slower than the approximation.
+    static __m512d fast_log(const __m512d& x) {
+        return log(x);
+    }
+
+    static __m512d fast_exprelr(const __m512d& x) {
+        return fast_approx<avx512_double8, true>::exprelr(x);
+    }
+
+    static __m512d fast_pow(const __m512d& x, const __m512d& y) {
+        return fast_approx<avx512_double8, true>::pow(x, y);
+    }
+
 protected:
     static inline __m512d horner1(__m512d x, double a0) {
         return add(x, broadcast(a0));
@@ -742,12 +801,272 @@ protected:
     }
 };
 
+// Sixteen-lane mask, for avx512_float16. Only the logical operations and
+// the mask interface are provided.
+
+struct avx512_mask16: implbase<avx512_mask16> {
+    using implbase<avx512_mask16>::gather;
+    using implbase<avx512_mask16>::scatter;
+    using implbase<avx512_mask16>::cast_from;
+
+    static __mmask16 broadcast(bool b) {
+        return _mm512_int2mask(-b);
+    }
+
+    static void copy_to(const __mmask16& k, bool* b) {
+        __m128i a = _mm512_cvtepi32_epi8(_mm512_maskz_set1_epi32(k, 1));
+        std::memcpy(b, &a, 16);
+    }
+
+    static __mmask16 copy_from(const bool* p) {
+        __m128i a;
+        std::memcpy(&a, p, 16);
+        __m512i w = _mm512_cvtepu8_epi32(a);
+        return _mm512_test_epi32_mask(w, w);
+    }
+
+    static __mmask16 logical_not(const __mmask16& k) {
+        return _mm512_knot(k);
+    }
+
+    static __mmask16 logical_and(const __mmask16& a, const __mmask16& b) {
+        return _mm512_kand(a, b);
+    }
+
+    static __mmask16 logical_or(const __mmask16& a, const __mmask16& b) {
+        return _mm512_kor(a, b);
+    }
+
+    static __mmask16 ifelse(const __mmask16& m, const __mmask16& u, const __mmask16& v) {
+        return _mm512_kor(_mm512_kandn(m, v), _mm512_kand(m, u));
+    }
+
+    static bool element(const __mmask16& k, int i) {
+        return _mm512_mask2int(k)&(1<<i);
+    }
+
+    static void set_element(__mmask16& k, int i, bool b) {
+        int n = _mm512_mask2int(k);
+        k = _mm512_int2mask((n&~(1<<i))|(b<<i));
+    }
+
+    static __mmask16 mask_broadcast(bool b) {
+        return broadcast(b);
+    }
+
+    static __mmask16 mask_unpack(unsigned long long p) {
+        return _mm512_int2mask(p);
+    }
+
+    static bool mask_element(const __mmask16& u, int i) {
+        return element(u, i);
+    }
+
+    static void mask_set_element(__mmask16& u, int i, bool b) {
+        set_element(u, i, b);
+    }
+
+    static void mask_copy_to(const __mmask16& m, bool* y) {
+        copy_to(m, y);
+    }
+
+    static __mmask16 mask_copy_from(const bool* y) {
+        return copy_from(y);
+    }
+};
+
+// Single precision, for the mixed precision kernels of mechanisms.
+
+struct avx512_float16: implbase<avx512_float16> {
+    // Use default implementations for:
+    //     element, set_element, gather, scatter, pow.
+
+    using implbase<avx512_float16>::cast_from;
+    using implbase<avx512_float16>::convert_from;
+    using implbase<avx512_float16>::convert_to;
+    using implbase<avx512_float16>::convert_to_masked;
+    using implbase<avx512_float16>::convert_gather;
+
+    using int32 = std::int32_t;
+
+    // CMPPS predicates (as for CMPPD):
+    static constexpr int cmp_eq_oq =    0;
+    static constexpr int cmp_neq_uq =   4;
+    static constexpr int cmp_lt_oq =   17;
+    static constexpr int cmp_le_oq =   18;
+    static constexpr int cmp_ge_oq =   29;
+    static constexpr int cmp_gt_oq =   30;
+
+    static __m512 broadcast(float v) {
+        return _mm512_set1_ps(v);
+    }
+
+    static void copy_to(const __m512& v, float* p) {
+        _mm512_storeu_ps(p, v);
+    }
+
+    static void copy_to_masked(const __m512& v, float* p, const __mmask16& mask) {
+        _mm512_mask_storeu_ps(p, mask, v);
+    }
+
+    static __m512 copy_from(const float* p) {
+        return _mm512_loadu_ps(p);
+    }
+
+    static __m512 copy_from_masked(const float* p, const __mmask16& mask) {
+        return _mm512_maskz_loadu_ps(mask, p);
+    }
+
+    static __m512 copy_from_masked(const __m512& v, const float* p, const __mmask16& mask) {
+        return _mm512_mask_loadu_ps(v, mask, p);
+    }
+
+    // Conversions from and to double precision, eight lanes at a time.
+
+    static __m512 convert_from(const double* p) {
+        __m256 lo = _mm512_cvtpd_ps(_mm512_loadu_pd(p));
+        __m256 hi = _mm512_cvtpd_ps(_mm512_loadu_pd(p+8));
+        return combine_m256(hi, lo);
+    }
+
+    static void convert_to(const __m512& v, double* p) {
+        _mm512_storeu_pd(p, _mm512_cvtps_pd(lo_m256(v)));
+        _mm512_storeu_pd(p+8, _mm512_cvtps_pd(hi_m256(v)));
+    }
+
+    static void convert_to_masked(const __m512& v, double* p, const __mmask16& mask) {
+        int k = _mm512_mask2int(mask);
+        _mm512_mask_storeu_pd(p, (__mmask8)(k&0xff), _mm512_cvtps_pd(lo_m256(v)));
+        _mm512_mask_storeu_pd(p+8, (__mmask8)(k>>8), _mm512_cvtps_pd(hi_m256(v)));
+    }
+
+    template <typename Impl>
+    using is_int16_simd = std::integral_constant<bool, std::is_same<int, typename Impl::scalar_type>::value && Impl::width==16>;
+
+    template <typename ImplIndex, typename = std::enable_if_t<is_int16_simd<ImplIndex>::value>>
+    static __m512 convert_gather(tag<ImplIndex>, const double* p, const typename ImplIndex::vector_type& index) {
+        int32 o[16];
+        ImplIndex::copy_to(index, o);
+        __m256 lo = _mm512_cvtpd_ps(_mm512_i32gather_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(o)), p, 8));
+        __m256 hi = _mm512_cvtpd_ps(_mm512_i32gather_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(o+8)), p, 8));
+        return combine_m256(hi, lo);
+    }
+
+    static float element0(const __m512& a) {
+        return _mm_cvtss_f32(_mm512_castps512_ps128(a));
+    }
+
+    static __m512 neg(const __m512& a) {
+        return _mm512_sub_ps(_mm512_setzero_ps(), a);
+    }
+
+    static __m512 add(const __m512& a, const __m512& b) {
+        return _mm512_add_ps(a, b);
+    }
+
+    static __m512 sub(const __m512& a, const __m512& b) {
+        return _mm512_sub_ps(a, b);
+    }
+
+    static __m512 mul(const __m512& a, const __m512& b) {
+        return _mm512_mul_ps(a, b);
+    }
+
+    static __m512 div(const __m512& a, const __m512& b) {
+        return _mm512_div_ps(a, b);
+    }
+
+    static __m512 fma(const __m512& a, const __m512& b, const __m512& c) {
+        return _mm512_fmadd_ps(a, b, c);
+    }
+
+    static __mmask16 cmp_eq(const __m512& a, const __m512& b) {
+        return _mm512_cmp_ps_mask(a, b, cmp_eq_oq);
+    }
+
+    static __mmask16 cmp_neq(const __m512& a, const __m512& b) {
+        return _mm512_cmp_ps_mask(a, b, cmp_neq_uq);
+    }
+
+    static __mmask16 cmp_gt(const __m512& a, const __m512& b) {
+        return _mm512_cmp_ps_mask(a, b, cmp_gt_oq);
+    }
+
+    static __mmask16 cmp_geq(const __m512& a, const __m512& b) {
+        return _mm512_cmp_ps_mask(a, b, cmp_ge_oq);
+    }
+
+    static __mmask16 cmp_lt(const __m512& a, const __m512& b) {
+        return _mm512_cmp_ps_mask(a, b, cmp_lt_oq);
+    }
+
+    static __mmask16 cmp_leq(const __m512& a, const __m512& b) {
+        return _mm512_cmp_ps_mask(a, b, cmp_le_oq);
+    }
+
+    static __m512 ifelse(const __mmask16& m, const __m512& u, const __m512& v) {
+        return _mm512_mask_blend_ps(m, v, u);
+    }
+
+    static __m512 max(const __m512& a, const __m512& b) {
+        return _mm512_max_ps(a, b);
+    }
+
+    static __m512 min(const __m512& a, const __m512& b) {
+        return _mm512_min_ps(a, b);
+    }
+
+    static __m512 abs(const __m512& x) {
+        __m512i m = _mm512_set1_epi32(0x7fffffff);
+        return _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(x), m));
+    }
+
+    static float reduce_add(const __m512& a) {
+        return _mm512_reduce_add_ps(a);
+    }
+
+    static __m512 exp(const __m512& x) {
+        return float_approx<avx512_float16>::exp(x);
+    }
+
+    static __m512 expm1(const __m512& x) {
+        return float_approx<avx512_float16>::expm1(x);
+    }
+
+    static __m512 log(const __m512& x) {
+        return float_approx<avx512_float16>::log(x);
+    }
+
+    static __m512 ldexp(const __m512& x, const __m512& n) {
+        return _mm512_scalef_ps(x, n);
+    }
+
+    static __m512 logb(const __m512& x) {
+        return _mm512_getexp_ps(x);
+    }
+
+protected:
+    static __m256 lo_m256(const __m512& v) {
+        return _mm512_castps512_ps256(v);
+    }
+
+    static __m256 hi_m256(const __m512& v) {
+        return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+    }
+
+    static __m512 combine_m256(const __m256& hi, const __m256& lo) {
+        __m512d w = _mm512_castpd256_pd512(_mm256_castps_pd(lo));
+        return _mm512_castpd_ps(_mm512_insertf64x4(w, _mm256_castps_pd(hi), 1));
+    }
+};
+
 } // namespace detail
 
 namespace simd_abi {
     template <typename T, unsigned N> struct avx512;
     template <> struct avx512<double, 8> { using type = detail::avx512_double8; };
     template <> struct avx512<int, 8> { using type = detail::avx512_int8; };
+    template <> struct avx512<float, 16> { using type = detail::avx512_float16; };
 } // namespace simd_abi
 
 } // namespace simd
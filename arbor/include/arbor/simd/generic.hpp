@@ -1,8 +1,10 @@
 #pragma once
 
 #include <array>
-#include <cstring>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 #include <arbor/simd/implbase.hpp>
 
@@ -52,6 +54,41 @@ struct generic: implbase<generic<T, N>> {
     static void mask_set_element(array& v, int i, bool x) {
         v[i] = x;
     }
+
+    // Double precision ldexp and logb for normal values (as used by
+    // fast_approx) by manipulation of the exponent bits, in loops that
+    // can be vectorized by the compiler.
+
+    static array ldexp(const array& x, const array& n) {
+        if constexpr (std::is_same<T, double>::value) {
+            array r;
+            for (unsigned i = 0; i<N; ++i) {
+                std::uint64_t bits;
+                std::memcpy(&bits, &x[i], sizeof(bits));
+                bits += std::uint64_t(std::int64_t(n[i]))<<52;
+                std::memcpy(&r[i], &bits, sizeof(bits));
+            }
+            return r;
+        }
+        else {
+            return implbase<generic<T, N>>::ldexp(x, n);
+        }
+    }
+
+    static array logb(const array& x) {
+        if constexpr (std::is_same<T, double>::value) {
+            array r;
+            for (unsigned i = 0; i<N; ++i) {
+                std::uint64_t bits;
+                std::memcpy(&bits, &x[i], sizeof(bits));
+                r[i] = double(std::int64_t((bits>>52)&0x7ff)-1023);
+            }
+            return r;
+        }
+        else {
+            return implbase<generic<T, N>>::logb(x);
+        }
+    }
 };
 
 } // namespace detail
@@ -24,15 +24,33 @@
 // pow      | lane-wise std::pow
 // expm1    | lane-wise std::expm1
 // exprelr  | expm1, div, add, cmp_eq, ifelse
+// ldexp    | lane-wise std::ldexp
+// logb     | lane-wise std::logb
 //
 // 'exprelr' is the function x ↦ x/(exp(x)-1).
+//
+// The fast approximations fast_exp, fast_expm1, fast_log,
+// fast_exprelr and fast_pow are by default the full accuracy
+// functions. fast_approx<I> below implements them for double
+// precision in terms of arithmetic primitives and ldexp and logb;
+// it is used by the AVX2 and AVX-512 implementations, as
+// fast_approx<I, true>, which have native ldexp, logb and fma.
+//
+// Implementations of float with a native fma can use float_approx<I>
+// for exp, expm1 and log, also in terms of ldexp and logb.
+//
+// The conversions convert_from, convert_to, convert_to_masked and
+// convert_gather read and write memory of another scalar type lane-wise
+// by default.
 
+#include <cfloat>
 #include <cstring>
 #include <cmath>
 #include <algorithm>
 #include <iterator>
 #include <type_traits>
 
+#include <arbor/simd/approx.hpp>
 #include <arbor/util/compat.hpp>
 
 // Derived class I must at minimum provide:
@@ -87,6 +105,278 @@ struct simd_traits {
 template <typename I>
 struct tag {};
 
+// Fast approximations of exp, expm1, log, exprelr and pow, with a relative
+// error below 1e-10 where the result is normal, in place of the 1-2 ulp of
+// exp, expm1 and log. They are used where a mechanism is generated with
+// `modcc --simd-accuracy fast`.
+//
+// Exponential: as for the exp implementations, x = g + n·ln(2) with n an
+// integer and |g| ≤ ln(2)/2, but e^g is approximated by its Taylor
+// polynomial of degree 9, with a relative truncation error below 1e-11,
+// and no division. The rounding of x/ln(2) to n uses the addition and
+// subtraction of 1.5·2^52.
+//
+// expm1: for |x| < ln(2)/2, the Taylor polynomial of degree 9 of e^x-1;
+// otherwise e^x-1, which has no cancellation for such x.
+//
+// Logarithm: x = 2^e·u with u in [sqrt(2)/2, sqrt(2)), and
+//
+//     ln(u) = 2·atanh(z) = 2·(z + z^3/3 + z^5/5 + ...),
+//
+// with z = (u-1)/(u+1), |z| < 0.172, evaluated to the z^19 term, so that
+// the truncation error in ln(u) is below 1e-17 (which pow requires, as the
+// error is scaled by the exponent). As with log, e·ln(2) is computed as a
+// sum of two parts, and zero and subnormal x give -inf.
+//
+// Power: x^y = exp(y·log(|x|)), negated for negative x and odd integral y,
+// and NaN for negative x and non-integral y. |y| ≥ 2^52 is treated as an
+// even integer. x^0 and 1^y are 1, as are (±1)^(±inf).
+//
+// The implementation I provides the primitives ldexp(x, n) and logb(x),
+// where n is integral; these may assume that x and their result are positive,
+// finite and normal. If fused is true, polynomials are evaluated with
+// I::fma; otherwise with I::mul and I::add.
+
+template <typename I, bool fused = false>
+struct fast_approx {
+    using vector_type = typename simd_traits<I>::vector_type;
+    using mask_impl = typename simd_traits<I>::mask_impl;
+
+    static vector_type exp(const vector_type& x) {
+        auto lo = I::broadcast(exp_minarg);
+        auto hi = I::broadcast(exp_maxarg);
+        auto in_range = mask_impl::logical_and(I::cmp_geq(x, lo), I::cmp_leq(x, hi));
+        auto xr = I::ifelse(in_range, x, I::broadcast(0));
+
+        auto n = round(I::mul(xr, I::broadcast(ln2inv)));
+        auto g = I::sub(xr, I::mul(n, I::broadcast(ln2C1)));
+        g = I::sub(g, I::mul(n, I::broadcast(ln2C2)));
+
+        // Evaluate the polynomial in two halves, to shorten the dependency chain.
+        auto g2 = I::mul(g, g);
+        auto g5 = I::mul(I::mul(g2, g2), g);
+        auto expg = madd(g5, horner(g, 1./120, 1./720, 1./5040, 1./40320, 1./362880),
+                             horner(g, 1., 1., 1./2, 1./6, 1./24));
+        auto r = I::ldexp(expg, n);
+
+        // Out of range: +inf, zero, or NaN.
+        return
+            I::ifelse(in_range, r,
+            I::ifelse(I::cmp_gt(x, hi), I::broadcast(HUGE_VAL),
+            I::ifelse(I::cmp_lt(x, lo), I::broadcast(0),
+                      x)));
+    }
+
+    static vector_type expm1(const vector_type& x) {
+        auto is_small = I::cmp_lt(I::abs(x), I::broadcast(0.5*ln2));
+        auto q = I::mul(x, horner(x, 1., 1./2, 1./6, 1./24, 1./120, 1./720, 1./5040, 1./40320, 1./362880));
+        return I::ifelse(is_small, q, I::sub(exp(x), I::broadcast(1)));
+    }
+
+    static vector_type log(const vector_type& x) {
+        auto one = I::broadcast(1);
+        auto inf = I::broadcast(HUGE_VAL);
+        auto is_normal = mask_impl::logical_and(I::cmp_geq(x, I::broadcast(log_minarg)), I::cmp_lt(x, inf));
+        auto xn = I::ifelse(is_normal, x, one);
+
+        auto e = I::logb(xn);
+        auto u = I::ldexp(xn, I::neg(e));
+        auto gtsqrt2 = I::cmp_geq(u, I::broadcast(sqrt2));
+        e = I::ifelse(gtsqrt2, I::add(e, one), e);
+        u = I::ifelse(gtsqrt2, I::mul(u, I::broadcast(0.5)), u);
+
+        auto z = I::div(I::sub(u, one), I::add(u, one));
+        auto w = I::mul(z, z);
+        auto w2 = I::mul(w, w);
+        auto w5 = I::mul(I::mul(w2, w2), w);
+        auto lnu = I::mul(z, madd(w5, horner(w, 2./11, 2./13, 2./15, 2./17, 2./19),
+                                      horner(w, 2., 2./3, 2./5, 2./7, 2./9)));
+        auto r = I::add(I::mul(e, I::broadcast(ln2C4)), lnu);
+        r = I::add(r, I::mul(e, I::broadcast(ln2C3)));
+
+        // Otherwise: +inf, -inf for zero or subnormal x, or NaN.
+        return
+            I::ifelse(is_normal, r,
+            I::ifelse(I::cmp_geq(x, inf), inf,
+            I::ifelse(I::cmp_geq(x, I::broadcast(0)), I::broadcast(-HUGE_VAL),
+                      I::broadcast(NAN))));
+    }
+
+    static vector_type exprelr(const vector_type& x) {
+        auto one = I::broadcast(1);
+        return I::ifelse(I::cmp_eq(one, I::add(one, x)), one, I::div(x, expm1(x)));
+    }
+
+    static vector_type pow(const vector_type& x, const vector_type& y) {
+        auto one = I::broadcast(1);
+        auto ax = I::abs(x);
+        auto ay = I::abs(y);
+        auto r = exp(I::mul(y, log(ax)));
+
+        // With h = round(y/2), y-2h is 0 for even y, ±1 for odd y.
+        auto h = round(I::mul(y, I::broadcast(0.5)));
+        auto d = I::abs(I::sub(y, I::add(h, h)));
+        auto is_large = I::cmp_geq(ay, I::broadcast(0x1p52));
+        auto is_odd = mask_impl::logical_and(mask_impl::logical_not(is_large), I::cmp_eq(d, one));
+        auto is_int = mask_impl::logical_or(is_large,
+                      mask_impl::logical_or(I::cmp_eq(d, I::broadcast(0)), I::cmp_eq(d, one)));
+
+        r = I::ifelse(I::cmp_lt(x, I::broadcast(0)),
+                I::ifelse(is_int, I::ifelse(is_odd, I::neg(r), r), I::broadcast(NAN)),
+                r);
+
+        auto is_one = mask_impl::logical_or(I::cmp_eq(y, I::broadcast(0)), I::cmp_eq(x, one));
+        is_one = mask_impl::logical_or(is_one,
+                 mask_impl::logical_and(I::cmp_eq(ax, one), I::cmp_eq(ay, I::broadcast(HUGE_VAL))));
+        return I::ifelse(is_one, one, r);
+    }
+
+private:
+    // Round to nearest, for |x| < 2^51.
+    static vector_type round(const vector_type& x) {
+        auto magic = I::broadcast(round_magic);
+        return I::sub(I::add(x, magic), magic);
+    }
+
+    static vector_type madd(const vector_type& a, const vector_type& b, const vector_type& c) {
+        if constexpr (fused) {
+            return I::fma(a, b, c);
+        }
+        else {
+            return I::add(I::mul(a, b), c);
+        }
+    }
+
+    static vector_type horner(const vector_type& x, double a0) {
+        return I::broadcast(a0);
+    }
+
+    template <typename... T>
+    static vector_type horner(const vector_type& x, double a0, T... tail) {
+        return madd(x, horner(x, tail...), I::broadcast(a0));
+    }
+};
+
+// Single precision exp, expm1 and log, for implementations of float with a
+// native fma, after the Cephes expf and logf; the relative error is within
+// 2 ulp where the result is normal.
+//
+// Exponential: x = g + n·ln(2), with n an integer and |g| ≤ ln(2)/2, and
+// e^g = 1 + g + g^2·P(g), with P of degree 5. Arguments for which e^x is
+// subnormal give zero.
+//
+// expm1: with the same n and g, e^x-1 = 2·(2^(n-1)·(e^g-1) + (2^(n-1)-1/2)),
+// which is exact in the scaling for n = 0 and does not overflow for n = 128.
+//
+// Logarithm: x = 2^e·u with u in [sqrt(2)/2, sqrt(2)), and
+// ln(u) = z - z^2/2 + z^3·P(z) with z = u-1 and P of degree 8. Zero and
+// subnormal x give -inf.
+//
+// As for fast_approx, the implementation I provides ldexp(x, n) and logb(x)
+// for positive, finite and normal x and results.
+
+template <typename I>
+struct float_approx {
+    using vector_type = typename simd_traits<I>::vector_type;
+    using mask_impl = typename simd_traits<I>::mask_impl;
+
+    static vector_type exp(const vector_type& x) {
+        auto lo = I::broadcast(exp_minargf);
+        auto hi = I::broadcast(exp_maxargf);
+        auto in_range = mask_impl::logical_and(I::cmp_geq(x, lo), I::cmp_leq(x, hi));
+        auto xr = I::ifelse(in_range, x, I::broadcast(0));
+
+        auto n = round(I::mul(xr, I::broadcast(ln2inv)));
+        auto expg = I::add(expm1_reduced(xr, n), I::broadcast(1));
+
+        // At the bottom of the range, 2^n·e^g may be subnormal: scale by
+        // 2^(n+1), which is normal, and then by one half.
+        auto nlo = I::cmp_lt(n, I::broadcast(-125));
+        auto r = I::ldexp(expg, I::ifelse(nlo, I::add(n, I::broadcast(1)), n));
+        r = I::ifelse(nlo, I::mul(r, I::broadcast(0.5f)), r);
+
+        // Out of range: +inf, zero, or NaN.
+        return
+            I::ifelse(in_range, r,
+            I::ifelse(I::cmp_gt(x, hi), I::broadcast(HUGE_VALF),
+            I::ifelse(I::cmp_lt(x, lo), I::broadcast(0),
+                      x)));
+    }
+
+    static vector_type expm1(const vector_type& x) {
+        auto lo = I::broadcast(expm1_minargf);
+        auto hi = I::broadcast(exp_maxargf);
+        auto in_range = mask_impl::logical_and(I::cmp_geq(x, lo), I::cmp_leq(x, hi));
+        auto xr = I::ifelse(in_range, x, I::broadcast(0));
+
+        auto half = I::broadcast(0.5f);
+        auto n = round(I::mul(xr, I::broadcast(ln2inv)));
+        auto expgm1 = expm1_reduced(xr, n);
+        auto scale = I::ldexp(half, n);
+        auto r = I::mul(I::fma(scale, expgm1, I::sub(scale, half)), I::broadcast(2));
+
+        // Out of range: +inf, -1, or NaN.
+        return
+            I::ifelse(in_range, r,
+            I::ifelse(I::cmp_gt(x, hi), I::broadcast(HUGE_VALF),
+            I::ifelse(I::cmp_lt(x, lo), I::broadcast(-1),
+                      x)));
+    }
+
+    static vector_type log(const vector_type& x) {
+        auto one = I::broadcast(1);
+        auto inf = I::broadcast(HUGE_VALF);
+        auto is_normal = mask_impl::logical_and(I::cmp_geq(x, I::broadcast(FLT_MIN)), I::cmp_lt(x, inf));
+        auto xn = I::ifelse(is_normal, x, one);
+
+        auto e = I::logb(xn);
+        auto u = I::ldexp(xn, I::neg(e));
+        auto gtsqrt2 = I::cmp_geq(u, I::broadcast(sqrt2));
+        e = I::ifelse(gtsqrt2, I::add(e, one), e);
+        u = I::ifelse(gtsqrt2, I::mul(u, I::broadcast(0.5f)), u);
+
+        auto z = I::sub(u, one);
+        auto zz = I::mul(z, z);
+        auto p = horner(z, P0logf, P1logf, P2logf, P3logf, P4logf, P5logf, P6logf, P7logf, P8logf);
+        auto r = I::mul(I::mul(zz, z), p);
+        r = I::fma(e, I::broadcast(ln2C4), r);
+        r = I::fma(zz, I::broadcast(-0.5f), r);
+        r = I::add(z, r);
+        r = I::fma(e, I::broadcast(ln2C3), r);
+
+        // Otherwise: +inf, -inf for zero or subnormal x, or NaN.
+        return
+            I::ifelse(is_normal, r,
+            I::ifelse(I::cmp_geq(x, inf), inf,
+            I::ifelse(I::cmp_geq(x, I::broadcast(0)), I::broadcast(-HUGE_VALF),
+                      I::broadcast(NAN))));
+    }
+
+private:
+    // e^g-1 for g = x-n·ln(2), with ln(2) split as ln2C3 + ln2C4.
+    static vector_type expm1_reduced(const vector_type& x, const vector_type& n) {
+        auto g = I::fma(n, I::broadcast(-ln2C3), x);
+        g = I::fma(n, I::broadcast(-ln2C4), g);
+        auto p = horner(g, P0expf, P1expf, P2expf, P3expf, P4expf, P5expf);
+        return I::fma(I::mul(g, g), p, g);
+    }
+
+    // Round to nearest, for |x| < 2^22.
+    static vector_type round(const vector_type& x) {
+        auto magic = I::broadcast(round_magicf);
+        return I::sub(I::add(x, magic), magic);
+    }
+
+    static vector_type horner(const vector_type& x, float a0) {
+        return I::broadcast(a0);
+    }
+
+    template <typename... T>
+    static vector_type horner(const vector_type& x, float a0, T... tail) {
+        return I::fma(x, horner(x, tail...), I::broadcast(a0));
+    }
+};
+
 template <typename I>
 struct implbase {
     constexpr static unsigned width = simd_traits<I>::width;
@@ -124,6 +414,47 @@ struct implbase {
         return cast_from_(tag, v, typename std::is_same<scalar_type, other_scalar_type>::type{});
     }
 
+    // Reads and writes of memory holding values of another scalar type V,
+    // with conversion.
+
+    template <typename V>
+    static vector_type convert_from(const V* p) {
+        store a;
+        std::copy(p, p+width, a);
+        return I::copy_from(a);
+    }
+
+    template <typename V>
+    static void convert_to(const vector_type& v, V* p) {
+        store a;
+        I::copy_to(v, a);
+        std::copy(a, a+width, p);
+    }
+
+    template <typename V>
+    static void convert_to_masked(const vector_type& v, V* p, const mask_type& mask) {
+        store a;
+        I::copy_to(v, a);
+
+        mask_store m;
+        mask_impl::mask_copy_to(mask, m);
+        for (unsigned i = 0; i<width; ++i) {
+            if (m[i]) p[i] = a[i];
+        }
+    }
+
+    template <typename ImplIndex, typename V>
+    static vector_type convert_gather(tag<ImplIndex>, const V* p, const typename ImplIndex::vector_type& index) {
+        typename ImplIndex::scalar_type o[width];
+        ImplIndex::copy_to(index, o);
+
+        store a;
+        for (unsigned i = 0; i<width; ++i) {
+            a[i] = p[o[i]];
+        }
+        return I::copy_from(a);
+    }
+
     static vector_type broadcast(scalar_type x) {
         store a;
         std::fill(std::begin(a), std::end(a), x);
@@ -532,6 +863,35 @@ struct implbase {
         }
         return I::copy_from(r);
     }
+
+    static vector_type ldexp(const vector_type& s, const vector_type& n) {
+        store a, b, r;
+        I::copy_to(s, a);
+        I::copy_to(n, b);
+
+        for (unsigned i = 0; i<width; ++i) {
+            r[i] = std::ldexp(a[i], (int)b[i]);
+        }
+        return I::copy_from(r);
+    }
+
+    static vector_type logb(const vector_type& s) {
+        store a, r;
+        I::copy_to(s, a);
+
+        for (unsigned i = 0; i<width; ++i) {
+            r[i] = std::logb(a[i]);
+        }
+        return I::copy_from(r);
+    }
+
+    // No fast approximations by default: use the full accuracy functions.
+
+    static vector_type fast_exp(const vector_type& s) { return I::exp(s); }
+    static vector_type fast_expm1(const vector_type& s) { return I::expm1(s); }
+    static vector_type fast_log(const vector_type& s) { return I::log(s); }
+    static vector_type fast_exprelr(const vector_type& s) { return I::exprelr(s); }
+    static vector_type fast_pow(const vector_type& s, const vector_type& t) { return I::pow(s, t); }
 };
 
 } // namespace detail
@@ -48,6 +48,7 @@ template <> struct native<T, N> {\
 #include <arbor/simd/avx.hpp>
 ARB_DEF_NATIVE_SIMD_(int, 4, avx2)
 ARB_DEF_NATIVE_SIMD_(double, 4, avx2)
+ARB_DEF_NATIVE_SIMD_(float, 8, avx2)
 
 #elif defined(__AVX__)
 
@@ -62,6 +63,7 @@ ARB_DEF_NATIVE_SIMD_(double, 4, avx)
 #include <arbor/simd/avx512.hpp>
 ARB_DEF_NATIVE_SIMD_(int, 8, avx512)
 ARB_DEF_NATIVE_SIMD_(double, 8, avx512)
+ARB_DEF_NATIVE_SIMD_(float, 16, avx512)
 
 #endif
 
@@ -80,9 +80,10 @@ typename detail::simd_impl<Impl>::simd_mask name(const typename detail::simd_imp
     return detail::simd_impl<Impl>::mask(Impl::name(Impl::broadcast(a), b.value_));\
 };
 
-ARB_PP_FOREACH(ARB_BINARY_ARITHMETIC_, add, sub, mul, div, pow, max, min)
+ARB_PP_FOREACH(ARB_BINARY_ARITHMETIC_, add, sub, mul, div, pow, max, min, fast_pow)
 ARB_PP_FOREACH(ARB_BINARY_COMPARISON_, cmp_eq, cmp_neq, cmp_leq, cmp_lt, cmp_geq, cmp_gt)
 ARB_PP_FOREACH(ARB_UNARY_ARITHMETIC_,  neg, abs, sin, cos, exp, log, expm1, exprelr)
+ARB_PP_FOREACH(ARB_UNARY_ARITHMETIC_,  fast_exp, fast_log, fast_expm1, fast_exprelr)
 
 #undef ARB_BINARY_ARITHMETIC_
 #undef ARB_BINARY_COMPARISON__
@@ -155,14 +156,26 @@ namespace detail {
         Impl::mask_copy_to(s.value_, p);
     }
 
+    // Values are converted if V differs from the scalar type.
+
     template <typename Impl, typename V>
     static void indirect_copy_to(const simd_impl<Impl>& s, V* p, unsigned width) {
-        Impl::copy_to(s.value_, p);
+        if constexpr (std::is_same<V, typename simd_traits<Impl>::scalar_type>::value) {
+            Impl::copy_to(s.value_, p);
+        }
+        else {
+            Impl::convert_to(s.value_, p);
+        }
     }
 
     template <typename Impl, typename ImplMask, typename V>
     static void indirect_copy_to(const simd_impl<Impl>& data, const simd_mask_impl<ImplMask>& mask, V* p, unsigned width) {
-        Impl::copy_to_masked(data.value_, p, mask.value_);
+        if constexpr (std::is_same<V, typename simd_traits<Impl>::scalar_type>::value) {
+            Impl::copy_to_masked(data.value_, p, mask.value_);
+        }
+        else {
+            Impl::convert_to_masked(data.value_, p, mask.value_);
+        }
     }
 
     /// Indirect Indexed Expressions
@@ -527,6 +540,30 @@ namespace detail {
             }
         }
 
+        // Read values of another scalar type V, with conversion.
+        template <
+            typename Index,
+            typename V,
+            typename = std::enable_if_t<
+                width==simd_traits<typename Index::simd_base>::width &&
+                !std::is_same<std::remove_const_t<V>, scalar_type>::value
+            >
+        >
+        void copy_from(indirect_indexed_expression<Index, V> pi) {
+            using IndexImpl = typename Index::simd_base;
+            switch (pi.constraint) {
+            case index_constraint::contiguous:
+                value_ = Impl::convert_from(IndexImpl::element0(pi.index.value_) + pi.p);
+                break;
+            case index_constraint::constant:
+                value_ = Impl::broadcast(*(IndexImpl::element0(pi.index.value_) + pi.p));
+                break;
+            default:
+                value_ = Impl::convert_gather(tag<IndexImpl>{}, pi.p, pi.index.value_);
+                break;
+            }
+        }
+
         void copy_from(indirect_expression<scalar_type> pi) {
             value_ = Impl::copy_from(pi.p);
         }
@@ -535,6 +572,11 @@ namespace detail {
             value_ = Impl::copy_from(pi.p);
         }
 
+        template <typename V, typename = std::enable_if_t<!std::is_same<std::remove_const_t<V>, scalar_type>::value>>
+        void copy_from(indirect_expression<V> pi) {
+            value_ = Impl::convert_from(pi.p);
+        }
+
         template <typename T, typename M>
         void copy_from(const_where_expression<T, M> w) {
             value_ = Impl::ifelse(w.mask_.value_, w.data_.value_, value_);
@@ -678,9 +720,10 @@ namespace detail {
         template <typename T>\
         friend typename simd_impl<T>::simd_mask arb::simd::name(const typename simd_impl<T>::scalar_type a, simd_impl<T> b);
 
-        ARB_PP_FOREACH(ARB_DECLARE_BINARY_ARITHMETIC_, add, sub, mul, div, pow, max, min, cmp_eq)
+        ARB_PP_FOREACH(ARB_DECLARE_BINARY_ARITHMETIC_, add, sub, mul, div, pow, max, min, cmp_eq, fast_pow)
         ARB_PP_FOREACH(ARB_DECLARE_BINARY_COMPARISON_, cmp_eq, cmp_neq, cmp_lt, cmp_leq, cmp_gt, cmp_geq)
         ARB_PP_FOREACH(ARB_DECLARE_UNARY_ARITHMETIC_,  neg, abs, sin, cos, exp, log, expm1, exprelr)
+        ARB_PP_FOREACH(ARB_DECLARE_UNARY_ARITHMETIC_,  fast_exp, fast_log, fast_expm1, fast_exprelr)
 
         #undef ARB_DECLARE_UNARY_ARITHMETIC_
         #undef ARB_DECLARE_BINARY_ARITHMETIC_
@@ -769,6 +812,14 @@ namespace detail {
             value_ = Impl::mask_copy_from(&a[0]);
         }
 
+        // Construct from a different SIMD mask of the same width.
+        template <typename Other, typename = std::enable_if_t<width==simd_traits<Other>::width>>
+        explicit simd_mask_impl(const simd_mask_impl<Other>& x) {
+            bool a[width];
+            x.copy_to(a);
+            value_ = Impl::mask_copy_from(a);
+        }
+
         // Copy assignment.
         simd_mask_impl& operator=(const simd_mask_impl& other) {
             std::memcpy(&value_, &other.value_, sizeof(vector_type));
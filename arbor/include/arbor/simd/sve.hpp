@@ -574,6 +574,14 @@ struct sve_double {
         return svlen_f64(m);
     }
 
+    // No fast approximations: use the full accuracy functions.
+
+    static svfloat64_t fast_exp(const svfloat64_t& x) { return exp(x); }
+    static svfloat64_t fast_expm1(const svfloat64_t& x) { return expm1(x); }
+    static svfloat64_t fast_log(const svfloat64_t& x) { return log(x); }
+    static svfloat64_t fast_exprelr(const svfloat64_t& x) { return exprelr(x); }
+    static svfloat64_t fast_pow(const svfloat64_t& x, const svfloat64_t& y) { return pow(x, y); }
+
 protected:
     // Compute n and f such that x = 2^n·f, with |f| ∈ [1,2), given x is finite and normal.
     static svint32_t logb_normal(const svfloat64_t& x) {
@@ -663,9 +671,10 @@ auto name(const typename detail::simd_traits<typename detail::sve_type_to_impl<T
 };
 
 
-ARB_PP_FOREACH(ARB_SVE_BINARY_ARITHMETIC_, add, sub, mul, div, pow, max, min)
+ARB_PP_FOREACH(ARB_SVE_BINARY_ARITHMETIC_, add, sub, mul, div, pow, max, min, fast_pow)
 ARB_PP_FOREACH(ARB_SVE_BINARY_ARITHMETIC_, cmp_eq, cmp_neq, cmp_leq, cmp_lt, cmp_geq, cmp_gt, logical_and, logical_or)
 ARB_PP_FOREACH(ARB_SVE_UNARY_ARITHMETIC_, logical_not, neg, abs, exp, log, expm1, exprelr)
+ARB_PP_FOREACH(ARB_SVE_UNARY_ARITHMETIC_, fast_exp, fast_log, fast_expm1, fast_exprelr)
 
 #undef ARB_SVE_UNARY_ARITHMETIC_
 #undef ARB_SVE_BINARY_ARITHMETIC_
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <iosfwd>
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -9,6 +13,7 @@
 #include <arbor/context.hpp>
 #include <arbor/domain_decomposition.hpp>
 #include <arbor/recipe.hpp>
+#include <arbor/sample_buffer.hpp>
 #include <arbor/sampling.hpp>
 #include <arbor/schedule.hpp>
 #include <arbor/spike.hpp>
@@ -18,6 +23,55 @@ namespace arb {
 
 using spike_export_function = std::function<void(const std::vector<spike>&)>;
 
+// Policy for distributing the advance of local cell groups over threads in
+// each epoch. The balanced and largest_first policies use the advance times
+// measured for each cell group in preceding epochs.
+
+enum class group_scheduling_kind {
+    each,          // => one task per cell group.
+    balanced,      // => one contiguous chunk of groups per thread, of approximately equal cost.
+    largest_first, // => threads take groups dynamically, most costly first.
+};
+
+// Method of spike exchange between domains.
+enum class spike_exchange_kind {
+    gather, // => every domain receives every spike.
+    sparse, // => each spike is sent only to domains with connections from its source.
+};
+
+// Encoding of spikes in the all-gather exchange between domains.
+enum class spike_encoding_kind {
+    full,    // => spikes are sent as stored.
+    compact, // => spikes are packed with delta-encoded gids and optionally quantised times.
+};
+
+// Timing of spike communication relative to the integration of cell state,
+// accumulated over calls to simulation::run since construction or reset.
+struct pipeline_stats {
+    unsigned depth = 2;             // Pipeline depth: see simulation::set_pipeline_depth.
+    time_type epoch_length = 0;     // Length of integration epochs [ms].
+    std::size_t num_epochs = 0;     // Number of epochs integrated.
+    std::size_t num_exchanges = 0;  // Number of spike exchanges between domains.
+    std::uint64_t bytes_sent = 0;     // Spike data sent to other domains in exchanges.
+    std::uint64_t bytes_received = 0; // Spike data received from other domains in exchanges.
+    double communication_time = 0;  // Wall time [s] in spike exchange and event setup.
+    double exposed_time = 0;        // Wall time [s] that integration waited on communication.
+
+    // Fraction of communication time hidden behind integration.
+    double overlap() const {
+        return communication_time>0? std::max(0., 1.-exposed_time/communication_time): 1.;
+    }
+};
+
+// Wall time and change in allocated memory of one phase of the construction
+// of a simulation on this domain. The memory change is zero if memory use
+// can not be measured on the platform.
+struct setup_phase {
+    std::string name;
+    double time = 0;        // Wall time [s].
+    std::int64_t memory = 0; // Change in allocated memory [B].
+};
+
 // simulation_state comprises private implementation for simulation class.
 class simulation_state;
 
@@ -29,12 +83,29 @@ public:
 
     time_type run(time_type tfinal, time_type dt);
 
+    // Write the state of the cells, events and spike count on this domain to
+    // a stream, or restore it from a checkpoint written by a simulation of the
+    // same model with the same domain decomposition; each domain writes its
+    // own checkpoint. Cell parameters that are not part of the state, such as
+    // mechanism parameters, may differ from those of the checkpointed model.
+    // Sampler associations, callbacks and settings are not checkpointed.
+    void checkpoint(std::ostream& out) const;
+    void restore(std::istream& in);
+
     // Note: sampler functions may be invoked from a different thread than that
     // which called the `run` method.
 
     sampler_association_handle add_sampler(cell_member_predicate probe_ids,
         schedule sched, sampler_function f, sampling_policy policy = sampling_policy::lax);
 
+    // Columnar sampling: cell groups write the samples of each matching probe
+    // directly into a column of the buffer, and the buffer is notified once
+    // after each integration epoch. A buffer can be attached to only one
+    // sampler association.
+
+    sampler_association_handle add_sampler(cell_member_predicate probe_ids,
+        schedule sched, sample_buffer_ptr buffer, sampling_policy policy = sampling_policy::lax);
+
     void remove_sampler(sampler_association_handle);
 
     void remove_all_samplers();
@@ -48,6 +119,51 @@ public:
     // Set event binning policy on all our groups.
     void set_binning_policy(binning_kind policy, time_type bin_interval);
 
+    // Set scheduling policy for advancing cell groups.
+    void set_group_scheduling(group_scheduling_kind policy);
+
+    // Measured wall time in seconds spent advancing each local cell group per
+    // epoch, as a moving average over recent epochs. Indexed as the groups
+    // of the domain decomposition.
+    std::vector<double> group_advance_times() const;
+
+    // Set the number of epochs per minimum network delay. The exchange of the
+    // spikes generated in an epoch overlaps the integration of the following
+    // depth-1 epochs; a depth of 1 serializes exchange and integration.
+    // Defaults to 2.
+    void set_pipeline_depth(unsigned depth);
+
+    pipeline_stats get_pipeline_stats() const;
+
+    // Time and memory of the phases of construction on this domain:
+    // "communicator" (recipe connection queries, validation and indexing),
+    // "event_generators" and "cell_groups". Each phase is also recorded as a
+    // profiler region, init_<phase>, when profiling is enabled.
+    const std::vector<setup_phase>& setup_profile() const;
+
+    // Set the method of spike exchange between domains. Must be called on
+    // all domains. With sparse exchange, the global spike callback is passed
+    // only the spikes from sources with connections to the local domain.
+    void set_spike_exchange(spike_exchange_kind kind);
+
+    // Set the encoding of spikes in the all-gather exchange. With compact
+    // encoding and a positive time_quantum, the times of exchanged spikes are
+    // rounded to multiples of time_quantum [ms] relative to the earliest spike
+    // of each domain in each exchange; otherwise spike times are exact.
+    // Must be called on all domains.
+    void set_spike_encoding(spike_encoding_kind kind, time_type time_quantum = 0);
+
+    // Reduce the storage of the weights of the connections to local cells:
+    // weights are stored exactly as 16-bit indices into a codebook of the
+    // distinct weights of the domain. Throws arbor_exception if the domain
+    // has more than 65536 distinct weights.
+    void quantize_connection_weights();
+
+    // Reduce the storage of the delays of the connections to local cells:
+    // delays are stored as 16-bit multiples of delay_quantum [ms], rounded
+    // up. The exact delays are discarded.
+    void quantize_connection_delays(time_type delay_quantum);
+
     // Register a callback that will perform a export of the global
     // spike vector.
     void set_global_spike_callback(spike_export_function = spike_export_function{});
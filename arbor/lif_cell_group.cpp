@@ -1,30 +1,74 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <tuple>
+
 #include <arbor/arbexcept.hpp>
+#include <arbor/assert.hpp>
+#include <arbor/simd/simd.hpp>
 
 #include <lif_cell_group.hpp>
 
 #include "profile/profiler_macro.hpp"
+#include "util/filter.hpp"
+#include "util/maputil.hpp"
+#include "util/rangeutil.hpp"
 #include "util/span.hpp"
 
 using namespace arb;
 
+namespace {
+constexpr unsigned simd_width = simd::simd_abi::native_width<lif_cell_group::value_type>::value;
+using simd_value = simd::simd<lif_cell_group::value_type, simd_width, simd::simd_abi::default_abi>;
+
+// Metadata shared by all LIF probes.
+const lif_probe_metadata lif_metadata;
+} // anonymous namespace
+
 // Constructor containing gid of first cell in a group and a container of all cells.
 lif_cell_group::lif_cell_group(const std::vector<cell_gid_type>& gids, const recipe& rec):
     gids_(gids)
 {
-    for (auto gid: gids_) {
-        if (!rec.get_probes(gid).empty()) {
-            throw bad_cell_probe(cell_kind::lif, gid);
+    for (auto lid: util::make_span(gids_.size())) {
+        auto gid = gids_[lid];
+        auto probes = rec.get_probes(gid);
+        for (cell_lid_type i: util::count_along(probes)) {
+            const auto& address = probes[i].address;
+
+            lif_probe_kind kind;
+            if (address.type()==typeid(lif_probe_voltage)) {
+                kind = lif_probe_kind::voltage;
+            }
+            else if (address.type()==typeid(lif_probe_refractory)) {
+                kind = lif_probe_kind::refractory;
+            }
+            else {
+                throw bad_cell_probe(cell_kind::lif, gid);
+            }
+            probes_.insert({{gid, i}, {cell_size_type(lid), kind, probes[i].tag}});
         }
     }
     // Default to no binning of events
     set_binning_policy(binning_kind::none, 0);
 
-    cells_.reserve(gids_.size());
-    last_time_updated_.resize(gids_.size());
+    auto n_cell = gids_.size();
+    for (auto v: {&tau_m_, &V_th_, &C_m_, &E_L_, &t_ref_, &V_init_}) {
+        v->reserve(n_cell);
+    }
 
-    for (auto lid: util::make_span(gids_.size())) {
-        cells_.push_back(util::any_cast<lif_cell>(rec.get_cell_description(gids_[lid])));
+    for (auto gid: gids_) {
+        auto cell = util::any_cast<lif_cell>(rec.get_cell_description(gid));
+        tau_m_.push_back(cell.tau_m);
+        V_th_.push_back(cell.V_th);
+        C_m_.push_back(cell.C_m);
+        E_L_.push_back(cell.E_L);
+        t_ref_.push_back(cell.t_ref);
+        V_init_.push_back(cell.V_m);
     }
+
+    reset();
 }
 
 cell_kind lif_cell_group::get_cell_kind() const {
@@ -33,12 +77,81 @@ cell_kind lif_cell_group::get_cell_kind() const {
 
 void lif_cell_group::advance(epoch ep, time_type dt, const event_lane_subrange& event_lanes) {
     PE(advance_lif);
-    if (event_lanes.size() > 0) {
-        for (auto lid: util::make_span(gids_.size())) {
-            // Advance each cell independently.
-            advance_cell(ep.tfinal, dt, lid, event_lanes[lid]);
+
+    // The samples of each sampler and probe are collected in one contiguous
+    // range of the sample buffers, to be passed to the sampler in one call.
+    struct sampler_call_info {
+        sampler_function sampler;
+        cell_member_type probe_id;
+        probe_tag tag;
+        sample_column* column; // Destination for columnar sampling, or nullptr.
+        std::size_t begin_offset;
+        std::size_t end_offset;
+    };
+    std::vector<sampler_call_info> call_info;
+
+    sample_requests_.clear();
+    sample_times_.clear();
+    {
+        std::lock_guard<std::mutex> guard(sampler_mex_);
+
+        for (auto& sm_entry: samplers_) {
+            sampler_association& sa = sm_entry.second;
+
+            auto sample_times = util::make_range(sa.sched.events(t_, ep.tfinal));
+            if (sample_times.empty()) {
+                continue;
+            }
+
+            auto column = sa.columns.begin();
+            for (cell_member_type pid: sa.probe_ids) {
+                const auto& probe = probes_.at(pid);
+                sample_column* col = sa.buffer? *column++: nullptr;
+                auto begin = sample_times_.size();
+                for (auto t: sample_times) {
+                    sample_requests_.push_back({probe.lid, t, probe.kind, sample_times_.size()});
+                    sample_times_.push_back(t);
+                }
+                call_info.push_back({sa.sampler, pid, probe.tag, col, begin, sample_times_.size()});
+            }
+        }
+    }
+
+    util::sort(sample_requests_,
+        [](const sample_request& a, const sample_request& b) {
+            return std::tie(a.lid, a.time, a.offset)<std::tie(b.lid, b.time, b.offset);
+        });
+
+    cell_sample_divs_.assign(gids_.size()+1, 0);
+    for (const auto& r: sample_requests_) {
+        ++cell_sample_divs_[r.lid+1];
+    }
+    std::partial_sum(cell_sample_divs_.begin(), cell_sample_divs_.end(), cell_sample_divs_.begin());
+    sample_values_.resize(sample_times_.size());
+
+    if (event_lanes.size() > 0 || !sample_requests_.empty()) {
+        advance_cells(ep.tfinal, event_lanes);
+    }
+
+    std::vector<sample_record> sample_records;
+    for (auto& sc: call_info) {
+        if (sc.column) {
+            for (auto i: util::make_span(sc.begin_offset, sc.end_offset)) {
+                if (double* v = sc.column->push(sample_times_[i])) {
+                    *v = sample_values_[i];
+                }
+            }
+            continue;
+        }
+
+        sample_records.clear();
+        for (auto i: util::make_span(sc.begin_offset, sc.end_offset)) {
+            sample_records.push_back(sample_record{sample_times_[i], static_cast<const double*>(&sample_values_[i])});
         }
+        sc.sampler({sc.probe_id, sc.tag, 0, &lif_metadata}, sample_records.size(), sample_records.data());
     }
+
+    t_ = ep.tfinal;
     PL();
 }
 
@@ -50,65 +163,245 @@ void lif_cell_group::clear_spikes() {
     spikes_.clear();
 }
 
-// TODO: implement sampler
 void lif_cell_group::add_sampler(sampler_association_handle h, cell_member_predicate probe_ids,
-                                    schedule sched, sampler_function fn, sampling_policy policy) {}
-void lif_cell_group::remove_sampler(sampler_association_handle h) {}
-void lif_cell_group::remove_all_samplers() {}
+                                 schedule sched, sampler_function fn, sampling_policy policy)
+{
+    std::lock_guard<std::mutex> guard(sampler_mex_);
+
+    std::vector<cell_member_type> probeset =
+        util::assign_from(util::filter(util::keys(probes_), probe_ids));
+
+    if (!probeset.empty()) {
+        // Ensure that the samples for each probe are delivered in a consistent order.
+        util::sort(probeset);
+        auto result = samplers_.insert({h, sampler_association{std::move(sched), std::move(fn), std::move(probeset), policy}});
+        arb_assert(result.second);
+    }
+}
+
+void lif_cell_group::add_sampler(sampler_association_handle h, cell_member_predicate probe_ids,
+                                 schedule sched, sample_buffer_ptr buffer, sampling_policy policy)
+{
+    std::lock_guard<std::mutex> guard(sampler_mex_);
+
+    std::vector<cell_member_type> probeset =
+        util::assign_from(util::filter(util::keys(probes_), probe_ids));
+
+    if (!probeset.empty()) {
+        util::sort(probeset);
+
+        std::vector<sample_column*> columns;
+        for (cell_member_type pid: probeset) {
+            columns.push_back(buffer->add_column({pid, probes_.at(pid).tag, 0, &lif_metadata}, 1));
+        }
+
+        auto result = samplers_.insert({h, sampler_association{std::move(sched), {}, std::move(probeset), policy, std::move(buffer), std::move(columns)}});
+        arb_assert(result.second);
+    }
+}
+
+void lif_cell_group::remove_sampler(sampler_association_handle h) {
+    std::lock_guard<std::mutex> guard(sampler_mex_);
+    samplers_.erase(h);
+}
+
+void lif_cell_group::remove_all_samplers() {
+    std::lock_guard<std::mutex> guard(sampler_mex_);
+    samplers_.clear();
+}
+
+std::vector<probe_metadata> lif_cell_group::get_probe_metadata(cell_member_type probe_id) const {
+    // Probe associations are fixed after construction, so we do not need to grab the mutex.
+
+    if (auto probe = util::value_by_key(probes_, probe_id)) {
+        return {probe_metadata{probe_id, probe->tag, 0, &lif_metadata}};
+    }
+    return {};
+}
 
-// TODO: implement binner_
 void lif_cell_group::set_binning_policy(binning_kind policy, time_type bin_interval) {
+    binners_.clear();
+    binners_.resize(gids_.size(), event_binner(policy, bin_interval));
 }
 
 void lif_cell_group::reset() {
     spikes_.clear();
-    last_time_updated_.clear();
+    t_ = 0;
+
+    {
+        std::lock_guard<std::mutex> guard(sampler_mex_);
+        for (auto& entry: samplers_) {
+            entry.second.sched.reset();
+        }
+    }
+
+    for (auto& b: binners_) {
+        b.reset();
+    }
+
+    V_m_ = V_init_;
+    last_time_updated_.assign(gids_.size(), 0);
+}
+
+void lif_cell_group::checkpoint(checkpoint_writer& out) const {
+    out.write(t_);
+    out.write(V_m_);
+    out.write(last_time_updated_);
+    for (auto& b: binners_) {
+        b.checkpoint(out);
+    }
 }
 
-// Advances a single cell (lid) with the exact solution (jumps can be arbitrary).
-// Parameter dt is ignored, since we make jumps between two consecutive spikes.
-void lif_cell_group::advance_cell(time_type tfinal, time_type dt, cell_gid_type lid, pse_vector& event_lane) {
-    // Current time of last update.
-    auto t = last_time_updated_[lid];
-    auto& cell = cells_[lid];
-    const auto n_events = event_lane.size();
-
-    // Integrate until tfinal using the exact solution of membrane voltage differential equation.
-    for (unsigned i=0; i<n_events; ++i ) {
-        auto& ev = event_lane[i];
-        const auto time = ev.time;
-        auto weight = ev.weight;
-
-        if (time < t) continue;        // skip event if a neuron is in refactory period
-        if (time >= tfinal) break;     // end of integration interval
-
-        // if there are events that happened at the same time as this event, process them as well
-        while (i + 1 < n_events && event_lane[i+1].time <= time) {
-            weight += event_lane[i+1].weight;
-            i++;
+void lif_cell_group::restore(checkpoint_reader& in) {
+    spikes_.clear();
+    t_ = in.read<time_type>();
+
+    {
+        std::lock_guard<std::mutex> guard(sampler_mex_);
+        for (auto& entry: samplers_) {
+            entry.second.sched.reset();
         }
+    }
+
+    V_m_ = in.read_vector<value_type>(gids_.size(), "LIF cell state");
+    last_time_updated_ = in.read_vector<time_type>(gids_.size(), "LIF cell state");
+    for (auto& b: binners_) {
+        b.restore(in);
+    }
+}
+
+// Advances the cells with the exact solution (jumps can be arbitrary).
+// Each SIMD lane takes the next unfinished cell when the events of its
+// current cell are exhausted, so that the lanes stay occupied however the
+// events are distributed over the cells.
+void lif_cell_group::advance_cells(time_type tfinal, const event_lane_subrange& event_lanes) {
+    constexpr unsigned W = simd_width;
+    const cell_size_type n_cell = gids_.size();
+    const auto first_spike = spikes_.size();
+
+    // Find the next event on cell lid from index i, skipping those in the
+    // refractory period, and accumulate the weight of any events delivered at
+    // the same time after binning, so that they are applied in one update.
+    // Returns false if there are no more events before tfinal.
+    //
+    // Binning an event time more than once yields the same time under every
+    // policy, so the look-ahead over the following events may bin the first
+    // event of the next update again.
+    auto next_event = [&](cell_size_type lid, std::size_t& i, time_type& time, float& weight) {
+        if (event_lanes.empty()) return false;
+
+        const auto& lane = event_lanes[lid];
+        auto& binner = binners_[lid];
+        const auto n_events = lane.size();
+        for (; i<n_events; ++i) {
+            const auto& ev = lane[i];
+            if (ev.time >= tfinal) return false; // end of integration interval
+
+            auto t = binner.bin(ev.time, t_);
+            if (t < last_time_updated_[lid]) continue; // skip event if a neuron is in refactory period
+
+            time = t;
+            weight = ev.weight;
+            while (++i < n_events && lane[i].time < tfinal && binner.bin(lane[i].time, t_) <= time) {
+                weight += lane[i].weight;
+            }
+            return true;
+        }
+        return false;
+    };
+
+    // Take the samples of cell lid from index i up to and including time
+    // t_end, from the analytic solution since the last update. Samples at
+    // the time of an event precede the event.
+    auto take_samples = [&](cell_size_type lid, std::size_t& i, time_type t_end) {
+        for (; i<cell_sample_divs_[lid+1] && sample_requests_[i].time<=t_end; ++i) {
+            const auto& r = sample_requests_[i];
+            auto elapsed = r.time-last_time_updated_[lid];
+
+            switch (r.kind) {
+            case lif_probe_kind::voltage:
+                // During the refractory period the potential is held at its reset value.
+                sample_values_[r.offset] = elapsed<0? V_m_[lid]: V_m_[lid]*std::exp(-elapsed/tau_m_[lid]);
+                break;
+            case lif_probe_kind::refractory:
+                sample_values_[r.offset] = elapsed<0? -elapsed: 0;
+                break;
+            }
+        }
+    };
+
+    cell_size_type next_cell = 0;
+    cell_size_type cell[W];
+    std::size_t event[W], sample[W];
+    bool active[W] = {};
+
+    time_type time[W];
+    value_type interval[W], tau[W], V[W], jump[W];
+
+    for (;;) {
+        // Gather the next event of each lane.
+        unsigned n_active = 0;
+        for (unsigned l = 0; l<W; ++l) {
+            float weight;
+            for (;;) {
+                if (!active[l]) {
+                    if (next_cell==n_cell) break;
+                    cell[l] = next_cell++;
+                    event[l] = 0;
+                    sample[l] = cell_sample_divs_[cell[l]];
+                    active[l] = true;
+                }
+                if (next_event(cell[l], event[l], time[l], weight)) {
+                    take_samples(cell[l], sample[l], time[l]);
+                    break;
+                }
+                take_samples(cell[l], sample[l], std::numeric_limits<time_type>::max());
+                active[l] = false;
+            }
+
+            if (active[l]) {
+                auto lid = cell[l];
+                interval[l] = time[l]-last_time_updated_[lid];
+                tau[l] = tau_m_[lid];
+                V[l] = V_m_[lid];
+                jump[l] = weight/C_m_[lid];
+                ++n_active;
+            }
+            else {
+                interval[l] = 0;
+                tau[l] = 1;
+                V[l] = 0;
+                jump[l] = 0;
+            }
+        }
+        if (!n_active) break;
+
+        // Let the membrane potential decay, then add the jump due to the events.
+        // Intervals rarely recur on a cell, and the exponential of every lane
+        // costs no more than that of one, so it is evaluated for every update.
+        (simd_value(V)*simd::exp(-simd_value(interval)/simd_value(tau))+simd_value(jump)).copy_to(V);
+
+        // Scatter the state, checking for threshold crossings.
+        for (unsigned l = 0; l<W; ++l) {
+            if (!active[l]) continue;
+
+            auto lid = cell[l];
+            last_time_updated_[lid] = time[l];
+            V_m_[lid] = V[l];
+
+            if (V[l] >= V_th_[lid]) {
+                spikes_.push_back({{gids_[lid], 0}, time[l]});
+
+                // Advance the last_time_updated to account for the refractory period.
+                last_time_updated_[lid] += t_ref_[lid];
 
-        // Let the membrane potential decay.
-        auto decay = exp(-(time - t) / cell.tau_m);
-        cell.V_m *= decay;
-        auto update = weight / cell.C_m;
-        // Add jump due to spike.
-        cell.V_m += update;
-        t = time;
-        // If crossing threshold occurred
-        if (cell.V_m >= cell.V_th) {
-            cell_member_type spike_neuron_gid = {gids_[lid], 0};
-            spike s = {spike_neuron_gid, t};
-            spikes_.push_back(s);
-
-            // Advance the last_time_updated to account for the refractory period.
-            t += cell.t_ref;
-
-            // Reset the voltage to resting potential.
-            cell.V_m = cell.E_L;
+                // Reset the voltage to resting potential.
+                V_m_[lid] = E_L_[lid];
+            }
         }
     }
 
-    // This is the last time a cell was updated.
-    last_time_updated_[lid] = t;
+    // Lanes generate spikes out of cell order.
+    std::stable_sort(spikes_.begin()+first_spike, spikes_.end(),
+        [](const spike& a, const spike& b) { return a.source.gid<b.source.gid; });
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include <arbor/common_types.hpp>
@@ -9,6 +11,8 @@
 #include <arbor/spike.hpp>
 
 #include "cell_group.hpp"
+#include "event_binner.hpp"
+#include "sampler_map.hpp"
 
 namespace arb {
 
@@ -29,28 +33,79 @@ public:
     virtual const std::vector<spike>& spikes() const override;
     virtual void clear_spikes() override;
 
+    virtual void checkpoint(checkpoint_writer&) const override;
+    virtual void restore(checkpoint_reader&) override;
+
     // Sampler association methods below should be thread-safe, as they might be invoked
     // from a sampler call back called from a different cell group running on a different thread.
     virtual void add_sampler(sampler_association_handle, cell_member_predicate, schedule, sampler_function, sampling_policy) override;
+    virtual void add_sampler(sampler_association_handle, cell_member_predicate, schedule, sample_buffer_ptr, sampling_policy) override;
     virtual void remove_sampler(sampler_association_handle) override;
     virtual void remove_all_samplers() override;
 
+    virtual std::vector<probe_metadata> get_probe_metadata(cell_member_type) const override;
+
 private:
-    // Advances a single cell (lid) with the exact solution (jumps can be arbitrary).
-    // Parameter dt is ignored, since we make jumps between two consecutive spikes.
-    void advance_cell(time_type tfinal, time_type dt, cell_gid_type lid, pse_vector& event_lane);
+    enum class lif_probe_kind {voltage, refractory};
+
+    struct lif_probe_info {
+        cell_size_type lid;
+        lif_probe_kind kind;
+        probe_tag tag;
+    };
+
+    // A sample to be taken in the current epoch, with the index of its
+    // time and value in the sample buffers.
+    struct sample_request {
+        cell_size_type lid;
+        time_type time;
+        lif_probe_kind kind;
+        std::size_t offset;
+    };
+
+    // Advances the cells with the exact solution (jumps can be arbitrary) over
+    // the events in their lanes before tfinal. SIMD lanes advance separate
+    // cells in lockstep, event by event.
+    void advance_cells(time_type tfinal, const event_lane_subrange& event_lanes);
 
     // List of the gids of the cells in the group.
     std::vector<cell_gid_type> gids_;
 
-    // Cells that belong to this group.
-    std::vector<lif_cell> cells_;
-
-    // Spikes that are generated (not necessarily sorted).
-    std::vector<spike> spikes_;
+    // Cell parameters and state, as structure of arrays indexed by lid.
+    std::vector<value_type> tau_m_;   // Membrane potential decaying constant [ms].
+    std::vector<value_type> V_th_;    // Firing threshold [mV].
+    std::vector<value_type> C_m_;     // Membrane capacitance [pF].
+    std::vector<value_type> E_L_;     // Resting potential [mV].
+    std::vector<value_type> t_ref_;   // Refractory period [ms].
+    std::vector<value_type> V_init_;  // Initial value of the membrane potential [mV].
+    std::vector<value_type> V_m_;     // Membrane potential [mV].
 
     // Time when the cell was last updated.
     std::vector<time_type> last_time_updated_;
+
+    // Event binners, one per cell: events binned to the same time are
+    // delivered in a single update.
+    std::vector<event_binner> binners_;
+
+    // Spikes that are generated, ordered by gid within each epoch.
+    std::vector<spike> spikes_;
+
+    // Time at the end of the last epoch.
+    time_type t_ = 0;
+
+    // Probes on the cells of the group, by probe id.
+    std::unordered_map<cell_member_type, lif_probe_info> probes_;
+
+    // Sampler associations, guarded by sampler_mex_.
+    sampler_association_map samplers_;
+    mutable std::mutex sampler_mex_;
+
+    // Samples of the current epoch, ordered by cell and time and partitioned
+    // by cell, and the buffers of sample times and values for all samplers.
+    std::vector<sample_request> sample_requests_;
+    std::vector<std::size_t> cell_sample_divs_;
+    std::vector<time_type> sample_times_;
+    std::vector<double> sample_values_;
 };
 
 } // namespace arb
@@ -6,6 +6,7 @@
 
 #include <memory/memory.hpp>
 #include <util/span.hpp>
+#include <threading/threading.hpp>
 
 namespace arb {
 
@@ -66,6 +67,12 @@ public:
         state_.solve(to);
     }
 
+    /// Split the assembly and solution of the cell matrices over at most n
+    /// threads of ts, where supported by the back-end state.
+    void set_thread_blocks(threading::task_system* ts, unsigned n) {
+        state_.set_thread_blocks(ts, n);
+    }
+
     /// Assemble the matrix for given dt
     void assemble(const array& dt_cell, const array& voltage, const array& current, const array& conductivity) {
         state_.assemble(dt_cell, voltage, current, conductivity);
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <functional>
 #include <optional>
 #include <unordered_set>
@@ -9,6 +10,7 @@
 #include <arbor/cable_cell.hpp>
 #include <arbor/sampling.hpp>
 #include <arbor/recipe.hpp>
+#include <arbor/sample_buffer.hpp>
 #include <arbor/spike.hpp>
 
 #include "backends/event.hpp"
@@ -75,6 +77,27 @@ void mc_cell_group::reset() {
     lowered_->reset();
 }
 
+void mc_cell_group::checkpoint(checkpoint_writer& out) const {
+    for (auto& b: binners_) {
+        b.checkpoint(out);
+    }
+    lowered_->checkpoint(out);
+}
+
+void mc_cell_group::restore(checkpoint_reader& in) {
+    spikes_.clear();
+
+    sample_events_.clear();
+    for (auto &entry: sampler_map_) {
+        entry.second.sched.reset();
+    }
+
+    for (auto& b: binners_) {
+        b.restore(in);
+    }
+    lowered_->restore(in);
+}
+
 void mc_cell_group::set_binning_policy(binning_kind policy, time_type bin_interval) {
     binners_.clear();
     binners_.resize(gids_.size(), event_binner(policy, bin_interval));
@@ -89,6 +112,9 @@ struct sampler_call_info {
     unsigned index;
     const fvm_probe_data* pdata_ptr;
 
+    // Destination of the samples for columnar sampling, or nullptr.
+    sample_column* column;
+
     // Offsets are into lowered cell sample time and event arrays.
     sample_size_type begin_offset;
     sample_size_type end_offset;
@@ -241,6 +267,36 @@ void run_samples(
     sc.sampler({sc.probe_id, sc.tag, sc.index, p.get_metadata_ptr()}, n_sample, sample_records.data());
 }
 
+// Compute the membrane current of each cable of a membrane currents probe into
+// out[0..n_cable) from the CV voltages v.
+void membrane_currents(const fvm_probe_membrane_currents& p, const double* v, double* out) {
+    const auto n_cv = p.cv_parent_cond.size();
+    const auto cables_by_cv = util::partition_view(p.cv_cables_divs);
+
+    std::fill_n(out, p.metadata.size(), 0.);
+
+    // Each CV voltage contributes to the current sum of its parent's cables
+    // and its own cables.
+
+    for (auto cv: util::make_span(n_cv)) {
+        fvm_index_type parent_cv = p.cv_parent[cv];
+        if (parent_cv+1==0) continue;
+
+        double cond = p.cv_parent_cond[cv];
+
+        double cv_I = v[cv]*cond;
+        double parent_cv_I = v[parent_cv]*cond;
+
+        for (auto cable_i: util::make_span(cables_by_cv[cv])) {
+            out[cable_i] -= (cv_I-parent_cv_I)*p.weight[cable_i];
+        }
+
+        for (auto cable_i: util::make_span(cables_by_cv[parent_cv])) {
+            out[cable_i] += (cv_I-parent_cv_I)*p.weight[cable_i];
+        }
+    }
+}
+
 void run_samples(
     const fvm_probe_membrane_currents& p,
     const sampler_call_info& sc,
@@ -254,14 +310,12 @@ void run_samples(
     arb_assert((sc.end_offset-sc.begin_offset)==n_sample*n_raw_per_sample);
 
     const auto n_cable = p.metadata.size();
-    const auto n_cv = p.cv_parent_cond.size();
-    const auto cables_by_cv = util::partition_view(p.cv_cables_divs);
 
     auto& sample_ranges = std::get<std::vector<cable_sample_range>>(scratch);
     sample_ranges.clear();
 
     auto& tmp = std::get<std::vector<double>>(scratch);
-    tmp.assign(n_cable*n_sample, 0.);
+    tmp.resize(n_cable*n_sample);
 
     sample_records.clear();
 
@@ -269,38 +323,112 @@ void run_samples(
         auto offset = j*n_raw_per_sample+sc.begin_offset;
         auto tmp_base = tmp.data()+j*n_cable;
 
-        // Each CV voltage contributes to the current sum of its parent's cables
-        // and its own cables.
+        membrane_currents(p, raw_samples+offset, tmp_base);
+        sample_ranges.push_back({tmp_base, tmp_base+n_cable});
+    }
 
-        const double* v = raw_samples+offset;
-        for (auto cv: util::make_span(n_cv)) {
-            fvm_index_type parent_cv = p.cv_parent[cv];
-            if (parent_cv+1==0) continue;
+    const auto& csample_ranges = sample_ranges;
+    for (sample_size_type j = 0; j<n_sample; ++j) {
+        auto offset = j*n_raw_per_sample+sc.begin_offset;
+        sample_records.push_back(sample_record{time_type(raw_times[offset]), &csample_ranges[j]});
+    }
 
-            double cond = p.cv_parent_cond[cv];
+    sc.sampler({sc.probe_id, sc.tag, sc.index, p.get_metadata_ptr()}, n_sample, sample_records.data());
+}
 
-            double cv_I = v[cv]*cond;
-            double parent_cv_I = v[parent_cv]*cond;
+// Columnar sampling: write the sample values of each probe type directly
+// into the sample column, with sample_width values per sample.
 
-            for (auto cable_i: util::make_span(cables_by_cv[cv])) {
-                tmp_base[cable_i] -= (cv_I-parent_cv_I)*p.weight[cable_i];
-            }
+unsigned sample_width(const missing_probe_info&) { return 0; }
+unsigned sample_width(const fvm_probe_scalar&) { return 1; }
+unsigned sample_width(const fvm_probe_interpolated&) { return 1; }
+unsigned sample_width(const fvm_probe_multi& p) { return p.raw_handles.size(); }
+unsigned sample_width(const fvm_probe_weighted_multi& p) { return p.raw_handles.size(); }
+unsigned sample_width(const fvm_probe_membrane_currents& p) { return p.metadata.size(); }
 
-            for (auto cable_i: util::make_span(cables_by_cv[parent_cv])) {
-                tmp_base[cable_i] += (cv_I-parent_cv_I)*p.weight[cable_i];
-            }
+unsigned sample_width(const fvm_probe_data& pdata) {
+    return std::visit([](auto& x) { return sample_width(x); }, pdata.info);
+}
+
+void write_samples(
+    const missing_probe_info&,
+    const sampler_call_info&,
+    const fvm_value_type*,
+    const fvm_value_type*)
+{
+    throw arbor_internal_error("invalid fvm_probe_data in sampler map");
+}
+
+void write_samples(
+    const fvm_probe_scalar&,
+    const sampler_call_info& sc,
+    const fvm_value_type* raw_times,
+    const fvm_value_type* raw_samples)
+{
+    for (auto i = sc.begin_offset; i!=sc.end_offset; ++i) {
+        if (double* v = sc.column->push(raw_times[i])) {
+            *v = raw_samples[i];
         }
+    }
+}
 
-        sample_ranges.push_back({tmp_base, tmp_base+n_cable});
+void write_samples(
+    const fvm_probe_interpolated& p,
+    const sampler_call_info& sc,
+    const fvm_value_type* raw_times,
+    const fvm_value_type* raw_samples)
+{
+    constexpr sample_size_type n_raw_per_sample = 2;
+    for (auto offset = sc.begin_offset; offset!=sc.end_offset; offset += n_raw_per_sample) {
+        if (double* v = sc.column->push(raw_times[offset])) {
+            *v = p.coef[0]*raw_samples[offset] + p.coef[1]*raw_samples[offset+1];
+        }
     }
+}
 
-    const auto& csample_ranges = sample_ranges;
-    for (sample_size_type j = 0; j<n_sample; ++j) {
-        auto offset = j*n_raw_per_sample+sc.begin_offset;
-        sample_records.push_back(sample_record{time_type(raw_times[offset]), &csample_ranges[j]});
+void write_samples(
+    const fvm_probe_multi& p,
+    const sampler_call_info& sc,
+    const fvm_value_type* raw_times,
+    const fvm_value_type* raw_samples)
+{
+    const sample_size_type n_raw_per_sample = p.raw_handles.size();
+    for (auto offset = sc.begin_offset; offset!=sc.end_offset; offset += n_raw_per_sample) {
+        if (double* v = sc.column->push(raw_times[offset])) {
+            std::copy_n(raw_samples+offset, n_raw_per_sample, v);
+        }
     }
+}
 
-    sc.sampler({sc.probe_id, sc.tag, sc.index, p.get_metadata_ptr()}, n_sample, sample_records.data());
+void write_samples(
+    const fvm_probe_weighted_multi& p,
+    const sampler_call_info& sc,
+    const fvm_value_type* raw_times,
+    const fvm_value_type* raw_samples)
+{
+    const sample_size_type n_raw_per_sample = p.raw_handles.size();
+    for (auto offset = sc.begin_offset; offset!=sc.end_offset; offset += n_raw_per_sample) {
+        if (double* v = sc.column->push(raw_times[offset])) {
+            for (sample_size_type i = 0; i<n_raw_per_sample; ++i) {
+                v[i] = raw_samples[offset+i]*p.weight[i];
+            }
+        }
+    }
+}
+
+void write_samples(
+    const fvm_probe_membrane_currents& p,
+    const sampler_call_info& sc,
+    const fvm_value_type* raw_times,
+    const fvm_value_type* raw_samples)
+{
+    const sample_size_type n_raw_per_sample = p.raw_handles.size();
+
+    for (auto offset = sc.begin_offset; offset!=sc.end_offset; offset += n_raw_per_sample) {
+        double* out = sc.column->push(raw_times[offset]);
+        if (!out) continue;
+        membrane_currents(p, raw_samples+offset, out);
+    }
 }
 
 // Generic run_samples dispatches on probe info variant type.
@@ -311,7 +439,12 @@ void run_samples(
     std::vector<sample_record>& sample_records,
     fvm_probe_scratch& scratch)
 {
-    std::visit([&](auto& x) {run_samples(x, sc, raw_times, raw_samples, sample_records, scratch); }, sc.pdata_ptr->info);
+    if (sc.column) {
+        std::visit([&](auto& x) {write_samples(x, sc, raw_times, raw_samples); }, sc.pdata_ptr->info);
+    }
+    else {
+        std::visit([&](auto& x) {run_samples(x, sc, raw_times, raw_samples, sample_records, scratch); }, sc.pdata_ptr->info);
+    }
 }
 
 void mc_cell_group::advance(epoch ep, time_type dt, const event_lane_subrange& event_lanes) {
@@ -401,13 +534,18 @@ void mc_cell_group::advance(epoch ep, time_type dt, const event_lane_subrange& e
             sample_size_type n_times = sample_times.size();
             max_samples_per_call = std::max(max_samples_per_call, n_times);
 
+            // Columns of a sample buffer are taken in the order in which
+            // they were added in add_sampler().
+            auto column = sa.columns.begin();
+
             for (cell_member_type pid: sa.probe_ids) {
                 auto cell_index = gid_index_map_.at(pid.gid);
 
                 probe_tag tag = probe_map_.tag.at(pid);
                 unsigned index = 0;
                 for (const fvm_probe_data& pdata: probe_map_.data_on(pid)) {
-                    call_info.push_back({sa.sampler, pid, tag, index++, &pdata, n_samples, n_samples + n_times*pdata.n_raw()});
+                    sample_column* col = sa.buffer? *column++: nullptr;
+                    call_info.push_back({sa.sampler, pid, tag, index++, &pdata, col, n_samples, n_samples + n_times*pdata.n_raw()});
                     auto intdom = cell_to_intdom_[cell_index];
 
                     for (auto t: sample_times) {
@@ -494,6 +632,29 @@ void mc_cell_group::add_sampler(sampler_association_handle h, cell_member_predic
     }
 }
 
+void mc_cell_group::add_sampler(sampler_association_handle h, cell_member_predicate probe_ids,
+                                schedule sched, sample_buffer_ptr buffer, sampling_policy policy)
+{
+    std::lock_guard<std::mutex> guard(sampler_mex_);
+
+    std::vector<cell_member_type> probeset =
+        util::assign_from(util::filter(util::keys(probe_map_.tag), probe_ids));
+
+    if (!probeset.empty()) {
+        std::vector<sample_column*> columns;
+        for (cell_member_type pid: probeset) {
+            probe_tag tag = probe_map_.tag.at(pid);
+            unsigned index = 0;
+            for (const fvm_probe_data& pdata: probe_map_.data_on(pid)) {
+                columns.push_back(buffer->add_column({pid, tag, index++, pdata.get_metadata_ptr()}, sample_width(pdata)));
+            }
+        }
+
+        auto result = sampler_map_.insert({h, sampler_association{std::move(sched), {}, std::move(probeset), policy, std::move(buffer), std::move(columns)}});
+        arb_assert(result.second);
+    }
+}
+
 void mc_cell_group::remove_sampler(sampler_association_handle h) {
     std::lock_guard<std::mutex> guard(sampler_mex_);
     sampler_map_.erase(h);
@@ -51,9 +51,16 @@ public:
         spikes_.clear();
     }
 
+    void checkpoint(checkpoint_writer& out) const override;
+
+    void restore(checkpoint_reader& in) override;
+
     void add_sampler(sampler_association_handle h, cell_member_predicate probe_ids,
                      schedule sched, sampler_function fn, sampling_policy policy) override;
 
+    void add_sampler(sampler_association_handle h, cell_member_predicate probe_ids,
+                     schedule sched, sample_buffer_ptr buffer, sampling_policy policy) override;
+
     void remove_sampler(sampler_association_handle h) override;
 
     void remove_all_samplers() override;
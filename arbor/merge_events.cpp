@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <vector>
@@ -34,10 +35,14 @@ static constexpr spike_event terminal_pse{cell_member_type{0,0}, terminal_time,
 // event generators than can be counted using an unsigned a complete redesign
 // will be needed.
 
-tourney_tree::tourney_tree(std::vector<event_span>& input):
-    input_(input),
-    n_lanes_(input_.size())
-{
+tourney_tree::tourney_tree(std::vector<event_span>& input) {
+    reset(input);
+}
+
+void tourney_tree::reset(std::vector<event_span>& input) {
+    input_ = &input;
+    n_lanes_ = input.size();
+
     // Must have at least 1 queue.
     arb_assert(n_lanes_>=1u);
 
@@ -86,7 +91,7 @@ void tourney_tree::pop() {
     unsigned i = leaf(lane);
 
     // draw the next event from the input lane
-    auto& in = input_[lane];
+    auto& in = (*input_)[lane];
 
     if (!in.empty()) {
         ++in.left;
@@ -94,6 +99,9 @@ void tourney_tree::pop() {
 
     event(i) = in.empty()? terminal_pse: in.front();
 
+    // with a single lane the leaf is the root
+    if (i==0) return;
+
     // re-heapify the tree with a single walk from leaf to root
     while ((i=parent(i))) {
         merge_up(i);
@@ -147,12 +155,41 @@ const spike_event& tourney_tree::event(unsigned i) const {
 } // namespace impl
 
 void tree_merge_events(std::vector<event_span>& sources, pse_vector& out) {
-    impl::tourney_tree tree(sources);
+    impl::tourney_tree tree;
+    tree_merge_events(sources, out, tree);
+}
+
+void tree_merge_events(std::vector<event_span>& sources, pse_vector& out, impl::tourney_tree& tree) {
+    tree.reset(sources);
     while (!tree.empty()) {
         out.push_back(tree.head());
         tree.pop();
     }
 }
 
-} // namespace arb
+void merge_sorted_runs(pse_vector& events, std::vector<std::size_t>& bounds, pse_vector& buf) {
+    arb_assert(!bounds.empty() && bounds.front()==0 && bounds.back()==events.size());
+
+    // Each pass merges runs 2k and 2k+1 from events into buf, copying a
+    // last unpaired run, and then exchanges events and buf.
+    buf.resize(events.size());
+    while (bounds.size()>2) {
+        const std::size_t nruns = bounds.size()-1;
+        std::size_t k = 0;
+        for (std::size_t i = 0; i<nruns; i += 2) {
+            auto b = events.begin();
+            if (i+1<nruns) {
+                std::merge(b+bounds[i], b+bounds[i+1], b+bounds[i+1], b+bounds[i+2], buf.begin()+bounds[i]);
+            }
+            else {
+                std::copy(b+bounds[i], b+bounds[i+1], buf.begin()+bounds[i]);
+            }
+            bounds[k++] = bounds[i];
+        }
+        bounds[k++] = bounds[nruns];
+        bounds.resize(k);
+        events.swap(buf);
+    }
+}
 
+} // namespace arb
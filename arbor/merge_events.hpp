@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <iosfwd>
 #include <vector>
 
@@ -17,6 +18,12 @@ using event_span = util::range<const spike_event*>;
 
 void tree_merge_events(std::vector<event_span>& sources, pse_vector& out);
 
+// Sort events, which are the concatenation of sorted runs with boundaries
+// bounds, from 0 to events.size(), by merging adjacent runs pairwise.
+// buf is scratch storage, which may exchange storage with events; bounds
+// is overwritten.
+void merge_sorted_runs(pse_vector& events, std::vector<std::size_t>& bounds, pse_vector& buf);
+
 namespace impl {
     // The tournament tree is used internally by the merge_events method, and
     // it is not intended for use elsewhere. It is exposed here for unit testing
@@ -25,7 +32,12 @@ namespace impl {
         using key_val = std::pair<unsigned, spike_event>;
 
     public:
+        tourney_tree() = default;
         tourney_tree(std::vector<event_span>& input);
+
+        // Rebuild the tree over new input, reusing the tree's storage.
+        void reset(std::vector<event_span>& input);
+
         bool empty() const;
         spike_event head() const;
         void pop();
@@ -46,11 +58,23 @@ namespace impl {
         unsigned next_power_2(unsigned x) const;
 
         std::vector<key_val> heap_;
-        std::vector<event_span>& input_;
-        unsigned leaves_;
-        unsigned nodes_;
-        unsigned n_lanes_;
+        std::vector<event_span>* input_ = nullptr;
+        unsigned leaves_ = 0;
+        unsigned nodes_ = 0;
+        unsigned n_lanes_ = 0;
     };
 }
 
+// Storage for merging event sequences that can be reused between merges
+// to avoid allocation.
+struct event_merge_scratch {
+    std::vector<event_span> spans;
+    impl::tourney_tree tree;
+    std::vector<std::size_t> run_bounds;
+    pse_vector buffer;
+};
+
+// As above, using the tree in scratch.
+void tree_merge_events(std::vector<event_span>& sources, pse_vector& out, impl::tourney_tree& tree);
+
 } // namespace arb
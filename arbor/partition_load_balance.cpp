@@ -1,4 +1,5 @@
 #include <queue>
+#include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -13,6 +14,8 @@
 #include "cell_group_factory.hpp"
 #include "execution_context.hpp"
 #include "gpu_context.hpp"
+#include "profile/profiler_macro.hpp"
+#include "threading/threading.hpp"
 #include "util/maputil.hpp"
 #include "util/partition.hpp"
 #include "util/span.hpp"
@@ -25,23 +28,32 @@ domain_decomposition partition_load_balance(
     const context& ctx,
     partition_hint_map hint_map)
 {
+    PE(init_load_balance);
     const bool gpu_avail = ctx->gpu->has_gpu();
 
+    // Domain of each gid, stored densely: the gids of a valid recipe are
+    // [0, num_global_cells), each on exactly one domain.
     struct partition_gid_domain {
-        partition_gid_domain(const gathered_vector<cell_gid_type>& divs, unsigned domains) {
+        partition_gid_domain(const gathered_vector<cell_gid_type>& divs, cell_size_type num_cells, threading::task_system* ts):
+            gid_map(num_cells, -1)
+        {
             auto rank_part = util::partition_view(divs.partition());
-            for (auto rank: count_along(rank_part)) {
-                for (auto gid: util::subrange_view(divs.values(), rank_part[rank])) {
-                    gid_map[gid] = rank;
-                }
-            }
+            threading::parallel_for::apply(0, rank_part.size(), 1, ts,
+                [&](int rank) {
+                    for (auto gid: util::subrange_view(divs.values(), rank_part[rank])) {
+                        if (gid<gid_map.size()) gid_map[gid] = rank;
+                    }
+                });
         }
 
         int operator()(cell_gid_type gid) const {
-            return gid_map.at(gid);
+            if (gid>=gid_map.size() || gid_map[gid]<0) {
+                throw std::out_of_range("gid not in domain decomposition");
+            }
+            return gid_map[gid];
         }
 
-        std::unordered_map<cell_gid_type, int> gid_map;
+        std::vector<int> gid_map;
     };
 
     struct cell_identifier {
@@ -69,6 +81,23 @@ domain_decomposition partition_load_balance(
 
     // Local load balance
 
+    // Query the recipe for the kind and gap junctions of each cell of the
+    // domain in parallel. The recipe is queried concurrently, so its methods
+    // must be thread safe.
+    const auto dom_range = gid_part[domain_id];
+    const cell_gid_type num_dom_cells = dom_range.second-dom_range.first;
+    std::vector<cell_kind> dom_kinds(num_dom_cells);
+    std::vector<char> dom_has_gj(num_dom_cells);
+    threading::parallel_for::apply(0, num_dom_cells, ctx->thread_pool.get(),
+        [&](cell_gid_type i) {
+            auto gid = dom_range.first+i;
+            dom_kinds[i] = rec.get_cell_kind(gid);
+            dom_has_gj[i] = !rec.gap_junctions_on(gid).empty();
+        });
+    auto kind_of = [&](cell_gid_type gid) {
+        return gid-dom_range.first<num_dom_cells? dom_kinds[gid-dom_range.first]: rec.get_cell_kind(gid);
+    };
+
     std::vector<std::vector<cell_gid_type>> super_cells; //cells connected by gj
     std::vector<cell_gid_type> reg_cells; //independent cells
 
@@ -77,8 +106,8 @@ domain_decomposition partition_load_balance(
 
     // Connected components algorithm using BFS
     std::queue<cell_gid_type> q;
-    for (auto gid: make_span(gid_part[domain_id])) {
-        if (!rec.gap_junctions_on(gid).empty()) {
+    for (auto gid: make_span(dom_range)) {
+        if (dom_has_gj[gid-dom_range.first]) {
             // If cell hasn't been visited yet, must belong to new super_cell
             // Perform BFS starting from that cell
             if (!visited.count(gid)) {
@@ -129,13 +158,13 @@ domain_decomposition partition_load_balance(
     std::unordered_map<cell_kind, std::vector<cell_identifier>> kind_lists;
     for (auto gid: reg_cells) {
         local_gids.push_back(gid);
-        kind_lists[rec.get_cell_kind(gid)].push_back({gid, false});
+        kind_lists[kind_of(gid)].push_back({gid, false});
     }
 
     for (unsigned i = 0; i < super_cells.size(); i++) {
-        auto kind = rec.get_cell_kind(super_cells[i].front());
+        auto kind = kind_of(super_cells[i].front());
         for (auto gid: super_cells[i]) {
-            if (rec.get_cell_kind(gid) != kind) {
+            if (kind_of(gid) != kind) {
                 throw gj_kind_mismatch(gid, super_cells[i].front());
             }
             local_gids.push_back(gid);
@@ -222,7 +251,8 @@ domain_decomposition partition_load_balance(
     d.num_local_cells = num_local_cells;
     d.num_global_cells = num_global_cells;
     d.groups = std::move(groups);
-    d.gid_domain = partition_gid_domain(global_gids, num_domains);
+    d.gid_domain = partition_gid_domain(global_gids, num_global_cells, ctx->thread_pool.get());
+    PL();
 
     return d;
 }
@@ -0,0 +1,40 @@
+#include <algorithm>
+#include <mutex>
+#include <tuple>
+
+#include <arbor/common_types.hpp>
+#include <arbor/sample_buffer.hpp>
+
+namespace arb {
+
+static auto column_key(const probe_metadata& meta) {
+    return std::make_tuple(meta.id, meta.index);
+}
+
+const sample_column* sample_buffer::find(cell_member_type probe_id, unsigned index) const {
+    auto key = std::make_tuple(probe_id, index);
+    auto i = std::lower_bound(columns_.begin(), columns_.end(), key,
+        [](const auto& c, const auto& k) { return column_key(c->metadata())<k; });
+
+    return i!=columns_.end() && column_key((*i)->metadata())==key? i->get(): nullptr;
+}
+
+void sample_buffer::clear() {
+    for (auto& c: columns_) {
+        c->clear();
+    }
+}
+
+sample_column* sample_buffer::add_column(probe_metadata meta, unsigned width) {
+    std::lock_guard<std::mutex> guard(mutex_);
+
+    // Keep columns ordered by probe id and index, irrespective of the order
+    // in which cell groups add them.
+    auto key = column_key(meta);
+    auto i = std::lower_bound(columns_.begin(), columns_.end(), key,
+        [](const auto& c, const auto& k) { return column_key(c->metadata())<k; });
+
+    return columns_.insert(i, std::make_unique<sample_column>(meta, width, capacity_))->get();
+}
+
+} // namespace arb
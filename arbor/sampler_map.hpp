@@ -7,6 +7,7 @@
 #include <vector>
 
 #include <arbor/common_types.hpp>
+#include <arbor/sample_buffer.hpp>
 #include <arbor/sampling.hpp>
 #include <arbor/schedule.hpp>
 
@@ -20,6 +21,11 @@ struct sampler_association {
     sampler_function sampler;
     std::vector<cell_member_type> probe_ids;
     sampling_policy policy;
+
+    // For columnar sampling, the sample buffer and its column for each
+    // concrete probe, in order of probe id in probe_ids and probe index.
+    sample_buffer_ptr buffer;
+    std::vector<sample_column*> columns;
 };
 
 using sampler_association_map = std::unordered_map<sampler_association_handle, sampler_association>;
@@ -1,53 +1,121 @@
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <set>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #include <arbor/arbexcept.hpp>
 #include <arbor/context.hpp>
 #include <arbor/domain_decomposition.hpp>
 #include <arbor/generic_event.hpp>
+#include <arbor/profile/timer.hpp>
 #include <arbor/recipe.hpp>
 #include <arbor/schedule.hpp>
 #include <arbor/simulation.hpp>
 
 #include "cell_group.hpp"
 #include "cell_group_factory.hpp"
+#include "checkpoint.hpp"
 #include "communication/communicator.hpp"
 #include "execution_context.hpp"
+#include "fvm_layout.hpp"
+#include "group_divisions.hpp"
+#include "hardware/memory.hpp"
 #include "merge_events.hpp"
 #include "thread_private_spike_store.hpp"
+#include "threading/enumerable_thread_specific.hpp"
 #include "threading/threading.hpp"
-#include "util/double_buffer.hpp"
 #include "util/filter.hpp"
 #include "util/maputil.hpp"
 #include "util/partition.hpp"
+#include "util/rangeutil.hpp"
 #include "util/span.hpp"
 #include "profile/profiler_macro.hpp"
 
 namespace arb {
 
-class spike_double_buffer {
-    util::double_buffer<thread_private_spike_store> buffer_;
-
+// Runs jobs on the task system one at a time, in order of submission.
+//
+// Spike exchanges are collective operations that must be performed in the
+// same order on every domain, but may proceed concurrently with the
+// integration of subsequent epochs.
+class serial_task_queue {
 public:
-    // Convenience functions that map the spike buffers onto the appropriate
-    // integration interval.
-    //
-    // To overlap communication and computation, integration intervals of
-    // size Delta/2 are used, where Delta is the minimum delay in the global
-    // system.
-    // From the frame of reference of the current integration period we
-    // define three intervals: previous, current and future
-    // Then we define the following :
-    //      current:  spikes generated in the current interval
-    //      previous: spikes generated in the preceding interval
-
-    spike_double_buffer(thread_private_spike_store l, thread_private_spike_store r):
-            buffer_(std::move(l), std::move(r)) {}
-
-    thread_private_spike_store& current()  { return buffer_.get(); }
-    thread_private_spike_store& previous() { return buffer_.other(); }
-    void exchange() { buffer_.exchange(); }
+    explicit serial_task_queue(threading::task_system* ts): ts_(ts) {}
+
+    serial_task_queue(const serial_task_queue&) = delete;
+    serial_task_queue& operator=(const serial_task_queue&) = delete;
+
+    // Submitted jobs may refer to state owned by the caller: see them through.
+    ~serial_task_queue() {
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!running_) break;
+            }
+            ts_->try_run_task();
+        }
+    }
+
+    void submit(threading::task job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(std::move(job));
+            if (running_) return;
+            running_ = true;
+        }
+        ts_->async([this] { drain(); });
+    }
+
+    // Wait until the first n submitted jobs have completed, rethrowing
+    // the exception raised by a failed job.
+    void wait(std::size_t n) {
+        while (completed_<n) {
+            ts_->try_run_task();
+        }
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+private:
+    void drain() {
+        for (;;) {
+            threading::task job;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (jobs_.empty()) {
+                    running_ = false;
+                    return;
+                }
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            // Once a job has failed, the remaining jobs are skipped.
+            if (!error_) {
+                try {
+                    job();
+                }
+                catch (...) {
+                    error_ = std::current_exception();
+                }
+            }
+            ++completed_;
+        }
+    }
+
+    threading::task_system* ts_;
+    std::mutex mutex_;
+    std::deque<threading::task> jobs_;
+    bool running_ = false;
+    std::atomic<std::size_t> completed_{0};
+    std::exception_ptr error_;
 };
 
 class simulation_state {
@@ -58,9 +126,16 @@ public:
 
     time_type run(time_type tfinal, time_type dt);
 
+    void checkpoint(std::ostream& out);
+
+    void restore(std::istream& in);
+
     sampler_association_handle add_sampler(cell_member_predicate probe_ids,
         schedule sched, sampler_function f, sampling_policy policy = sampling_policy::lax);
 
+    sampler_association_handle add_sampler(cell_member_predicate probe_ids,
+        schedule sched, sample_buffer_ptr buffer, sampling_policy policy = sampling_policy::lax);
+
     void remove_sampler(sampler_association_handle);
 
     void remove_all_samplers();
@@ -75,6 +150,46 @@ public:
 
     void inject_events(const pse_vector& events);
 
+    void set_group_scheduling(group_scheduling_kind policy) {
+        group_scheduling_ = policy;
+    }
+
+    const std::vector<double>& group_advance_times() const {
+        return group_advance_times_;
+    }
+
+    void set_pipeline_depth(unsigned depth);
+
+    const std::vector<setup_phase>& setup_profile() const {
+        return setup_profile_;
+    }
+
+    pipeline_stats get_pipeline_stats() const {
+        auto stats = pipeline_stats_;
+        stats.bytes_sent = communicator_.num_bytes_sent();
+        stats.bytes_received = communicator_.num_bytes_received();
+        return stats;
+    }
+
+    void set_spike_exchange(spike_exchange_kind kind) {
+        communicator_.set_sparse_exchange(kind==spike_exchange_kind::sparse);
+    }
+
+    void set_spike_encoding(spike_encoding_kind kind, time_type time_quantum) {
+        if (!(time_quantum>=0)) {
+            throw arbor_exception("spike time quantum must be non-negative");
+        }
+        communicator_.set_compact_encoding(kind==spike_encoding_kind::compact, time_quantum);
+    }
+
+    void quantize_connection_weights() {
+        communicator_.quantize_connection_weights();
+    }
+
+    void quantize_connection_delays(time_type delay_quantum) {
+        communicator_.quantize_connection_delays(delay_quantum);
+    }
+
     spike_export_function global_export_callback_;
     spike_export_function local_export_callback_;
 
@@ -87,17 +202,35 @@ private:
         return event_lanes_[epoch_id%2];
     }
 
+    // Spikes generated in an epoch, and the events generated by their exchange.
+    thread_private_spike_store& local_spikes(std::size_t epoch_id) {
+        return local_spikes_[epoch_id%pipeline_depth_];
+    }
+
+    std::vector<pse_vector>& exchange_events(std::size_t epoch_id) {
+        return exchange_events_[epoch_id%pipeline_depth_];
+    }
+
     // keep track of information about the current integration interval
     epoch epoch_;
 
     time_type t_ = 0.;
     time_type min_delay_;
+    time_type min_remote_delay_;
+    int num_domains_;
+    int domain_id_;
     std::vector<cell_group_ptr> cell_groups_;
 
     // one set of event_generators for each local cell
     std::vector<std::vector<event_generator>> event_generators_;
 
-    std::unique_ptr<spike_double_buffer> local_spikes_;
+    // The spike exchange for an epoch may lag its integration by up to
+    // pipeline_depth_-1 epochs: keep a ring of spike stores and exchanged
+    // events, with one entry for each epoch in flight.
+    unsigned pipeline_depth_ = 0;
+    std::vector<thread_private_spike_store> local_spikes_;
+    std::vector<std::vector<pse_vector>> exchange_events_;
+    pipeline_stats pipeline_stats_;
 
     // Hash table for looking up the the local index of a cell with a given gid
     struct gid_local_info {
@@ -106,6 +239,9 @@ private:
     };
     std::unordered_map<cell_gid_type, gid_local_info> gid_to_local_;
 
+    // Time and memory of each phase of construction.
+    std::vector<setup_phase> setup_profile_;
+
     communicator communicator_;
 
     task_system_handle task_system_;
@@ -114,13 +250,26 @@ private:
     std::array<std::vector<pse_vector>, 2> event_lanes_;
     std::vector<pse_vector> pending_events_;
 
+    // Per-thread storage reused by setup_events for merging events.
+    threading::enumerable_thread_specific<event_merge_scratch> merge_scratch_;
+
     // Sampler associations handles are managed by a helper class.
     util::handle_set<sampler_association_handle> sassoc_handles_;
 
+    // Sample buffers of columnar sampler associations, notified after each epoch.
+    std::vector<std::pair<sampler_association_handle, sample_buffer_ptr>> sample_buffers_;
+
+    // Scheduling of cell group updates, and the per-group advance times
+    // on which it is based.
+    group_scheduling_kind group_scheduling_ = group_scheduling_kind::each;
+    std::vector<double> group_advance_times_;
+    std::vector<cell_size_type> group_order_;
+
     // Apply a functional to each cell group in parallel.
+    // Cell groups are coarse-grained, so each is given its own task.
     template <typename L>
     void foreach_group(L&& fn) {
-        threading::parallel_for::apply(0, cell_groups_.size(), task_system_.get(),
+        threading::parallel_for::apply(0, cell_groups_.size(), 1, task_system_.get(),
             [&, fn = std::forward<L>(fn)](int i) { fn(cell_groups_[i]); });
     }
 
@@ -128,58 +277,130 @@ private:
     // the cell group pointer reference and index.
     template <typename L>
     void foreach_group_index(L&& fn) {
-        threading::parallel_for::apply(0, cell_groups_.size(), task_system_.get(),
+        threading::parallel_for::apply(0, cell_groups_.size(), 1, task_system_.get(),
             [&, fn = std::forward<L>(fn)](int i) { fn(cell_groups_[i], i); });
     }
+
+    // Apply a functional to each cell group in parallel, distributed over
+    // threads according to the group scheduling policy.
+    template <typename L>
+    void foreach_group_scheduled(L&& fn);
+};
+
+// Record the wall time and change in allocated memory between construction
+// and destruction as a phase of the setup profile.
+struct setup_phase_recorder {
+    std::vector<setup_phase>& phases;
+    std::string name;
+    tick_type start_time = profile::timer<>::tic();
+    hw::memory_size_type start_memory = hw::allocated_memory();
+
+    setup_phase_recorder(std::vector<setup_phase>& p, std::string n):
+        phases(p), name(std::move(n))
+    {}
+
+    ~setup_phase_recorder() {
+        auto memory = start_memory<0? 0: hw::allocated_memory()-start_memory;
+        phases.push_back({std::move(name), profile::timer<>::toc(start_time), memory});
+    }
 };
 
+static communicator make_communicator(
+        const recipe& rec,
+        const domain_decomposition& decomp,
+        execution_context& ctx,
+        std::vector<setup_phase>& phases)
+{
+    setup_phase_recorder phase(phases, "communicator");
+    return communicator(rec, decomp, ctx);
+}
+
 simulation_state::simulation_state(
         const recipe& rec,
         const domain_decomposition& decomp,
         execution_context ctx
     ):
-    local_spikes_(new spike_double_buffer(thread_private_spike_store(ctx.thread_pool),
-                                          thread_private_spike_store(ctx.thread_pool))),
-    communicator_(rec, decomp, ctx),
-    task_system_(ctx.thread_pool)
+    communicator_(make_communicator(rec, decomp, ctx, setup_profile_)),
+    task_system_(ctx.thread_pool),
+    merge_scratch_(ctx.thread_pool)
 {
     const auto num_local_cells = communicator_.num_local_cells();
 
     // Cache the minimum delay of the network
     min_delay_ = communicator_.min_delay();
+    min_remote_delay_ = communicator_.min_delay(source_domain::remote);
+    num_domains_ = ctx.distributed->size();
+    domain_id_ = ctx.distributed->id();
 
     // Initialize empty buffers for pending events for each local cell
     pending_events_.resize(num_local_cells);
 
-    event_generators_.resize(num_local_cells);
-    cell_size_type lidx = 0;
-    cell_size_type grpidx = 0;
-    for (const auto& group_info: decomp.groups) {
-        for (auto gid: group_info.gids) {
-            // Store mapping of gid to local cell index.
-            gid_to_local_[gid] = gid_local_info{lidx, grpidx};
-
-            // Set up the event generators for cell gid.
-            event_generators_[lidx] = rec.event_generators(gid);
-            ++lidx;
+    {
+        PE(init_event_generators);
+        setup_phase_recorder phase(setup_profile_, "event_generators");
+
+        std::vector<cell_gid_type> gids;
+        gids.reserve(num_local_cells);
+        gid_to_local_.reserve(num_local_cells);
+        cell_size_type grpidx = 0;
+        for (const auto& group_info: decomp.groups) {
+            for (auto gid: group_info.gids) {
+                // Store mapping of gid to local cell index.
+                gid_to_local_[gid] = gid_local_info{cell_size_type(gids.size()), grpidx};
+                gids.push_back(gid);
+            }
+            ++grpidx;
         }
-        ++grpidx;
+
+        // Set up the event generators for each cell, querying the recipe in parallel.
+        event_generators_.resize(num_local_cells);
+        threading::parallel_for::apply(0, num_local_cells, task_system_.get(),
+            [&](cell_size_type i) { event_generators_[i] = rec.event_generators(gids[i]); });
+        PL();
     }
 
-    // Generate the cell groups in parallel, with one task per cell group.
-    cell_groups_.resize(decomp.groups.size());
-    foreach_group_index(
-        [&](cell_group_ptr& group, int i) {
-            const auto& group_info = decomp.groups[i];
-            auto factory = cell_kind_implementation(group_info.kind, group_info.backend, ctx);
-            group = factory(group_info.gids, rec);
-        });
+    {
+        PE(init_cell_groups);
+        setup_phase_recorder phase(setup_profile_, "cell_groups");
+
+        // Generate the cell groups in parallel, with one task per cell group.
+        // Cable cells with the same contents are discretized once.
+        auto cache = std::make_shared<fvm_discretization_cache>();
+        cell_groups_.resize(decomp.groups.size());
+        foreach_group_index(
+            [&](cell_group_ptr& group, int i) {
+                const auto& group_info = decomp.groups[i];
+                auto factory = cell_kind_implementation(group_info.kind, group_info.backend, ctx, cache);
+                group = factory(group_info.gids, rec);
+            });
+        PL();
+    }
 
     // Create event lane buffers.
     // There is one set for each epoch: current (0) and next (1).
     // For each epoch there is one lane for each cell in the cell group.
     event_lanes_[0].resize(num_local_cells);
     event_lanes_[1].resize(num_local_cells);
+
+    group_advance_times_.assign(cell_groups_.size(), 0.);
+
+    set_pipeline_depth(2);
+}
+
+void simulation_state::set_pipeline_depth(unsigned depth) {
+    if (!depth) {
+        throw arbor_exception("pipeline depth must be at least one");
+    }
+
+    // Outside of run() the spike stores and exchanged events are empty.
+    pipeline_depth_ = depth;
+    local_spikes_.clear();
+    for (unsigned i = 0; i<depth; ++i) {
+        local_spikes_.emplace_back(task_system_);
+    }
+    exchange_events_.assign(depth, std::vector<pse_vector>(communicator_.num_local_cells()));
+
+    pipeline_stats_.depth = depth;
 }
 
 void simulation_state::reset() {
@@ -207,42 +428,100 @@ void simulation_state::reset() {
         lane.clear();
     }
 
+    std::fill(group_advance_times_.begin(), group_advance_times_.end(), 0.);
+    pipeline_stats_ = pipeline_stats{};
+    pipeline_stats_.depth = pipeline_depth_;
+
     communicator_.reset();
 
-    local_spikes_->current().clear();
-    local_spikes_->previous().clear();
+    for (auto& store: local_spikes_) {
+        store.clear();
+    }
+    for (auto& lanes: exchange_events_) {
+        for (auto& lane: lanes) {
+            lane.clear();
+        }
+    }
 }
 
 time_type simulation_state::run(time_type tfinal, time_type dt) {
-    // Calculate the size of the largest possible time integration interval
-    // before communication of spikes is required.
-    // If spike exchange and cell update are serialized, this is the
-    // minimum delay of the network, however we use half this period
-    // to overlap communication and computation.
-    const time_type t_interval = min_delay_/2;
+    using timer = profile::timer<>;
+
+    // Integrate in epochs of length Delta/depth, where Delta is the minimum
+    // delay in the global system. The spikes generated in epoch k give rise
+    // to events no earlier than the start of epoch k+depth, so the exchange
+    // of those spikes can overlap the integration of epochs k+1, ..., k+depth-1.
+    // A depth of one serializes exchange and integration.
+    const unsigned depth = pipeline_depth_;
+    const time_type t_interval = min_delay_/depth;
+
+    // Spikes from sources on other domains give rise to events no earlier
+    // than L = floor(Delta_remote/t_interval) epochs later, where Delta_remote
+    // is the minimum delay of connections between domains. If L exceeds the
+    // depth, the spikes of exchange_period = L-depth consecutive epochs are
+    // exchanged together, keeping one epoch in reserve against the rounding
+    // of epoch boundaries, while the events from local sources are generated
+    // for each epoch without an exchange.
+    std::size_t exchange_period = 1;
+    if (num_domains_>1 && t_<tfinal) {
+        const double max_epochs = std::ceil((tfinal-t_)/t_interval)+depth+1;
+        const double epochs = std::min(std::floor(min_remote_delay_/t_interval), max_epochs);
+        if (epochs>depth+1) {
+            exchange_period = epochs-depth;
+        }
+    }
+    const auto remote_sources = exchange_period>1? source_domain::remote: source_domain::any;
+    std::vector<spike> period_spikes;
+
+    // Wall time in communication, and in waiting for it.
+    double exchange_time = 0, setup_time = 0, exposed_time = 0;
+    double update_time = 0;
 
     // task that updates cell state in parallel.
     auto update_cells = [&] () {
-        foreach_group_index(
+        auto t0 = timer::tic();
+        foreach_group_scheduled(
             [&](cell_group_ptr& group, int i) {
                 auto queues = util::subrange_view(event_lanes(epoch_.id), communicator_.group_queue_range(i));
+                auto t0 = timer::tic();
                 group->advance(epoch_, dt, queues);
+                double elapsed = timer::toc(t0);
+
+                // Exponential moving average, seeded with the first measurement.
+                double& avg = group_advance_times_[i];
+                avg = avg? 0.5*(avg+elapsed): elapsed;
 
                 PE(advance_spikes);
-                local_spikes_->current().insert(group->spikes());
+                local_spikes(epoch_.id).insert(group->spikes());
                 group->clear_spikes();
                 PL();
             });
+        update_time = timer::toc(t0);
     };
 
-    // task that performs spike exchange with the spikes generated in
-    // the previous integration period, generating the postsynaptic
-    // events that must be delivered at the start of the next
-    // integration period at the latest.
-    auto exchange = [&] () {
+    // Spike exchange with the spikes generated in epoch k, generating the
+    // postsynaptic events that must be delivered from epoch k+depth.
+    // With an exchange period, the spikes are exchanged at the end of each
+    // period, or of the run.
+    auto exchange = [&] (std::size_t k, bool last) {
+        auto t0 = timer::tic();
         PE(communication_exchange_gatherlocal);
-        auto local_spikes = local_spikes_->previous().gather();
+        auto local_spikes = local_spikes_[k%depth].gather();
         PL();
+
+        if (exchange_period>1) {
+            PE(communication_walkspikes);
+            communicator_.make_local_event_queues(local_spikes, exchange_events(k));
+            PL();
+
+            util::append(period_spikes, local_spikes);
+            if ((k+1)%exchange_period && !last) {
+                exchange_time += timer::toc(t0);
+                return;
+            }
+            local_spikes = std::move(period_spikes);
+            period_spikes.clear();
+        }
         auto global_spikes = communicator_.exchange(local_spikes);
 
         PE(communication_spikeio);
@@ -255,44 +534,300 @@ time_type simulation_state::run(time_type tfinal, time_type dt) {
         PL();
 
         PE(communication_walkspikes);
-        communicator_.make_event_queues(global_spikes, pending_events_);
+        communicator_.make_event_queues(global_spikes, exchange_events(k), remote_sources);
         PL();
+        ++pipeline_stats_.num_exchanges;
+        exchange_time += timer::toc(t0);
+    };
+
+    // Spike exchanges run in epoch order, concurrently with integration.
+    // The queue is declared after the exchange and the state it captures: if
+    // the integration throws, its destructor completes the submitted
+    // exchanges before these are destroyed.
+    serial_task_queue comm(task_system_.get());
+
+    // task that sets up the event lanes for the epoch following the current
+    // one, once the exchange that supplies its events has completed.
+    auto setup_next = [&] () {
+        const auto id = epoch_.id;
+        if (id+2>depth) {
+            comm.wait(id+2-depth);
+        }
 
-        const auto t0 = epoch_.tfinal;
-        const auto t1 = std::min(tfinal, t0+t_interval);
-        setup_events(t0, t1, epoch_.id);
+        auto t0 = timer::tic();
+        const auto t_from = epoch_.tfinal;
+        const auto t_to = std::min(tfinal, t_from+t_interval);
+        setup_events(t_from, t_to, id);
+        setup_time += timer::toc(t0);
     };
 
+    // The event lanes and exchanged events are empty at the start of run():
+    // the lanes for the first epoch are set up from the pending events.
+    auto t_start = timer::tic();
     time_type tuntil = std::min(t_+t_interval, tfinal);
     epoch_ = epoch(0, tuntil);
     setup_events(t_, tuntil, 1);
-    while (t_<tfinal) {
-        local_spikes_->exchange();
+    setup_time += timer::toc(t_start);
+    exposed_time += timer::toc(t_start);
 
-        // empty the spike buffers for the current integration period.
-        // these buffers will store the new spikes generated in update_cells.
-        local_spikes_->current().clear();
+    while (t_<tfinal) {
+        // empty the spike store for the current epoch, last read by the
+        // exchange for epoch id-depth.
+        local_spikes(epoch_.id).clear();
 
         // run the tasks, overlapping if the threading model and number of
         // available threads permits it.
+        auto t0 = timer::tic();
         threading::task_group g(task_system_.get());
-        g.run(exchange);
         g.run(update_cells);
+        if (depth>1) {
+            g.run(setup_next);
+        }
         g.wait();
 
+        // The samples of the epoch are complete.
+        for (auto& entry: sample_buffers_) {
+            entry.second->notify();
+        }
+
+        comm.submit([&exchange, k = epoch_.id, last = tuntil>=tfinal] { exchange(k, last); });
+        if (depth==1) {
+            setup_next();
+        }
+        exposed_time += std::max(0., timer::toc(t0)-update_time);
+        ++pipeline_stats_.num_epochs;
+
         t_ = tuntil;
 
         tuntil = std::min(t_+t_interval, tfinal);
         epoch_.advance(tuntil);
     }
 
-    // Run the exchange one last time to ensure that all spikes are output to file.
-    local_spikes_->exchange();
-    exchange();
+    // Complete the outstanding exchanges to ensure that all spikes are output,
+    // and return the undelivered events to the pending events for the next
+    // call to run().
+    auto t_end = timer::tic();
+    comm.wait(epoch_.id);
+
+    threading::parallel_for::apply(0, communicator_.num_local_cells(), task_system_.get(),
+        [&](cell_size_type i) {
+            auto& pending = pending_events_[i];
+            util::append(pending, event_lanes(epoch_.id)[i]);
+            for (auto& lanes: exchange_events_) {
+                util::append(pending, lanes[i]);
+                lanes[i].clear();
+            }
+            for (auto& lanes: event_lanes_) {
+                lanes[i].clear();
+            }
+        });
+    communicator_.update_num_spikes();
+    setup_time += timer::toc(t_end);
+    exposed_time += timer::toc(t_end);
+
+    pipeline_stats_.epoch_length = t_interval;
+    pipeline_stats_.communication_time += exchange_time+setup_time;
+    pipeline_stats_.exposed_time += exposed_time;
 
     return t_;
 }
 
+// Checkpoints hold the state of the simulation on one domain, outside of
+// run(), when all undelivered events are held in the pending events:
+//
+//   "ARBCKPT1", u32 version, u32 number of domains, u32 domain id,
+//   gids of local cells, time, number of spikes,
+//   for each cell group: u32 cell kind, state of group,
+//   for each local cell: pending events.
+//
+// The state of each cell group is written and read in parallel, via a
+// separate buffer per group. Event generators are not written: they are
+// queried monotonically from time zero, so their positions are recovered on
+// restore by replaying them from a reset up to the checkpoint time.
+
+static constexpr char checkpoint_magic[8] = {'A', 'R', 'B', 'C', 'K', 'P', 'T', '1'};
+static constexpr std::uint32_t checkpoint_version = 1;
+
+void simulation_state::checkpoint(std::ostream& out) {
+    std::vector<std::string> group_state(cell_groups_.size());
+    foreach_group_index(
+        [&](cell_group_ptr& group, int i) {
+            std::ostringstream buf;
+            checkpoint_writer w(buf);
+            group->checkpoint(w);
+            group_state[i] = buf.str();
+        });
+
+    std::vector<cell_gid_type> gids(communicator_.num_local_cells());
+    for (auto& entry: gid_to_local_) {
+        gids[entry.second.cell_index] = entry.first;
+    }
+
+    checkpoint_writer w(out);
+    w.write(checkpoint_magic);
+    w.write(checkpoint_version);
+    w.write<std::uint32_t>(num_domains_);
+    w.write<std::uint32_t>(domain_id_);
+    w.write(gids);
+    w.write(t_);
+    w.write<std::uint64_t>(communicator_.num_spikes());
+
+    for (auto i: util::count_along(cell_groups_)) {
+        w.write(cell_groups_[i]->get_cell_kind());
+        w.write_values(group_state[i].data(), group_state[i].size());
+    }
+    for (auto& lane: pending_events_) {
+        w.write(lane);
+    }
+}
+
+void simulation_state::restore(std::istream& in) {
+    checkpoint_reader r(in);
+
+    char magic[sizeof(checkpoint_magic)];
+    for (auto& c: magic) {
+        c = r.read<char>();
+    }
+    if (!std::equal(magic, magic+sizeof(magic), checkpoint_magic)) {
+        throw bad_checkpoint("not an arbor checkpoint");
+    }
+    r.expect(checkpoint_version, "checkpoint version");
+    r.expect<std::uint32_t>(num_domains_, "number of domains");
+    r.expect<std::uint32_t>(domain_id_, "domain id");
+
+    auto gids = r.read_vector<cell_gid_type>(communicator_.num_local_cells(), "local cell gids");
+    for (auto& entry: gid_to_local_) {
+        if (gids[entry.second.cell_index]!=entry.first) {
+            throw bad_checkpoint("local cell gids do not match simulation");
+        }
+    }
+
+    auto t = r.read<time_type>();
+    auto num_spikes = r.read<std::uint64_t>();
+
+    std::vector<std::string> group_state(cell_groups_.size());
+    for (auto i: util::count_along(cell_groups_)) {
+        r.expect(cell_groups_[i]->get_cell_kind(), "cell kind");
+        auto state = r.read_vector<char>();
+        group_state[i].assign(state.begin(), state.end());
+    }
+
+    std::vector<pse_vector> pending(pending_events_.size());
+    for (auto& lane: pending) {
+        lane = r.read_vector<spike_event>();
+    }
+
+    // The checkpoint has been read: restore the state of the simulation.
+    std::vector<std::exception_ptr> errors(cell_groups_.size());
+    foreach_group_index(
+        [&](cell_group_ptr& group, int i) {
+            try {
+                std::istringstream buf(group_state[i]);
+                checkpoint_reader r(buf);
+                group->restore(r);
+                if (buf.peek()!=std::istringstream::traits_type::eof()) {
+                    throw bad_checkpoint("state of cell group does not match simulation");
+                }
+            }
+            catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    for (auto& e: errors) {
+        if (e) std::rethrow_exception(e);
+    }
+
+    t_ = t;
+    communicator_.set_num_spikes(num_spikes);
+    pending_events_ = std::move(pending);
+
+    threading::parallel_for::apply(0, communicator_.num_local_cells(), task_system_.get(),
+        [&](cell_size_type i) {
+            for (auto& gen: event_generators_[i]) {
+                gen.reset();
+                gen.events(0, t_);
+            }
+            for (auto& lanes: event_lanes_) {
+                lanes[i].clear();
+            }
+            for (auto& lanes: exchange_events_) {
+                lanes[i].clear();
+            }
+        });
+
+    for (auto& store: local_spikes_) {
+        store.clear();
+    }
+}
+
+std::vector<cell_size_type> balanced_group_divisions(const std::vector<double>& cost, unsigned n) {
+    const cell_size_type ngroups = cost.size();
+    std::vector<cell_size_type> divs = {0};
+    if (!ngroups || !n) {
+        divs.push_back(ngroups);
+        return divs;
+    }
+
+    double total = std::accumulate(cost.begin(), cost.end(), 0.);
+    const bool uniform = total<=0;
+    if (uniform) total = ngroups;
+    auto cost_of = [&](cell_size_type i) { return uniform? 1.: cost[i]; };
+
+    // Close chunk k once the running cost reaches k/n of the total, or earlier
+    // if adding the next group would overshoot by more than stopping short.
+    double acc = 0;
+    for (cell_size_type i = 0; i<ngroups; ++i) {
+        double target = total*divs.size()/n;
+        double c = cost_of(i);
+        if (i>divs.back() && divs.size()<n && acc+c-target>target-acc) {
+            divs.push_back(i);
+        }
+        acc += c;
+    }
+    divs.push_back(ngroups);
+    return divs;
+}
+
+template <typename L>
+void simulation_state::foreach_group_scheduled(L&& fn) {
+    const cell_size_type ngroups = cell_groups_.size();
+    const unsigned nthreads = task_system_->get_num_threads();
+
+    switch (group_scheduling_) {
+    case group_scheduling_kind::each:
+        foreach_group_index(std::forward<L>(fn));
+        break;
+    case group_scheduling_kind::balanced: {
+        auto divs = balanced_group_divisions(group_advance_times_, nthreads);
+        threading::parallel_for::apply(0, divs.size()-1, 1, task_system_.get(),
+            [&](int c) {
+                for (auto i = divs[c]; i<divs[c+1]; ++i) {
+                    fn(cell_groups_[i], i);
+                }
+            });
+        break;
+    }
+    case group_scheduling_kind::largest_first: {
+        group_order_.resize(ngroups);
+        std::iota(group_order_.begin(), group_order_.end(), 0);
+        std::stable_sort(group_order_.begin(), group_order_.end(),
+            [&](cell_size_type a, cell_size_type b) {
+                return group_advance_times_[a]>group_advance_times_[b];
+            });
+
+        std::atomic<cell_size_type> next{0};
+        threading::parallel_for::apply(0, std::min<cell_size_type>(nthreads, ngroups), 1, task_system_.get(),
+            [&](int) {
+                for (cell_size_type k; (k = next++)<ngroups;) {
+                    auto i = group_order_[k];
+                    fn(cell_groups_[i], i);
+                }
+            });
+        break;
+    }
+    }
+}
+
 template <typename Seq, typename Value, typename Less = std::less<>>
 auto split_sorted_range(Seq&& seq, const Value& v, Less cmp = Less{}) {
     auto canon = util::canonical_view(seq);
@@ -307,75 +842,131 @@ auto split_sorted_range(Seq&& seq, const Value& v, Less cmp = Less{}) {
 // On completion event_lanes[epoch+1] will contain sorted lists of events with
 // delivery times due in or after epoch+1. The events will be taken from the
 // following sources:
-//      event_lanes[epoch]: take all events ≥ t_from
-//      event_generators  : take all events < t_to
-//      pending_events    : take all events
-
-// merge_cell_events() is a separate function for unit testing purposes.
-void merge_cell_events(
+//      event_lanes[epoch]         : take all events ≥ t_from
+//      event_generators           : take all events < t_to
+//      pending_events             : take all events
+//      exchange_events[epoch+1]   : take all events, i.e. those generated by
+//                                   the spikes of epoch+1-depth
+//
+// The events generated from the spikes of each source arrive in time order:
+// the pending events are sorted by merging these runs pairwise, or if the
+// runs are short on average, by a sort. The sorted pending events are then
+// merged with the other sources.
+
+// Merge into new_events the sorted event sequences in scratch.spans,
+// the events in old_events at or after t_from, and the generator events
+// in [t_from, t_to).
+static void merge_staged_events(
     time_type t_from,
     time_type t_to,
     event_span old_events,
-    event_span pending,
     std::vector<event_generator>& generators,
-    pse_vector& new_events)
+    pse_vector& new_events,
+    event_merge_scratch& scratch)
 {
     PE(communication_enqueue_setup);
+    auto& spans = scratch.spans;
     new_events.clear();
-    old_events = split_sorted_range(old_events, t_from, event_time_less()).second;
-    PL();
 
-    if (!generators.empty()) {
-        PE(communication_enqueue_setup);
-        // Tree-merge events in [t_from, t_to) from old, pending and generator events.
-
-        std::vector<event_span> spanbuf;
-        spanbuf.reserve(2+generators.size());
+    old_events = split_sorted_range(old_events, t_from, event_time_less()).second;
+    if (!old_events.empty()) {
+        spans.push_back(old_events);
+    }
 
-        auto old_split = split_sorted_range(old_events, t_to, event_time_less());
-        auto pending_split = split_sorted_range(pending, t_to, event_time_less());
+    for (auto& g: generators) {
+        event_span evs = g.events(t_from, t_to);
+        if (!evs.empty()) {
+            spans.push_back(evs);
+        }
+    }
 
-        spanbuf.push_back(old_split.first);
-        spanbuf.push_back(pending_split.first);
+    // Drop empty sequences.
+    spans.erase(std::remove_if(spans.begin(), spans.end(), [](event_span s) { return s.empty(); }), spans.end());
+    PL();
 
-        for (auto& g: generators) {
-            event_span evs = g.events(t_from, t_to);
-            if (!evs.empty()) {
-                spanbuf.push_back(evs);
-            }
-        }
+    switch (spans.size()) {
+    case 0:
+        break;
+    case 1:
+        PE(communication_enqueue_merge);
+        new_events.assign(spans[0].begin(), spans[0].end());
         PL();
-
+        break;
+    case 2:
+        PE(communication_enqueue_merge);
+        new_events.resize(spans[0].size()+spans[1].size());
+        std::merge(spans[0].begin(), spans[0].end(), spans[1].begin(), spans[1].end(), new_events.begin());
+        PL();
+        break;
+    default:
         PE(communication_enqueue_tree);
-        tree_merge_events(spanbuf, new_events);
+        tree_merge_events(spans, new_events, scratch.tree);
         PL();
+    }
+}
+
+// Sort pending in place and append it to scratch.spans. Pending events form
+// sorted runs, which are merged pairwise if they are long enough for merging
+// to be faster than sorting: see the event_staging ubench.
+static void stage_pending_events(pse_vector& pending, event_merge_scratch& scratch) {
+    constexpr std::size_t min_mean_run_length = 8;
+
+    const auto n = pending.size();
+    if (!n) return;
 
-        old_events = old_split.second;
-        pending = pending_split.second;
+    auto& bounds = scratch.run_bounds;
+    bounds.assign(1, 0);
+    for (std::size_t i = 1; i<n; ++i) {
+        if (pending[i]<pending[i-1]) bounds.push_back(i);
     }
+    bounds.push_back(n);
 
-    // Merge (remaining) old and pending events.
-    PE(communication_enqueue_merge);
-    auto n = new_events.size();
-    new_events.resize(n+pending.size()+old_events.size());
-    std::merge(pending.begin(), pending.end(), old_events.begin(), old_events.end(), new_events.begin()+n);
-    PL();
+    const auto nruns = bounds.size()-1;
+    if (nruns>1) {
+        if (nruns*min_mean_run_length>n) {
+            util::sort(pending);
+        }
+        else {
+            merge_sorted_runs(pending, bounds, scratch.buffer);
+        }
+    }
+    scratch.spans.push_back(util::range_pointer_view(pending));
+}
+
+// merge_cell_events() is a separate function for unit testing purposes.
+// The pending events must be sorted.
+void merge_cell_events(
+    time_type t_from,
+    time_type t_to,
+    event_span old_events,
+    event_span pending,
+    std::vector<event_generator>& generators,
+    pse_vector& new_events)
+{
+    event_merge_scratch scratch;
+    scratch.spans.push_back(pending);
+    merge_staged_events(t_from, t_to, old_events, generators, new_events, scratch);
 }
 
 void simulation_state::setup_events(time_type t_from, time_type t_to, std::size_t epoch) {
     const auto n = communicator_.num_local_cells();
     threading::parallel_for::apply(0, n, task_system_.get(),
         [&](cell_size_type i) {
+            auto& scratch = merge_scratch_.local();
+
+            auto& exchanged = exchange_events(epoch+1)[i];
+
             PE(communication_enqueue_sort);
-            util::sort(pending_events_[i]);
+            scratch.spans.clear();
+            stage_pending_events(pending_events_[i], scratch);
+            stage_pending_events(exchanged, scratch);
             PL();
 
-            event_span pending = util::range_pointer_view(pending_events_[i]);
             event_span old_events = util::range_pointer_view(event_lanes(epoch)[i]);
-
-            merge_cell_events(t_from, t_to, old_events, pending, event_generators_[i], event_lanes(epoch+1)[i]);
+            merge_staged_events(t_from, t_to, old_events, event_generators_[i], event_lanes(epoch+1)[i], scratch);
             pending_events_[i].clear();
-            });
+            exchanged.clear();
+        });
 }
 
 sampler_association_handle simulation_state::add_sampler(
@@ -392,10 +983,38 @@ sampler_association_handle simulation_state::add_sampler(
     return h;
 }
 
+sampler_association_handle simulation_state::add_sampler(
+        cell_member_predicate probe_ids,
+        schedule sched,
+        sample_buffer_ptr buffer,
+        sampling_policy policy)
+{
+    if (!buffer) {
+        throw arbor_exception("sample buffer is null");
+    }
+    for (auto& entry: sample_buffers_) {
+        if (entry.second==buffer) {
+            throw arbor_exception("sample buffer is already attached to a sampler association");
+        }
+    }
+
+    sampler_association_handle h = sassoc_handles_.acquire();
+
+    foreach_group(
+        [&](cell_group_ptr& group) { group->add_sampler(h, probe_ids, sched, buffer, policy); });
+
+    sample_buffers_.push_back({h, std::move(buffer)});
+    return h;
+}
+
 void simulation_state::remove_sampler(sampler_association_handle h) {
     foreach_group(
         [h](cell_group_ptr& group) { group->remove_sampler(h); });
 
+    sample_buffers_.erase(
+        std::remove_if(sample_buffers_.begin(), sample_buffers_.end(), [h](auto& entry) { return entry.first==h; }),
+        sample_buffers_.end());
+
     sassoc_handles_.release(h);
 }
 
@@ -403,6 +1022,8 @@ void simulation_state::remove_all_samplers() {
     foreach_group(
         [](cell_group_ptr& group) { group->remove_all_samplers(); });
 
+    sample_buffers_.clear();
+
     sassoc_handles_.clear();
 }
 
@@ -452,6 +1073,14 @@ time_type simulation::run(time_type tfinal, time_type dt) {
     return impl_->run(tfinal, dt);
 }
 
+void simulation::checkpoint(std::ostream& out) const {
+    impl_->checkpoint(out);
+}
+
+void simulation::restore(std::istream& in) {
+    impl_->restore(in);
+}
+
 sampler_association_handle simulation::add_sampler(
     cell_member_predicate probe_ids,
     schedule sched,
@@ -461,6 +1090,15 @@ sampler_association_handle simulation::add_sampler(
     return impl_->add_sampler(std::move(probe_ids), std::move(sched), std::move(f), policy);
 }
 
+sampler_association_handle simulation::add_sampler(
+    cell_member_predicate probe_ids,
+    schedule sched,
+    sample_buffer_ptr buffer,
+    sampling_policy policy)
+{
+    return impl_->add_sampler(std::move(probe_ids), std::move(sched), std::move(buffer), policy);
+}
+
 void simulation::remove_sampler(sampler_association_handle h) {
     impl_->remove_sampler(h);
 }
@@ -481,6 +1119,42 @@ void simulation::set_binning_policy(binning_kind policy, time_type bin_interval)
     impl_->set_binning_policy(policy, bin_interval);
 }
 
+void simulation::set_group_scheduling(group_scheduling_kind policy) {
+    impl_->set_group_scheduling(policy);
+}
+
+std::vector<double> simulation::group_advance_times() const {
+    return impl_->group_advance_times();
+}
+
+void simulation::set_pipeline_depth(unsigned depth) {
+    impl_->set_pipeline_depth(depth);
+}
+
+const std::vector<setup_phase>& simulation::setup_profile() const {
+    return impl_->setup_profile();
+}
+
+pipeline_stats simulation::get_pipeline_stats() const {
+    return impl_->get_pipeline_stats();
+}
+
+void simulation::set_spike_exchange(spike_exchange_kind kind) {
+    impl_->set_spike_exchange(kind);
+}
+
+void simulation::set_spike_encoding(spike_encoding_kind kind, time_type time_quantum) {
+    impl_->set_spike_encoding(kind, time_quantum);
+}
+
+void simulation::quantize_connection_weights() {
+    impl_->quantize_connection_weights();
+}
+
+void simulation::quantize_connection_delays(time_type delay_quantum) {
+    impl_->quantize_connection_delays(delay_quantum);
+}
+
 void simulation::set_global_spike_callback(spike_export_function export_callback) {
     impl_->global_export_callback_ = std::move(export_callback);
 }
@@ -69,6 +69,22 @@ void spike_source_cell_group::clear_spikes() {
     spikes_.clear();
 }
 
+void spike_source_cell_group::checkpoint(checkpoint_writer& out) const {
+    out.write(t_);
+}
+
+void spike_source_cell_group::restore(checkpoint_reader& in) {
+    t_ = in.read<time_type>();
+
+    // Schedules are queried monotonically from time zero, so the position of
+    // a schedule at t_ is recovered by replaying it from a reset.
+    for (auto& s: time_sequences_) {
+        s.reset();
+        s.events(0, t_);
+    }
+    clear_spikes();
+}
+
 void spike_source_cell_group::add_sampler(sampler_association_handle, cell_member_predicate, schedule, sampler_function, sampling_policy) {
     throw std::logic_error("A spike_source_cell group doen't support sampling of internal state!");
 }
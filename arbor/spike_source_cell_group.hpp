@@ -29,6 +29,10 @@ public:
 
     void clear_spikes() override;
 
+    void checkpoint(checkpoint_writer&) const override;
+
+    void restore(checkpoint_reader&) override;
+
     void add_sampler(sampler_association_handle h, cell_member_predicate probe_ids, schedule sched, sampler_function fn, sampling_policy policy) override;
 
     void remove_sampler(sampler_association_handle h) override {}
@@ -56,41 +56,199 @@ void notification_queue::quit() {
     q_tasks_available_.notify_all();
 }
 
+task_pool::~task_pool() {
+    for (auto p: free_) ::operator delete(p);
+}
+
+void* task_pool::allocate() {
+    if (free_.empty()) return ::operator new(sizeof(task_node));
+    auto p = free_.back();
+    free_.pop_back();
+    return p;
+}
+
+void task_pool::deallocate(void* p) {
+    if (free_.size()<max_free) {
+        free_.push_back(p);
+    }
+    else {
+        ::operator delete(p);
+    }
+}
+
+work_stealing_deque::work_stealing_deque(std::int64_t capacity) {
+    std::int64_t n = 1;
+    while (n<capacity) n *= 2;
+    rings_.emplace_back(new ring(n));
+    ring_.store(rings_.back().get(), std::memory_order_relaxed);
+}
+
+work_stealing_deque::~work_stealing_deque() {
+    while (pop()) {}
+}
+
+work_stealing_deque::ring* work_stealing_deque::grow(ring* r, std::int64_t top, std::int64_t bottom) {
+    rings_.emplace_back(new ring(2*r->capacity()));
+    ring* g = rings_.back().get();
+    for (auto i = top; i<bottom; ++i) {
+        g->put(i, r->get(i));
+    }
+    ring_.store(g, std::memory_order_release);
+    return g;
+}
+
+void work_stealing_deque::push(task_ptr t) {
+    auto b = bottom_.load(std::memory_order_relaxed);
+    auto tp = top_.load(std::memory_order_acquire);
+    ring* r = ring_.load(std::memory_order_relaxed);
+    if (b-tp>r->capacity()-1) {
+        r = grow(r, tp, b);
+    }
+    r->put(b, t.release());
+    bottom_.store(b+1, std::memory_order_release);
+}
+
+task_ptr work_stealing_deque::pop() {
+    auto b = bottom_.load(std::memory_order_relaxed)-1;
+    ring* r = ring_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto tp = top_.load(std::memory_order_relaxed);
+
+    task_node* t = nullptr;
+    if (tp<=b) {
+        t = r->get(b);
+        if (tp==b) {
+            // Last element: race against steal().
+            if (!top_.compare_exchange_strong(tp, tp+1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                t = nullptr;
+            }
+            bottom_.store(b+1, std::memory_order_relaxed);
+        }
+    }
+    else {
+        bottom_.store(b+1, std::memory_order_relaxed);
+    }
+    return task_ptr(t);
+}
+
+task_ptr work_stealing_deque::steal() {
+    auto tp = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto b = bottom_.load(std::memory_order_acquire);
+
+    task_node* t = nullptr;
+    if (tp<b) {
+        ring* r = ring_.load(std::memory_order_acquire);
+        t = r->get(tp);
+        if (!top_.compare_exchange_strong(tp, tp+1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            t = nullptr;
+        }
+    }
+    return task_ptr(t);
+}
+
+bool work_stealing_deque::empty() const {
+    auto b = bottom_.load(std::memory_order_relaxed);
+    auto tp = top_.load(std::memory_order_relaxed);
+    return b<=tp;
+}
+
+namespace {
+// Identifies the pool and index of a worker thread.
+struct worker_identity {
+    const task_system* owner = nullptr;
+    int index = -1;
+};
+
+thread_local worker_identity this_worker;
+}
+
+int task_system::current_index() const {
+    if (this_worker.owner==this) return this_worker.index;
+    return std::this_thread::get_id()==main_thread_id_? 0: -1;
+}
+
+task_ptr task_system::find_task(int i) {
+    task_ptr tsk;
+    if (i>=0) {
+        tsk = deques_[i].pop();
+    }
+    if (!tsk) {
+        lock l{injected_mutex_, std::try_to_lock};
+        if (l && !injected_.empty()) {
+            tsk = std::move(injected_.front());
+            injected_.pop_front();
+        }
+    }
+    for (unsigned n = 1; !tsk && n<=count_; ++n) {
+        unsigned victim = (i+n)%count_;
+        if ((int)victim!=i) tsk = deques_[victim].steal();
+    }
+    if (tsk) {
+        --num_queued_;
+        // The node is released to the pool of the thread that runs it.
+        tsk.get_deleter().pool = i>=0? &pools_[i]: nullptr;
+    }
+    return tsk;
+}
+
+void task_system::push(int i, task_ptr tsk) {
+    ++num_queued_;
+    if (i>=0) {
+        deques_[i].push(std::move(tsk));
+    }
+    else {
+        lock l{injected_mutex_};
+        injected_.push_back(std::move(tsk));
+    }
+
+    // Wake a sleeping worker, if any. The increment of num_queued_ above and
+    // of num_sleeping_ in run_tasks_loop() are sequentially consistent, so
+    // either the sleeper sees the new task or we see the sleeper.
+    if (num_sleeping_.load()) {
+        { lock l{sleep_mutex_}; }
+        sleep_cv_.notify_one();
+    }
+}
+
 void task_system::run_tasks_loop(int i){
+    this_worker = worker_identity{this, i};
     while (true) {
-        task tsk;
-        for (unsigned n = 0; n != count_; n++) {
-            tsk = q_[(i + n) % count_].try_pop();
-            if (tsk) break;
+        if (auto tsk = find_task(i)) {
+            (*tsk)();
+            continue;
         }
-        if (!tsk) tsk = q_[i].pop();
-        if (!tsk) break;
-        tsk();
+
+        lock l{sleep_mutex_};
+        ++num_sleeping_;
+        while (!num_queued_.load() && !quit_) {
+            sleep_cv_.wait(l);
+        }
+        --num_sleeping_;
+        if (quit_ && !num_queued_.load()) break;
     }
 }
 
 void task_system::try_run_task() {
-    auto nthreads = get_num_threads();
-    task tsk;
-    for (int n = 0; n != nthreads; n++) {
-        tsk = q_[n % nthreads].try_pop();
-        if (tsk) {
-            tsk();
-            break;
-        }
+    if (auto tsk = find_task(current_index())) {
+        (*tsk)();
     }
 }
 
 // Default construct with one thread.
 task_system::task_system(): task_system(1) {}
 
-task_system::task_system(int nthreads): count_(nthreads), q_(nthreads) {
+task_system::task_system(int nthreads):
+    count_(nthreads), pools_(nthreads > 0? nthreads: 0), deques_(nthreads > 0? nthreads: 0)
+{
     if (nthreads <= 0)
         throw std::runtime_error("Non-positive number of threads in thread pool");
 
     // Main thread
     auto tid = std::this_thread::get_id();
     thread_ids_[tid] = 0;
+    main_thread_id_ = tid;
 
     for (unsigned i = 1; i < count_; i++) {
         threads_.emplace_back([this, i]{run_tasks_loop(i);});
@@ -100,17 +258,12 @@ task_system::task_system(int nthreads): count_(nthreads), q_(nthreads) {
 }
 
 task_system::~task_system() {
-    for (auto& e: q_) e.quit();
-    for (auto& e: threads_) e.join();
-}
-
-void task_system::async(task tsk) {
-    auto i = index_++;
-
-    for (unsigned n = 0; n != count_; n++) {
-        if (q_[(i + n) % count_].try_push(tsk)) return;
+    {
+        lock l{sleep_mutex_};
+        quit_ = true;
     }
-    q_[i % count_].push(std::move(tsk));
+    sleep_cv_.notify_all();
+    for (auto& e: threads_) e.join();
 }
 
 int task_system::get_num_threads() const {
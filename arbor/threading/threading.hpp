@@ -5,11 +5,15 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <vector>
 #include <unordered_map>
 #include <utility>
@@ -50,6 +54,137 @@ public:
     // Finish popping all waiting tasks on queue then stop trying to pop new tasks
     void quit();
 };
+
+// Storage for the task nodes of one thread: nodes released by the thread are
+// kept for reuse, up to max_free of them, so that a thread that runs as many
+// tasks as it creates allocates no memory.
+class task_pool {
+public:
+    static constexpr std::size_t max_free = 1024;
+
+    task_pool() = default;
+    task_pool(task_pool&&) = default;
+    ~task_pool();
+
+    void* allocate();
+    void deallocate(void* p);
+
+private:
+    std::vector<void*> free_;
+};
+
+// A task in a fixed-size, type-erased node. Callables of up to inline_size
+// bytes, such as the wrapped pieces of parallel_for, are stored in the node;
+// larger ones on the heap. A node is released through its deleter, to the
+// pool of the thread that ran it if set, or else to the heap.
+class task_node {
+public:
+    static constexpr std::size_t inline_size = 64;
+
+    struct deleter {
+        task_pool* pool = nullptr;
+
+        void operator()(task_node* t) const {
+            t->~task_node();
+            if (pool) pool->deallocate(t);
+            else ::operator delete(t);
+        }
+    };
+
+    template <typename F>
+    static std::unique_ptr<task_node, deleter> make(F&& f, task_pool* pool = nullptr) {
+        void* p = pool? pool->allocate(): ::operator new(sizeof(task_node));
+        try {
+            return std::unique_ptr<task_node, deleter>(new (p) task_node(std::forward<F>(f)), deleter{pool});
+        }
+        catch (...) {
+            if (pool) pool->deallocate(p);
+            else ::operator delete(p);
+            throw;
+        }
+    }
+
+    task_node(const task_node&) = delete;
+    task_node& operator=(const task_node&) = delete;
+
+    ~task_node() { destroy_(storage_); }
+
+    void operator()() { invoke_(storage_); }
+
+private:
+    template <typename D>
+    static constexpr bool fits_inline =
+        sizeof(D)<=inline_size && alignof(D)<=alignof(std::max_align_t);
+
+    template <typename F, typename D = std::decay_t<F>>
+    explicit task_node(F&& f) {
+        if constexpr (fits_inline<D>) {
+            new (storage_) D(std::forward<F>(f));
+            invoke_ = [](void* p) { (*static_cast<D*>(p))(); };
+            destroy_ = [](void* p) { static_cast<D*>(p)->~D(); };
+        }
+        else {
+            new (storage_) D*(new D(std::forward<F>(f)));
+            invoke_ = [](void* p) { (**static_cast<D**>(p))(); };
+            destroy_ = [](void* p) { delete *static_cast<D**>(p); };
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[inline_size];
+    void (*invoke_)(void*);
+    void (*destroy_)(void*);
+};
+
+using task_ptr = std::unique_ptr<task_node, task_node::deleter>;
+
+// Lock-free work-stealing deque after Chase and Lev (SPAA 2005), with the
+// memory orderings of Le et al. (PPoPP 2013).
+//
+// Only the owning thread may call push() and pop(), which operate on the
+// bottom of the deque; any thread may call steal(), which takes from the top.
+// pop() and steal() return an empty task pointer if there is nothing to take
+// or if they lose a race for the last element; the pointers they return
+// release their tasks to the heap, unless given a pool.
+class work_stealing_deque {
+private:
+    struct ring {
+        explicit ring(std::int64_t capacity):
+            mask(capacity-1), data(new std::atomic<task_node*>[capacity])
+        {}
+
+        std::int64_t capacity() const { return mask+1; }
+        task_node* get(std::int64_t i) const { return data[i&mask].load(std::memory_order_relaxed); }
+        void put(std::int64_t i, task_node* t) { data[i&mask].store(t, std::memory_order_relaxed); }
+
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<task_node*>[]> data;
+    };
+
+    alignas(64) std::atomic<std::int64_t> top_{0};
+    alignas(64) std::atomic<std::int64_t> bottom_{0};
+    std::atomic<ring*> ring_;
+
+    // Rings replaced by growth are retained until destruction, as a
+    // concurrent steal() may still be reading from them.
+    std::vector<std::unique_ptr<ring>> rings_;
+
+    ring* grow(ring* r, std::int64_t top, std::int64_t bottom);
+
+public:
+    explicit work_stealing_deque(std::int64_t capacity = 256);
+
+    work_stealing_deque(const work_stealing_deque&) = delete;
+    work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+    // Deletes any tasks that were never taken.
+    ~work_stealing_deque();
+
+    void push(task_ptr t);
+    task_ptr pop();
+    task_ptr steal();
+
+    bool empty() const;
+};
 }// namespace impl
 
 class task_system {
@@ -58,14 +193,36 @@ private:
 
     std::vector<std::thread> threads_;
 
-    // queue of tasks
-    std::vector<impl::notification_queue> q_;
+    // One pool of task nodes and one work-stealing deque per thread,
+    // including the main thread at index 0.
+    std::vector<impl::task_pool> pools_;
+    std::vector<impl::work_stealing_deque> deques_;
+
+    // Tasks submitted from threads that do not belong to the pool.
+    mutex injected_mutex_;
+    std::deque<impl::task_ptr> injected_;
 
     // threads -> index
     std::unordered_map<std::thread::id, std::size_t> thread_ids_;
+    std::thread::id main_thread_id_;
+
+    // Idle worker threads sleep on sleep_cv_ until a task is queued or the
+    // task system is shut down.
+    std::atomic<std::size_t> num_queued_{0};
+    std::atomic<unsigned> num_sleeping_{0};
+    std::atomic<bool> quit_{false};
+    mutex sleep_mutex_;
+    condition_variable sleep_cv_;
 
-    // total number of tasks pushed in all queues
-    std::atomic<unsigned> index_{0};
+    // Index of the calling thread in the pool, or -1 if it is not a pool thread.
+    int current_index() const;
+
+    // Take a task from the deque of thread i, the injected queue, or by
+    // stealing from another thread, in that order of preference.
+    impl::task_ptr find_task(int i);
+
+    // Queue a task created by thread i.
+    void push(int i, impl::task_ptr tsk);
 
 public:
     task_system();
@@ -78,8 +235,14 @@ public:
 
     ~task_system();
 
-    // Pushes tasks into notification queue.
-    void async(task tsk);
+    // Pushes task onto the calling thread's deque, from where it may be
+    // stolen by idle threads. Tasks from threads outside the pool are
+    // placed on a shared queue.
+    template <typename F>
+    void async(F f) {
+        int i = current_index();
+        push(i, impl::task_node::make(std::move(f), i>=0? &pools_[i]: nullptr));
+    }
 
     // Runs tasks until quit is true.
     void run_tasks_loop(int i);
@@ -126,8 +289,9 @@ private:
     std::atomic<std::size_t> in_flight_{0};
 
     // Set by run(), cleared by wait(). Used to check task completion status
-    // in destructor.
-    bool running_ = false;
+    // in destructor. Atomic because tasks may run() further tasks in the
+    // same group, as parallel_for does.
+    std::atomic<bool> running_{false};
 
     // We use a raw pointer here instead of a shared_ptr to avoid a race condition
     // on the destruction of a task_system that would lead to a thread trying to join itself.
@@ -163,8 +327,8 @@ public:
                 exception_status_(other.exception_status_)
         {}
 
-        // std::function is not guaranteed to not copy the contents on move construction,
-        // but the class is safe because we don't call operator() more than once on the same wrapped task.
+        // The task system moves wrapped tasks, but copies are safe, as
+        // operator() is not called more than once on the same wrapped task.
         wrap(const wrap& other):
                 f_(other.f_),
                 counter_(other.counter_),
@@ -194,7 +358,7 @@ public:
 
     template<typename F>
     void run(F&& f) {
-        running_ = true;
+        running_.store(true, std::memory_order_relaxed);
         ++in_flight_;
         task_system_->async(make_wrapped_function(std::forward<F>(f), in_flight_, exception_status_));
     }
@@ -204,7 +368,7 @@ public:
         while (in_flight_) {
             task_system_->try_run_task();
         }
-        running_ = false;
+        running_.store(false, std::memory_order_relaxed);
 
         if (auto ex = exception_status_.reset()) {
             std::rethrow_exception(ex);
@@ -212,7 +376,7 @@ public:
     }
 
     ~task_group() {
-        if (running_) std::terminate();
+        if (running_.load(std::memory_order_relaxed)) std::terminate();
     }
 };
 
@@ -220,14 +384,53 @@ public:
 // algorithms
 ///////////////////////////////////////////////////////////////////////
 struct parallel_for {
+    // Apply f to each index in [left, right).
+    //
+    // The range is split recursively: a task holding the upper half of a
+    // range is offered to the other threads while the lower half is split
+    // further, until pieces of at most grain_size indices remain. These are
+    // executed as a plain loop over f, so the per-index cost is a direct
+    // call, and the number of tasks is of order (right-left)/grain_size.
     template <typename F>
-    static void apply(int left, int right, task_system* ts, F f) {
+    static void apply(int left, int right, int grain_size, task_system* ts, F f) {
+        if (left>=right) return;
+
         task_group g(ts);
-        for (int i = left; i < right; ++i) {
-          g.run([=] {f(i);});
-        }
+        g.run(range_task<F>{left, right, std::max(grain_size, 1), &g, &f});
         g.wait();
     }
+
+    // Apply f to each index in [left, right) with a grain size chosen to
+    // give several pieces per thread.
+    template <typename F>
+    static void apply(int left, int right, task_system* ts, F f) {
+        apply(left, right, default_grain_size(right-left, ts), ts, std::move(f));
+    }
+
+    static int default_grain_size(int n, const task_system* ts) {
+        constexpr int pieces_per_thread = 8;
+        return std::max(1, n/(pieces_per_thread*ts->get_num_threads()));
+    }
+
+private:
+    template <typename F>
+    struct range_task {
+        int left, right, grain_size;
+        task_group* group;
+        F* f;
+
+        void operator()() const {
+            int r = right;
+            while (r-left>grain_size) {
+                int mid = left+(r-left)/2;
+                group->run(range_task{mid, r, grain_size, group, f});
+                r = mid;
+            }
+            for (int i = left; i<r; ++i) {
+                (*f)(i);
+            }
+        }
+    };
 };
 } // namespace threading
 
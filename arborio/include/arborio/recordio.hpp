@@ -0,0 +1,182 @@
+#pragma once
+
+// Streaming output of spikes and samples to a chunked binary columnar file,
+// and a reader for such files.
+//
+// A record file comprises a header, a sequence of chunks and an index of
+// the chunks. Each chunk holds the rows of one stream — the spikes, or the
+// samples of one concrete probe — column by column. The index records the
+// offset, row count and time range of each chunk, so that readers can seek
+// to the data of a stream or time window; if the file was not closed, the
+// chunks can still be recovered by scanning.
+//
+// Writes are buffered: completed chunks are serialized into one of two
+// buffers, which are handed in turn to a background thread for writing to
+// the file, so that output overlaps with simulation.
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <arbor/arbexcept.hpp>
+#include <arbor/common_types.hpp>
+#include <arbor/sample_buffer.hpp>
+#include <arbor/sampling.hpp>
+#include <arbor/simulation.hpp>
+#include <arbor/spike.hpp>
+
+namespace arborio {
+
+struct record_error: public arb::arbor_exception {
+    explicit record_error(const std::string& msg);
+};
+
+enum class record_chunk_kind: std::uint32_t {
+    stream = 1,  // => description of a sample stream.
+    spikes = 2,  // => spike source gids, indices and times.
+    samples = 3, // => sample times and values of one stream.
+    index = 4,   // => index of all preceding chunks.
+};
+
+// A stream of samples from one concrete probe.
+struct record_stream_info {
+    arb::cell_member_type probe_id;
+    arb::probe_tag tag;
+    unsigned index;  // Index of the probe within those of probe_id.
+    unsigned width;  // Number of values per sample.
+};
+
+// Index entry for one chunk.
+struct record_chunk_info {
+    record_chunk_kind kind;
+    std::uint32_t stream;  // Stream id of sample chunks.
+    std::uint64_t offset;  // Offset of chunk header in file.
+    std::uint64_t rows;
+    arb::time_type t_min;  // Time range of rows in chunk.
+    arb::time_type t_max;
+};
+
+class record_writer {
+public:
+    // Spikes and the samples of each stream are written in chunks of up
+    // to chunk_rows rows. Serialized chunks are passed to the background
+    // writer in blocks of about buffer_size bytes.
+    explicit record_writer(const std::string& path,
+                           std::size_t chunk_rows = 1<<16,
+                           std::size_t buffer_size = 1<<22);
+
+    record_writer(const record_writer&) = delete;
+    record_writer& operator=(const record_writer&) = delete;
+
+    // Closes the file if still open; errors are ignored.
+    ~record_writer();
+
+    // The methods below are thread safe.
+
+    void write_spikes(const std::vector<arb::spike>& spikes);
+
+    // Write the samples of a sampler call: the sample data must be
+    // `const double*` or `const cable_sample_range*`.
+    void write_samples(const arb::probe_metadata& meta, std::size_t n, const arb::sample_record* records);
+
+    // Write the samples held in a column.
+    void write_samples(const arb::sample_column& column);
+
+    // Adaptors for the simulation interface: a spike callback, a sampler,
+    // and a sample buffer notification that writes and clears all columns.
+    arb::spike_export_function spike_writer();
+    arb::sampler_function sampler();
+    arb::sample_notify_function sample_buffer_writer();
+
+    // Wait until all data so far has been written to the file, emitting
+    // partial chunks.
+    void flush();
+
+    // Flush, write the index and close the file.
+    void close();
+
+private:
+    struct stream_state {
+        record_stream_info info;
+        std::vector<arb::time_type> times;
+        std::vector<double> values;
+    };
+
+    std::size_t chunk_rows_;
+    std::size_t buffer_size_;
+    bool closed_ = false;
+
+    // Pending rows and the front buffer of serialized chunks, guarded by mutex_.
+    std::mutex mutex_;
+    std::vector<arb::spike> spikes_;
+    std::vector<stream_state> streams_;
+    std::map<std::pair<arb::cell_member_type, unsigned>, std::uint32_t> stream_ids_;
+    std::vector<char> front_;
+    std::vector<record_chunk_info> index_;
+    std::uint64_t committed_ = 0; // Bytes passed to the background writer.
+
+    // Back buffer and background writer state, guarded by io_mutex_.
+    std::mutex io_mutex_;
+    std::condition_variable io_cv_;
+    std::vector<char> back_;
+    bool back_full_ = false;
+    bool done_ = false;
+    std::string io_error_;
+    std::ofstream file_;
+    std::thread io_thread_;
+
+    std::uint32_t stream_id(const arb::probe_metadata& meta, unsigned width);
+    void append_sample(std::uint32_t id, arb::time_type t, const double* values);
+    void emit_spikes();
+    void emit_samples(stream_state& s);
+    void hand_off(bool wait);
+    void io_loop();
+};
+
+// Samples of one stream, with width values per sample stored contiguously.
+struct record_samples {
+    unsigned width = 0;
+    std::vector<arb::time_type> times;
+    std::vector<double> values;
+};
+
+class record_reader {
+public:
+    explicit record_reader(const std::string& path);
+
+    // False if the file was not closed, and the chunks were found by scanning.
+    bool indexed() const { return indexed_; }
+
+    const std::vector<record_stream_info>& streams() const { return streams_; }
+    const std::vector<record_chunk_info>& chunks() const { return chunks_; }
+
+    // Spikes and samples with times in [t0, t1), in order of writing. Chunks
+    // outside the interval are skipped.
+    std::vector<arb::spike> spikes(
+        arb::time_type t0 = std::numeric_limits<arb::time_type>::lowest(),
+        arb::time_type t1 = std::numeric_limits<arb::time_type>::max()) const;
+
+    record_samples samples(std::size_t stream,
+        arb::time_type t0 = std::numeric_limits<arb::time_type>::lowest(),
+        arb::time_type t1 = std::numeric_limits<arb::time_type>::max()) const;
+
+private:
+    std::string path_;
+    bool indexed_ = false;
+    std::vector<record_stream_info> streams_;
+    std::vector<record_chunk_info> chunks_;
+};
+
+// Aggregate record files, e.g. those written by each rank, into one file.
+// Sample streams are renumbered in order of the inputs.
+void merge_records(const std::vector<std::string>& inputs, const std::string& output);
+
+} // namespace arborio
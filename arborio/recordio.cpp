@@ -0,0 +1,605 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <arbor/cable_cell.hpp>
+#include <arbor/common_types.hpp>
+#include <arbor/sample_buffer.hpp>
+#include <arbor/sampling.hpp>
+#include <arbor/spike.hpp>
+#include <arbor/util/any_ptr.hpp>
+
+#include <arborio/recordio.hpp>
+
+namespace arborio {
+
+using arb::time_type;
+
+record_error::record_error(const std::string& msg):
+    arbor_exception("record file: "+msg)
+{}
+
+// File layout, in native byte order:
+//
+//   header:  "ARBREC01", u32 byte order mark, u32 version
+//   chunk:   u32 kind, u32 stream, u64 rows, u64 payload size, payload
+//   trailer: u64 offset of index chunk, "ARBRECIX"
+//
+// Chunk payloads by kind:
+//
+//   stream:  u32 probe gid, u32 probe index, i32 tag, u32 index, u32 width
+//   spikes:  u32 gid[rows], u32 index[rows], f64 time[rows]
+//   samples: f64 time[rows], f64 value[rows*width]
+//   index:   {u32 kind, u32 stream, u64 offset, u64 rows, f64 t_min, f64 t_max}[rows]
+
+namespace {
+constexpr char file_magic[8] = {'A', 'R', 'B', 'R', 'E', 'C', '0', '1'};
+constexpr char index_magic[8] = {'A', 'R', 'B', 'R', 'E', 'C', 'I', 'X'};
+constexpr std::uint32_t byte_order_mark = 0x01020304;
+constexpr std::uint32_t format_version = 1;
+
+constexpr std::size_t file_header_size = 16;
+constexpr std::size_t chunk_header_size = 24;
+constexpr std::size_t trailer_size = 16;
+constexpr std::size_t stream_payload_size = 20;
+constexpr std::size_t index_entry_size = 40;
+
+struct chunk_header {
+    std::uint32_t kind;
+    std::uint32_t stream;
+    std::uint64_t rows;
+    std::uint64_t size;
+};
+
+template <typename T>
+void put(std::vector<char>& buf, const T& v) {
+    const char* p = reinterpret_cast<const char*>(&v);
+    buf.insert(buf.end(), p, p+sizeof(T));
+}
+
+template <typename T>
+T get(const char*& p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+}
+
+void put_header(std::vector<char>& buf, record_chunk_kind kind, std::uint32_t stream, std::uint64_t rows, std::uint64_t size) {
+    put(buf, std::uint32_t(kind));
+    put(buf, stream);
+    put(buf, rows);
+    put(buf, size);
+}
+
+std::vector<char> read_bytes(std::ifstream& in, std::uint64_t offset, std::size_t n) {
+    std::vector<char> buf(n);
+    in.seekg(offset);
+    in.read(buf.data(), n);
+    if (!in) {
+        throw record_error("unexpected end of file");
+    }
+    return buf;
+}
+
+chunk_header read_chunk_header(std::ifstream& in, std::uint64_t offset) {
+    auto buf = read_bytes(in, offset, chunk_header_size);
+    const char* p = buf.data();
+    chunk_header h;
+    h.kind = get<std::uint32_t>(p);
+    h.stream = get<std::uint32_t>(p);
+    h.rows = get<std::uint64_t>(p);
+    h.size = get<std::uint64_t>(p);
+    return h;
+}
+
+std::vector<char> read_payload(std::ifstream& in, const record_chunk_info& c, std::uint64_t size) {
+    return read_bytes(in, c.offset+chunk_header_size, size);
+}
+
+std::ifstream open_record_file(const std::string& path, std::uint64_t& file_size) {
+    std::ifstream in(path, std::ios::binary|std::ios::ate);
+    if (!in) {
+        throw record_error("unable to open "+path);
+    }
+    file_size = in.tellg();
+
+    if (file_size<file_header_size) {
+        throw record_error(path+" is not a record file");
+    }
+    auto buf = read_bytes(in, 0, file_header_size);
+    const char* p = buf.data()+sizeof(file_magic);
+    if (std::memcmp(buf.data(), file_magic, sizeof(file_magic))) {
+        throw record_error(path+" is not a record file");
+    }
+    if (get<std::uint32_t>(p)!=byte_order_mark) {
+        throw record_error(path+" has foreign byte order");
+    }
+    if (get<std::uint32_t>(p)!=format_version) {
+        throw record_error(path+" has unsupported version");
+    }
+    return in;
+}
+
+// Read the chunk index from the trailer, or else recover it by scanning the
+// chunks, up to the first incomplete chunk. Returns true if indexed.
+bool read_chunk_index(std::ifstream& in, std::uint64_t file_size, std::vector<record_chunk_info>& chunks) {
+    chunks.clear();
+
+    if (file_size>=file_header_size+chunk_header_size+trailer_size) {
+        auto buf = read_bytes(in, file_size-trailer_size, trailer_size);
+        const char* p = buf.data();
+        auto index_offset = get<std::uint64_t>(p);
+
+        if (!std::memcmp(p, index_magic, sizeof(index_magic)) && index_offset+chunk_header_size<=file_size) {
+            auto h = read_chunk_header(in, index_offset);
+            if (h.kind==std::uint32_t(record_chunk_kind::index) && h.size==h.rows*index_entry_size) {
+                auto entries = read_bytes(in, index_offset+chunk_header_size, h.size);
+                const char* q = entries.data();
+                for (std::uint64_t i = 0; i<h.rows; ++i) {
+                    record_chunk_info c;
+                    c.kind = record_chunk_kind(get<std::uint32_t>(q));
+                    c.stream = get<std::uint32_t>(q);
+                    c.offset = get<std::uint64_t>(q);
+                    c.rows = get<std::uint64_t>(q);
+                    c.t_min = get<double>(q);
+                    c.t_max = get<double>(q);
+                    chunks.push_back(c);
+                }
+                return true;
+            }
+        }
+    }
+
+    for (std::uint64_t offset = file_header_size; offset+chunk_header_size<=file_size;) {
+        auto h = read_chunk_header(in, offset);
+        if (h.kind==std::uint32_t(record_chunk_kind::index) || offset+chunk_header_size+h.size>file_size) {
+            break;
+        }
+
+        record_chunk_info c{record_chunk_kind(h.kind), h.stream, offset, h.rows, 0, 0};
+        std::uint64_t time_offset = offset+chunk_header_size;
+        switch (c.kind) {
+        case record_chunk_kind::spikes:
+            time_offset += 2*sizeof(std::uint32_t)*h.rows;
+            break;
+        case record_chunk_kind::samples:
+            break;
+        default:
+            h.rows = 0;
+        }
+        if (h.rows) {
+            auto buf = read_bytes(in, time_offset, h.rows*sizeof(double));
+            const double* t = reinterpret_cast<const double*>(buf.data());
+            auto minmax = std::minmax_element(t, t+h.rows);
+            c.t_min = *minmax.first;
+            c.t_max = *minmax.second;
+        }
+        chunks.push_back(c);
+        offset += chunk_header_size+h.size;
+    }
+    return false;
+}
+
+void put_index(std::vector<char>& buf, std::uint64_t offset, const std::vector<record_chunk_info>& index) {
+    put_header(buf, record_chunk_kind::index, 0, index.size(), index.size()*index_entry_size);
+    for (auto& c: index) {
+        put(buf, std::uint32_t(c.kind));
+        put(buf, c.stream);
+        put(buf, c.offset);
+        put(buf, c.rows);
+        put(buf, c.t_min);
+        put(buf, c.t_max);
+    }
+    put(buf, offset);
+    buf.insert(buf.end(), index_magic, index_magic+sizeof(index_magic));
+}
+
+void put_file_header(std::vector<char>& buf) {
+    buf.insert(buf.end(), file_magic, file_magic+sizeof(file_magic));
+    put(buf, byte_order_mark);
+    put(buf, format_version);
+}
+} // anonymous namespace
+
+// record_writer implementation.
+
+record_writer::record_writer(const std::string& path, std::size_t chunk_rows, std::size_t buffer_size):
+    chunk_rows_(std::max<std::size_t>(chunk_rows, 1)),
+    buffer_size_(buffer_size),
+    file_(path, std::ios::binary|std::ios::trunc)
+{
+    if (!file_) {
+        throw record_error("unable to open "+path+" for writing");
+    }
+    put_file_header(front_);
+    io_thread_ = std::thread([this] { io_loop(); });
+}
+
+record_writer::~record_writer() {
+    try {
+        close();
+    }
+    catch (...) {}
+}
+
+void record_writer::write_spikes(const std::vector<arb::spike>& spikes) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (closed_) throw record_error("write after close");
+
+    spikes_.insert(spikes_.end(), spikes.begin(), spikes.end());
+    if (spikes_.size()>=chunk_rows_) {
+        emit_spikes();
+    }
+    if (front_.size()>=buffer_size_) {
+        hand_off(false);
+    }
+}
+
+void record_writer::write_samples(const arb::probe_metadata& meta, std::size_t n, const arb::sample_record* records) {
+    if (!n) return;
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (closed_) throw record_error("write after close");
+
+    std::uint32_t id = 0;
+    for (std::size_t i = 0; i<n; ++i) {
+        const double* values;
+        unsigned width;
+        if (auto p = arb::util::any_cast<const double*>(records[i].data)) {
+            values = p;
+            width = 1;
+        }
+        else if (auto p = arb::util::any_cast<const arb::cable_sample_range*>(records[i].data)) {
+            values = p->first;
+            width = p->second-p->first;
+        }
+        else {
+            throw record_error("unsupported sample type");
+        }
+
+        if (i==0) {
+            id = stream_id(meta, width);
+        }
+        else if (width!=streams_[id].info.width) {
+            throw record_error("inconsistent sample width for probe");
+        }
+        append_sample(id, records[i].time, values);
+    }
+    if (front_.size()>=buffer_size_) {
+        hand_off(false);
+    }
+}
+
+void record_writer::write_samples(const arb::sample_column& column) {
+    if (column.empty()) return;
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (closed_) throw record_error("write after close");
+
+    auto id = stream_id(column.metadata(), column.width());
+    for (std::size_t i = 0; i<column.size(); ++i) {
+        append_sample(id, column.time(i), column.values(i));
+    }
+    if (front_.size()>=buffer_size_) {
+        hand_off(false);
+    }
+}
+
+arb::spike_export_function record_writer::spike_writer() {
+    return [this](const std::vector<arb::spike>& spikes) { write_spikes(spikes); };
+}
+
+arb::sampler_function record_writer::sampler() {
+    return [this](arb::probe_metadata meta, std::size_t n, const arb::sample_record* records) {
+        write_samples(meta, n, records);
+    };
+}
+
+arb::sample_notify_function record_writer::sample_buffer_writer() {
+    return [this](arb::sample_buffer& buffer) {
+        for (std::size_t i = 0; i<buffer.size(); ++i) {
+            write_samples(buffer[i]);
+        }
+        buffer.clear();
+    };
+}
+
+void record_writer::flush() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (closed_) return;
+
+    emit_spikes();
+    for (auto& s: streams_) {
+        emit_samples(s);
+    }
+    hand_off(true);
+}
+
+// The background writer is stopped and joined even if the final hand off
+// fails, before the error is rethrown.
+void record_writer::close() {
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (closed_) return;
+        closed_ = true;
+
+        try {
+            emit_spikes();
+            for (auto& s: streams_) {
+                emit_samples(s);
+            }
+            put_index(front_, committed_+front_.size(), index_);
+            hand_off(true);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(io_mutex_);
+        done_ = true;
+    }
+    io_cv_.notify_all();
+    io_thread_.join();
+    file_.close();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (!io_error_.empty()) {
+        throw record_error(io_error_);
+    }
+}
+
+std::uint32_t record_writer::stream_id(const arb::probe_metadata& meta, unsigned width) {
+    auto key = std::make_pair(meta.id, meta.index);
+    if (auto i = stream_ids_.find(key); i!=stream_ids_.end()) {
+        if (streams_[i->second].info.width!=width) {
+            throw record_error("inconsistent sample width for probe");
+        }
+        return i->second;
+    }
+
+    std::uint32_t id = streams_.size();
+    stream_ids_[key] = id;
+    streams_.push_back({{meta.id, meta.tag, meta.index, width}, {}, {}});
+
+    index_.push_back({record_chunk_kind::stream, id, committed_+front_.size(), 1, 0, 0});
+    put_header(front_, record_chunk_kind::stream, id, 1, stream_payload_size);
+    put(front_, std::uint32_t(meta.id.gid));
+    put(front_, std::uint32_t(meta.id.index));
+    put(front_, std::int32_t(meta.tag));
+    put(front_, std::uint32_t(meta.index));
+    put(front_, std::uint32_t(width));
+    return id;
+}
+
+void record_writer::append_sample(std::uint32_t id, time_type t, const double* values) {
+    auto& s = streams_[id];
+    s.times.push_back(t);
+    s.values.insert(s.values.end(), values, values+s.info.width);
+    if (s.times.size()>=chunk_rows_) {
+        emit_samples(s);
+    }
+}
+
+// Serialize pending spikes into chunks of at most chunk_rows_ rows.
+void record_writer::emit_spikes() {
+    for (std::size_t first = 0; first<spikes_.size(); first += chunk_rows_) {
+        std::size_t n = std::min(chunk_rows_, spikes_.size()-first);
+        auto b = spikes_.begin()+first;
+        auto e = b+n;
+
+        auto minmax = std::minmax_element(b, e, [](auto& x, auto& y) { return x.time<y.time; });
+        index_.push_back({record_chunk_kind::spikes, 0, committed_+front_.size(), n, minmax.first->time, minmax.second->time});
+
+        put_header(front_, record_chunk_kind::spikes, 0, n, n*(2*sizeof(std::uint32_t)+sizeof(double)));
+        for (auto i = b; i!=e; ++i) put(front_, std::uint32_t(i->source.gid));
+        for (auto i = b; i!=e; ++i) put(front_, std::uint32_t(i->source.index));
+        for (auto i = b; i!=e; ++i) put(front_, double(i->time));
+    }
+    spikes_.clear();
+}
+
+// Serialize the pending samples of a stream into one chunk.
+void record_writer::emit_samples(stream_state& s) {
+    std::size_t n = s.times.size();
+    if (!n) return;
+
+    auto id = stream_ids_.at({s.info.probe_id, s.info.index});
+    auto minmax = std::minmax_element(s.times.begin(), s.times.end());
+    index_.push_back({record_chunk_kind::samples, id, committed_+front_.size(), n, *minmax.first, *minmax.second});
+
+    put_header(front_, record_chunk_kind::samples, id, n, (n+s.values.size())*sizeof(double));
+    for (auto t: s.times) put(front_, double(t));
+    for (auto v: s.values) put(front_, v);
+
+    s.times.clear();
+    s.values.clear();
+}
+
+// Pass the front buffer to the background writer, first waiting for the
+// write of the back buffer to complete. With wait, also wait for the write
+// of the front buffer. Called with mutex_ held.
+void record_writer::hand_off(bool wait) {
+    std::unique_lock<std::mutex> lock(io_mutex_);
+    io_cv_.wait(lock, [this] { return !back_full_; });
+    if (!io_error_.empty()) {
+        throw record_error(io_error_);
+    }
+
+    std::swap(front_, back_);
+    committed_ += back_.size();
+    back_full_ = true;
+    io_cv_.notify_all();
+
+    if (wait) {
+        io_cv_.wait(lock, [this] { return !back_full_; });
+        if (!io_error_.empty()) {
+            throw record_error(io_error_);
+        }
+    }
+}
+
+void record_writer::io_loop() {
+    std::unique_lock<std::mutex> lock(io_mutex_);
+    for (;;) {
+        io_cv_.wait(lock, [this] { return back_full_ || done_; });
+        if (!back_full_) break;
+
+        // The back buffer is not modified while back_full_ is set.
+        lock.unlock();
+        file_.write(back_.data(), back_.size());
+        file_.flush();
+        lock.lock();
+
+        if (!file_ && io_error_.empty()) {
+            io_error_ = "write failed";
+        }
+        back_.clear();
+        back_full_ = false;
+        io_cv_.notify_all();
+    }
+}
+
+// record_reader implementation.
+
+record_reader::record_reader(const std::string& path): path_(path) {
+    std::uint64_t file_size;
+    auto in = open_record_file(path, file_size);
+    indexed_ = read_chunk_index(in, file_size, chunks_);
+
+    for (auto& c: chunks_) {
+        if (c.kind!=record_chunk_kind::stream) continue;
+
+        auto buf = read_payload(in, c, stream_payload_size);
+        const char* p = buf.data();
+        record_stream_info s;
+        s.probe_id.gid = get<std::uint32_t>(p);
+        s.probe_id.index = get<std::uint32_t>(p);
+        s.tag = get<std::int32_t>(p);
+        s.index = get<std::uint32_t>(p);
+        s.width = get<std::uint32_t>(p);
+
+        if (c.stream!=streams_.size()) {
+            throw record_error(path+": unexpected stream id");
+        }
+        streams_.push_back(s);
+    }
+}
+
+std::vector<arb::spike> record_reader::spikes(time_type t0, time_type t1) const {
+    std::uint64_t file_size;
+    auto in = open_record_file(path_, file_size);
+
+    std::vector<arb::spike> result;
+    for (auto& c: chunks_) {
+        if (c.kind!=record_chunk_kind::spikes || c.t_max<t0 || c.t_min>=t1) continue;
+
+        auto n = c.rows;
+        auto buf = read_payload(in, c, n*(2*sizeof(std::uint32_t)+sizeof(double)));
+        const char* gid = buf.data();
+        const char* index = gid+n*sizeof(std::uint32_t);
+        const char* time = index+n*sizeof(std::uint32_t);
+
+        for (std::uint64_t i = 0; i<n; ++i) {
+            arb::spike s;
+            s.source.gid = get<std::uint32_t>(gid);
+            s.source.index = get<std::uint32_t>(index);
+            s.time = get<double>(time);
+            if (s.time>=t0 && s.time<t1) {
+                result.push_back(s);
+            }
+        }
+    }
+    return result;
+}
+
+record_samples record_reader::samples(std::size_t stream, time_type t0, time_type t1) const {
+    if (stream>=streams_.size()) {
+        throw record_error("no stream "+std::to_string(stream)+" in "+path_);
+    }
+
+    std::uint64_t file_size;
+    auto in = open_record_file(path_, file_size);
+
+    record_samples result;
+    const unsigned width = result.width = streams_[stream].width;
+
+    for (auto& c: chunks_) {
+        if (c.kind!=record_chunk_kind::samples || c.stream!=stream || c.t_max<t0 || c.t_min>=t1) continue;
+
+        auto n = c.rows;
+        auto buf = read_payload(in, c, (n+n*width)*sizeof(double));
+        const char* time = buf.data();
+        const char* value = time+n*sizeof(double);
+
+        for (std::uint64_t i = 0; i<n; ++i) {
+            auto t = get<double>(time);
+            if (t>=t0 && t<t1) {
+                result.times.push_back(t);
+                auto v = result.values.size();
+                result.values.resize(v+width);
+                std::memcpy(result.values.data()+v, value, width*sizeof(double));
+            }
+            value += width*sizeof(double);
+        }
+    }
+    return result;
+}
+
+void merge_records(const std::vector<std::string>& inputs, const std::string& output) {
+    std::ofstream out(output, std::ios::binary|std::ios::trunc);
+    if (!out) {
+        throw record_error("unable to open "+output+" for writing");
+    }
+
+    std::vector<char> buf;
+    put_file_header(buf);
+    out.write(buf.data(), buf.size());
+    std::uint64_t offset = buf.size();
+
+    std::vector<record_chunk_info> index;
+    std::uint32_t stream_base = 0;
+    for (auto& path: inputs) {
+        record_reader reader(path);
+        std::uint64_t file_size;
+        auto in = open_record_file(path, file_size);
+
+        for (auto c: reader.chunks()) {
+            auto h = read_chunk_header(in, c.offset);
+            auto chunk = read_bytes(in, c.offset, chunk_header_size+h.size);
+
+            // Renumber the stream of stream and sample chunks.
+            if (c.kind==record_chunk_kind::stream || c.kind==record_chunk_kind::samples) {
+                c.stream += stream_base;
+                std::memcpy(chunk.data()+sizeof(std::uint32_t), &c.stream, sizeof(std::uint32_t));
+            }
+            c.offset = offset;
+            index.push_back(c);
+
+            out.write(chunk.data(), chunk.size());
+            offset += chunk.size();
+        }
+        stream_base += reader.streams().size();
+    }
+
+    buf.clear();
+    put_index(buf, offset, index);
+    out.write(buf.data(), buf.size());
+    if (!out) {
+        throw record_error("write to "+output+" failed");
+    }
+}
+
+} // namespace arborio
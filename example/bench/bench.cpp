@@ -44,6 +44,9 @@ struct bench_params {
     std::string name = "default";    // Name of the model.
     unsigned num_cells = 1000;       // Number of cells in model.
     arb::time_type duration = 100;          // Simulation duration in ms.
+    std::string spike_exchange = "gather";  // Spike exchange method: "gather" or "sparse".
+    std::string spike_encoding = "full";    // Spike encoding in exchange: "full" or "compact".
+    arb::time_type spike_time_quantum = 0;  // Resolution of compact spike times in ms, or 0 for exact.
 
     cell_params cell;                // Cell parameters for all cells in model.
     network_params network;          // Description of the network.
@@ -188,6 +191,11 @@ int main(int argc, char** argv) {
 
         // Construct the model.
         arb::simulation sim(recipe, decomp, context);
+        sim.set_spike_exchange(params.spike_exchange=="sparse"?
+            arb::spike_exchange_kind::sparse: arb::spike_exchange_kind::gather);
+        sim.set_spike_encoding(params.spike_encoding=="compact"?
+            arb::spike_encoding_kind::compact: arb::spike_encoding_kind::full,
+            params.spike_time_quantum);
         meters.checkpoint("model-build", context);
 
         // Run the simulation for 100 ms, with time steps of 0.01 ms.
@@ -210,6 +218,13 @@ int main(int argc, char** argv) {
         std::cout << summary << "\n";
 
         std::cout << "there were " << sim.num_spikes() << " spikes\n";
+
+        auto stats = sim.get_pipeline_stats();
+        if (stats.num_epochs) {
+            std::cout << "spike exchange per epoch on root domain: "
+                      << stats.bytes_sent/stats.num_epochs << " bytes sent, "
+                      << stats.bytes_received/stats.num_epochs << " bytes received\n";
+        }
     }
     catch (std::exception& e) {
         std::cerr << "exception caught running benchmark miniapp:\n" << e.what() << std::endl;
@@ -224,7 +239,9 @@ std::ostream& operator<<(std::ostream& o, const bench_params& p) {
       << "  fan in:        " << p.network.fan_in << " connections/cell\n"
       << "  min delay:     " << p.network.min_delay << " ms\n"
       << "  spike freq:    " << p.cell.spike_freq_hz << " Hz\n"
-      << "  cell overhead: " << p.cell.realtime_ratio << " ms to advance 1 ms\n";
+      << "  cell overhead: " << p.cell.realtime_ratio << " ms to advance 1 ms\n"
+      << "  exchange:      " << p.spike_exchange << "\n"
+      << "  encoding:      " << p.spike_encoding << ", time quantum " << p.spike_time_quantum << " ms\n";
     o << "expected:\n"
       << "  cell advance: " << p.expected_advance_time() << " s\n"
       << "  spikes:       " << p.expected_spikes() << "\n"
@@ -264,6 +281,15 @@ bench_params read_options(int argc, char** argv) {
     param_from_json(params.network.fan_in, "fan-in", json);
     param_from_json(params.cell.realtime_ratio, "realtime-ratio", json);
     param_from_json(params.cell.spike_freq_hz, "spike-frequency", json);
+    param_from_json(params.spike_exchange, "spike-exchange", json);
+    if (params.spike_exchange!="gather" && params.spike_exchange!="sparse") {
+        throw std::runtime_error("spike-exchange must be \"gather\" or \"sparse\"");
+    }
+    param_from_json(params.spike_encoding, "spike-encoding", json);
+    param_from_json(params.spike_time_quantum, "spike-time-quantum", json);
+    if (params.spike_encoding!="full" && params.spike_encoding!="compact") {
+        throw std::runtime_error("spike-encoding must be \"full\" or \"compact\"");
+    }
 
     for (auto it=json.begin(); it!=json.end(); ++it) {
         std::cout << "  Warning: unused input parameter: \"" << it.key() << "\"\n";
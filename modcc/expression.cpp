@@ -103,7 +103,10 @@ void IdentifierExpression::semantic(scope_ptr scp) {
     // procedure.
     //
     // If, however, we are in a PROCEDURE or FUNCTION block, we do not
-    // have access to indexed variables and this constitutes an error.
+    // have access to indexed variables and this constitutes an error, with
+    // the exception of the temperature in a FUNCTION: calls to the function
+    // are inlined into API blocks, or the function is tabulated for the
+    // temperature of the mechanism (see functiontables.hpp).
 
     if(auto sym = s->is_indexed_variable()) {
         if (scope_->in_api_context()) {
@@ -111,7 +114,7 @@ void IdentifierExpression::semantic(scope_ptr scp) {
             var->external_variable(sym);
             s = scope_->add_local_symbol(spelling_, scope_type::symbol_ptr{var});
         }
-        else {
+        else if (!(scope_->in_function_context() && sym->data_source()==sourceKind::temperature)) {
             error( pprintf("the symbol '%' refers to an external quantity "
                            "and is unavailable in a function or procedure",
                            yellow(spelling_)));
@@ -779,6 +782,7 @@ void FunctionExpression::semantic(scope_type::symbol_map &global_symbols) {
 
     // create the scope for this procedure
     scope_ = std::make_shared<scope_type>(global_symbols);
+    scope_->in_function_context(true);
     error_ = false;
 
     // add the argumemts to the list of local variables
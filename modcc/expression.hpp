@@ -4,6 +4,8 @@
 #include <limits>
 #include <list>
 #include <memory>
+#include <optional>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -1079,6 +1081,20 @@ public:
     void accept(Visitor *v) override;
 
     std::string to_string() const override;
+
+    // Locals assigned in the top level of the body from expressions of
+    // constants, scalar parameters and other invariant locals only: their
+    // values are the same for every instance of the mechanism, and may be
+    // computed once for all instances (see `hoist_invariants`).
+    const std::set<std::string>& invariant_locals() const {
+        return invariant_locals_;
+    }
+    void invariant_locals(std::set<std::string> names) {
+        invariant_locals_ = std::move(names);
+    }
+
+private:
+    std::set<std::string> invariant_locals_;
 };
 
 /// stores the INITIAL block in a NET_RECEIVE block, if there is one
@@ -1141,6 +1157,19 @@ public:
     void accept(Visitor *v) override;
 };
 
+// Tabulation of a FUNCTION of one argument at intervals+1 evenly spaced
+// points in [from, to]. Calls with an argument in [from, to] are evaluated
+// by linear interpolation in the table; other calls are evaluated directly.
+struct function_table {
+    double from = 0;
+    double to = 0;
+    unsigned intervals = 0;
+    std::vector<std::string> depend; // Variables named by DEPEND.
+    bool automatic = false;          // Selected by modcc rather than a TABLE statement.
+
+    double step() const { return (to-from)/intervals; }
+};
+
 class FunctionExpression : public Symbol {
 public:
     FunctionExpression( Location loc,
@@ -1176,6 +1205,12 @@ public:
         body_ = std::move(new_body);
     }
 
+    const function_table* table() const {
+        return table_? &*table_: nullptr;
+    }
+    void table(function_table t) { table_ = std::move(t); }
+    void clear_table() { table_.reset(); }
+
     FunctionExpression* is_function() override {return this;}
     void semantic(scope_type::symbol_map&) override;
     std::string to_string() const override;
@@ -1186,6 +1221,7 @@ private:
 
     std::vector<expression_ptr> args_;
     expression_ptr body_;
+    std::optional<function_table> table_;
 };
 
 ////////////////////////////////////////////////////////////
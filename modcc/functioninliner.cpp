@@ -6,7 +6,7 @@
 #include "errorvisitor.hpp"
 #include "symdiff.hpp"
 
-expression_ptr inline_function_calls(std::string calling_func, BlockExpression* block) {
+expression_ptr inline_function_calls(std::string calling_func, BlockExpression* block, bool inline_tabulated) {
     auto inline_block = block->clone();
 
     // The function inliner will inline one function at a time
@@ -15,7 +15,7 @@ expression_ptr inline_function_calls(std::string calling_func, BlockExpression*
     while(true) {
         inline_block->semantic(block->scope());
 
-        auto func_inliner = std::make_unique<FunctionInliner>(calling_func);
+        auto func_inliner = std::make_unique<FunctionInliner>(calling_func, inline_tabulated);
         inline_block->accept(func_inliner.get());
 
         if (!func_inliner->return_val_set()) {
@@ -130,7 +130,10 @@ void FunctionInliner::visit(AssignmentExpression* e) {
     // an Assignment Expression.
     // If we find a new function to inline, we can do so, provided we aren't already inlining
     // another function and we haven't inlined a function already.
-    if (!inlining_in_progress_ && !inlining_executed_ && e->rhs()->is_function_call()) {
+    // Calls to tabulated functions are left in place, to be printed as table lookups.
+    auto tabulated = [this](CallExpression* f) { return !inline_tabulated_ && f->function()->table(); };
+
+    if (!inlining_in_progress_ && !inlining_executed_ && e->rhs()->is_function_call() && !tabulated(e->rhs()->is_function_call())) {
         auto f = e->rhs()->is_function_call();
         auto& fargs = f->function()->args();
         auto& cargs = f->args();
@@ -5,12 +5,15 @@
 #include "scope.hpp"
 #include "visitor.hpp"
 
-expression_ptr inline_function_calls(std::string calling_func, BlockExpression* block);
+// Inline the function calls in block, other than calls to tabulated functions
+// unless inline_tabulated is set.
+expression_ptr inline_function_calls(std::string calling_func, BlockExpression* block, bool inline_tabulated = false);
 
 class FunctionInliner : public BlockRewriterBase {
 public:
     using BlockRewriterBase::visit;
-    FunctionInliner(std::string calling_func) : BlockRewriterBase(), calling_func_(calling_func) {};
+    FunctionInliner(std::string calling_func, bool inline_tabulated = false):
+        BlockRewriterBase(), calling_func_(calling_func), inline_tabulated_(inline_tabulated) {};
     FunctionInliner(scope_ptr s): BlockRewriterBase(s) {}
 
     virtual void visit(Expression *e)            override;
@@ -38,6 +41,9 @@ private:
     std::map<std::string, expression_ptr> local_arg_map_;
     scope_ptr scope_;
 
+    // Inline calls to tabulated functions
+    bool inline_tabulated_ = false;
+
     // Tracks whether the return value of a function has been set
     bool return_set_ = true;
 
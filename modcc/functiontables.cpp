@@ -0,0 +1,410 @@
+#include <cfloat>
+#include <cmath>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "error.hpp"
+#include "functiontables.hpp"
+#include "io/pprintf.hpp"
+#include "util.hpp"
+#include "visitor.hpp"
+
+namespace {
+
+// Collect the calls and identifiers in a function or procedure body, and
+// note whether it evaluates a transcendental function.
+class body_walker: public Visitor {
+public:
+    std::vector<CallExpression*> calls;
+    std::vector<IdentifierExpression*> identifiers;
+    bool transcendental = false;
+
+    void visit(Expression*) override {}
+
+    void visit(IdentifierExpression* e) override {
+        identifiers.push_back(e);
+    }
+
+    void visit(CallExpression* e) override {
+        calls.push_back(e);
+        for (auto& a: e->args()) a->accept(this);
+    }
+
+    void visit(UnaryExpression* e) override {
+        if (is_in(e->op(), {tok::exp, tok::log, tok::exprelr, tok::sin, tok::cos})) {
+            transcendental = true;
+        }
+        e->expression()->accept(this);
+    }
+
+    void visit(BinaryExpression* e) override {
+        if (e->op()==tok::pow) transcendental = true;
+        e->lhs()->accept(this);
+        e->rhs()->accept(this);
+    }
+
+    void visit(BlockExpression* e) override {
+        for (auto& s: e->statements()) s->accept(this);
+    }
+
+    void visit(IfExpression* e) override {
+        e->condition()->accept(this);
+        e->true_branch()->accept(this);
+        if (e->false_branch()) e->false_branch()->accept(this);
+    }
+
+    void visit(ReactionExpression* e) override {
+        e->fwd_rate()->accept(this);
+        e->rev_rate()->accept(this);
+    }
+
+    void visit(CompartmentExpression* e) override {
+        e->scale_factor()->accept(this);
+    }
+};
+
+// A variable whose value is fixed over the lifetime of a mechanism instance,
+// i.e. a scalar parameter.
+bool is_constant_variable(Symbol* s) {
+    auto var = s? s->is_variable(): nullptr;
+    return var && !var->is_range() && !var->is_state() && !var->is_writeable();
+}
+
+// The temperature, celsius, on which a table may depend: the tables are then
+// computed for the temperature of the mechanism instances.
+bool is_temperature(Symbol* s) {
+    auto var = s? s->is_indexed_variable(): nullptr;
+    return var && var->data_source()==sourceKind::temperature;
+}
+
+struct call_site {
+    Symbol* caller;
+    CallExpression* call;
+};
+
+class table_selector {
+public:
+    table_selector(scope_type::symbol_map& symbols) {
+        for (auto& e: symbols) {
+            auto s = e.second.get();
+            if (s->kind()!=symbolKind::function && s->kind()!=symbolKind::procedure) continue;
+
+            s->semantic(symbols);
+            auto& w = walkers_[s];
+            if (auto f = s->is_function()) {
+                f->body()->accept(&w);
+                functions_.push_back(f);
+            }
+            else {
+                s->is_procedure()->body()->accept(&w);
+            }
+            for (auto c: w.calls) {
+                call_sites_[c->name()].push_back({s, c});
+            }
+        }
+    }
+
+    const std::vector<FunctionExpression*>& functions() const { return functions_; }
+
+    // The name of a variable other than the arguments, locals and scalar
+    // parameters on which the value of f depends, or empty if there is none.
+    // If temperature is true, the temperature is not counted.
+    std::string impure_dependency(FunctionExpression* f, bool temperature) {
+        std::set<Symbol*> visiting;
+        return impure_dependency(f, temperature, visiting);
+    }
+
+    bool evaluates_transcendental(FunctionExpression* f) {
+        std::set<Symbol*> visiting;
+        return evaluates_transcendental(f, visiting);
+    }
+
+    // True if callable is called, and every call passes the membrane
+    // voltage as the argument with index arg.
+    bool passes_voltage(Symbol* callable, unsigned arg) {
+        std::map<Symbol*, bool> memo;
+        return call_sites_.count(callable->name()) && passes_voltage(callable, arg, memo);
+    }
+
+private:
+    std::map<Symbol*, body_walker> walkers_;
+    std::map<std::string, std::vector<call_site>> call_sites_;
+    std::vector<FunctionExpression*> functions_;
+
+    std::string impure_dependency(FunctionExpression* f, bool temperature, std::set<Symbol*>& visiting) {
+        if (!visiting.insert(f).second) return {};
+
+        auto& w = walkers_[f];
+        for (auto id: w.identifiers) {
+            auto sym = id->symbol();
+            if (!sym) return id->spelling();
+
+            if (auto local = sym->is_local_variable()) {
+                if (local->is_indexed()) return id->spelling();
+            }
+            else if (sym->kind()!=symbolKind::local_variable && !is_constant_variable(sym) &&
+                     !(temperature && is_temperature(sym)))
+            {
+                return id->spelling();
+            }
+        }
+        for (auto c: w.calls) {
+            auto g = c->function();
+            if (!g) return c->name();
+
+            auto dep = impure_dependency(g, temperature, visiting);
+            if (!dep.empty()) return dep;
+        }
+        return {};
+    }
+
+    bool evaluates_transcendental(FunctionExpression* f, std::set<Symbol*>& visiting) {
+        if (!visiting.insert(f).second) return false;
+
+        auto& w = walkers_[f];
+        if (w.transcendental) return true;
+        for (auto c: w.calls) {
+            if (auto g = c->function()) {
+                if (evaluates_transcendental(g, visiting)) return true;
+            }
+        }
+        return false;
+    }
+
+    static int argument_index(Symbol* callable, const std::string& name) {
+        auto& args = callable->is_function()?
+            callable->is_function()->args():
+            callable->is_procedure()->args();
+
+        for (unsigned i = 0; i<args.size(); ++i) {
+            if (args[i]->is_argument()->spelling()==name) return i;
+        }
+        return -1;
+    }
+
+    // Results by callable; a callable is first entered as false, to stop
+    // recursion (which is an error reported by the inliner).
+    bool passes_voltage(Symbol* callable, unsigned arg, std::map<Symbol*, bool>& memo) {
+        if (memo.count(callable)) return memo[callable];
+        memo[callable] = false;
+
+        for (auto& site: call_sites_[callable->name()]) {
+            auto& args = site.call->args();
+            auto id = arg<args.size()? args[arg]->is_identifier(): nullptr;
+            if (!id || id->spelling()!="v" || !id->symbol()) return false;
+
+            // The membrane voltage is the indexed variable v, or an argument
+            // of the caller through which the voltage is passed.
+            auto sym = id->symbol();
+            if (auto local = sym->is_local_variable()) {
+                if (local->is_arg()) {
+                    int k = argument_index(site.caller, "v");
+                    if (k<0 || !passes_voltage(site.caller, k, memo)) return false;
+                }
+                else if (!local->is_indexed()) {
+                    return false;
+                }
+            }
+            else if (!sym->is_indexed_variable()) {
+                return false;
+            }
+        }
+        return memo[callable] = true;
+    }
+};
+
+// Evaluate a function body in which all calls have been inlined, with
+// parameters taking their default values.
+class evaluator: public Visitor {
+public:
+    std::map<std::string, double> values;
+    double result = 0;
+
+    void visit(Expression* e) override {
+        throw compiler_exception("can not evaluate "+e->to_string(), e->location());
+    }
+
+    void visit(LocalDeclaration*) override {}
+
+    void visit(NumberExpression* e) override {
+        result = e->value();
+    }
+
+    void visit(IdentifierExpression* e) override {
+        auto it = values.find(e->spelling());
+        if (it!=values.end()) {
+            result = it->second;
+        }
+        else if (is_constant_variable(e->symbol()) && !std::isnan(e->symbol()->is_variable()->value())) {
+            result = e->symbol()->is_variable()->value();
+        }
+        else {
+            throw compiler_exception("no value for "+e->spelling(), e->location());
+        }
+    }
+
+    void visit(UnaryExpression* e) override {
+        e->expression()->accept(this);
+        double x = result;
+
+        switch (e->op()) {
+        case tok::minus:   result = -x; break;
+        case tok::lnot:    result = !x; break;
+        case tok::exp:     result = std::exp(x); break;
+        case tok::log:     result = std::log(x); break;
+        case tok::cos:     result = std::cos(x); break;
+        case tok::sin:     result = std::sin(x); break;
+        case tok::abs:     result = std::fabs(x); break;
+        case tok::safeinv: result = 1+x==1? 1/DBL_EPSILON: 1/x; break;
+        case tok::exprelr: result = 1+x==1? 1: x/std::expm1(x); break;
+        default:
+            visit(static_cast<Expression*>(e));
+        }
+    }
+
+    void visit(BinaryExpression* e) override {
+        e->lhs()->accept(this);
+        double x = result;
+        e->rhs()->accept(this);
+        double y = result;
+
+        switch (e->op()) {
+        case tok::plus:     result = x+y; break;
+        case tok::minus:    result = x-y; break;
+        case tok::times:    result = x*y; break;
+        case tok::divide:   result = x/y; break;
+        case tok::pow:      result = std::pow(x, y); break;
+        case tok::min:      result = std::min(x, y); break;
+        case tok::max:      result = std::max(x, y); break;
+        case tok::lt:       result = x<y; break;
+        case tok::lte:      result = x<=y; break;
+        case tok::gt:       result = x>y; break;
+        case tok::gte:      result = x>=y; break;
+        case tok::equality: result = x==y; break;
+        case tok::ne:       result = x!=y; break;
+        case tok::land:     result = x && y; break;
+        case tok::lor:      result = x || y; break;
+        default:
+            visit(static_cast<Expression*>(e));
+        }
+    }
+
+    void visit(AssignmentExpression* e) override {
+        auto lhs = e->lhs()->is_identifier();
+        if (!lhs) visit(static_cast<Expression*>(e));
+
+        e->rhs()->accept(this);
+        values[lhs->spelling()] = result;
+    }
+
+    void visit(BlockExpression* e) override {
+        for (auto& s: e->statements()) s->accept(this);
+    }
+
+    void visit(IfExpression* e) override {
+        e->condition()->accept(this);
+        if (result) {
+            e->true_branch()->accept(this);
+        }
+        else if (e->false_branch()) {
+            e->false_branch()->accept(this);
+        }
+    }
+};
+
+double evaluate(FunctionExpression* f, double x) {
+    evaluator eval;
+    eval.values[f->args()[0]->is_argument()->spelling()] = x;
+    f->body()->accept(&eval);
+
+    auto it = eval.values.find(f->name());
+    if (it==eval.values.end()) {
+        throw compiler_exception("return value of "+f->name()+" not set", f->location());
+    }
+    return it->second;
+}
+
+} // anonymous namespace
+
+void select_tabulated_functions(scope_type::symbol_map& symbols, const function_table* automatic, error_stack& diagnostics) {
+    table_selector selector(symbols);
+
+    for (auto f: selector.functions()) {
+        if (auto table = f->table()) {
+            bool temperature = false;
+            for (auto& name: table->depend) {
+                auto it = symbols.find(name);
+                auto sym = it==symbols.end()? nullptr: it->second.get();
+                if (is_temperature(sym)) {
+                    temperature = true;
+                }
+                else if (!is_constant_variable(sym)) {
+                    diagnostics.warning({pprintf("TABLE in FUNCTION '%' ignored: DEPEND variable '%' is neither a scalar parameter nor celsius", f->name(), name), f->location()});
+                    f->clear_table();
+                    break;
+                }
+            }
+            if (!f->table()) continue;
+
+            auto dep = selector.impure_dependency(f, temperature);
+            if (!dep.empty()) {
+                diagnostics.warning({pprintf("TABLE in FUNCTION '%' ignored: the function depends on '%', which may vary by location or in time", f->name(), dep), f->location()});
+                f->clear_table();
+            }
+        }
+        else if (automatic &&
+                 f->args().size()==1 &&
+                 f->args()[0]->is_argument()->spelling()=="v" &&
+                 selector.impure_dependency(f, true).empty() &&
+                 selector.evaluates_transcendental(f) &&
+                 selector.passes_voltage(f, 0))
+        {
+            function_table table = *automatic;
+            table.automatic = true;
+            if (!selector.impure_dependency(f, false).empty()) {
+                table.depend.push_back("celsius");
+            }
+            f->table(table);
+        }
+    }
+}
+
+table_accuracy estimate_table_accuracy(FunctionExpression* f) {
+    table_accuracy acc;
+    auto table = f->table();
+    if (!table) return acc;
+
+    const unsigned n = table->intervals;
+    const double h = table->step();
+
+    try {
+        std::vector<double> y(n+1);
+        double scale = 0;
+        for (unsigned k = 0; k<=n; ++k) {
+            y[k] = evaluate(f, table->from+k*h);
+            scale = std::max(scale, std::fabs(y[k]));
+        }
+
+        for (unsigned k = 0; k<n; ++k) {
+            for (double r: {0.25, 0.5, 0.75}) {
+                double x = table->from+(k+r)*h;
+                double exact = evaluate(f, x);
+                double err = std::fabs(y[k]+r*(y[k+1]-y[k])-exact);
+
+                acc.max_abs_error = std::max(acc.max_abs_error, err);
+                // Relative errors are not meaningful close to a zero of f.
+                if (std::fabs(exact)>1e-12*scale && err/std::fabs(exact)>acc.max_rel_error) {
+                    acc.max_rel_error = err/std::fabs(exact);
+                    acc.argument = x;
+                }
+            }
+        }
+        acc.evaluated = true;
+    }
+    catch (compiler_exception&) {
+        acc = table_accuracy{};
+    }
+    return acc;
+}
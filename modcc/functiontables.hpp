@@ -0,0 +1,48 @@
+#pragma once
+
+// Tabulation of FUNCTIONs of one argument.
+//
+// Calls to a tabulated FUNCTION are not inlined: the printers emit a lookup
+// with linear interpolation in a table of the function values, which is
+// filled when the mechanism is initialized, in place of the evaluation of
+// the function body.
+//
+// A FUNCTION is tabulated if it has a TABLE statement, or if automatic
+// tabulation is requested, if it is a function of the membrane voltage that
+// evaluates a transcendental function.
+
+#include <string>
+
+#include "error.hpp"
+#include "expression.hpp"
+
+// Select the tabulated functions, after the function calls in the bodies of
+// functions and procedures have been lowered, and before they are inlined.
+//
+// A FUNCTION with a TABLE statement is not tabulated, with a warning, if its
+// value depends on anything but its argument, constants, scalar parameters
+// and, if it is named by DEPEND, the temperature celsius: for example on
+// RANGE parameters or ASSIGNED variables.
+//
+// If automatic is non-null, FUNCTIONs of one argument named v are tabulated
+// on the grid of automatic if: their value depends only on v, constants,
+// scalar parameters and celsius; they evaluate exp, log, exprelr, pow, sin or
+// cos; and every call passes the membrane voltage v. A dependency on celsius
+// is recorded in the DEPEND list of the table.
+//
+// The tables of a mechanism are computed for the values of its scalar
+// parameters and the temperature of its instances, and are recomputed when
+// these change.
+void select_tabulated_functions(scope_type::symbol_map& symbols, const function_table* automatic, error_stack& diagnostics);
+
+// Accuracy of linear interpolation in the table of a tabulated function,
+// estimated by evaluating the function at the table points and between them,
+// with the default values of any parameters.
+struct table_accuracy {
+    bool evaluated = false;  // False if the function could not be evaluated.
+    double max_abs_error = 0;
+    double max_rel_error = 0;
+    double argument = 0;     // Argument with the largest relative error.
+};
+
+table_accuracy estimate_table_accuracy(FunctionExpression* f);
@@ -1,5 +1,6 @@
 #include <exception>
 #include <iostream>
+#include <map>
 #include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
@@ -12,6 +13,7 @@
 #include "printer/printeropt.hpp"
 #include "printer/simd.hpp"
 
+#include "functiontables.hpp"
 #include "module.hpp"
 #include "parser.hpp"
 #include "perfvisitor.hpp"
@@ -22,6 +24,18 @@
 using std::cout;
 using std::cerr;
 
+// Procedures and API methods included in the analysis report.
+std::vector<ProcedureExpression*> analysed_procedures(const Module& m) {
+    std::vector<ProcedureExpression*> procs;
+    for (auto& symbol: m.symbols()) {
+        auto proc = symbol.second->is_procedure();
+        if (proc && (proc->is_api_method() || proc->kind()==procedureKind::normal)) {
+            procs.push_back(proc);
+        }
+    }
+    return procs;
+}
+
 // Options and option parsing:
 
 int report_error(const std::string& message) {
@@ -56,6 +70,11 @@ std::unordered_map<std::string, enum simd_spec::simd_abi> simdAbiMap = {
     {"native", simd_spec::native}
 };
 
+std::unordered_map<std::string, simd_accuracy> simdAccuracyMap = {
+    {"full", simd_accuracy::full},
+    {"fast", simd_accuracy::fast}
+};
+
 template <typename Map, typename V>
 auto key_by_value(const Map& map, const V& v) -> decltype(map.begin()->first) {
     for (const auto& kv: map) {
@@ -70,6 +89,9 @@ struct Options {
     std::string modulename;
     bool verbose = false;
     bool analysis = false;
+    bool tabulate = false;
+    bool optimize = true;
+    function_table table_grid{-150, 150, 3000};
     std::unordered_set<targetKind> targets;
 };
 
@@ -102,7 +124,9 @@ std::ostream& operator<<(std::ostream& out, const Options& opt) {
         table_prefix{"output"} << (opt.outprefix.empty()? "-": opt.outprefix) << line_end <<
         table_prefix{"verbose"} << noyes[opt.verbose] << line_end <<
         table_prefix{"targets"} << targets << line_end <<
-        table_prefix{"analysis"} << noyes[opt.analysis] << line_end;
+        table_prefix{"analysis"} << noyes[opt.analysis] << line_end <<
+        table_prefix{"tabulate"} << noyes[opt.tabulate] << line_end <<
+        table_prefix{"optimize"} << noyes[opt.optimize] << line_end;
 }
 
 std::ostream& operator<<(std::ostream& out, const printer_options& popt) {
@@ -112,7 +136,9 @@ std::ostream& operator<<(std::ostream& out, const printer_options& popt) {
     return out <<
         table_prefix{"namespace"} << popt.cpp_namespace << line_end <<
         table_prefix{"profile"} << noyes[popt.profile] << line_end <<
-        table_prefix{"simd"} << popt.simd << line_end;
+        table_prefix{"simd"} << popt.simd << line_end <<
+        table_prefix{"simd accuracy"} << key_by_value(simdAccuracyMap, popt.accuracy) << line_end <<
+        table_prefix{"mixed precision"} << noyes[popt.mixed_precision] << line_end;
 }
 
 std::istream& operator>> (std::istream& i, simd_spec& spec) {
@@ -131,6 +157,20 @@ std::istream& operator>> (std::istream& i, simd_spec& spec) {
     return i;
 }
 
+// Table grid specification: <from>:<to>:<intervals>
+std::istream& operator>> (std::istream& i, function_table& grid) {
+    char sep1 = 0, sep2 = 0;
+    function_table t;
+    i >> t.from >> sep1 >> t.to >> sep2 >> t.intervals;
+    if (!i || sep1!=':' || sep2!=':' || !(t.from<t.to) || t.intervals<1) {
+        i.setstate(std::ios::failbit);
+    }
+    else {
+        grid = t;
+    }
+    return i;
+}
+
 const char* usage_str =
         "\n"
         "-o|--output            [Prefix for output file names]\n"
@@ -138,9 +178,14 @@ const char* usage_str =
         "-t|--target            [Build module for target; Avaliable targets: 'cpu', 'gpu']\n"
         "-s|--simd              [Generate code with explicit SIMD vectorization]\n"
         "-S|--simd-abi          [Override SIMD ABI in generated code. Use /n suffix to force SIMD width to be size n. Examples: 'avx2', 'native/4', ...]\n"
+        "--simd-accuracy        [Accuracy of exp, log, exprelr and pow in SIMD code: 'full' (default), or 'fast' for a relative error below 1e-10, on AVX2 and AVX-512 only]\n"
         "-P|--profile           [Build with profiled kernels]\n"
+        "--mixed-precision      [Store STATE variables, and evaluate the INITIAL and state update kernels, in single precision (CPU target)]\n"
         "-V|--verbose           [Toggle verbose mode]\n"
         "-A|--analyse           [Toggle analysis mode]\n"
+        "-T|--tabulate          [Tabulate functions of the membrane voltage, in addition to those with a TABLE]\n"
+        "--table-grid           [Grid for tabulated functions, as <from>:<to>:<intervals>; default -150:150:3000]\n"
+        "--no-optimize          [Disable common subexpression elimination, integer power expansion and loop invariant hoisting]\n"
         "<filename>             [File to be compiled]\n";
 
 int main(int argc, char **argv) {
@@ -170,11 +215,16 @@ int main(int argc, char **argv) {
                 { opt.outprefix,                     "-o", "--output" },
                 { to::set(opt.verbose),  to::flag,   "-V", "--verbose" },
                 { to::set(opt.analysis), to::flag,   "-A", "--analyse" },
+                { to::set(opt.tabulate), to::flag,   "-T", "--tabulate" },
+                { opt.table_grid,                    "--table-grid" },
+                { to::set(opt.optimize, false), to::flag, "--no-optimize" },
                 { opt.modulename,                    "-m", "--module" },
                 { to::set(popt.profile), to::flag,   "-P", "--profile" },
+                { to::set(popt.mixed_precision), to::flag, "--mixed-precision" },
                 { popt.cpp_namespace,                "-N", "--namespace" },
                 { to::action(enable_simd), to::flag, "-s", "--simd" },
                 { popt.simd,                         "-S", "--simd-abi" },
+                { {popt.accuracy, to::keywords(simdAccuracyMap)}, "--simd-accuracy" },
                 { {to::action(add_target, to::keywords(targetKindMap))}, "-t", "--target" },
                 { to::action(help), to::flag, to::exit,    "-h", "--help" }
         };
@@ -186,6 +236,11 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    // Single precision SIMD values have a fixed width: SVE vectors are sizeless.
+    if (popt.mixed_precision && popt.simd.abi==simd_spec::sve) {
+        return report_error("--mixed-precision can not be combined with the SVE SIMD ABI");
+    }
+
     try {
         auto emit_header = [&opt](const char* h) {
             if (opt.verbose) {
@@ -223,6 +278,9 @@ int main(int argc, char **argv) {
         }
 
         emit_header("semantic analysis");
+        if (opt.tabulate) {
+            m.auto_tables(opt.table_grid);
+        }
         m.semantic();
         if (m.has_warning()) {
             cerr << m.warning_string() << "\n";
@@ -231,6 +289,21 @@ int main(int argc, char **argv) {
             return report_error(m.error_string());
         }
 
+        // Operation counts before optimization, for the analysis report.
+        std::map<std::string, FlopVisitor> unoptimized_flops;
+        std::map<std::string, MemOpVisitor> unoptimized_memops;
+        if (opt.analysis) {
+            for (auto proc: analysed_procedures(m)) {
+                proc->accept(&unoptimized_flops[proc->name()]);
+                proc->accept(&unoptimized_memops[proc->name()]);
+            }
+        }
+
+        if (opt.optimize) {
+            emit_header("optimization");
+            m.optimize();
+        }
+
         // Generate backend-specific sources for each backend provided.
 
         emit_header("code generation");
@@ -256,19 +329,51 @@ int main(int argc, char **argv) {
 
         if (opt.analysis) {
             cout << green("performance analysis\n");
-            for (auto &symbol: m.symbols()) {
-                if (auto method = symbol.second->is_api_method()) {
-                    cout << white("-------------------------\n");
-                    cout << yellow("method " + method->name()) << "\n";
-                    cout << white("-------------------------\n");
-
-                    FlopVisitor flops;
-                    method->accept(&flops);
+            for (auto proc: analysed_procedures(m)) {
+                cout << white("-------------------------\n");
+                cout << yellow((proc->is_api_method()? "method ": "procedure ") + proc->name()) << "\n";
+                cout << white("-------------------------\n");
+
+                FlopVisitor flops;
+                proc->accept(&flops);
+                if (opt.optimize) {
+                    std::vector<std::pair<std::string, FlopAccumulator>> rows = {
+                        {"unoptimized", unoptimized_flops[proc->name()].flops},
+                        {"optimized", flops.flops},
+                        {"once per call", flops.invariant_flops}
+                    };
+                    cout << white("FLOPS\n");
+                    print_flop_table(cout, rows) << "\n";
+
+                    cout << white("MEMOPS (unoptimized)\n") << unoptimized_memops[proc->name()].print() << "\n";
+                }
+                else {
                     cout << white("FLOPS\n") << flops.print() << "\n";
+                }
 
-                    MemOpVisitor memops;
-                    method->accept(&memops);
-                    cout << white("MEMOPS\n") << memops.print() << "\n";
+                MemOpVisitor memops;
+                proc->accept(&memops);
+                cout << white("MEMOPS\n") << memops.print() << "\n";
+            }
+
+            for (auto &symbol: m.symbols()) {
+                auto f = symbol.second->is_function();
+                if (!f || !f->table()) continue;
+
+                auto table = f->table();
+                cout << white("-------------------------\n");
+                cout << yellow("table " + f->name()) << "\n";
+                cout << white("-------------------------\n");
+                cout << pprintf("range [%, %] with % intervals (%)\n",
+                    table->from, table->to, table->intervals, table->automatic? "automatic": "TABLE");
+
+                auto acc = estimate_table_accuracy(f);
+                if (acc.evaluated) {
+                    cout << pprintf("max abs error %, max rel error % at %\n\n",
+                        acc.max_abs_error, acc.max_rel_error, acc.argument);
+                }
+                else {
+                    cout << "accuracy not estimated: function depends on parameters without default values\n\n";
                 }
             }
         }
@@ -10,12 +10,15 @@
 #include "errorvisitor.hpp"
 #include "functionexpander.hpp"
 #include "functioninliner.hpp"
+#include "functiontables.hpp"
 #include "kineticrewriter.hpp"
 #include "linearrewriter.hpp"
 #include "module.hpp"
+#include "optimizer.hpp"
 #include "parser.hpp"
 #include "solvers.hpp"
 #include "symdiff.hpp"
+#include "util.hpp"
 #include "visitor.hpp"
 
 class NrnCurrentRewriter: public BlockRewriterBase {
@@ -815,8 +818,15 @@ int Module::semantic_func_proc() {
         }
     }
 
+    // Calls to tabulated functions are not inlined, other than in the bodies
+    // of tabulated functions, which are evaluated to fill the tables.
+    if (!tables_selected_) {
+        select_tabulated_functions(symbols_, auto_tables_? &*auto_tables_: nullptr, *this);
+        tables_selected_ = true;
+    }
+
     auto inline_and_simplify = [&](auto&& caller) {
-        auto rewritten = inline_function_calls(caller->name(), caller->body());
+        auto rewritten = inline_function_calls(caller->name(), caller->body(), caller->is_function() && caller->is_function()->table());
         caller->body(std::move(rewritten));
         caller->body(constant_simplify(caller->body()));
     };
@@ -876,6 +886,28 @@ int Module::semantic_func_proc() {
     return errors;
 }
 
+void Module::optimize() {
+    for (auto& e: symbols_) {
+        auto proc = e.second->is_procedure();
+        if (!proc || !is_in(proc->kind(), {procedureKind::normal, procedureKind::api, procedureKind::net_receive, procedureKind::post_event})) {
+            continue;
+        }
+
+        proc->body(expand_integer_powers(proc->body()));
+        proc->semantic(symbols_);
+
+        proc->body(eliminate_common_subexpressions(proc->body()));
+        proc->semantic(symbols_);
+
+        if (auto api = proc->is_api_method()) {
+            auto hoisted = hoist_invariants(api->body());
+            api->body(std::move(hoisted.block));
+            api->invariant_locals(std::move(hoisted.invariant_locals));
+            api->semantic(symbols_);
+        }
+    }
+}
+
 void Module::check_revpot_mechanism() {
     int n_write_revpot = 0;
     for (auto& iondep: neuron_block_.ions) {
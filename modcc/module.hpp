@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iterator>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -88,9 +89,18 @@ public:
 
     std::string warning_string() const;
 
+    // Tabulate functions of the membrane voltage on the grid of t, in addition
+    // to functions with a TABLE statement; set before the semantic pass.
+    void auto_tables(function_table t) { auto_tables_ = std::move(t); }
+
     // Perform semantic analysis pass.
     bool semantic();
 
+    // Apply the optimization passes of optimizer.hpp to the bodies of the
+    // procedures, NET_RECEIVE and POST_EVENT blocks and API methods, after
+    // a successful semantic analysis pass.
+    void optimize();
+
     auto find_ion(const std::string& ion_name) -> decltype(ion_deps().begin()) {
         auto& ions = neuron_block().ions;
         return std::find_if(
@@ -120,6 +130,8 @@ private:
     AssignedBlock assigned_block_;
     bool linear_;
     bool post_events_;
+    std::optional<function_table> auto_tables_;
+    bool tables_selected_ = false;
 
     // AST storage.
     std::vector<symbol_ptr> callables_;
@@ -0,0 +1,513 @@
+#include <cmath>
+#include <list>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "astmanip.hpp"
+#include "expression.hpp"
+#include "optimizer.hpp"
+#include "util.hpp"
+
+namespace {
+
+// The operands of an expression that are evaluated, indexed from zero: the
+// operands of a unary or binary expression, the right hand side of an
+// assignment, the arguments of a call, or the condition of an if statement.
+// Returns null past the last operand.
+
+Expression* operand(Expression* e, unsigned i) {
+    if (auto a = e->is_assignment()) {
+        return i==0? a->rhs(): nullptr;
+    }
+    if (auto b = e->is_binary()) {
+        return i==0? b->lhs(): i==1? b->rhs(): nullptr;
+    }
+    if (auto u = e->is_unary()) {
+        return i==0? u->expression(): nullptr;
+    }
+    if (auto c = e->is_call()) {
+        return i<c->args().size()? c->args()[i].get(): nullptr;
+    }
+    if (auto f = e->is_if()) {
+        return i==0? f->condition(): nullptr;
+    }
+    return nullptr;
+}
+
+void replace_operand(Expression* e, unsigned i, expression_ptr&& x) {
+    if (auto a = e->is_assignment()) {
+        a->replace_rhs(std::move(x));
+    }
+    else if (auto b = e->is_binary()) {
+        if (i==0) b->replace_lhs(std::move(x));
+        else b->replace_rhs(std::move(x));
+    }
+    else if (auto u = e->is_unary()) {
+        u->replace_expression(std::move(x));
+    }
+    else if (auto c = e->is_call()) {
+        c->args()[i] = std::move(x);
+    }
+    else if (auto f = e->is_if()) {
+        f->replace_condition(std::move(x));
+    }
+}
+
+// Apply f(s, i) to each operand i of each statement s in a block, including
+// the statements in the branches of if statements.
+template <typename F>
+void for_each_operand(Expression* s, F& f) {
+    if (auto b = s->is_block()) {
+        for (auto& t: b->statements()) {
+            for_each_operand(t.get(), f);
+        }
+        return;
+    }
+
+    for (unsigned i = 0; operand(s, i); ++i) {
+        f(s, i);
+    }
+
+    if (auto c = s->is_if()) {
+        for_each_operand(c->true_branch(), f);
+        if (c->false_branch()) {
+            for_each_operand(c->false_branch(), f);
+        }
+    }
+}
+
+// Expressions which are candidates for elimination or hoisting: arithmetic
+// on numbers and identifiers, without calls or comparisons.
+
+bool is_arithmetic(Expression* e) {
+    if (auto u = e->is_unary()) {
+        return is_in(u->op(), {tok::minus, tok::exp, tok::log, tok::cos, tok::sin, tok::abs, tok::exprelr, tok::safeinv});
+    }
+    if (auto b = e->is_binary()) {
+        return !b->is_assignment() && is_in(b->op(), {tok::plus, tok::minus, tok::times, tok::divide, tok::pow, tok::min, tok::max});
+    }
+    return false;
+}
+
+bool is_leaf(Expression* e) {
+    return e->is_number() || e->is_identifier();
+}
+
+// A leaf or the negation of a leaf: not worth assigning to a local.
+bool is_trivial(Expression* e) {
+    if (is_leaf(e)) return true;
+
+    auto u = e->is_unary();
+    return u && u->op()==tok::minus && is_leaf(u->expression());
+}
+
+// Key that is the same for two arithmetic expressions if and only if they
+// are the same expression, or empty if e is not an arithmetic expression of
+// numbers and identifiers. Numbers are represented exactly.
+
+std::string expression_key(Expression* e) {
+    if (auto n = e->is_number()) {
+        std::ostringstream o;
+        o << std::hexfloat << n->value();
+        return o.str();
+    }
+    if (auto id = e->is_identifier()) {
+        return id->spelling();
+    }
+    if (!is_arithmetic(e)) {
+        return {};
+    }
+
+    std::vector<std::string> keys;
+    for (unsigned i = 0; operand(e, i); ++i) {
+        keys.push_back(expression_key(operand(e, i)));
+        if (keys.back().empty()) return {};
+    }
+
+    if (auto u = e->is_unary()) {
+        return token_string(u->op())+"("+keys[0]+")";
+    }
+    return "("+keys[0]+" "+token_string(e->is_binary()->op())+" "+keys[1]+")";
+}
+
+// Integer power expansion:
+
+expression_ptr product_power(Expression* x, int n, Location loc) {
+    if (n==1) {
+        return x->clone();
+    }
+
+    auto h = product_power(x, n/2, loc);
+    auto square = make_expression<MulBinaryExpression>(loc, h->clone(), std::move(h));
+    if (n%2) {
+        return make_expression<MulBinaryExpression>(loc, std::move(square), x->clone());
+    }
+    return square;
+}
+
+void expand_powers(Expression* e, unsigned i) {
+    auto x = operand(e, i);
+    for (unsigned j = 0; operand(x, j); ++j) {
+        expand_powers(x, j);
+    }
+
+    auto b = x->is_binary();
+    if (!b || b->op()!=tok::pow) return;
+
+    // A negative exponent is parsed as the negation of a number.
+    double n = NAN;
+    if (auto num = b->rhs()->is_number()) {
+        n = num->value();
+    }
+    else if (auto neg = b->rhs()->is_unary()) {
+        if (neg->op()==tok::minus && neg->expression()->is_number()) {
+            n = -neg->expression()->is_number()->value();
+        }
+    }
+    if (n!=std::trunc(n) || std::fabs(n)<2 || std::fabs(n)>max_expanded_power) return;
+
+    auto loc = x->location();
+    auto p = product_power(b->lhs(), std::abs(int(n)), loc);
+    if (n<0) {
+        p = make_expression<DivBinaryExpression>(loc, make_expression<NumberExpression>(loc, 1.), std::move(p));
+    }
+    replace_operand(e, i, std::move(p));
+}
+
+// Common subexpression elimination:
+//
+// The statements are scanned in order for the evaluations of each candidate
+// expression which give the same value: a group of evaluations ends at an
+// assignment to an identifier of the expression, or at the end of the block
+// in which the group began. The largest expression with more than one
+// evaluation in a group is replaced with a local, and the scan repeated.
+
+struct cse_instance {
+    Expression* parent;
+    unsigned index;
+};
+
+struct cse_group {
+    unsigned size;                  // Number of nodes in the expression.
+    std::set<std::string> deps;     // Identifiers in the expression.
+    expr_list_type* block;          // Statement before which the local is assigned.
+    expr_list_type::iterator stmt;
+    std::vector<cse_instance> instances;
+};
+
+// Identifiers assigned in a sequence of statements; all identifiers if all
+// is true, e.g. after a procedure call.
+struct assigned_set {
+    std::set<std::string> names;
+    bool all = false;
+};
+
+class cse_scan {
+public:
+    std::list<cse_group> groups;
+
+    // The groups that may be extended, by expression key.
+    using available_map = std::map<std::string, cse_group*>;
+
+    void scan_block(expr_list_type& stmts, available_map& avail, assigned_set& assigned) {
+        for (auto i = stmts.begin(); i!=stmts.end(); ++i) {
+            scan_statement(i->get(), &stmts, i, avail, assigned);
+        }
+    }
+
+private:
+    struct node {
+        unsigned size = 0;
+        std::set<std::string> deps;
+        bool arithmetic = false;
+    };
+
+    // New groups may begin in the statement only if block is non-null.
+    void scan_statement(Expression* s, expr_list_type* block, expr_list_type::iterator stmt, available_map& avail, assigned_set& assigned) {
+        if (s->is_local_declaration()) return;
+
+        for (unsigned i = 0; operand(s, i); ++i) {
+            scan_operand(s, i, block, stmt, avail);
+        }
+
+        std::vector<Expression*> branches;
+        if (auto a = s->is_assignment()) {
+            if (auto id = a->lhs()->is_identifier()) {
+                kill(id->spelling(), avail, assigned);
+                return;
+            }
+        }
+        else if (auto c = s->is_if()) {
+            branches = {c->true_branch(), c->false_branch()};
+        }
+        else if (s->is_block()) {
+            branches = {s};
+        }
+        else {
+            // Procedure calls, in particular, may assign to anything.
+            kill_all(avail, assigned);
+            return;
+        }
+
+        assigned_set branch_assigned;
+        for (auto b: branches) {
+            if (!b) continue;
+
+            available_map branch_avail = avail;
+            if (auto inner = b->is_block()) {
+                scan_block(inner->statements(), branch_avail, branch_assigned);
+            }
+            else {
+                scan_statement(b, nullptr, {}, branch_avail, branch_assigned);
+            }
+        }
+
+        if (branch_assigned.all) {
+            kill_all(avail, assigned);
+        }
+        for (auto& name: branch_assigned.names) {
+            kill(name, avail, assigned);
+        }
+    }
+
+    node scan_operand(Expression* parent, unsigned i, expr_list_type* block, expr_list_type::iterator stmt, available_map& avail) {
+        Expression* e = operand(parent, i);
+        node r;
+
+        if (e->is_number()) {
+            r.size = 1;
+            r.arithmetic = true;
+            return r;
+        }
+        if (auto id = e->is_identifier()) {
+            r.size = 1;
+            r.deps.insert(id->spelling());
+            r.arithmetic = true;
+            return r;
+        }
+
+        std::vector<node> operands;
+        for (unsigned j = 0; operand(e, j); ++j) {
+            operands.push_back(scan_operand(e, j, block, stmt, avail));
+        }
+
+        if (!is_arithmetic(e)) return r;
+        for (auto& x: operands) {
+            if (!x.arithmetic) return r;
+            r.size += x.size;
+            r.deps.insert(x.deps.begin(), x.deps.end());
+        }
+        r.size += 1;
+        r.arithmetic = true;
+
+        if (r.deps.empty() || is_trivial(e)) return r;
+
+        auto key = expression_key(e);
+        auto g = avail.find(key);
+        if (g!=avail.end()) {
+            g->second->instances.push_back({parent, i});
+        }
+        else if (block) {
+            groups.push_back({r.size, r.deps, block, stmt, {{parent, i}}});
+            avail[key] = &groups.back();
+        }
+        return r;
+    }
+
+    static void kill(const std::string& name, available_map& avail, assigned_set& assigned) {
+        assigned.names.insert(name);
+        for (auto i = avail.begin(); i!=avail.end(); ) {
+            if (i->second->deps.count(name)) {
+                i = avail.erase(i);
+            }
+            else {
+                ++i;
+            }
+        }
+    }
+
+    static void kill_all(available_map& avail, assigned_set& assigned) {
+        assigned.all = true;
+        avail.clear();
+    }
+};
+
+// Loop invariant hoisting:
+
+void count_assignments(Expression* s, std::map<std::string, unsigned>& count) {
+    if (auto b = s->is_block()) {
+        for (auto& t: b->statements()) {
+            count_assignments(t.get(), count);
+        }
+    }
+    else if (auto a = s->is_assignment()) {
+        if (auto id = a->lhs()->is_identifier()) {
+            ++count[id->spelling()];
+        }
+    }
+    else if (auto c = s->is_if()) {
+        count_assignments(c->true_branch(), count);
+        if (c->false_branch()) {
+            count_assignments(c->false_branch(), count);
+        }
+    }
+}
+
+class invariant_hoister {
+public:
+    explicit invariant_hoister(scope_ptr scope): scope_(scope) {}
+
+    std::set<std::string> invariant;  // Locals with invariant values.
+    expr_list_type declarations;      // Declarations of new locals.
+    expr_list_type hoisted;           // Assignments to invariant locals, in order.
+
+    bool is_invariant(Expression* e) {
+        if (e->is_number()) {
+            return true;
+        }
+        if (auto id = e->is_identifier()) {
+            if (invariant.count(id->spelling())) return true;
+
+            auto sym = scope_->find(id->spelling());
+            auto var = sym? sym->is_variable(): nullptr;
+            return var && !var->is_range() && !var->is_state() && !var->is_writeable();
+        }
+        if (!is_arithmetic(e)) {
+            return false;
+        }
+
+        for (unsigned i = 0; operand(e, i); ++i) {
+            if (!is_invariant(operand(e, i))) return false;
+        }
+        return true;
+    }
+
+    // True if s assigns to a local that is assigned nowhere else.
+    bool is_single_local_assignment(Expression* s, std::map<std::string, unsigned>& count) {
+        auto a = s->is_assignment();
+        auto id = a? a->lhs()->is_identifier(): nullptr;
+        auto sym = id? scope_->find(id->spelling()): nullptr;
+        auto local = sym? sym->is_local_variable(): nullptr;
+
+        return local && !local->is_indexed() && !local->is_arg() && count[id->spelling()]==1;
+    }
+
+    // Replace the largest invariant operands in the statement s with
+    // invariant locals. Only the operands that are always evaluated are
+    // considered: the statements in the branches of an if statement are
+    // left unchanged, as their evaluation might depend on the condition.
+    void extract(Expression* s) {
+        for (unsigned i = 0; operand(s, i); ++i) {
+            extract_operand(s, i);
+        }
+    }
+
+private:
+    scope_ptr scope_;
+    std::map<std::string, std::string> by_key_;
+
+    void extract_operand(Expression* e, unsigned i) {
+        auto x = operand(e, i);
+        if (is_trivial(x)) return;
+
+        if (!is_invariant(x)) {
+            for (unsigned j = 0; operand(x, j); ++j) {
+                extract_operand(x, j);
+            }
+            return;
+        }
+
+        auto loc = x->location();
+        auto& name = by_key_[expression_key(x)];
+        if (name.empty()) {
+            auto local = make_unique_local_decl(scope_, loc, "inv");
+            name = local.id->is_identifier()->spelling();
+            invariant.insert(name);
+
+            declarations.push_back(std::move(local.local_decl));
+            hoisted.push_back(make_expression<AssignmentExpression>(loc, std::move(local.id), x->clone()));
+        }
+        replace_operand(e, i, make_expression<IdentifierExpression>(loc, name));
+    }
+};
+
+} // anonymous namespace
+
+expression_ptr expand_integer_powers(BlockExpression* block) {
+    auto result = block->clone();
+    auto f = [](Expression* e, unsigned i) { expand_powers(e, i); };
+    for_each_operand(result.get(), f);
+    return result;
+}
+
+expression_ptr eliminate_common_subexpressions(BlockExpression* block) {
+    auto scope = block->scope();
+    auto result = block->clone();
+    auto& body = result->is_block()->statements();
+
+    for (;;) {
+        cse_scan scan;
+        cse_scan::available_map avail;
+        assigned_set assigned;
+        scan.scan_block(body, avail, assigned);
+
+        cse_group* best = nullptr;
+        for (auto& g: scan.groups) {
+            if (g.instances.size()>1 && (!best || g.size>best->size)) {
+                best = &g;
+            }
+        }
+        if (!best) break;
+
+        auto& first = best->instances.front();
+        auto value = operand(first.parent, first.index);
+        auto loc = value->location();
+
+        auto local = make_unique_local_decl(scope, loc, "cse");
+        best->block->insert(best->stmt,
+            make_expression<AssignmentExpression>(loc, local.id->clone(), value->clone()));
+        for (auto& x: best->instances) {
+            replace_operand(x.parent, x.index, local.id->clone());
+        }
+        body.push_front(std::move(local.local_decl));
+    }
+
+    return result;
+}
+
+hoisted_block hoist_invariants(BlockExpression* block) {
+    auto scope = block->scope();
+    auto result = block->clone();
+    auto& body = result->is_block()->statements();
+
+    std::map<std::string, unsigned> count;
+    count_assignments(result.get(), count);
+
+    // Local declarations are moved to the start of the block, before the
+    // hoisted assignments.
+    invariant_hoister h(scope);
+    for (auto i = body.begin(); i!=body.end(); ) {
+        auto s = i->get();
+        if (s->is_local_declaration()) {
+            h.declarations.push_back(std::move(*i));
+            i = body.erase(i);
+        }
+        else if (h.is_single_local_assignment(s, count) && h.is_invariant(s->is_assignment()->rhs())) {
+            h.invariant.insert(s->is_assignment()->lhs()->is_identifier()->spelling());
+            h.hoisted.push_back(std::move(*i));
+            i = body.erase(i);
+        }
+        else {
+            h.extract(s);
+            ++i;
+        }
+    }
+
+    body.splice(body.begin(), h.hoisted);
+    body.splice(body.begin(), h.declarations);
+
+    return {std::move(result), std::move(h.invariant)};
+}
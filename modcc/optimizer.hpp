@@ -0,0 +1,52 @@
+#pragma once
+
+// Optimization of the bodies of procedures and API methods, after semantic
+// analysis, inlining and constant simplification.
+//
+// Each pass takes a block that has been through the semantic pass, and
+// returns a new block, which requires a semantic pass before use. New locals
+// are declared in the top level of the new block, with names that are unique
+// in the scope of the given block.
+
+#include <set>
+#include <string>
+
+#include "expression.hpp"
+
+// Integer powers x^n with 2 <= |n| <= max_expanded_power are expanded as
+// products of x, by repeated squaring; if n is negative, the reciprocal of
+// the product is taken.
+constexpr int max_expanded_power = 4;
+
+expression_ptr expand_integer_powers(BlockExpression* block);
+
+// Assign each arithmetic expression of numbers and identifiers that is
+// evaluated more than once with the same values of its identifiers to a
+// new local, which is used in place of each evaluation.
+//
+// The assignment is made before the statement with the first evaluation,
+// in the same block. Evaluations after an assignment to one of the
+// identifiers of the expression, or after a procedure call, are not
+// replaced; nor are evaluations after the end of the block of the first
+// evaluation.
+expression_ptr eliminate_common_subexpressions(BlockExpression* block);
+
+// Collect the evaluations that do not depend on the mechanism instance in
+// the body of an API method: these are arithmetic expressions of numbers,
+// scalar PARAMETERs, and locals which are themselves invariant.
+//
+// A statement in the top level of the block that assigns an invariant value
+// to a local that is assigned nowhere else is moved to the start of the
+// block; other invariant expressions in the top level statements of the
+// block, excluding the branches of if statements, are assigned to new locals
+// at the start of the block. The names of the locals so assigned are returned with the
+// new block.
+//
+// The values of scalar parameters may be set when a mechanism is
+// instantiated, and so they are not folded into constants.
+struct hoisted_block {
+    expression_ptr block;
+    std::set<std::string> invariant_locals;
+};
+
+hoisted_block hoist_invariants(BlockExpression* block);
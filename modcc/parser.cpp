@@ -984,12 +984,21 @@ symbol_ptr Parser::parse_function() {
     // check for opening left brace {
     if (!expect(tok::lbrace)) return nullptr;
 
-    // parse the body of the function
-    auto body = parse_block(false);
+    // parse the body of the function, which may include a TABLE statement
+    function_table table;
+    auto body = parse_block(false, &table);
     if (body == nullptr) return nullptr;
 
     PrototypeExpression* proto = p->is_prototype();
-    return make_symbol<FunctionExpression>(proto->location(), proto->name(), std::move(proto->args()), std::move(body));
+    auto f = make_symbol<FunctionExpression>(proto->location(), proto->name(), std::move(proto->args()), std::move(body));
+    if (table.intervals) {
+        if (f->is_function()->args().size()!=1) {
+            error(pprintf("FUNCTION '%' with a TABLE must have exactly one argument", proto->name()), proto->location());
+            return nullptr;
+        }
+        f->is_function()->table(std::move(table));
+    }
+    return f;
 }
 
 // this is the first port of call when parsing a new line inside a verb block
@@ -1696,8 +1705,9 @@ expression_ptr Parser::parse_if() {
 
 // takes a flag indicating whether the block is at procedure/function body,
 // or lower. Can be used to check for illegal statements inside a nested block,
-// e.g. LOCAL declarations.
-expression_ptr Parser::parse_block(bool is_nested) {
+// e.g. LOCAL declarations. A TABLE statement is accepted only at the top
+// level of a FUNCTION body, for which table is non-null.
+expression_ptr Parser::parse_block(bool is_nested, function_table* table) {
     // blocks have to be enclosed in curly braces {}
     expect(tok::lbrace);
 
@@ -1708,6 +1718,19 @@ expression_ptr Parser::parse_block(bool is_nested) {
 
     expr_list_type body;
     while (token_.type != tok::rbrace) {
+        if (token_.type == tok::table) {
+            if (!table) {
+                error("TABLE statements are supported only at the top level of FUNCTION blocks");
+                return nullptr;
+            }
+            if (table->intervals) {
+                error("a FUNCTION may have only one TABLE statement");
+                return nullptr;
+            }
+            if (!parse_table_statement(*table)) return nullptr;
+            continue;
+        }
+
         auto e = parse_statement();
         if (!e) return e;
 
@@ -1736,6 +1759,47 @@ expression_ptr Parser::parse_block(bool is_nested) {
     return make_expression<BlockExpression>(block_location, std::move(body), is_nested);
 }
 
+// TABLE [DEPEND name, ...] FROM <number> TO <number> WITH <integer>
+//
+// In a FUNCTION, the table holds the function value, so no variables are
+// named before DEPEND.
+bool Parser::parse_table_statement(function_table& table) {
+    get_token(); // consume TABLE
+
+    if (token_.type == tok::identifier) {
+        error(pprintf("a TABLE statement in a FUNCTION tabulates the function value, and can not name the variable '%'", token_.spelling));
+        return false;
+    }
+
+    if (token_.type == tok::depend) {
+        for (auto& t: comma_separated_identifiers()) {
+            table.depend.push_back(t.spelling);
+        }
+        if (status_ == lexerStatus::error) return false;
+    }
+
+    auto range = from_to_description();
+    if (status_ == lexerStatus::error) return false;
+
+    if (token_.type != tok::with) {
+        error(pprintf("TABLE statement must be of form TABLE [DEPEND ...] FROM <number> TO <number> WITH <integer>, found '%'", token_));
+        return false;
+    }
+    get_token(); // consume WITH
+
+    int intervals = value_signed_integer();
+    if (status_ == lexerStatus::error) return false;
+
+    table.from = std::stod(range.first);
+    table.to = std::stod(range.second);
+    if (!(table.from<table.to) || intervals<1) {
+        error("TABLE range must be non-empty, with at least one interval");
+        return false;
+    }
+    table.intervals = intervals;
+    return true;
+}
+
 expression_ptr Parser::parse_initial() {
     // has to start with INITIAL: error in compiler implementaion otherwise
     expect(tok::initial);
@@ -35,7 +35,7 @@ public:
     expression_ptr parse_local();
     expression_ptr parse_solve();
     expression_ptr parse_conductance();
-    expression_ptr parse_block(bool);
+    expression_ptr parse_block(bool, function_table* table = nullptr);
     expression_ptr parse_initial();
     expression_ptr parse_compartment_statement();
     expression_ptr parse_if();
@@ -69,6 +69,7 @@ private:
     int value_signed_integer();
     std::pair<std::string, std::string> range_description();
     std::pair<std::string, std::string> from_to_description();
+    bool parse_table_statement(function_table&);
 
     /// build the identifier list
     void add_variables_to_symbols();
@@ -3,6 +3,9 @@
 #include <cstdio>
 #include <iomanip>
 #include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "visitor.hpp"
 
@@ -18,7 +21,7 @@ struct FlopAccumulator {
     int pow=0;
 
     void reset() {
-        add = neg = mul = div = exp = sin = cos = log = 0;
+        add = neg = mul = div = exp = sin = cos = log = pow = 0;
     }
 };
 
@@ -37,14 +40,41 @@ static std::ostream& operator << (std::ostream& os, FlopAccumulator const& f) {
     return os;
 }
 
+// Tabulate the counts of several accumulators, one labelled row each.
+inline std::ostream& print_flop_table(std::ostream& os, const std::vector<std::pair<std::string, FlopAccumulator>>& rows) {
+    char buffer[512];
+    os << std::setw(20) << "" << "   add   neg   mul   div   exp   sin   cos   log   pow\n";
+    for (auto& row: rows) {
+        auto& f = row.second;
+        snprintf(buffer,
+                 512,
+                 "%6d%6d%6d%6d%6d%6d%6d%6d%6d",
+                 f.add, f.neg, f.mul, f.div, f.exp, f.sin, f.cos, f.log, f.pow);
+        os << std::left << std::setw(20) << row.first << std::right << buffer << "\n";
+    }
+    return os;
+}
+
 class FlopVisitor : public Visitor {
 public:
     void visit(Expression *e) override {}
 
-    // traverse the statements in an API method
+    // traverse the statements in an API method; operations in assignments
+    // to invariant locals, which are evaluated once for all instances, are
+    // counted separately
     void visit(APIMethod *e) override {
+        auto& invariant = e->invariant_locals();
         for(auto& expression : *(e->body())) {
-            expression->accept(this);
+            auto assign = expression->is_assignment();
+            auto lhs = assign? assign->lhs()->is_identifier(): nullptr;
+            if(lhs && invariant.count(lhs->spelling())) {
+                std::swap(flops, invariant_flops);
+                expression->accept(this);
+                std::swap(flops, invariant_flops);
+            }
+            else {
+                expression->accept(this);
+            }
         }
     }
 
@@ -62,13 +92,45 @@ public:
         }
     }
 
+    void visit(BlockExpression *e) override {
+        for(auto& expression : e->statements()) {
+            expression->accept(this);
+        }
+    }
+
+    // both branches are counted
+    void visit(IfExpression *e) override {
+        e->condition()->accept(this);
+        e->true_branch()->accept(this);
+        if(e->false_branch()) {
+            e->false_branch()->accept(this);
+        }
+    }
+
+    void visit(CallExpression *e) override {
+        for(auto& a : e->args()) {
+            a->accept(this);
+        }
+    }
+
     ////////////////////////////////////////////////////
-    // specializations for each type of unary expression
-    // leave UnaryExpression to throw, to catch
-    // any missed specializations
+    // specializations for each type of unary expression;
+    // exprelr(x) is counted as x/expm1(x), safeinv(x)
+    // as 1/x, and abs(x) is free
     ////////////////////////////////////////////////////
     void visit(UnaryExpression *e) override {
-        // do nothing
+        e->expression()->accept(this);
+        switch(e->op()) {
+            case tok::exprelr :
+                flops.exp++;
+                flops.div++;
+                break;
+            case tok::safeinv :
+                flops.div++;
+                break;
+            default :
+                break;
+        }
     }
 
     void visit(NegUnaryExpression *e) override {
@@ -79,6 +141,7 @@ public:
         //  :: x * -exp(3)  // should be counted
         //  :: x / -exp(3)  // should be counted
         //  :: x / - -exp(3)// should be counted only once
+        e->expression()->accept(this);
         flops.neg++;
     }
     void visit(ExpUnaryExpression *e) override {
@@ -104,13 +167,28 @@ public:
     // any missed specializations
     ////////////////////////////////////////////////////
     void visit(BinaryExpression *e) override {
-        // there must be a specialization of the flops counter for every type
-        // of binary expression: if we get here there has been an attempt to
-        // visit a binary expression for which no visitor is implemented
+        // min and max have no specialized visitor, and are counted as
+        // comparisons, as below
+        if(e->op()==tok::min || e->op()==tok::max) {
+            e->lhs()->accept(this);
+            e->rhs()->accept(this);
+            flops.add++;
+            return;
+        }
+
+        // there must be a specialization of the flops counter for every other
+        // type of binary expression: if we get here there has been an attempt
+        // to visit a binary expression for which no visitor is implemented
         throw compiler_exception(
             "PerfVisitor unable to analyse binary expression " + e->to_string(),
             e->location());
     }
+    // comparisons are counted as additions
+    void visit(ConditionalExpression *e) override {
+        e->lhs()->accept(this);
+        e->rhs()->accept(this);
+        flops.add++;
+    }
     void visit(AssignmentExpression *e) override {
         e->rhs()->accept(this);
     }
@@ -141,6 +219,7 @@ public:
     }
 
     FlopAccumulator flops;
+    FlopAccumulator invariant_flops;
 
     std::string print() const {
         std::stringstream s;
@@ -189,6 +268,26 @@ public:
         }
     }
 
+    void visit(BlockExpression *e) override {
+        for(auto& expression : e->statements()) {
+            expression->accept(this);
+        }
+    }
+
+    void visit(IfExpression *e) override {
+        e->condition()->accept(this);
+        e->true_branch()->accept(this);
+        if(e->false_branch()) {
+            e->false_branch()->accept(this);
+        }
+    }
+
+    void visit(CallExpression *e) override {
+        for(auto& a : e->args()) {
+            a->accept(this);
+        }
+    }
+
     void visit(UnaryExpression *e) override {
         e->expression()->accept(this);
     }
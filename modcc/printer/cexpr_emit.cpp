@@ -33,6 +33,28 @@ std::ostream& operator<<(std::ostream& out, as_c_double wrap) {
     }
 }
 
+std::ostream& operator<<(std::ostream& out, as_c_float wrap) {
+    bool neg = std::signbit(wrap.value);
+
+    switch (std::fpclassify(wrap.value)) {
+    case FP_INFINITE:
+        return out << (neg? "-": "") << "INFINITY";
+    case FP_NAN:
+        return out << "NAN";
+    case FP_ZERO:
+        return out << (neg? "-0.f": "0.f");
+    default:
+        float val;
+        std::stringstream s;
+        if (std::modf(wrap.value, &val) == 0) {
+            s << io::classic << std::fixed << std::setprecision(1) << wrap.value << 'f';
+        } else {
+            s << io::classic << std::setprecision(9) << wrap.value << 'f';
+        }
+        return out << s.rdbuf();
+    }
+}
+
 void CExprEmitter::emit_as_call(const char* sub, Expression* e) {
     out_ << sub << '(';
     e->accept(this);
@@ -48,7 +70,12 @@ void CExprEmitter::emit_as_call(const char* sub, Expression* e1, Expression* e2)
 }
 
 void CExprEmitter::visit(NumberExpression* e) {
-    out_ << " " << as_c_double(e->value());
+    if (single_) {
+        out_ << " " << as_c_float(e->value());
+    }
+    else {
+        out_ << " " << as_c_double(e->value());
+    }
 }
 
 void CExprEmitter::visit(UnaryExpression* e) {
@@ -178,7 +205,7 @@ void CExprEmitter::visit(IfExpression* e) {
 std::unordered_set<std::string> SimdExprEmitter::mask_names_;
 
 void SimdExprEmitter::visit(PowBinaryExpression* e) {
-    out_ << "S::pow(";
+    out_ << (fast_maths_? "S::fast_pow(": "S::pow(");
     e->lhs()->accept(this);
     out_ << ", ";
     e->rhs()->accept(this);
@@ -201,12 +228,19 @@ void SimdExprEmitter::visit(UnaryExpression* e) {
         {tok::safeinv, "safeinv"}
     };
 
+    static std::unordered_map<tok, const char*> fast_unaryop_tbl = {
+        {tok::exp,     "S::fast_exp"},
+        {tok::log,     "S::fast_log"},
+        {tok::exprelr, "S::fast_exprelr"}
+    };
+
     if (!unaryop_tbl.count(e->op())) {
         throw compiler_exception(
             "CExprEmitter: unsupported unary operator "+token_string(e->op()), e->location());
     }
 
-    const char* op_spelling = unaryop_tbl.at(e->op());
+    const char* op_spelling = fast_maths_ && fast_unaryop_tbl.count(e->op())?
+        fast_unaryop_tbl.at(e->op()): unaryop_tbl.at(e->op());
     Expression* inner = e->expression();
 
     auto iden = inner->is_identifier();
@@ -340,19 +374,28 @@ void SimdExprEmitter::visit(BlockExpression* block) {
 }
 
 void SimdExprEmitter::visit(CallExpression* e) {
+    // In mixed precision, the arguments select the overload for the
+    // precision of the kernel.
+    std::string cast_open = mixed_? "simd_cast<simd_value>(": "";
+    std::string cast_close = mixed_? ")": "";
+
     if(is_indirect_)
         out_ << e->name() << "(index_";
     else
         out_ << e->name() << "(i_";
 
-    if (processing_true_ && !current_mask_.empty()) {
-        out_ << ", " << current_mask_;
-    } else if (!processing_true_ && !current_mask_bar_.empty()) {
-        out_ << ", " << current_mask_bar_;
+    // Calls to (tabulated) functions have no side effects, and take no mask.
+    if (!e->is_function_call()) {
+        if (processing_true_ && !current_mask_.empty()) {
+            out_ << ", " << current_mask_;
+        } else if (!processing_true_ && !current_mask_bar_.empty()) {
+            out_ << ", " << current_mask_bar_;
+        }
     }
     for (auto& arg: e->args()) {
-        out_ << ", ";
+        out_ << ", " << cast_open;
         arg->accept(this);
+        out_ << cast_close;
     }
     out_ << ")";
 }
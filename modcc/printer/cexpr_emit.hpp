@@ -11,8 +11,8 @@
 
 class CExprEmitter: public Visitor {
 public:
-    CExprEmitter(std::ostream& out, Visitor* fallback):
-        out_(out), fallback_(fallback)
+    CExprEmitter(std::ostream& out, Visitor* fallback, bool single = false):
+        out_(out), fallback_(fallback), single_(single)
     {}
 
     void visit(Expression* e) override { e->accept(fallback_); }
@@ -27,13 +27,14 @@ public:
 protected:
     std::ostream& out_;
     Visitor* fallback_;
+    bool single_; // Emit single precision numeric constants.
 
     void emit_as_call(const char* sub, Expression*);
     void emit_as_call(const char* sub, Expression*, Expression*);
 };
 
-inline void cexpr_emit(Expression* e, std::ostream& out, Visitor* fallback) {
-    CExprEmitter emitter(out, fallback);
+inline void cexpr_emit(Expression* e, std::ostream& out, Visitor* fallback, bool single = false) {
+    CExprEmitter emitter(out, fallback, single);
     e->accept(&emitter);
 }
 
@@ -45,8 +46,10 @@ public:
         bool is_indirect,
         std::string input_mask,
         const std::unordered_set<std::string>& scalars,
-        Visitor* fallback):
-            CExprEmitter(out, fallback), is_indirect_(is_indirect), input_mask_(input_mask), scalars_(scalars), fallback_(fallback) {}
+        Visitor* fallback,
+        bool fast_maths = false,
+        bool mixed = false):
+            CExprEmitter(out, fallback), is_indirect_(is_indirect), fast_maths_(fast_maths), mixed_(mixed), input_mask_(input_mask), scalars_(scalars), fallback_(fallback) {}
 
     void visit(BlockExpression *e) override;
     void visit(CallExpression *e) override;
@@ -61,6 +64,8 @@ protected:
     static std::unordered_set<std::string> mask_names_;
     bool processing_true_;
     bool is_indirect_;
+    bool fast_maths_; // Use the fast approximations of exp, log, exprelr and pow.
+    bool mixed_;      // Cast call arguments to simd_value (overloads on precision).
     std::string current_mask_, current_mask_bar_, input_mask_;
     std::unordered_set<std::string> scalars_;
     Visitor* fallback_;
@@ -83,9 +88,11 @@ inline void simd_expr_emit(
         bool is_indirect,
         std::string input_mask,
         const std::unordered_set<std::string>& scalars,
-        Visitor* fallback)
+        Visitor* fallback,
+        bool fast_maths = false,
+        bool mixed = false)
 {
-    SimdExprEmitter emitter(out, is_indirect, input_mask, scalars, fallback);
+    SimdExprEmitter emitter(out, is_indirect, input_mask, scalars, fallback, fast_maths, mixed);
     e->accept(&emitter);
 }
 
@@ -96,3 +103,11 @@ struct as_c_double {
 };
 
 std::ostream& operator<<(std::ostream&, as_c_double);
+
+// Helper for formatting of float-valued numeric constants.
+struct as_c_float {
+    float value;
+    as_c_float(double value): value(value) {}
+};
+
+std::ostream& operator<<(std::ostream&, as_c_float);
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <regex>
@@ -34,14 +35,25 @@ struct index_prop {
 };
 
 void emit_procedure_proto(std::ostream&, ProcedureExpression*, const std::string& qualified = "");
-void emit_simd_procedure_proto(std::ostream&, ProcedureExpression*, const std::string& qualified = "");
-void emit_masked_simd_procedure_proto(std::ostream&, ProcedureExpression*, const std::string& qualified = "");
+void emit_simd_procedure_proto(std::ostream&, ProcedureExpression*, const std::string& qualified = "", bool single = false);
+void emit_masked_simd_procedure_proto(std::ostream&, ProcedureExpression*, const std::string& qualified = "", bool single = false);
 
-void emit_api_body(std::ostream&, APIMethod*);
-void emit_simd_api_body(std::ostream&, APIMethod*, const std::vector<VariableExpression*>& scalars);
+void emit_table_proto(std::ostream&, FunctionExpression*, bool simd, const std::string& qualified = "", bool single = false);
+void emit_table_exact_proto(std::ostream&, FunctionExpression*, const std::string& qualified = "");
+
+void emit_api_body(std::ostream&, APIMethod*, bool single = false);
+void emit_simd_api_body(std::ostream&, APIMethod*, const std::vector<VariableExpression*>& scalars, bool fast_maths, bool mixed = false, bool single = false);
 
 void emit_simd_index_initialize(std::ostream& out, const std::list<index_prop>& indices, simd_expr_constraint constraint);
 
+// In mixed precision, the single precision kernels, procedures and tabulated
+// functions compute over float_width_ instances with these types.
+static const char* simd_single_aliases =
+    "using simd_value [[maybe_unused]] = simd_float;\n"
+    "using simd_mask [[maybe_unused]] = simd_float_mask;\n"
+    "using simd_index [[maybe_unused]] = simd_float_index;\n"
+    "constexpr unsigned simd_width_ [[maybe_unused]] = float_width_;\n";
+
 void emit_simd_body_for_loop(std::ostream& out,
                              BlockExpression* body,
                              const std::vector<LocalVariable*>& indexed_vars,
@@ -56,10 +68,11 @@ void emit_simd_for_loop_per_constraint(std::ostream& out, BlockExpression* body,
 
 struct cprint {
     Expression* expr_;
-    explicit cprint(Expression* expr): expr_(expr) {}
+    bool single_;
+    explicit cprint(Expression* expr, bool single = false): expr_(expr), single_(single) {}
 
     friend std::ostream& operator<<(std::ostream& out, const cprint& w) {
-        CPrinter printer(out);
+        CPrinter printer(out, w.single_);
         return w.expr_->accept(&printer), out;
     }
 };
@@ -68,7 +81,10 @@ struct simdprint {
     Expression* expr_;
     bool is_indirect_ = false;
     bool is_masked_ = false;
+    bool is_fast_maths_ = false;
+    bool is_mixed_ = false;
     std::unordered_set<std::string> scalars_;
+    std::set<std::string> hoisted_;
 
     explicit simdprint(Expression* expr, const std::vector<VariableExpression*>& scalars): expr_(expr) {
         for (const auto& s: scalars) {
@@ -82,6 +98,15 @@ struct simdprint {
     void set_masked() {
         is_masked_ = true;
     }
+    void set_fast_maths(bool fast_maths) {
+        is_fast_maths_ = fast_maths;
+    }
+    void set_hoisted(const std::set<std::string>& hoisted) {
+        hoisted_ = hoisted;
+    }
+    void set_mixed_precision(bool mixed) {
+        is_mixed_ = mixed;
+    }
 
     friend std::ostream& operator<<(std::ostream& out, const simdprint& w) {
         SimdPrinter printer(out);
@@ -89,7 +114,10 @@ struct simdprint {
             printer.set_input_mask("mask_input_");
         }
         printer.set_var_indexed(w.is_indirect_);
+        printer.set_fast_maths(w.is_fast_maths_);
+        printer.set_mixed_precision(w.is_mixed_);
         printer.save_scalar_names(w.scalars_);
+        printer.set_hoisted(w.hoisted_);
         return w.expr_->accept(&printer), out;
     }
 };
@@ -113,8 +141,15 @@ std::string emit_cpp_source(const Module& module_, const printer_options& opt) {
     APIMethod* state_api = find_api_method(module_, "advance_state");
     APIMethod* current_api = find_api_method(module_, "compute_currents");
     APIMethod* write_ions_api = find_api_method(module_, "write_ions");
+    auto tables = tabulated_functions(module_);
+    bool tables_celsius = std::any_of(tables.begin(), tables.end(), table_depends_on_temperature);
 
     bool with_simd = opt.simd.abi!=simd_spec::none;
+    bool fast_maths = with_simd && opt.accuracy==simd_accuracy::fast;
+    bool mixed = opt.mixed_precision;
+
+    // In mixed precision, STATE variables are held in single precision.
+    auto is_float = [mixed](VariableExpression* v) { return mixed && v->is_state(); };
 
     // init_api, state_api, current_api methods are mandatory:
 
@@ -154,7 +189,14 @@ std::string emit_cpp_source(const Module& module_, const printer_options& opt) {
         "#include <algorithm>\n"
         "#include <cmath>\n"
         "#include <cstddef>\n"
-        "#include <memory>\n"
+        "#include <memory>\n";
+
+    !tables.empty() && out <<
+        "#include <map>\n"
+        "#include <mutex>\n"
+        "#include <vector>\n";
+
+    out <<
         "#include <" << arb_private_header_prefix() << "backends/multicore/mechanism.hpp>\n"
         "#include <" << arb_header_prefix() << "math.hpp>\n";
 
@@ -230,6 +272,47 @@ std::string emit_cpp_source(const Module& module_, const printer_options& opt) {
             "    return S::div(ones, x);\n"
             "}\n"
             "\n";
+
+        // In mixed precision, the INITIAL and state update kernels compute
+        // in single precision over float_width_ instances at a time, with
+        // the native ABI for float if there is one. float_width_ is a
+        // multiple of simd_width_, and the other kernels compute over each
+        // group of float_width_ instances in steps of simd_width_. Values
+        // are converted on loads and stores where the precisions differ;
+        // simd_double is for the weighted updates of the single precision
+        // kernels.
+        if (mixed) {
+            out << "static constexpr unsigned float_vector_length_ = ";
+            switch (opt.simd.abi) {
+            case simd_spec::avx2:
+                out << "8;\n";
+                break;
+            case simd_spec::avx512:
+                out << "16;\n";
+                break;
+            case simd_spec::native:
+            case simd_spec::default_abi:
+                out << "S::simd_abi::native_width<float>::value;\n";
+                break;
+            default:
+                out << "vector_length_;\n";
+            }
+            out <<
+                "static constexpr unsigned float_width_ = float_vector_length_ > simd_width_? float_vector_length_: simd_width_;\n"
+                "static_assert(float_width_ % simd_width_ == 0, \"float SIMD width must be a multiple of the SIMD width\");\n"
+                "using simd_float = S::simd<float, float_width_, S::simd_abi::default_abi>;\n"
+                "using simd_float_mask = S::simd_mask<float, float_width_, S::simd_abi::default_abi>;\n"
+                "using simd_float_index = S::simd<::arb::fvm_index_type, float_width_, S::simd_abi::default_abi>;\n"
+                "using simd_double = S::simd<::arb::fvm_value_type, float_width_, S::simd_abi::default_abi>;\n"
+                "\n"
+                "inline simd_float safeinv(simd_float x) {\n"
+                "    simd_float ones = simd_cast<simd_float>(1.0f);\n"
+                "    auto mask = S::cmp_eq(S::add(x,ones), ones);\n"
+                "    S::where(mask, x) = simd_cast<simd_float>(FLT_EPSILON);\n"
+                "    return S::div(ones, x);\n"
+                "}\n"
+                "\n";
+        }
     }
 
     out <<
@@ -255,13 +338,16 @@ std::string emit_cpp_source(const Module& module_, const printer_options& opt) {
     post_event && out <<
         "void post_event() override;\n";
 
-    with_simd && out << "unsigned simd_width() const override { return simd_width_; }\n";
+    with_simd && out << "unsigned simd_width() const override { return " << (mixed? "float_width_": "simd_width_") << "; }\n";
 
     out <<
         "\n" << popindent <<
         "protected:\n" << indent <<
         "std::size_t object_sizeof() const override { return sizeof(*this); }\n";
 
+    !tables.empty() && out <<
+        "void init_tables() override;\n";
+
     io::separator sep("\n", ",\n");
     if (!vars.scalars.empty()) {
         out <<
@@ -283,7 +369,9 @@ std::string emit_cpp_source(const Module& module_, const printer_options& opt) {
         sep.reset();
         for (const auto& array: vars.arrays) {
             auto memb = array->name();
-            out << sep << "{" << quote(memb) << ", &" << memb << "}";
+            if (!is_float(array)) {
+                out << sep << "{" << quote(memb) << ", &" << memb << "}";
+            }
         }
         out << popindent << "\n};" << popindent << "\n}\n";
 
@@ -308,12 +396,27 @@ std::string emit_cpp_source(const Module& module_, const printer_options& opt) {
         sep.reset();
         for (const auto& array: vars.arrays) {
             auto memb = array->name();
-            if(array->is_state()) {
+            if(array->is_state() && !is_float(array)) {
                 out << sep << "{" << quote(memb) << ", &" << memb << "}";
             }
         }
         out << popindent << "\n};" << popindent << "\n}\n";
 
+        if (mixed) {
+            out <<
+                "mechanism_float_state_table float_state_table() override {\n" << indent <<
+                "return {" << indent;
+
+            sep.reset();
+            for (const auto& array: vars.arrays) {
+                auto memb = array->name();
+                if (is_float(array)) {
+                    out << sep << "{" << quote(memb) << ", &" << memb << "}";
+                }
+            }
+            out << popindent << "\n};" << popindent << "\n}\n";
+        }
+
     }
 
     if (!ion_deps.empty()) {
@@ -342,7 +445,7 @@ std::string emit_cpp_source(const Module& module_, const printer_options& opt) {
         out << "::arb::fvm_value_type " << scalar->name() <<  " = " << as_c_double(scalar->value()) << ";\n";
     }
     for (const auto& array: vars.arrays) {
-        out << "::arb::fvm_value_type* " << array->name() << ";\n";
+        out << (is_float(array)? "float* ": "::arb::fvm_value_type* ") << array->name() << ";\n";
     }
     for (const auto& dep: ion_deps) {
         out << "::arb::ion_state_view " << ion_state_field(dep.name) << ";\n";
@@ -355,12 +458,51 @@ std::string emit_cpp_source(const Module& module_, const printer_options& opt) {
             out << ";\n";
             emit_masked_simd_procedure_proto(out, proc);
             out << ";\n";
+            if (mixed) {
+                emit_simd_procedure_proto(out, proc, "", true);
+                out << ";\n";
+                emit_masked_simd_procedure_proto(out, proc, "", true);
+                out << ";\n";
+            }
         } else {
             emit_procedure_proto(out, proc);
             out << ";\n";
         }
     }
 
+    // Tabulated functions: each table holds the values at the intervals+1
+    // points of the grid, followed by a copy of the last value, so that the
+    // lookup at the upper end of the range need not be a special case. The
+    // tables are shared by all instances of the mechanism with the same global
+    // parameters and temperature (tables_key_).
+    if (!tables.empty()) {
+        out << "struct tables_type_ {\n" << indent;
+        for (auto f: tables) {
+            out << "::arb::fvm_value_type " << f->name() << "_table_[" << f->table()->intervals+2 << "];\n";
+        }
+        out << popindent << "};\n"
+            "std::vector<::arb::fvm_value_type> tables_key_;\n"
+            "std::shared_ptr<const tables_type_> tables_;\n";
+
+        // Tables that depend on the temperature are not used if the
+        // instances are not all at the same temperature.
+        tables_celsius && out << "bool exact_celsius_ = false;\n";
+    }
+    for (auto f: tables) {
+        emit_table_exact_proto(out, f);
+        out << ";\n";
+        emit_table_proto(out, f, false);
+        out << ";\n";
+        if (with_simd) {
+            emit_table_proto(out, f, true);
+            out << ";\n";
+            if (mixed) {
+                emit_table_proto(out, f, true, "", true);
+                out << ";\n";
+            }
+        }
+    }
+
     out << popindent <<
         "};\n\n"
         "template <typename B> ::arb::concrete_mech_ptr<B> make_mechanism_" <<name << "();\n"
@@ -408,22 +550,23 @@ std::string emit_cpp_source(const Module& module_, const printer_options& opt) {
             "}\n\n";
     }
 
-    auto emit_body = [&](APIMethod *p) {
+    // The fast approximations are for double precision only.
+    auto emit_body = [&](APIMethod *p, bool single = false) {
         if (with_simd) {
-            emit_simd_api_body(out, p, vars.scalars);
+            emit_simd_api_body(out, p, vars.scalars, fast_maths && !single, mixed, single);
         }
         else {
-            emit_api_body(out, p);
+            emit_api_body(out, p, single);
         }
     };
 
     out << "void " << class_name << "::init() {\n" << indent;
-    emit_body(init_api);
+    emit_body(init_api, mixed);
     out << popindent << "}\n\n";
 
     out << "void " << class_name << "::advance_state() {\n" << indent;
     out << profiler_enter("advance_integrate_state");
-    emit_body(state_api);
+    emit_body(state_api, mixed);
     out << profiler_leave();
     out << popindent << "}\n\n";
 
@@ -437,18 +580,133 @@ std::string emit_cpp_source(const Module& module_, const printer_options& opt) {
     emit_body(write_ions_api);
     out << popindent << "}\n\n";
 
-    // Mechanism procedures
+    // The tables are looked up in a cache of the tables of all instances of
+    // the mechanism, and computed only if no instance with the same key has
+    // them.
+    if (!tables.empty()) {
+        out << "void " << class_name << "::init_tables() {\n" << indent;
+        if (tables_celsius) {
+            out <<
+                "::arb::fvm_value_type celsius = width_? temperature_degC_[node_index_[0]]: 0;\n"
+                "exact_celsius_ = false;\n"
+                "for (size_type i_ = 1; i_ < width_; ++i_) {\n" << indent <<
+                "if (temperature_degC_[node_index_[i_]]!=celsius) exact_celsius_ = true;\n" << popindent <<
+                "}\n";
+        }
+        out << "std::vector<::arb::fvm_value_type> key_ = {";
+        io::separator key_sep("", ", ");
+        for (auto& scalar: vars.scalars) {
+            out << key_sep << scalar->name();
+        }
+        tables_celsius && out << key_sep << "celsius";
+        out << "};\n"
+            "if (tables_ && key_==tables_key_) return;\n"
+            "tables_key_ = key_;\n"
+            "\n"
+            "static std::mutex mutex_;\n"
+            "static std::map<std::vector<::arb::fvm_value_type>, std::weak_ptr<const tables_type_>> cache_;\n"
+            "std::lock_guard<std::mutex> lock_(mutex_);\n"
+            "if ((tables_ = cache_[key_].lock())) return;\n"
+            "\n"
+            "auto tables = std::make_shared<tables_type_>();\n";
+        for (auto f: tables) {
+            auto table = f->table();
+            auto t = "tables->"+f->name()+"_table_";
+            out <<
+                "for (unsigned k_ = 0; k_ <= " << table->intervals << "; ++k_) {\n" << indent <<
+                t << "[k_] = " << f->name() << "_exact_(" << as_c_double(table->from) << "+k_*" << as_c_double(table->step())
+                  << (table_depends_on_temperature(f)? ", celsius": "") << ");\n" << popindent <<
+                "}\n" <<
+                t << "[" << table->intervals+1 << "] = " << t << "[" << table->intervals << "];\n";
+        }
+        out <<
+            "for (auto e_ = cache_.begin(); e_ != cache_.end();) {\n" << indent <<
+            "e_ = e_->second.expired()? cache_.erase(e_): std::next(e_);\n" << popindent <<
+            "}\n"
+            "cache_[key_] = tables_ = tables;\n" << popindent <<
+            "}\n\n";
+    }
+
+    // Tabulated functions: values of the argument outside the range of the
+    // table are evaluated exactly, as are all values of functions that depend
+    // on the temperature if the instances differ in temperature.
+
+    for (auto f: tables) {
+        auto table = f->table();
+        auto t = "tables_->"+f->name()+"_table_";
+        auto x = f->args().front()->is_argument()->name();
+        bool celsius = table_depends_on_temperature(f);
+        auto exact = celsius? "exact_celsius_ || ": "";
+
+        emit_table_exact_proto(out, f, class_name);
+        out <<
+            " {\n" << indent <<
+            "::arb::fvm_value_type " << f->name() << ";\n" <<
+            cprint(f->body()) <<
+            "return " << f->name() << ";\n" << popindent <<
+            "}\n\n";
+
+        emit_table_proto(out, f, false, class_name);
+        out <<
+            " {\n" << indent <<
+            "::arb::fvm_value_type u_ = (" << x << "-(" << as_c_double(table->from) << "))*" << as_c_double(1/table->step()) << ";\n"
+            "if (" << exact << "!(u_ >= 0 && u_ <= " << as_c_double(table->intervals) << ")) "
+                "return " << f->name() << "_exact_(" << x << (celsius? ", temperature_degC_[node_index_[i_]]": "") << ");\n"
+            "int k_ = u_;\n"
+            "::arb::fvm_value_type r_ = u_-k_;\n"
+            "return " << t << "[k_]+r_*(" << t << "[k_+1]-" << t << "[k_]);\n" << popindent <<
+            "}\n\n";
+
+        if (with_simd) {
+            for (bool single: {false, true}) {
+                if (single && !mixed) continue;
+
+                emit_table_proto(out, f, true, class_name, single);
+                out <<
+                    " {\n" << indent <<
+                    (single? simd_single_aliases: "") <<
+                    "simd_value u_ = S::mul(S::sub(" << x << ", simd_cast<simd_value>(" << as_c_double(table->from) << ")), "
+                        "simd_cast<simd_value>(" << as_c_double(1/table->step()) << "));\n"
+                    "simd_mask in_ = S::logical_and(S::cmp_geq(u_, simd_cast<simd_value>(0.)), "
+                        "S::cmp_leq(u_, simd_cast<simd_value>(" << as_c_double(table->intervals) << ")));\n"
+                    "S::where(S::logical_not(in_), u_) = simd_cast<simd_value>(0.);\n"
+                    "simd_index k_ = simd_cast<simd_index>(u_);\n"
+                    "simd_value r_ = S::sub(u_, simd_cast<simd_value>(k_));\n"
+                    "simd_value y0_ = simd_cast<simd_value>(indirect(" << t << ", k_, simd_width_));\n"
+                    "simd_value y1_ = simd_cast<simd_value>(indirect(" << t << "+1, k_, simd_width_));\n"
+                    "simd_value y_ = S::fma(r_, S::sub(y1_, y0_), y0_);\n"
+                    "for (unsigned j_ = 0; j_ < simd_width_; ++j_) {\n" << indent <<
+                    "if (" << exact << "!in_[j_]) "
+                        "y_[j_] = " << f->name() << "_exact_(" << x << "[j_]" << (celsius? ", temperature_degC_[node_index_[i_+j_]]": "") << ");\n" << popindent <<
+                    "}\n"
+                    "return y_;\n" << popindent <<
+                    "}\n\n";
+            }
+        }
+    }
+
+    // Mechanism procedures: in mixed precision, these are also emitted in
+    // single precision, for the calls from the single precision kernels.
 
     for (auto proc: normal_procedures(module_)) {
         if (with_simd) {
-            emit_simd_procedure_proto(out, proc, class_name);
-            auto simd_print = simdprint(proc->body(), vars.scalars);
-            out << " {\n" << indent << simd_print << popindent <<  "}\n\n";
-
-            emit_masked_simd_procedure_proto(out, proc, class_name);
-            auto masked_print = simdprint(proc->body(), vars.scalars);
-            masked_print.set_masked();
-            out << " {\n" << indent << masked_print << popindent << "}\n\n";
+            for (bool single: {false, true}) {
+                if (single && !mixed) continue;
+                const char* aliases = single? simd_single_aliases: "";
+
+                emit_simd_procedure_proto(out, proc, class_name, single);
+                auto simd_print = simdprint(proc->body(), vars.scalars);
+                simd_print.set_fast_maths(fast_maths && !single);
+                simd_print.set_mixed_precision(mixed);
+                out << " {\n" << indent << aliases << simd_print << popindent <<  "}\n\n";
+
+                emit_masked_simd_procedure_proto(out, proc, class_name, single);
+                auto masked_print = simdprint(proc->body(), vars.scalars);
+                masked_print.set_masked();
+                masked_print.set_fast_maths(fast_maths && !single);
+                masked_print.set_mixed_precision(mixed);
+                out << " {\n" << indent << aliases << masked_print << popindent << "}\n\n";
+            }
         } else {
             emit_procedure_proto(out, proc, class_name);
             out <<
@@ -473,24 +731,66 @@ void CPrinter::visit(LocalVariable* sym) {
 }
 
 void CPrinter::visit(VariableExpression *sym) {
+    bool convert = single_ && !lhs_ && !sym->is_state();
+
+    convert && out_ << "float(";
     out_ << sym->name() << (sym->is_range()? "[i_]": "");
+    convert && out_ << ")";
+}
+
+void CPrinter::visit(AssignmentExpression* e) {
+    lhs_ = true;
+    e->lhs()->accept(this);
+    lhs_ = false;
+    out_ << " = ";
+    e->rhs()->accept(this);
+}
+
+// The temperature, in the body of a tabulated function: the argument celsius.
+void CPrinter::visit(IndexedVariable* sym) {
+    if (sym->data_source()!=sourceKind::temperature) {
+        visit(static_cast<Expression*>(sym));
+        return;
+    }
+    out_ << "celsius";
+}
+
+// The return value of a function, in the body of a tabulated function.
+void CPrinter::visit(Symbol* sym) {
+    if (sym->kind()!=symbolKind::local_variable) {
+        visit(static_cast<Expression*>(sym));
+    }
+    out_ << sym->name();
 }
 
 void CPrinter::visit(CallExpression* e) {
+    bool convert = single_ && e->is_function_call();
+
+    convert && out_ << "float(";
     out_ << e->name() << "(i_";
     for (auto& arg: e->args()) {
         out_ << ", ";
         arg->accept(this);
     }
     out_ << ")";
+    convert && out_ << ")";
+}
+
+static bool is_hoisted_assignment(Expression* stmt, const std::set<std::string>& hoisted) {
+    auto assign = stmt->is_assignment();
+    auto lhs = assign? assign->lhs()->is_identifier(): nullptr;
+    return lhs && hoisted.count(lhs->spelling());
 }
 
 void CPrinter::visit(BlockExpression* block) {
     // Only include local declarations in outer-most block.
     if (!block->is_nested()) {
         auto locals = pure_locals(block->scope());
+        locals.erase(std::remove_if(locals.begin(), locals.end(),
+                [this](LocalVariable* local) { return hoisted_.count(local->name()); }),
+            locals.end());
         if (!locals.empty()) {
-            out_ << "::arb::fvm_value_type ";
+            out_ << (single_? "float ": "::arb::fvm_value_type ");
             io::separator sep(", ");
             for (auto local: locals) {
                 out_ << sep << local->name();
@@ -500,13 +800,34 @@ void CPrinter::visit(BlockExpression* block) {
     }
 
     for (auto& stmt: block->statements()) {
-        if (!stmt->is_local_declaration()) {
+        if (!stmt->is_local_declaration() && !is_hoisted_assignment(stmt.get(), hoisted_)) {
             stmt->accept(this);
             out_ << (stmt->is_if()? "": ";\n");
         }
     }
 }
 
+void emit_table_exact_proto(std::ostream& out, FunctionExpression* e, const std::string& qualified) {
+    out << "::arb::fvm_value_type " << qualified << (qualified.empty()? "": "::") << e->name()
+        << "_exact_(::arb::fvm_value_type " << e->args().front()->is_argument()->name()
+        << (table_depends_on_temperature(e)? ", ::arb::fvm_value_type celsius": "") << ")";
+}
+
+// The instance index i_ is used only to look up the temperature.
+void emit_table_proto(std::ostream& out, FunctionExpression* e, bool simd, const std::string& qualified, bool single) {
+    auto x = e->args().front()->is_argument()->name();
+    auto i = table_depends_on_temperature(e)? " i_": "";
+    if (simd) {
+        auto value_type = single? "simd_float": "simd_value";
+        out << value_type << " " << qualified << (qualified.empty()? "": "::") << e->name()
+            << "(::arb::fvm_index_type" << i << ", const " << value_type << "& " << x << ")";
+    }
+    else {
+        out << "::arb::fvm_value_type " << qualified << (qualified.empty()? "": "::") << e->name()
+            << "(int" << i << ", ::arb::fvm_value_type " << x << ")";
+    }
+}
+
 static std::string index_i_name(const std::string& index_var) {
     return index_var+"i_";
 }
@@ -534,13 +855,18 @@ namespace {
     };
 }
 
-void emit_state_read(std::ostream& out, LocalVariable* local) {
-    out << "::arb::fvm_value_type " << cprint(local) << " = ";
+void emit_state_read(std::ostream& out, LocalVariable* local, bool single) {
+    out << (single? "float ": "::arb::fvm_value_type ") << cprint(local) << " = ";
 
     if (local->is_read()) {
         auto d = decode_indexed_variable(local->external_variable());
         if (d.scale != 1) {
-            out << as_c_double(d.scale) << "*";
+            if (single) {
+                out << as_c_float(d.scale) << "*";
+            }
+            else {
+                out << as_c_double(d.scale) << "*";
+            }
         }
         out << deref(d) << ";\n";
     }
@@ -575,7 +901,7 @@ void emit_state_update(std::ostream& out, Symbol* from, IndexedVariable* externa
     }
 }
 
-void emit_api_body(std::ostream& out, APIMethod* method) {
+void emit_api_body(std::ostream& out, APIMethod* method, bool single) {
     auto body = method->body();
     auto indexed_vars = indexed_locals(method->scope());
 
@@ -595,6 +921,14 @@ void emit_api_body(std::ostream& out, APIMethod* method) {
     }
 
     if (!body->statements().empty()) {
+        // Values that are the same for every instance are computed once.
+        auto& hoisted = method->invariant_locals();
+        for (auto& stmt: body->statements()) {
+            if (is_hoisted_assignment(stmt.get(), hoisted)) {
+                out << (single? "const float ": "const ::arb::fvm_value_type ") << cprint(stmt.get(), single) << ";\n";
+            }
+        }
+
         out <<
             "int n_ = width_;\n"
             "for (int i_ = 0; i_ < n_; ++i_) {\n" << indent;
@@ -604,9 +938,11 @@ void emit_api_body(std::ostream& out, APIMethod* method) {
         }
 
         for (auto& sym: indexed_vars) {
-            emit_state_read(out, sym);
+            emit_state_read(out, sym, single);
         }
-        out << cprint(body);
+        CPrinter printer(out, single);
+        printer.set_hoisted(hoisted);
+        body->accept(&printer);
 
         for (auto& sym: indexed_vars) {
             emit_state_update(out, sym, sym->external_variable());
@@ -683,13 +1019,17 @@ void SimdPrinter::visit(AssignmentExpression* e) {
 }
 
 void SimdPrinter::visit(CallExpression* e) {
+    // In mixed precision, the arguments select the overload for the
+    // precision of the kernel.
     if(is_indirect_)
         out_ << e->name() << "(index_";
     else
         out_ << e->name() << "(i_";
     for (auto& arg: e->args()) {
         out_ << ", ";
+        if (mixed_) out_ << "simd_cast<simd_value>(";
         arg->accept(this);
+        if (mixed_) out_ << ")";
     }
     out_ << ")";
 }
@@ -698,6 +1038,9 @@ void SimdPrinter::visit(BlockExpression* block) {
     // Only include local declarations in outer-most block.
     if (!block->is_nested()) {
         auto locals = pure_locals(block->scope());
+        locals.erase(std::remove_if(locals.begin(), locals.end(),
+                [this](LocalVariable* local) { return hoisted_.count(local->name()); }),
+            locals.end());
         if (!locals.empty()) {
             out_ << "simd_value ";
             io::separator sep(", ");
@@ -709,7 +1052,7 @@ void SimdPrinter::visit(BlockExpression* block) {
     }
 
     for (auto& stmt: block->statements()) {
-        if (!stmt->is_local_declaration()) {
+        if (!stmt->is_local_declaration() && !is_hoisted_assignment(stmt.get(), hoisted_)) {
             stmt->accept(this);
             if (!stmt->is_if() && !stmt->is_block()) {
                 out_ << ";\n";
@@ -718,19 +1061,19 @@ void SimdPrinter::visit(BlockExpression* block) {
     }
 }
 
-void emit_simd_procedure_proto(std::ostream& out, ProcedureExpression* e, const std::string& qualified) {
+void emit_simd_procedure_proto(std::ostream& out, ProcedureExpression* e, const std::string& qualified, bool single) {
     out << "void " << qualified << (qualified.empty()? "": "::") << e->name() << "(::arb::fvm_index_type i_";
     for (auto& arg: e->args()) {
-        out << ", const simd_value& " << arg->is_argument()->name();
+        out << ", const " << (single? "simd_float": "simd_value") << "& " << arg->is_argument()->name();
     }
     out << ")";
 }
 
-void emit_masked_simd_procedure_proto(std::ostream& out, ProcedureExpression* e, const std::string& qualified) {
+void emit_masked_simd_procedure_proto(std::ostream& out, ProcedureExpression* e, const std::string& qualified, bool single) {
     out << "void " << qualified << (qualified.empty()? "": "::") << e->name()
-    << "(::arb::fvm_index_type i_, simd_mask mask_input_";
+    << "(::arb::fvm_index_type i_, " << (single? "simd_float_mask": "simd_mask") << " mask_input_";
     for (auto& arg: e->args()) {
-        out << ", const simd_value& " << arg->is_argument()->name();
+        out << ", const " << (single? "simd_float": "simd_value") << "& " << arg->is_argument()->name();
     }
     out << ")";
 }
@@ -749,7 +1092,7 @@ void emit_simd_state_read(std::ostream& out, LocalVariable* local, simd_expr_con
                 switch (constraint) {
                     case simd_expr_constraint::contiguous:
                         out << ";\n"
-                            << "assign(" << local->name() << ", indirect(" << d.data_var
+                            << "assign(" << local->name() << ", " << "indirect(" << d.data_var
                             << " + " << index_i_name(d.node_index_var) << ", simd_width_));\n";
                         break;
                     case simd_expr_constraint::constant:
@@ -758,13 +1101,13 @@ void emit_simd_state_read(std::ostream& out, LocalVariable* local, simd_expr_con
                         break;
                     default:
                         out << ";\n"
-                            << "assign(" << local->name() << ", indirect(" << d.data_var
+                            << "assign(" << local->name() << ", " << "indirect(" << d.data_var
                             << ", " << index_i_name(d.node_index_var) << ", simd_width_, constraint_category_));\n";
                 }
             }
             else {
                 out << ";\n"
-                    << "assign(" << local->name() << ", indirect(" << d.data_var
+                    << "assign(" << local->name() << ", " << "indirect(" << d.data_var
                     << ", " << index_i_name(d.cell_index_var) << ", simd_width_, index_constraint::none));\n";
             }
         }
@@ -778,9 +1121,14 @@ void emit_simd_state_read(std::ostream& out, LocalVariable* local, simd_expr_con
     }
 }
 
-void emit_simd_state_update(std::ostream& out, Symbol* from, IndexedVariable* external, simd_expr_constraint constraint) {
+// In a single precision kernel (single), the values are converted to double
+// precision before they are written.
+void emit_simd_state_update(std::ostream& out, Symbol* from, IndexedVariable* external, simd_expr_constraint constraint, bool single = false) {
     if (!external->is_write()) return;
 
+    std::string value_type = single? "simd_double": "simd_value";
+    std::string from_value = single? "simd_cast<simd_double>("+from->name()+")": from->name();
+
     auto d = decode_indexed_variable(external);;
     double coeff = 1./d.scale;
 
@@ -794,12 +1142,12 @@ void emit_simd_state_update(std::ostream& out, Symbol* from, IndexedVariable* ex
                 case simd_expr_constraint::contiguous:
                 {
                     std::string tempvar = "t_" + external->name();
-                    out << "simd_value " << tempvar << ";\n"
+                    out << value_type << " " << tempvar << ";\n"
                         << "assign(" << tempvar << ", indirect(" << d.data_var << " + " << index_i_name(d.node_index_var) << ", simd_width_));\n";
                     if (coeff != 1) {
-                        out << tempvar << " = S::fma(S::mul(w_, simd_cast<simd_value>(" << as_c_double(coeff) << "))," << from->name() << ", " << tempvar << ");\n";
+                        out << tempvar << " = S::fma(S::mul(w_, simd_cast<" << value_type << ">(" << as_c_double(coeff) << "))," << from_value << ", " << tempvar << ");\n";
                     } else {
-                        out << tempvar << " = S::fma(w_, " << from->name() << ", " << tempvar << ");\n";
+                        out << tempvar << " = S::fma(w_, " << from_value << ", " << tempvar << ");\n";
                     }
                     out << "indirect(" << d.data_var << " + " << index_i_name(d.node_index_var) << ", simd_width_) = " << tempvar << ";\n";
                     break;
@@ -808,9 +1156,9 @@ void emit_simd_state_update(std::ostream& out, Symbol* from, IndexedVariable* ex
                 {
                     out << "indirect(" << d.data_var << ", simd_cast<simd_index>(" << index_i_name(d.node_index_var) << "), simd_width_, constraint_category_)";
                     if (coeff != 1) {
-                        out << " += S::mul(w_, S::mul(simd_cast<simd_value>(" << as_c_double(coeff) << "), " << from->name() << "));\n";
+                        out << " += S::mul(w_, S::mul(simd_cast<" << value_type << ">(" << as_c_double(coeff) << "), " << from_value << "));\n";
                     } else {
-                        out << " += S::mul(w_, " << from->name() << ");\n";
+                        out << " += S::mul(w_, " << from_value << ");\n";
                     }
                     break;
                 }
@@ -818,18 +1166,18 @@ void emit_simd_state_update(std::ostream& out, Symbol* from, IndexedVariable* ex
                 {
                     out << "indirect(" << d.data_var << ", " << index_i_name(d.node_index_var) << ", simd_width_, constraint_category_)";
                     if (coeff != 1) {
-                        out << " += S::mul(w_, S::mul(simd_cast<simd_value>(" << as_c_double(coeff) << "), " << from->name() << "));\n";
+                        out << " += S::mul(w_, S::mul(simd_cast<" << value_type << ">(" << as_c_double(coeff) << "), " << from_value << "));\n";
                     } else {
-                        out << " += S::mul(w_, " << from->name() << ");\n";
+                        out << " += S::mul(w_, " << from_value << ");\n";
                     }
                 }
             }
         } else {
             out << "indirect(" << d.data_var << ", " << index_i_name(d.cell_index_var) << ", simd_width_, index_constraint::none)";
             if (coeff != 1) {
-                out << " += S::mul(w_, S::mul(simd_cast<simd_value>(" << as_c_double(coeff) << "), " << from->name() << "));\n";
+                out << " += S::mul(w_, S::mul(simd_cast<" << value_type << ">(" << as_c_double(coeff) << "), " << from_value << "));\n";
             } else {
-                out << " += S::mul(w_, " << from->name() << ");\n";
+                out << " += S::mul(w_, " << from_value << ");\n";
             }
         }
     }
@@ -850,9 +1198,9 @@ void emit_simd_state_update(std::ostream& out, Symbol* from, IndexedVariable* ex
         }
 
         if (coeff != 1) {
-            out << "(S::mul(simd_cast<simd_value>(" << as_c_double(coeff) << ")," << from->name() << "));\n";
+            out << "(S::mul(simd_cast<" << value_type << ">(" << as_c_double(coeff) << ")," << from_value << "));\n";
         } else {
-            out << from->name() << ";\n";
+            out << from_value << ";\n";
         }
     }
 }
@@ -896,7 +1244,11 @@ void emit_simd_body_for_loop(
         const std::vector<LocalVariable*>& indexed_vars,
         const std::vector<VariableExpression*>& scalars,
         const std::list<index_prop>& indices,
-        const simd_expr_constraint& constraint) {
+        const simd_expr_constraint& constraint,
+        const std::set<std::string>& hoisted,
+        bool fast_maths,
+        bool mixed,
+        bool single) {
     emit_simd_index_initialize(out, indices, constraint);
 
     for (auto& sym: indexed_vars) {
@@ -905,11 +1257,14 @@ void emit_simd_body_for_loop(
 
     simdprint printer(body, scalars);
     printer.set_indirect_index();
+    printer.set_fast_maths(fast_maths);
+    printer.set_hoisted(hoisted);
+    printer.set_mixed_precision(mixed);
 
     out << printer;
 
     for (auto& sym: indexed_vars) {
-        emit_simd_state_update(out, sym, sym->external_variable(), constraint);
+        emit_simd_state_update(out, sym, sym->external_variable(), constraint, single);
     }
 }
 
@@ -919,25 +1274,45 @@ void emit_simd_for_loop_per_constraint(std::ostream& out, BlockExpression* body,
                                   bool requires_weight,
                                   const std::list<index_prop>& indices,
                                   const simd_expr_constraint& constraint,
-                                  std::string underlying_constraint_name) {
+                                  std::string underlying_constraint_name,
+                                  const std::set<std::string>& hoisted,
+                                  bool fast_maths,
+                                  bool mixed,
+                                  bool single) {
+
+    // The constraints partition the instances in groups of float_width_ in
+    // mixed precision: a double precision kernel computes over each group in
+    // steps of simd_width_, with the same constraint.
+    bool split = mixed && !single;
 
     out << "constraint_category_ = index_constraint::"<< underlying_constraint_name << ";\n";
     out << "for (unsigned i_ = 0; i_ < index_constraints_." << underlying_constraint_name
         << ".size(); i_++) {\n"
         << indent;
 
-    out << "::arb::fvm_index_type index_ = index_constraints_." << underlying_constraint_name << "[i_];\n";
+    if (split) {
+        out << "for (unsigned j_ = 0; j_ < float_width_; j_ += simd_width_) {\n" << indent;
+        out << "::arb::fvm_index_type index_ = index_constraints_." << underlying_constraint_name << "[i_]+j_;\n";
+    }
+    else {
+        out << "::arb::fvm_index_type index_ = index_constraints_." << underlying_constraint_name << "[i_];\n";
+    }
     if (requires_weight) {
-        out << "simd_value w_;\n"
+        out << (single? "simd_double w_;\n": "simd_value w_;\n")
             << "assign(w_, indirect((weight_+index_), simd_width_));\n";
     }
 
-    emit_simd_body_for_loop(out, body, indexed_vars, scalars, indices, constraint);
+    emit_simd_body_for_loop(out, body, indexed_vars, scalars, indices, constraint, hoisted, fast_maths, mixed, single);
 
+    if (split) {
+        out << popindent << "}\n";
+    }
     out << popindent << "}\n";
 }
 
-void emit_simd_api_body(std::ostream& out, APIMethod* method, const std::vector<VariableExpression*>& scalars) {
+// In mixed precision (mixed), the STATE variables are held in single
+// precision, and a kernel with single true computes in single precision.
+void emit_simd_api_body(std::ostream& out, APIMethod* method, const std::vector<VariableExpression*>& scalars, bool fast_maths, bool mixed, bool single) {
     auto body = method->body();
     auto indexed_vars = indexed_locals(method->scope());
     bool requires_weight = false;
@@ -977,7 +1352,29 @@ void emit_simd_api_body(std::ostream& out, APIMethod* method, const std::vector<
         }
     }
     if (!body->statements().empty()) {
+        if (single) {
+            out << simd_single_aliases;
+        }
         out << "assert(simd_width_ <= (unsigned)S::width(simd_cast<simd_value>(0)));\n";
+
+        // Values that are the same for every instance are computed once.
+        auto& hoisted = method->invariant_locals();
+        if (!hoisted.empty()) {
+            out << "simd_value ";
+            io::separator sep(", ");
+            for (auto& name: hoisted) {
+                out << sep << name;
+            }
+            out << ";\n";
+            for (auto& stmt: body->statements()) {
+                if (is_hoisted_assignment(stmt.get(), hoisted)) {
+                    simdprint printer(stmt.get(), scalars);
+                    printer.set_fast_maths(fast_maths);
+                    printer.set_mixed_precision(mixed);
+                    out << printer << ";\n";
+                }
+            }
+        }
         if (!indices.empty()) {
             out << "index_constraint constraint_category_;\n\n";
 
@@ -985,25 +1382,25 @@ void emit_simd_api_body(std::ostream& out, APIMethod* method, const std::vector<
             simd_expr_constraint constraint = simd_expr_constraint::contiguous;
             std::string underlying_constraint = "contiguous";
 
-            emit_simd_for_loop_per_constraint(out, body, indexed_vars, scalars, requires_weight, indices, constraint, underlying_constraint);
+            emit_simd_for_loop_per_constraint(out, body, indexed_vars, scalars, requires_weight, indices, constraint, underlying_constraint, hoisted, fast_maths, mixed, single);
 
             //Generate for loop for all independent simd_vectors
             constraint = simd_expr_constraint::other;
             underlying_constraint = "independent";
 
-            emit_simd_for_loop_per_constraint(out, body, indexed_vars, scalars, requires_weight, indices, constraint, underlying_constraint);
+            emit_simd_for_loop_per_constraint(out, body, indexed_vars, scalars, requires_weight, indices, constraint, underlying_constraint, hoisted, fast_maths, mixed, single);
 
             //Generate for loop for all simd_vectors that have no optimizing constraints
             constraint = simd_expr_constraint::other;
             underlying_constraint = "none";
 
-            emit_simd_for_loop_per_constraint(out, body, indexed_vars, scalars, requires_weight, indices, constraint, underlying_constraint);
+            emit_simd_for_loop_per_constraint(out, body, indexed_vars, scalars, requires_weight, indices, constraint, underlying_constraint, hoisted, fast_maths, mixed, single);
 
             //Generate for loop for all constant simd_vectors
             constraint = simd_expr_constraint::constant;
             underlying_constraint = "constant";
 
-            emit_simd_for_loop_per_constraint(out, body, indexed_vars, scalars, requires_weight, indices, constraint, underlying_constraint);
+            emit_simd_for_loop_per_constraint(out, body, indexed_vars, scalars, requires_weight, indices, constraint, underlying_constraint, hoisted, fast_maths, mixed, single);
 
         }
         else {
@@ -1012,10 +1409,15 @@ void emit_simd_api_body(std::ostream& out, APIMethod* method, const std::vector<
                 emit_simd_state_read(out, sym, simd_expr_constraint::other);
             }
 
+            simdprint printer(body, scalars);
+            printer.set_fast_maths(fast_maths);
+            printer.set_hoisted(hoisted);
+            printer.set_mixed_precision(mixed);
+
             out <<
                 "unsigned n_ = width_;\n\n"
                 "for (unsigned i_ = 0; i_ < n_; i_ += simd_width_) {\n" << indent <<
-                simdprint(body, scalars) << popindent <<
+                printer << popindent <<
                 "}\n";
         }
     }
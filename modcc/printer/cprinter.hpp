@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iosfwd>
+#include <set>
 #include <string>
 
 #include "module.hpp"
@@ -15,7 +16,10 @@ std::string emit_cpp_source(const Module& m, const printer_options& opt);
 
 class CPrinter: public Visitor {
 public:
-    CPrinter(std::ostream& out): out_(out) {}
+    // If single is true, locals and constants are single precision, and
+    // the values of double precision (non-STATE) variables and of function
+    // calls are converted to single precision.
+    CPrinter(std::ostream& out, bool single = false): out_(out), single_(single) {}
 
     void visit(Expression* e) override {
         throw compiler_exception("CPrinter cannot translate expression "+e->to_string());
@@ -26,15 +30,25 @@ public:
     void visit(IdentifierExpression*) override;
     void visit(VariableExpression*) override;
     void visit(LocalVariable*) override;
+    void visit(IndexedVariable*) override;
+    void visit(Symbol*) override;
+    void visit(AssignmentExpression*) override;
 
     // Delegate low-level emits to cexpr_emit:
-    void visit(NumberExpression* e) override { cexpr_emit(e, out_, this); }
-    void visit(UnaryExpression* e) override { cexpr_emit(e, out_, this); }
-    void visit(BinaryExpression* e) override { cexpr_emit(e, out_, this); }
-    void visit(IfExpression* e) override { cexpr_emit(e, out_, this); }
+    void visit(NumberExpression* e) override { cexpr_emit(e, out_, this, single_); }
+    void visit(UnaryExpression* e) override { cexpr_emit(e, out_, this, single_); }
+    void visit(BinaryExpression* e) override { cexpr_emit(e, out_, this, single_); }
+    void visit(IfExpression* e) override { cexpr_emit(e, out_, this, single_); }
+
+    // Locals that are declared and assigned before the loop over instances:
+    // they are neither declared nor assigned in the printed block.
+    void set_hoisted(const std::set<std::string>& names) { hoisted_ = names; }
 
 protected:
     std::ostream& out_;
+    bool single_;
+    bool lhs_ = false; // Printing the target of an assignment.
+    std::set<std::string> hoisted_;
 };
 
 
@@ -60,6 +74,21 @@ public:
     void save_scalar_names(const std::unordered_set<std::string>& scalars) {
         scalars_ = scalars;
     }
+    void set_fast_maths(bool fast_maths) {
+        fast_maths_ = fast_maths;
+    }
+
+    // In mixed precision, procedures and tabulated functions are overloaded
+    // on the precision of their arguments, which are cast to simd_value.
+    void set_mixed_precision(bool mixed) {
+        mixed_ = mixed;
+    }
+
+    // Locals that are declared and assigned before the SIMD loop: they are
+    // neither declared nor assigned in the printed block.
+    void set_hoisted(const std::set<std::string>& names) {
+        hoisted_ = names;
+    }
 
     void visit(BlockExpression*) override;
     void visit(CallExpression*) override;
@@ -68,14 +97,17 @@ public:
     void visit(LocalVariable*) override;
     void visit(AssignmentExpression*) override;
 
-    void visit(NumberExpression* e) override { simd_expr_emit(e, out_, is_indirect_, input_mask_, scalars_, this); } 
-    void visit(UnaryExpression* e)  override { simd_expr_emit(e, out_, is_indirect_, input_mask_, scalars_, this); }
-    void visit(BinaryExpression* e) override { simd_expr_emit(e, out_, is_indirect_, input_mask_, scalars_, this); }
-    void visit(IfExpression* e)     override { simd_expr_emit(e, out_, is_indirect_, input_mask_, scalars_, this); }
+    void visit(NumberExpression* e) override { simd_expr_emit(e, out_, is_indirect_, input_mask_, scalars_, this, fast_maths_, mixed_); } 
+    void visit(UnaryExpression* e)  override { simd_expr_emit(e, out_, is_indirect_, input_mask_, scalars_, this, fast_maths_, mixed_); }
+    void visit(BinaryExpression* e) override { simd_expr_emit(e, out_, is_indirect_, input_mask_, scalars_, this, fast_maths_, mixed_); }
+    void visit(IfExpression* e)     override { simd_expr_emit(e, out_, is_indirect_, input_mask_, scalars_, this, fast_maths_, mixed_); }
 
 private:
     std::ostream& out_;
     std::string input_mask_;
     bool is_indirect_ = false;
+    bool fast_maths_ = false;
+    bool mixed_ = false;
     std::unordered_set<std::string> scalars_;
+    std::set<std::string> hoisted_;
 };
@@ -263,6 +263,21 @@ std::string emit_gpu_cu_source(const Module& module_, const printer_options& opt
     out << "using ::arb::gpu::min;\n";
     out << "using ::arb::gpu::max;\n\n";
 
+    // Tabulated functions as __device__ functions, evaluated exactly.
+    for (auto f: tabulated_functions(module_)) {
+        out << "__device__\n"
+            << "::arb::fvm_value_type " << f->name()
+            << "(" << ppack_name << " params_, int tid_, ::arb::fvm_value_type "
+            << f->args().front()->is_argument()->name() << ") {\n" << indent
+            << "::arb::fvm_value_type " << f->name() << ";\n";
+        table_depends_on_temperature(f) && out
+            << "::arb::fvm_value_type celsius = params_.temperature_degC_[params_.node_index_[tid_]];\n";
+        out
+            << cuprint(f->body())
+            << "return " << f->name() << ";\n"
+            << popindent << "}\n\n";
+    }
+
     // Procedures as __device__ functions.
     auto emit_procedure_kernel = [&] (ProcedureExpression* e) {
         out << "__device__\n"
@@ -13,8 +13,16 @@ struct printer_options {
     // Explicit vectorization (C printer only)? Default is none.
     simd_spec simd;
 
+    // Accuracy of transcendental functions in explicitly vectorized code.
+    simd_accuracy accuracy = simd_accuracy::full;
+
     // Instrument kernels? True => use ::arb::profile regions.
     // Currently only supported for C printer.
 
     bool profile = false;
+
+    // Mixed precision (C printer, without SIMD, only): STATE variables are
+    // stored in single precision, and the INITIAL and state update kernels
+    // evaluated in single precision. Currents are computed in double precision.
+    bool mixed_precision = false;
 };
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <regex>
 #include <string>
 #include <unordered_set>
@@ -54,6 +55,24 @@ std::vector<ProcedureExpression*> normal_procedures(const Module& m) {
     return procs;
 }
 
+std::vector<FunctionExpression*> tabulated_functions(const Module& m) {
+    std::vector<FunctionExpression*> funcs;
+
+    for (auto& sym: m.symbols()) {
+        auto f = sym.second->is_function();
+        if (f && f->table()) {
+            funcs.push_back(f);
+        }
+    }
+
+    return funcs;
+}
+
+bool table_depends_on_temperature(FunctionExpression* f) {
+    auto& depend = f->table()->depend;
+    return std::find(depend.begin(), depend.end(), "celsius")!=depend.end();
+}
+
 public_variable_ids_t public_variable_ids(const Module& m) {
     public_variable_ids_t ids;
     ids.state_ids = m.state_block().state_variables;
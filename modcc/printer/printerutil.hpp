@@ -83,6 +83,16 @@ std::vector<LocalVariable*> pure_locals(scope_ptr scope);
 
 std::vector<ProcedureExpression*> normal_procedures(const Module&);
 
+// Functions in module with a table (see functiontables.hpp); calls to these
+// are printed as calls to a member function of the mechanism.
+
+std::vector<FunctionExpression*> tabulated_functions(const Module&);
+
+// True if the table of the tabulated function f depends on the temperature,
+// which is then passed to the exact evaluation of f as the argument celsius.
+
+bool table_depends_on_temperature(FunctionExpression* f);
+
 struct public_variable_ids_t {
     std::vector<Id> state_ids;
     std::vector<Id> global_parameter_ids;
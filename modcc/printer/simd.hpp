@@ -48,3 +48,8 @@ struct simd_spec {
 
     }
 };
+
+// Accuracy of the exponential, logarithm and power functions in generated
+// SIMD code: full (a few ulp), or the fast approximations of arb::simd
+// (relative error below 1e-10).
+enum class simd_accuracy { full, fast };
@@ -39,10 +39,20 @@ public:
         api_context_ = flag;
     }
 
+    // A FUNCTION may read the temperature, celsius.
+    bool in_function_context() const {
+        return function_context_;
+    }
+
+    void in_function_context(bool flag) {
+        function_context_ = flag;
+    }
+
 private:
     symbol_map* global_symbols_=nullptr;
     symbol_map  local_symbols_;
     bool api_context_ = false;
+    bool function_context_ = false;
 };
 
 template<typename Symbol>
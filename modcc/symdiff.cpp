@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <map>
 #include <set>
@@ -309,6 +311,9 @@ public:
             stmt->accept(this);
             auto simpl = result();
 
+            // an if without an else branch may simplify to nothing
+            if (!simpl) continue;
+
             // flatten any naked blocks generated by if/else simplification
             if (auto inner = simpl->is_block()) {
                 for (auto& stmt: inner->statements()) {
@@ -371,6 +376,15 @@ public:
             case tok::log:
                 as_number(loc, std::log(val));
                 return;
+            case tok::abs:
+                as_number(loc, std::fabs(val));
+                return;
+            case tok::exprelr:
+                as_number(loc, 1+val==1? 1: val/std::expm1(val));
+                return;
+            case tok::safeinv:
+                as_number(loc, 1+val==1? 1/DBL_EPSILON: 1/val);
+                return;
             default: ; // treat opaquely as below
             }
         }
@@ -381,7 +395,25 @@ public:
     }
 
     void visit(BinaryExpression* e) override {
-        result_ = e->clone();
+        if (e->op()!=tok::min && e->op()!=tok::max) {
+            result_ = e->clone();
+            return;
+        }
+
+        auto loc = e->location();
+        e->lhs()->accept(this);
+        expression_ptr lhs = result();
+        e->rhs()->accept(this);
+        expression_ptr rhs = result();
+
+        if (is_number(lhs) && is_number(rhs)) {
+            auto lval = expr_value(lhs);
+            auto rval = expr_value(rhs);
+            as_number(loc, e->op()==tok::min? std::min(lval, rval): std::max(lval, rval));
+        }
+        else {
+            result_ = binary_expression(loc, e->op(), std::move(lhs), std::move(rhs));
+        }
     }
 
     void visit(AssignmentExpression* e) override {
@@ -428,7 +460,7 @@ public:
             as_number(loc, 0);
         }
         else if (expr_value(rhs)==1) {
-            result_ = e->lhs()->clone();
+            result_ = std::move(lhs);
         }
         else if (is_number(rhs)) {
             result_ = make_expression<MulBinaryExpression>(loc, std::move(lhs), make_expression<NumberExpression>(loc, 1.0/expr_value(rhs)));
@@ -532,18 +564,18 @@ public:
                 return;
             case tok::gte:
                 as_number(loc, lval>=rval);
+                return;
             case tok::land:
                 as_number(loc, lval&&rval);
+                return;
             case tok::lor:
                 as_number(loc, lval||rval);
-                    return;
+                return;
             default: ;
                 // unrecognized, fall through to non-numeric case below
             }
         }
-        if (!is_number(lhs) || !is_number(rhs)) {
-            result_ = make_expression<ConditionalExpression>(loc, e->op(), std::move(lhs), std::move(rhs));
-        }
+        result_ = make_expression<ConditionalExpression>(loc, e->op(), std::move(lhs), std::move(rhs));
     }
 };
 
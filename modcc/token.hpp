@@ -65,6 +65,7 @@ enum class tok {
     threadsafe, global,
     point_process,
     from, to,
+    table, depend, with,
 
     // prefix binary operators
     min, max,
@@ -113,6 +113,8 @@ void register_domain_decomposition(pybind11::module& m) {
                 throw;
             }
         },
+        // Release the python gil, so that callbacks into the python recipe don't deadlock.
+        pybind11::call_guard<pybind11::gil_scoped_release>(),
         "Construct a domain_decomposition that distributes the cells in the model described by recipe\n"
         "over the distributed and local hardware resources described by context.\n"
         "Optionally, provide a dictionary of partition hints for certain cell kinds, by default empty.",
@@ -178,6 +178,22 @@ class Domain_Decompositions(unittest.TestCase):
                 n += 1
         self.assertEqual(n_cells, n)
 
+    # 4 threads, no gpus: the recipe is queried on the threads of the context
+    def test_domain_decomposition_heterogenous_threads(self):
+        n_cells = 100
+        recipe = hetero_recipe(n_cells)
+        context = arb.context(threads=4)
+        decomp = arb.partition_load_balance(recipe, context)
+
+        self.assertEqual(decomp.num_local_cells, n_cells)
+        self.assertEqual(decomp.num_global_cells, n_cells)
+        self.assertEqual(len(decomp.groups), n_cells)
+
+        for i in range(n_cells):
+            grp = decomp.groups[i]
+            self.assertEqual(len(grp.gids), 1)
+            self.assertEqual(recipe.cell_kind(grp.gids[0]), grp.kind)
+
     def test_domain_decomposition_hints(self):
         n_cells = 20
         recipe = hetero_recipe(n_cells)
@@ -0,0 +1,185 @@
+// Compare methods for staging the pending events of each cell for the next
+// epoch, as performed by simulation_state::setup_events.
+//
+// Pending events arrive per cell in the order of the spikes that generated
+// them: grouped by source, and in time order for each source. They must be
+// merged with the events carried over from the previous epoch into a single
+// time-sorted lane.
+//
+// sort_merge: sort all pending events, then merge with carried-over events.
+// tree_merge: merge the time-ordered runs of pending events directly with
+//             the carried-over events in a tournament tree, reusing the
+//             merge state between cells and epochs.
+// run_merge:  sort the pending events by merging their runs pairwise, as
+//             setup_events does for long runs, then merge with carried-over
+//             events.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <arbor/event_generator.hpp>
+#include <arbor/spike_event.hpp>
+
+#include "merge_events.hpp"
+#include "util/rangeutil.hpp"
+
+namespace arb {
+void merge_cell_events(
+    time_type t_from,
+    time_type t_to,
+    event_span old_events,
+    event_span pending,
+    std::vector<event_generator>& generators,
+    pse_vector& new_events);
+} // namespace arb
+
+using namespace arb;
+
+// Append to runs the maximal non-decreasing runs of events in the sequence.
+void append_sorted_runs(event_span events, std::vector<event_span>& runs) {
+    auto b = events.begin();
+    auto e = events.end();
+    while (b!=e) {
+        auto i = std::is_sorted_until(b, e);
+        runs.push_back({b, i});
+        b = i;
+    }
+}
+
+struct epoch_inputs {
+    std::vector<pse_vector> pending;
+    std::vector<pse_vector> old_events;
+};
+
+// Each cell has fan_in sources, each of which spikes spikes_per_source
+// times in the epoch [0, 1), and old events in [0, 2).
+epoch_inputs generate_inputs(std::size_t ncells, std::size_t fan_in, std::size_t spikes_per_source) {
+    std::mt19937 gen;
+    std::uniform_real_distribution<time_type> time_dist(0, 1);
+    std::uniform_real_distribution<time_type> delay_dist(1, 2);
+
+    epoch_inputs in;
+    in.pending.resize(ncells);
+    in.old_events.resize(ncells);
+    for (std::size_t c = 0; c<ncells; ++c) {
+        for (std::size_t s = 0; s<fan_in; ++s) {
+            std::vector<time_type> times(spikes_per_source);
+            for (auto& t: times) t = time_dist(gen);
+            std::sort(times.begin(), times.end());
+
+            time_type delay = delay_dist(gen);
+            for (auto t: times) {
+                in.pending[c].push_back({{cell_gid_type(c), 0}, t+delay, 1.f});
+            }
+        }
+        for (std::size_t i = 0; i<fan_in; ++i) {
+            in.old_events[c].push_back({{cell_gid_type(c), 0}, 2*time_dist(gen), 1.f});
+        }
+        util::sort(in.old_events[c]);
+    }
+    return in;
+}
+
+void sort_merge(benchmark::State& state) {
+    const std::size_t ncells = state.range(0);
+    const std::size_t fan_in = state.range(1);
+    const std::size_t spikes_per_source = state.range(2);
+
+    auto in = generate_inputs(ncells, fan_in, spikes_per_source);
+    std::vector<pse_vector> pending(ncells);
+    std::vector<pse_vector> lanes(ncells);
+    std::vector<event_generator> no_generators;
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        pending = in.pending;
+        state.ResumeTiming();
+
+        for (std::size_t c = 0; c<ncells; ++c) {
+            util::sort(pending[c]);
+            merge_cell_events(1, 2, util::range_pointer_view(in.old_events[c]),
+                util::range_pointer_view(pending[c]), no_generators, lanes[c]);
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+void tree_merge(benchmark::State& state) {
+    const std::size_t ncells = state.range(0);
+    const std::size_t fan_in = state.range(1);
+    const std::size_t spikes_per_source = state.range(2);
+
+    auto in = generate_inputs(ncells, fan_in, spikes_per_source);
+    std::vector<pse_vector> pending(ncells);
+    std::vector<pse_vector> lanes(ncells);
+    event_merge_scratch scratch;
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        pending = in.pending;
+        state.ResumeTiming();
+
+        for (std::size_t c = 0; c<ncells; ++c) {
+            auto& spans = scratch.spans;
+            spans.clear();
+            append_sorted_runs(util::range_pointer_view(pending[c]), spans);
+            spans.push_back(util::range_pointer_view(in.old_events[c]));
+
+            lanes[c].clear();
+            tree_merge_events(spans, lanes[c], scratch.tree);
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+void run_merge(benchmark::State& state) {
+    const std::size_t ncells = state.range(0);
+    const std::size_t fan_in = state.range(1);
+    const std::size_t spikes_per_source = state.range(2);
+
+    auto in = generate_inputs(ncells, fan_in, spikes_per_source);
+    std::vector<pse_vector> pending(ncells);
+    std::vector<pse_vector> lanes(ncells);
+    std::vector<event_generator> no_generators;
+    event_merge_scratch scratch;
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        pending = in.pending;
+        state.ResumeTiming();
+
+        for (std::size_t c = 0; c<ncells; ++c) {
+            auto& p = pending[c];
+            auto& bounds = scratch.run_bounds;
+            bounds.assign(1, 0);
+            for (std::size_t i = 1; i<p.size(); ++i) {
+                if (p[i]<p[i-1]) bounds.push_back(i);
+            }
+            bounds.push_back(p.size());
+
+            merge_sorted_runs(p, bounds, scratch.buffer);
+            merge_cell_events(1, 2, util::range_pointer_view(in.old_events[c]),
+                util::range_pointer_view(p), no_generators, lanes[c]);
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+void run_custom_arguments(benchmark::internal::Benchmark* b) {
+    for (auto ncells: {100, 1000}) {
+        for (auto fan_in: {10, 100, 1000}) {
+            for (auto spikes_per_source: {1, 4, 16}) {
+                b->Args({ncells, fan_in, spikes_per_source});
+            }
+        }
+    }
+}
+
+BENCHMARK(sort_merge)->Apply(run_custom_arguments);
+BENCHMARK(tree_merge)->Apply(run_custom_arguments);
+BENCHMARK(run_merge)->Apply(run_custom_arguments);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,145 @@
+// Cost of the discretization of cable cells at model setup, and the saving
+// from the discretization cache for groups of identical cells.
+//
+// The cache identifies cells by a fingerprint of their contents, which costs
+// a pass over the morphology and decorations of each cell even when the
+// lookup hits.
+
+#include <any>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <arbor/cable_cell.hpp>
+#include <arbor/morph/segment_tree.hpp>
+#include <arbor/recipe.hpp>
+
+#include "backends/multicore/fvm.hpp"
+#include "execution_context.hpp"
+#include "fvm_layout.hpp"
+#include "fvm_lowered_cell_impl.hpp"
+
+using namespace arb;
+
+using backend = arb::multicore::backend;
+using fvm_cell = arb::fvm_lowered_cell_impl<backend>;
+
+// A binary tree of dendrites of the given depth from a soma, each of three
+// segments, with hh on the soma, pas everywhere, and 100 synapses.
+cable_cell make_cell(unsigned depth) {
+    segment_tree tree;
+    double soma_radius = 12.6157/2.0;
+    auto soma = tree.append(mnpos, {0,0,-soma_radius,soma_radius}, {0,0,soma_radius,soma_radius}, 1);
+
+    std::vector<std::pair<msize_t, mpoint>> tips = {{soma, {0,0,soma_radius,1}}};
+    for (unsigned level = 0; level<depth; ++level) {
+        std::vector<std::pair<msize_t, mpoint>> next;
+        for (auto [parent, p]: tips) {
+            for (double dx: {-1., 1.}) {
+                auto seg = parent;
+                mpoint q = p;
+                for (int s = 0; s<3; ++s) {
+                    mpoint r{q.x+dx*10, q.y+(s-1)*5, q.z+20, q.radius*0.95};
+                    seg = tree.append(seg, q, r, 3);
+                    q = r;
+                }
+                next.push_back({seg, q});
+            }
+        }
+        tips = std::move(next);
+    }
+
+    decor decor;
+    decor.paint(reg::tagged(1), "hh");
+    decor.paint(reg::all(), "pas");
+    decor.place(ls::uniform(reg::tagged(3), 0, 99, 0), "expsyn");
+    decor.set_default(cv_policy_max_extent(10));
+
+    return cable_cell(morphology(tree), {}, decor);
+}
+
+cable_cell_global_properties make_gprop() {
+    cable_cell_global_properties gprop;
+    gprop.default_parameters = neuron_parameter_defaults;
+    return gprop;
+}
+
+class recipe_identical: public recipe {
+    cell_size_type n_;
+    cable_cell cell_;
+    cable_cell_global_properties gprop_;
+
+public:
+    recipe_identical(cell_size_type n, unsigned depth):
+        n_(n), cell_(make_cell(depth)), gprop_(make_gprop())
+    {}
+
+    cell_size_type num_cells() const override { return n_; }
+    cell_kind get_cell_kind(cell_gid_type) const override { return cell_kind::cable; }
+    util::unique_any get_cell_description(cell_gid_type) const override { return cell_; }
+    std::any get_global_properties(cell_kind) const override { return gprop_; }
+};
+
+// Argument: depth of the dendritic tree.
+void discretize_cell(benchmark::State& state) {
+    auto cell = make_cell(state.range(0));
+    auto gprop = make_gprop();
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(fvm_discretize_cell(cell, gprop));
+    }
+}
+
+// Argument: depth of the dendritic tree.
+void cache_hit(benchmark::State& state) {
+    auto cell = make_cell(state.range(0));
+    auto gprop = make_gprop();
+    fvm_discretization_cache cache;
+    cache.get(cell, gprop);
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(cache.get(cell, gprop));
+    }
+}
+
+// Arguments: number of cells, depth of the dendritic tree, and whether the
+// cells are initialized with a discretization cache.
+void cell_group_setup(benchmark::State& state) {
+    const cell_size_type ncell = state.range(0);
+    recipe_identical rec(ncell, state.range(1));
+    const bool use_cache = state.range(2);
+
+    std::vector<cell_gid_type> gids(ncell);
+    std::iota(gids.begin(), gids.end(), 0);
+
+    while (state.KeepRunning()) {
+        std::vector<target_handle> target_handles;
+        std::vector<fvm_index_type> cell_to_intdom;
+        probe_association_map probe_handles;
+
+        fvm_cell cell(execution_context(), use_cache? std::make_shared<fvm_discretization_cache>(): nullptr);
+        cell.initialize(gids, rec, cell_to_intdom, target_handles, probe_handles);
+    }
+}
+
+void depth_range(benchmark::internal::Benchmark* b) {
+    for (int depth: {2, 4, 6}) {
+        b->Arg(depth);
+    }
+}
+
+void setup_range(benchmark::internal::Benchmark* b) {
+    for (int depth: {2, 6}) {
+        for (int use_cache: {0, 1}) {
+            b->Args({100, depth, use_cache});
+        }
+    }
+}
+
+BENCHMARK(discretize_cell)->Apply(depth_range)->Unit(benchmark::kMicrosecond);
+BENCHMARK(cache_hit)->Apply(depth_range)->Unit(benchmark::kMicrosecond);
+BENCHMARK(cell_group_setup)->Apply(setup_range)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
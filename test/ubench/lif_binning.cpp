@@ -0,0 +1,99 @@
+// Throughput of the LIF cell group advance under dense input, with and
+// without event binning.
+//
+// Binning collapses the events that fall in one bin into a single update
+// of the cell.
+
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <arbor/common_types.hpp>
+#include <arbor/lif_cell.hpp>
+#include <arbor/recipe.hpp>
+#include <arbor/spike_event.hpp>
+
+#include "epoch.hpp"
+#include "lif_cell_group.hpp"
+#include "util/span.hpp"
+
+using namespace arb;
+
+struct lif_recipe: recipe {
+    cell_size_type n;
+    explicit lif_recipe(cell_size_type n): n(n) {}
+
+    cell_size_type num_cells() const override { return n; }
+    cell_kind get_cell_kind(cell_gid_type) const override { return cell_kind::lif; }
+    util::unique_any get_cell_description(cell_gid_type) const override {
+        lif_cell c;
+        c.V_th = 1e6; // Never spike: every event results in an update.
+        return c;
+    }
+};
+
+// Poisson input of `rate` events per ms on each cell over [0, t_end).
+std::vector<pse_vector> make_events(cell_size_type ncells, double rate, time_type t_end) {
+    std::mt19937_64 gen;
+    std::exponential_distribution<time_type> dt(rate);
+
+    std::vector<pse_vector> lanes(ncells);
+    for (auto i: util::make_span(ncells)) {
+        for (time_type t = dt(gen); t<t_end; t += dt(gen)) {
+            lanes[i].push_back({{i, 0}, t, 1.f});
+        }
+    }
+    return lanes;
+}
+
+void run_lif_advance(benchmark::State& state, binning_kind kind) {
+    const cell_size_type ncells = 1000;
+    const double rate = state.range(0); // [events/ms]
+    const time_type t_end = 10;
+    const time_type bin_interval = 0.1;
+
+    lif_recipe rec(ncells);
+    std::vector<cell_gid_type> gids(ncells);
+    std::iota(gids.begin(), gids.end(), 0);
+    lif_cell_group group(gids, rec);
+    group.set_binning_policy(kind, bin_interval);
+
+    auto lanes = make_events(ncells, rate, t_end);
+    auto events = util::subrange_view(lanes, 0, ncells);
+
+    std::size_t n_events = 0;
+    for (auto& lane: lanes) n_events += lane.size();
+
+    while (state.KeepRunning()) {
+        group.reset();
+        group.advance(epoch(0, t_end), 0.025, events);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations()*n_events);
+}
+
+void lif_none(benchmark::State& state) {
+    run_lif_advance(state, binning_kind::none);
+}
+
+void lif_regular(benchmark::State& state) {
+    run_lif_advance(state, binning_kind::regular);
+}
+
+void lif_following(benchmark::State& state) {
+    run_lif_advance(state, binning_kind::following);
+}
+
+void rate_range(benchmark::internal::Benchmark* b) {
+    for (int rate: {1, 10, 100, 1000}) {
+        b->Arg(rate);
+    }
+}
+
+BENCHMARK(lif_none)->Apply(rate_range);
+BENCHMARK(lif_regular)->Apply(rate_range);
+BENCHMARK(lif_following)->Apply(rate_range);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,137 @@
+// Compare the solution of the matrices of many cells in SIMD batches, as
+// performed by the multicore matrix_state, against solving each cell in turn.
+//
+// solve_batched: matrix_state::solve, which sweeps the interleaved matrices of
+//                batches of simd_width cells in lockstep.
+// solve_scalar:  the Hines algorithm applied to each cell in turn, over the
+//                matrices stored one cell after another.
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <arbor/fvm_types.hpp>
+
+#include "backends/multicore/matrix_state.hpp"
+#include "util/span.hpp"
+
+using namespace arb;
+
+using state_type = multicore::matrix_state<fvm_value_type, fvm_index_type>;
+using index_type = fvm_index_type;
+using value_type = fvm_value_type;
+
+// ncells cells with the structure of a binary tree: the parent of CV i of a
+// cell is CV (i-1)/2. Cells have ncv CVs each, or if vary is set, from ncv to
+// ncv+ncv/8 CVs. The matrices are assembled once with arbitrary positive
+// values.
+state_type make_state(index_type ncells, index_type ncv, bool vary) {
+    std::vector<index_type> p, cell_cv_divs = {0}, cell_to_intdom;
+    for (index_type c = 0; c<ncells; ++c) {
+        const index_type first = p.size();
+        const index_type n = vary? ncv+c%(ncv/8+1): ncv;
+        p.push_back(first);
+        for (index_type i = 1; i<n; ++i) {
+            p.push_back(first+(i-1)/2);
+        }
+        cell_cv_divs.push_back(p.size());
+        cell_to_intdom.push_back(c);
+    }
+
+    const std::size_t n = p.size();
+    std::vector<value_type> cap(n), cond(n), area(n, 1.);
+    for (std::size_t i = 0; i<n; ++i) {
+        cap[i] = 1+i%3;
+        cond[i] = 1+i%5;
+    }
+
+    state_type state(p, cell_cv_divs, cap, cond, area, cell_to_intdom);
+
+    state_type::array dt(ncells, 0.025), v(n), current(n), conductivity(n);
+    for (std::size_t i = 0; i<n; ++i) {
+        v[i] = -65+i%11;
+        current[i] = i%13-6;
+        conductivity[i] = 1+i%7;
+    }
+    state.assemble(dt, v, current, conductivity);
+    return state;
+}
+
+// The matrices of a state, one cell after another.
+struct flat_matrix {
+    std::vector<index_type> p, cell_cv_divs;
+    std::vector<value_type> d, u, rhs;
+
+    flat_matrix(const state_type& s):
+        p(s.parent_index.begin(), s.parent_index.end()),
+        cell_cv_divs(s.cell_cv_divs.begin(), s.cell_cv_divs.end())
+    {
+        for (auto j: s.cv_slot) {
+            d.push_back(s.d[j]);
+            u.push_back(s.u[j]);
+            rhs.push_back(s.rhs[j]);
+        }
+    }
+};
+
+void solve_scalar_cells(flat_matrix& s) {
+    const index_type ncells = s.cell_cv_divs.size()-1;
+    for (index_type cell = 0; cell<ncells; ++cell) {
+        auto first = s.cell_cv_divs[cell];
+        auto last = s.cell_cv_divs[cell+1];
+
+        for (auto i = last-1; i>first; --i) {
+            auto factor = s.u[i]/s.d[i];
+            s.d[s.p[i]] -= factor*s.u[i];
+            s.rhs[s.p[i]] -= factor*s.rhs[i];
+        }
+        s.rhs[first] /= s.d[first];
+
+        for (auto i = first+1; i<last; ++i) {
+            s.rhs[i] -= s.u[i]*s.rhs[s.p[i]];
+            s.rhs[i] /= s.d[i];
+        }
+    }
+}
+
+// Restore the diagonal and rhs of m before each solve, outside the timed region.
+template <typename M, typename F>
+void run(benchmark::State& state, M& m, F&& solve) {
+    const auto d = m.d;
+    const auto rhs = m.rhs;
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        m.d = d;
+        m.rhs = rhs;
+        state.ResumeTiming();
+
+        solve(m);
+        benchmark::ClobberMemory();
+    }
+}
+
+void solve_batched(benchmark::State& state) {
+    auto s = make_state(state.range(0), state.range(1), state.range(2));
+    run(state, s, [](state_type& s) { s.solve(); });
+}
+
+void solve_scalar(benchmark::State& state) {
+    flat_matrix m(make_state(state.range(0), state.range(1), state.range(2)));
+    run(state, m, solve_scalar_cells);
+}
+
+void run_custom_arguments(benchmark::internal::Benchmark* b) {
+    for (auto ncells: {100, 1000, 10000}) {
+        for (auto ncv: {10, 40, 200}) {
+            for (auto vary: {0, 1}) {
+                b->Args({ncells, ncv, vary});
+            }
+        }
+    }
+}
+
+BENCHMARK(solve_batched)->Apply(run_custom_arguments)->Unit(benchmark::kMicrosecond);
+BENCHMARK(solve_scalar)->Apply(run_custom_arguments)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
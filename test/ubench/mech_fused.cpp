@@ -0,0 +1,112 @@
+// Compare the fused, tiled current and state updates of consecutive density
+// mechanisms (mechanism_pipeline, with mechanism_tile_cvs set) with the update
+// of each mechanism over all of its CVs in turn, with one or more threads.
+
+#include <any>
+#include <string>
+#include <vector>
+
+#include <arbor/cable_cell.hpp>
+#include <arbor/morph/segment_tree.hpp>
+
+#include "backends/multicore/fvm.hpp"
+#include "benchmark/benchmark.h"
+#include "execution_context.hpp"
+#include "fvm_lowered_cell_impl.hpp"
+
+using namespace arb;
+
+using backend = arb::multicore::backend;
+using fvm_cell = arb::fvm_lowered_cell_impl<backend>;
+
+// One unbranched dendrite of num_comp CVs, with pas, hh, nax and kdrmt
+// painted over all of it.
+class recipe_4_mechs: public recipe {
+    unsigned num_comp_;
+    arb::cable_cell_global_properties gprop_;
+
+public:
+    recipe_4_mechs(unsigned num_comp, unsigned tile_cvs, unsigned threads):
+        num_comp_(num_comp)
+    {
+        gprop_.default_parameters = arb::neuron_parameter_defaults;
+        gprop_.mechanism_tile_cvs = tile_cvs;
+        gprop_.max_group_threads = threads;
+    }
+
+    cell_size_type num_cells() const override {
+        return 1;
+    }
+
+    virtual util::unique_any get_cell_description(cell_gid_type gid) const override {
+        arb::segment_tree tree;
+
+        double soma_radius = 12.6157/2.0;
+        double dend_radius = 1.0/2;
+        double dend_length = 200;
+
+        // Add soma.
+        auto s0 = tree.append(arb::mnpos, {0,0,-soma_radius,soma_radius}, {0,0,soma_radius,soma_radius}, 1);
+
+        // Add dendrite
+        auto s1 = tree.append(s0, {0          ,0          ,soma_radius,             dend_radius}, 3);
+        tree.append(s1,           {0          ,0          ,soma_radius+dend_length, dend_radius}, 3);
+
+        arb::decor decor;
+        for (auto mech: {"pas", "hh", "nax", "kdrmt"}) {
+            decor.paint(arb::reg::all(), mech);
+        }
+        decor.set_default(arb::cv_policy_max_extent(dend_length/num_comp_));
+
+        return arb::cable_cell(arb::morphology(tree), {}, decor);
+    }
+
+    virtual cell_kind get_cell_kind(cell_gid_type) const override {
+        return cell_kind::cable;
+    }
+
+    std::any get_global_properties(arb::cell_kind) const override {
+        return gprop_;
+    }
+};
+
+// Arguments: number of CVs, CVs per tile (0 => not fused), threads.
+void mech_step(benchmark::State& state) {
+    const unsigned ncomp = state.range(0);
+    const unsigned tile_cvs = state.range(1);
+    const unsigned threads = state.range(2);
+    recipe_4_mechs rec(ncomp, tile_cvs, threads);
+
+    std::vector<cell_gid_type> gids = {0};
+    std::vector<target_handle> target_handles;
+    std::vector<fvm_index_type> cell_to_intdom;
+    probe_association_map probe_handles;
+
+    fvm_cell cell(execution_context(proc_allocation(threads, -1)));
+    cell.initialize(gids, rec, cell_to_intdom, target_handles, probe_handles);
+
+    auto pipeline = cell.pipeline();
+    if (tile_cvs && pipeline.n_fused()!=4) {
+        state.SkipWithError("mechanisms not fused");
+        return;
+    }
+
+    while (state.KeepRunning()) {
+        pipeline.update_current();
+        pipeline.update_state();
+    }
+}
+
+void run_custom_arguments(benchmark::internal::Benchmark* b) {
+    for (auto ncomps: {1000, 10000, 100000}) {
+        for (auto tile_cvs: {0, 64, 512}) {
+            for (auto threads: {1, 4}) {
+                b->Args({ncomps, tile_cvs, threads});
+            }
+        }
+    }
+}
+
+BENCHMARK(mech_step)->Apply(run_custom_arguments);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,160 @@
+// Compare the performance of mechanisms generated by modcc with
+// --mixed-precision, whose INITIAL and state update kernels compute in
+// single precision, with their double precision implementations.
+//
+// The mixed precision versions of hh and nax are registered with the
+// suffix _mixed; with ARB_VECTORIZE both are generated with --simd.
+
+#include <any>
+#include <string>
+#include <vector>
+
+#include <arbor/cable_cell.hpp>
+#include <arbor/mechcat.hpp>
+#include <arbor/morph/segment_tree.hpp>
+
+#include "backends/multicore/fvm.hpp"
+#include "benchmark/benchmark.h"
+#include "execution_context.hpp"
+#include "fvm_lowered_cell_impl.hpp"
+
+#include "mechanisms/hh.hpp"
+#include "mechanisms/nax.hpp"
+
+using namespace arb;
+
+using backend = arb::multicore::backend;
+using fvm_cell = arb::fvm_lowered_cell_impl<backend>;
+
+#define ADD_MECH(c, x)\
+c.add(#x, ubench::mechanism_##x##_info());\
+c.register_implementation(#x, ubench::make_mechanism_##x<backend>());
+
+const mechanism_catalogue& mixed_catalogue() {
+    static mechanism_catalogue cat = [] {
+        mechanism_catalogue cat(global_default_catalogue());
+        ADD_MECH(cat, hh_mixed)
+        ADD_MECH(cat, nax_mixed)
+        return cat;
+    }();
+    return cat;
+}
+
+mechanism_ptr& find_mechanism(const std::string& name, fvm_cell& cell) {
+    auto &mechs = cell.mechanisms();
+    auto it = std::find_if(mechs.begin(),
+                           mechs.end(),
+                           [&](mechanism_ptr& m){return m->internal_name()==name;});
+    if (it==mechs.end()) {
+        std::cerr << "couldn't find mechanism with name " << name << "\n";
+        exit(1);
+    }
+    return *it;
+}
+
+// One unbranched dendrite of num_comp CVs, with the mechanism painted over all.
+class recipe_1_branch: public recipe {
+    unsigned num_comp_;
+    std::string mech_;
+    arb::cable_cell_global_properties gprop_;
+
+public:
+    recipe_1_branch(unsigned num_comp, std::string mech):
+        num_comp_(num_comp), mech_(std::move(mech))
+    {
+        gprop_.default_parameters = arb::neuron_parameter_defaults;
+        gprop_.catalogue = &mixed_catalogue();
+    }
+
+    cell_size_type num_cells() const override {
+        return 1;
+    }
+
+    virtual util::unique_any get_cell_description(cell_gid_type gid) const override {
+        arb::segment_tree tree;
+
+        double soma_radius = 12.6157/2.0;
+        double dend_radius = 1.0/2;
+        double dend_length = 200;
+
+        // Add soma.
+        auto s0 = tree.append(arb::mnpos, {0,0,-soma_radius,soma_radius}, {0,0,soma_radius,soma_radius}, 1);
+
+        // Add dendrite
+        auto s1 = tree.append(s0, {0          ,0          ,soma_radius,             dend_radius}, 3);
+        tree.append(s1,           {0          ,0          ,soma_radius+dend_length, dend_radius}, 3);
+
+        arb::decor decor;
+        decor.paint(arb::reg::all(), mech_);
+        decor.set_default(arb::cv_policy_max_extent(dend_length/num_comp_));
+
+        return arb::cable_cell(arb::morphology(tree), {}, decor);
+    }
+
+    virtual cell_kind get_cell_kind(cell_gid_type) const override {
+        return cell_kind::cable;
+    }
+
+    std::any get_global_properties(arb::cell_kind) const override {
+        return gprop_;
+    }
+};
+
+mechanism_ptr& make_mechanism(benchmark::State& state, const std::string& mech, std::unique_ptr<fvm_cell>& cell) {
+    const unsigned ncomp = state.range(0);
+    recipe_1_branch rec(ncomp, mech);
+
+    std::vector<cell_gid_type> gids = {0};
+    std::vector<target_handle> target_handles;
+    std::vector<fvm_index_type> cell_to_intdom;
+    probe_association_map probe_handles;
+
+    cell = std::make_unique<fvm_cell>(execution_context());
+    cell->initialize(gids, rec, cell_to_intdom, target_handles, probe_handles);
+
+    return find_mechanism(mech, *cell);
+}
+
+void mech_state(benchmark::State& state, std::string mech) {
+    std::unique_ptr<fvm_cell> cell;
+    auto& m = make_mechanism(state, mech, cell);
+
+    while (state.KeepRunning()) {
+        m->update_state();
+    }
+}
+
+void mech_init(benchmark::State& state, std::string mech) {
+    std::unique_ptr<fvm_cell> cell;
+    auto& m = make_mechanism(state, mech, cell);
+
+    while (state.KeepRunning()) {
+        m->initialize();
+    }
+}
+
+void mech_current(benchmark::State& state, std::string mech) {
+    std::unique_ptr<fvm_cell> cell;
+    auto& m = make_mechanism(state, mech, cell);
+
+    while (state.KeepRunning()) {
+        m->update_current();
+    }
+}
+
+void run_custom_arguments(benchmark::internal::Benchmark* b) {
+    for (auto ncomps: {100, 1000, 10000, 100000}) {
+        b->Args({ncomps});
+    }
+}
+
+BENCHMARK_CAPTURE(mech_state, hh, std::string("hh"))->Apply(run_custom_arguments);
+BENCHMARK_CAPTURE(mech_state, hh_mixed, std::string("hh_mixed"))->Apply(run_custom_arguments);
+BENCHMARK_CAPTURE(mech_state, nax, std::string("nax"))->Apply(run_custom_arguments);
+BENCHMARK_CAPTURE(mech_state, nax_mixed, std::string("nax_mixed"))->Apply(run_custom_arguments);
+BENCHMARK_CAPTURE(mech_init, hh, std::string("hh"))->Apply(run_custom_arguments);
+BENCHMARK_CAPTURE(mech_init, hh_mixed, std::string("hh_mixed"))->Apply(run_custom_arguments);
+BENCHMARK_CAPTURE(mech_current, hh, std::string("hh"))->Apply(run_custom_arguments);
+BENCHMARK_CAPTURE(mech_current, hh_mixed, std::string("hh_mixed"))->Apply(run_custom_arguments);
+
+BENCHMARK_MAIN();
@@ -1,15 +1,18 @@
 // Test performance of vectorization for mechanism implementations.
 //
-// Start with pas (passive dendrite) mechanism
-
-// NOTE: This targets an earlier version of the Arbor API and
-// will need to be reworked in order to compile.
+// Start with pas (passive dendrite) mechanism, and compare the SIMD
+// transcendental functions used by generated mechanisms, in their full
+// and fast accuracy variants, with the scalar C library.
 
 #include <any>
+#include <cmath>
 #include <fstream>
+#include <random>
+#include <vector>
 
 #include <arbor/cable_cell.hpp>
 #include <arbor/morph/segment_tree.hpp>
+#include <arbor/simd/simd.hpp>
 
 #include "backends/multicore/fvm.hpp"
 #include "benchmark/benchmark.h"
@@ -64,18 +67,17 @@ public:
 
         arb::label_dict d;
         d.set("soma", arb::reg::tagged(1));
-        arb::cable_cell cell{arb::morphology(tree), d};
-        cell.paint("soma", "pas");
 
-        auto distribution = std::uniform_real_distribution<float>(0.f, 1.0f);
-        for(unsigned i = 0; i < num_synapse_; i++) {
-            auto gen = std::mt19937(i);
-            cell.place(arb::mlocation{1, distribution(gen)}, "expsyn");
+        arb::decor decor;
+        decor.paint("\"soma\"", "pas");
+
+        // Synapses at random locations on the dendrite.
+        if (num_synapse_) {
+            decor.place(arb::ls::uniform(arb::reg::tagged(3), 0, num_synapse_-1, 0), "expsyn");
         }
 
-        cell.default_parameters = arb::neuron_parameter_defaults;
-        cell.default_parameters.discretization = arb::cv_policy_max_extent(dend_length/num_comp_);
-        return std::move(cell);
+        decor.set_default(arb::cv_policy_max_extent(dend_length/num_comp_));
+        return arb::cable_cell(arb::morphology(tree), d, decor);
     }
 
     virtual cell_kind get_cell_kind(cell_gid_type) const override {
@@ -113,12 +115,11 @@ public:
         auto s1 = tree.append(s0, {0,0,soma_radius,dend_radius}, 3);
         tree.append(s1, {0,0,soma_radius+dend_length,dend_radius}, 3);
 
-        arb::cable_cell cell{arb::morphology(tree)};
-        cell.paint(arb::reg::all(), "pas");
+        arb::decor decor;
+        decor.paint(arb::reg::all(), "pas");
+        decor.set_default(arb::cv_policy_max_extent(dend_length/num_comp_));
 
-        cell.default_parameters = arb::neuron_parameter_defaults;
-        cell.default_parameters.discretization = arb::cv_policy_max_extent(dend_length/num_comp_);
-        return std::move(cell);
+        return arb::cable_cell(arb::morphology(tree), {}, decor);
     }
 
     virtual cell_kind get_cell_kind(cell_gid_type) const override {
@@ -158,12 +159,11 @@ public:
         tree.append(s2,           {0          ,dend_length,soma_radius+dend_length, dend_radius}, 3);
         tree.append(s2,           {dend_length,0          ,soma_radius+dend_length, dend_radius}, 3);
 
-        arb::cable_cell cell{arb::morphology(tree)};
-        cell.paint(arb::reg::all(), "pas");
+        arb::decor decor;
+        decor.paint(arb::reg::all(), "pas");
+        decor.set_default(arb::cv_policy_max_extent(dend_length*3/num_comp_));
 
-        cell.default_parameters = arb::neuron_parameter_defaults;
-        cell.default_parameters.discretization = arb::cv_policy_max_extent(dend_length*3/num_comp_);
-        return std::move(cell);
+        return arb::cable_cell(arb::morphology(tree), {}, decor);
     }
 
     virtual cell_kind get_cell_kind(cell_gid_type) const override {
@@ -201,12 +201,11 @@ public:
         auto s1 = tree.append(s0, {0          ,0          ,soma_radius,             dend_radius}, 3);
         tree.append(s1,           {0          ,0          ,soma_radius+dend_length, dend_radius}, 3);
 
-        arb::cable_cell cell{arb::morphology(tree)};
-        cell.paint(arb::reg::all(), "hh");
+        arb::decor decor;
+        decor.paint(arb::reg::all(), "hh");
+        decor.set_default(arb::cv_policy_max_extent(dend_length/num_comp_));
 
-        cell.default_parameters = arb::neuron_parameter_defaults;
-        cell.default_parameters.discretization = arb::cv_policy_max_extent(dend_length/num_comp_);
-        return std::move(cell);
+        return arb::cable_cell(arb::morphology(tree), {}, decor);
     }
 
     virtual cell_kind get_cell_kind(cell_gid_type) const override {
@@ -246,12 +245,11 @@ public:
         tree.append(          s2, {0          ,dend_length,soma_radius+dend_length, dend_radius}, 3);
         tree.append(          s2, {dend_length,0          ,soma_radius+dend_length, dend_radius}, 3);
 
-        arb::cable_cell cell{arb::morphology(tree)};
-        cell.paint(arb::reg::all(), "hh");
+        arb::decor decor;
+        decor.paint(arb::reg::all(), "hh");
+        decor.set_default(arb::cv_policy_max_extent(dend_length*3/num_comp_));
 
-        cell.default_parameters = arb::neuron_parameter_defaults;
-        cell.default_parameters.discretization = arb::cv_policy_max_extent(dend_length*3/num_comp_);
-        return std::move(cell);
+        return arb::cable_cell(arb::morphology(tree), {}, decor);
     }
 
     virtual cell_kind get_cell_kind(cell_gid_type) const override {
@@ -417,6 +415,80 @@ void hh_3_branches_current(benchmark::State& state) {
     }
 }
 
+// Transcendental functions over arrays of arguments in the ranges seen in
+// gating variable rate computations: scalar (with the C library, which
+// the compiler may or may not vectorize), and with arb::simd values of the
+// native width with full and fast accuracy.
+
+namespace S = arb::simd;
+using simd_value = S::simd<double, S::simd_abi::native_width<double>::value, S::simd_abi::default_abi>;
+
+enum class maths_impl { scalar, simd_full, simd_fast };
+
+struct exp_op {
+    static double scalar(double x) { return std::exp(x); }
+    static simd_value full(simd_value x) { return S::exp(x); }
+    static simd_value fast(simd_value x) { return S::fast_exp(x); }
+};
+
+struct expm1_op {
+    static double scalar(double x) { return std::expm1(x); }
+    static simd_value full(simd_value x) { return S::expm1(x); }
+    static simd_value fast(simd_value x) { return S::fast_expm1(x); }
+};
+
+struct exprelr_op {
+    static double scalar(double x) { return x+1.==1.? 1.: x/std::expm1(x); }
+    static simd_value full(simd_value x) { return S::exprelr(x); }
+    static simd_value fast(simd_value x) { return S::fast_exprelr(x); }
+};
+
+struct log_op {
+    static double scalar(double x) { return std::log(x); }
+    static simd_value full(simd_value x) { return S::log(x); }
+    static simd_value fast(simd_value x) { return S::fast_log(x); }
+};
+
+// Power with a fixed exponent, as for temperature coefficients q10^((T-T0)/10).
+struct pow_op {
+    static double scalar(double x) { return std::pow(x, 2.3); }
+    static simd_value full(simd_value x) { return S::pow(x, simd_value(2.3)); }
+    static simd_value fast(simd_value x) { return S::fast_pow(x, simd_value(2.3)); }
+};
+
+template <typename Op, maths_impl impl>
+void transcendental(benchmark::State& state, double lb, double ub) {
+    constexpr unsigned width = simd_value::width;
+    const unsigned n = state.range(0)/width*width;
+
+    std::vector<double> x(n), y(n);
+    std::mt19937 gen(23);
+    std::uniform_real_distribution<double> distribution(lb, ub);
+    for (auto& v: x) v = distribution(gen);
+
+    while (state.KeepRunning()) {
+        if (impl==maths_impl::scalar) {
+            for (unsigned i = 0; i<n; ++i) {
+                y[i] = Op::scalar(x[i]);
+            }
+        }
+        else {
+            for (unsigned i = 0; i<n; i += width) {
+                simd_value v(x.data()+i);
+                (impl==maths_impl::simd_full? Op::full(v): Op::fast(v)).copy_to(y.data()+i);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations()*n);
+}
+
+template <maths_impl impl> void exp_bench(benchmark::State& s)     { transcendental<exp_op, impl>(s, -20, 20); }
+template <maths_impl impl> void expm1_bench(benchmark::State& s)   { transcendental<expm1_op, impl>(s, -5, 5); }
+template <maths_impl impl> void exprelr_bench(benchmark::State& s) { transcendental<exprelr_op, impl>(s, -5, 5); }
+template <maths_impl impl> void log_bench(benchmark::State& s)     { transcendental<log_op, impl>(s, 1e-3, 1e3); }
+template <maths_impl impl> void pow_bench(benchmark::State& s)     { transcendental<pow_op, impl>(s, 0.1, 10); }
+
 void run_custom_arguments(benchmark::internal::Benchmark* b) {
     for (auto ncomps: {10, 100, 1000, 10000, 100000}) {
         b->Args({ncomps});
@@ -435,4 +507,21 @@ BENCHMARK(hh_1_branch_state)->Apply(run_custom_arguments);
 BENCHMARK(pas_3_branches_current)->Apply(run_custom_arguments);
 BENCHMARK(hh_3_branches_current)->Apply(run_custom_arguments);
 BENCHMARK(hh_3_branches_state)->Apply(run_custom_arguments);
+
+BENCHMARK_TEMPLATE(exp_bench, maths_impl::scalar)->Arg(10000);
+BENCHMARK_TEMPLATE(exp_bench, maths_impl::simd_full)->Arg(10000);
+BENCHMARK_TEMPLATE(exp_bench, maths_impl::simd_fast)->Arg(10000);
+BENCHMARK_TEMPLATE(expm1_bench, maths_impl::scalar)->Arg(10000);
+BENCHMARK_TEMPLATE(expm1_bench, maths_impl::simd_full)->Arg(10000);
+BENCHMARK_TEMPLATE(expm1_bench, maths_impl::simd_fast)->Arg(10000);
+BENCHMARK_TEMPLATE(exprelr_bench, maths_impl::scalar)->Arg(10000);
+BENCHMARK_TEMPLATE(exprelr_bench, maths_impl::simd_full)->Arg(10000);
+BENCHMARK_TEMPLATE(exprelr_bench, maths_impl::simd_fast)->Arg(10000);
+BENCHMARK_TEMPLATE(log_bench, maths_impl::scalar)->Arg(10000);
+BENCHMARK_TEMPLATE(log_bench, maths_impl::simd_full)->Arg(10000);
+BENCHMARK_TEMPLATE(log_bench, maths_impl::simd_fast)->Arg(10000);
+BENCHMARK_TEMPLATE(pow_bench, maths_impl::scalar)->Arg(10000);
+BENCHMARK_TEMPLATE(pow_bench, maths_impl::simd_full)->Arg(10000);
+BENCHMARK_TEMPLATE(pow_bench, maths_impl::simd_fast)->Arg(10000);
+
 BENCHMARK_MAIN();
@@ -1,10 +1,11 @@
-// Test performance of vectorization for mechanism implementations.
-//
-// Start with pas (passive dendrite) mechanism
+// Compare the overheads of the work-stealing task system and parallel_for
+// against a queue-per-thread pool that creates one task per index.
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include <arbor/version.hpp>
 
@@ -14,6 +15,67 @@
 
 using namespace arb;
 
+// Reference implementation: the mutex and condition variable protected
+// notification_queue per thread, with a std::function task pushed for every
+// index of a parallel loop.
+class queue_pool {
+    unsigned count_;
+    std::vector<std::thread> threads_;
+    std::vector<threading::impl::notification_queue> q_;
+    std::atomic<unsigned> index_{0};
+
+    void run_tasks_loop(unsigned i) {
+        while (true) {
+            threading::task tsk;
+            for (unsigned n = 0; n!=count_; n++) {
+                tsk = q_[(i+n)%count_].try_pop();
+                if (tsk) break;
+            }
+            if (!tsk) tsk = q_[i].pop();
+            if (!tsk) break;
+            tsk();
+        }
+    }
+
+public:
+    explicit queue_pool(unsigned nthreads): count_(nthreads), q_(nthreads) {
+        for (unsigned i = 1; i<count_; ++i) {
+            threads_.emplace_back([this, i]{ run_tasks_loop(i); });
+        }
+    }
+
+    ~queue_pool() {
+        for (auto& q: q_) q.quit();
+        for (auto& t: threads_) t.join();
+    }
+
+    void async(threading::task tsk) {
+        auto i = index_++;
+        for (unsigned n = 0; n!=count_; n++) {
+            if (q_[(i+n)%count_].try_push(tsk)) return;
+        }
+        q_[i%count_].push(std::move(tsk));
+    }
+
+    void try_run_task() {
+        for (unsigned n = 0; n!=count_; n++) {
+            if (auto tsk = q_[n].try_pop()) {
+                tsk();
+                return;
+            }
+        }
+    }
+
+    template <typename F>
+    void parallel_for(int left, int right, F f) {
+        std::atomic<int> in_flight{right-left};
+        for (int i = left; i<right; ++i) {
+            async([&, i] { f(i); --in_flight; });
+        }
+        while (in_flight) try_run_task();
+    }
+};
+
 void run(unsigned long us_per_task, unsigned tasks, threading::task_system* ts) {
     auto duration = std::chrono::microseconds(us_per_task);
     arb::threading::parallel_for::apply(
@@ -33,11 +95,63 @@ void task_test(benchmark::State& state) {
     }
 }
 
+// Fine-grained loops: a few nanoseconds of work per index, as in
+// per-cell event setup, run over a given number of threads.
+
+void fine_grained_queue(benchmark::State& state) {
+    const int n = state.range(0);
+    queue_pool pool(state.range(1));
+    std::vector<double> v(n, 1.);
+
+    while (state.KeepRunning()) {
+        pool.parallel_for(0, n, [&](int i) { v[i] = v[i]*0.5+1.; });
+        benchmark::ClobberMemory();
+    }
+}
+
+void fine_grained_work_stealing(benchmark::State& state) {
+    const int n = state.range(0);
+    const int grain = state.range(1);
+    threading::task_system ts(state.range(2));
+    std::vector<double> v(n, 1.);
+
+    while (state.KeepRunning()) {
+        if (grain) {
+            threading::parallel_for::apply(0, n, grain, &ts, [&](int i) { v[i] = v[i]*0.5+1.; });
+        }
+        else {
+            threading::parallel_for::apply(0, n, &ts, [&](int i) { v[i] = v[i]*0.5+1.; });
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
 void us_per_task(benchmark::internal::Benchmark *b) {
     for (auto ncomps: {100, 250, 500, 1000, 10000}) {
         b->Args({ncomps});
     }
 }
 
+void loop_size(benchmark::internal::Benchmark *b) {
+    for (auto n: {1000, 10000, 100000}) {
+        for (auto threads: {1, 4}) {
+            b->Args({n, threads});
+        }
+    }
+}
+
+// Grain size 0 selects the default grain size.
+void loop_size_grain(benchmark::internal::Benchmark *b) {
+    for (auto n: {1000, 10000, 100000}) {
+        for (auto grain: {0, 1, 16, 256}) {
+            for (auto threads: {1, 4}) {
+                b->Args({n, grain, threads});
+            }
+        }
+    }
+}
+
 BENCHMARK(task_test)->Apply(us_per_task);
+BENCHMARK(fine_grained_queue)->Apply(loop_size);
+BENCHMARK(fine_grained_work_stealing)->Apply(loop_size_grain);
 BENCHMARK_MAIN();
@@ -179,6 +179,31 @@ TEST(communicator, gather_gids_variant) {
     }
 }
 
+// Test low level alltoall_gids function, where domain i sends j+1 copies of
+// i*1000+j to domain j.
+TEST(communicator, alltoall_gids) {
+    const auto num_domains = g_context->distributed->size();
+    const auto rank = g_context->distributed->id();
+
+    std::vector<cell_gid_type> send;
+    std::vector<unsigned> send_partition = {0};
+    for (auto dom=0; dom<num_domains; ++dom) {
+        send.insert(send.end(), dom+1, rank*1000+dom);
+        send_partition.push_back(send.size());
+    }
+
+    const auto received = g_context->distributed->alltoall_gids(send, send_partition);
+
+    const auto& part = received.partition();
+    ASSERT_EQ(unsigned(num_domains+1), part.size());
+    for (auto dom=0; dom<num_domains; ++dom) {
+        EXPECT_EQ(unsigned(rank+1), received.count(dom));
+        for (auto i=part[dom]; i<part[dom+1]; ++i) {
+            EXPECT_EQ(cell_gid_type(dom*1000+rank), received.values()[i]);
+        }
+    }
+}
+
 namespace {
     // Population of cable and rss cells with ring connection topology.
     // Even gid are rss, and odd gid are cable cells.
@@ -495,3 +520,127 @@ TEST(communicator, all2all)
     // odd-numbered cells fire
     EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return g%2==1;}));
 }
+
+// Event generation is split over blocks of local cells, one per thread
+// in the communicator's thread pool.
+TEST(communicator, threaded_event_generation)
+{
+    unsigned N = g_context->distributed->size();
+    unsigned n_global = 10u*N;
+
+    execution_context ctx = *g_context;
+    ctx.thread_pool = std::make_shared<threading::task_system>(4);
+
+    {
+        auto R = ring_recipe(n_global);
+        const auto D = partition_load_balance(R, g_context);
+        auto C = communicator(R, D, ctx);
+
+        EXPECT_TRUE(test_ring(D, C, [](cell_gid_type g){return true;}));
+        EXPECT_TRUE(test_ring(D, C, [](cell_gid_type g){return g%3==0;}));
+    }
+    {
+        auto R = all2all_recipe(n_global);
+        const auto D = partition_load_balance(R, g_context);
+        auto C = communicator(R, D, ctx);
+
+        EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return true;}));
+        EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return g%3==1;}));
+    }
+}
+
+// Each source spikes several times: the events from each source are generated
+// for every spike, in time order.
+TEST(communicator, repeated_spikes)
+{
+    unsigned N = g_context->distributed->size();
+    unsigned n_global = 10u*N;
+
+    execution_context ctx = *g_context;
+    ctx.thread_pool = std::make_shared<threading::task_system>(4);
+
+    auto R = all2all_recipe(n_global);
+    const auto D = partition_load_balance(R, g_context);
+    auto C = communicator(R, D, ctx);
+
+    const std::vector<time_type> offsets = {0.5, 0, 0.25};
+    std::vector<spike> local_spikes;
+    for (auto gid: get_gids(D)) {
+        for (auto dt: offsets) {
+            local_spikes.push_back(spike({gid, 0u}, gid+dt));
+        }
+    }
+
+    auto global_spikes = C.exchange(local_spikes);
+    std::vector<pse_vector> queues(C.num_local_cells());
+    C.make_event_queues(global_spikes, queues);
+
+    auto gids = get_gids(D);
+    for (unsigned i = 0; i<gids.size(); ++i) {
+        ASSERT_EQ(3*n_global, queues[i].size());
+        for (cell_gid_type sid = 0; sid<n_global; ++sid) {
+            std::vector<time_type> times;
+            for (auto& ev: queues[i]) {
+                if (ev.target.index==sid) {
+                    EXPECT_EQ(float(gids[i]+sid), ev.weight);
+                    times.push_back(ev.time);
+                }
+            }
+            std::vector<time_type> expected = {sid+1., sid+1.25, sid+1.5};
+            EXPECT_EQ(expected, times);
+        }
+    }
+}
+
+// Sparse exchange sends each spike only to the domains with connections from
+// its source, and generates the same events as the all-gather.
+TEST(communicator, sparse_exchange)
+{
+    using util::assign_from;
+    using util::transform_view;
+
+    unsigned N = g_context->distributed->size();
+    unsigned n_global = 10u*N;
+
+    {
+        // Every domain requires every spike.
+        auto R = all2all_recipe(n_global);
+        const auto D = partition_load_balance(R, g_context);
+        auto C = communicator(R, D, *g_context);
+        C.set_sparse_exchange(true);
+
+        EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return true;}));
+        EXPECT_TRUE(test_all2all(D, C, [](cell_gid_type g){return g%2==0;}));
+    }
+    {
+        auto R = ring_recipe(n_global);
+        const auto D = partition_load_balance(R, g_context);
+        auto gather = communicator(R, D, *g_context);
+        auto sparse = communicator(R, D, *g_context);
+        sparse.set_sparse_exchange(true);
+
+        std::vector<spike> local_spikes = assign_from(transform_view(get_gids(D), make_spike));
+        std::reverse(local_spikes.begin(), local_spikes.end());
+
+        // Each spike in the ring is required by exactly one cell, and only
+        // the spike of the last cell on each domain leaves the domain.
+        auto sparse_spikes = sparse.exchange(local_spikes);
+        EXPECT_EQ(local_spikes.size(), sparse_spikes.size());
+        const auto expected_bytes = N>1? sizeof(spike): 0u;
+        EXPECT_EQ(expected_bytes, sparse.num_bytes_sent());
+        EXPECT_EQ(expected_bytes, sparse.num_bytes_received());
+
+        std::vector<pse_vector> expected(gather.num_local_cells());
+        std::vector<pse_vector> queues(sparse.num_local_cells());
+        gather.make_event_queues(gather.exchange(local_spikes), expected);
+        sparse.make_event_queues(sparse_spikes, queues);
+        for (auto i: util::make_span(queues.size())) {
+            util::sort(expected[i]);
+            util::sort(queues[i]);
+            EXPECT_EQ(expected[i], queues[i]);
+        }
+
+        sparse.update_num_spikes();
+        EXPECT_EQ(gather.num_spikes(), sparse.num_spikes());
+    }
+}
@@ -0,0 +1,65 @@
+: Functions with and without TABLE statements, and candidates for automatic
+: tabulation.
+
+NEURON {
+    SUFFIX test9
+    NONSPECIFIC_CURRENT i
+    RANGE gbar, q
+}
+
+PARAMETER {
+    gbar = 0.1
+    k = 10
+    q = 3
+}
+
+ASSIGNED {
+    minf
+    mtau
+}
+
+STATE {
+    m
+}
+
+BREAKPOINT {
+    SOLVE states METHOD cnexp
+    i = gbar*m*(v - shift(v - 10))
+}
+
+INITIAL {
+    rates(v)
+    m = minf
+}
+
+DERIVATIVE states {
+    rates(v)
+    m' = (minf - m)/mtau
+}
+
+PROCEDURE rates(v) {
+    minf = alpha(v)/(alpha(v) + beta(v))
+    mtau = 1/(q10(v)*(alpha(v) + beta(v)))
+}
+
+: Tabulated: depends only on the argument and a scalar parameter.
+FUNCTION alpha(v) {
+    TABLE DEPEND k FROM -100 TO 100 WITH 200
+    alpha = k*exprelr(-v/k)
+}
+
+: Tabulated only in automatic mode.
+FUNCTION beta(v) {
+    beta = exp(-v/20)
+}
+
+: Not tabulated, with a warning: depends on the RANGE parameter q.
+FUNCTION q10(v) {
+    TABLE FROM -100 TO 100 WITH 200
+    q10 = q^(v/100)
+}
+
+: Never tabulated automatically: called with an argument other than v.
+FUNCTION shift(v) {
+    shift = exp(v/50)
+}
@@ -1,4 +1,5 @@
 #include "common.hpp"
+#include "functiontables.hpp"
 #include "io/bulkio.hpp"
 #include "module.hpp"
 #include <unordered_map>
@@ -113,3 +114,62 @@ TEST(Module, breakpoint) {
 
     EXPECT_TRUE(m.semantic());
 }
+
+TEST(Module, function_tables) {
+    Module m(io::read_all(DATADIR "/mod_files/test9.mod"), "test9.mod");
+    EXPECT_NE(m.buffer().size(), 0);
+
+    Parser p(m, false);
+    EXPECT_TRUE(p.parse());
+    EXPECT_TRUE(m.semantic());
+
+    auto function = [&m](const char* name) { return m.symbols().at(name)->is_function(); };
+
+    auto alpha = function("alpha")->table();
+    ASSERT_TRUE(alpha);
+    EXPECT_FALSE(alpha->automatic);
+    EXPECT_EQ(200u, alpha->intervals);
+
+    // The table of q10 is ignored, as q10 depends on a RANGE parameter.
+    EXPECT_FALSE(function("q10")->table());
+    ASSERT_EQ(1u, m.warnings().size());
+    EXPECT_NE(std::string::npos, m.warnings().front().message.find("'q'"));
+
+    EXPECT_FALSE(function("beta")->table());
+    EXPECT_FALSE(function("shift")->table());
+
+    // Linear interpolation of k*exprelr(-v/k) at unit intervals.
+    auto acc = estimate_table_accuracy(function("alpha"));
+    EXPECT_TRUE(acc.evaluated);
+    EXPECT_LT(acc.max_rel_error, 2e-3);
+    EXPECT_GT(acc.max_rel_error, 0);
+}
+
+TEST(Module, automatic_function_tables) {
+    Module m(io::read_all(DATADIR "/mod_files/test9.mod"), "test9.mod");
+    EXPECT_NE(m.buffer().size(), 0);
+
+    Parser p(m, false);
+    EXPECT_TRUE(p.parse());
+    m.auto_tables({-150, 150, 3000});
+    EXPECT_TRUE(m.semantic());
+
+    auto function = [&m](const char* name) { return m.symbols().at(name)->is_function(); };
+
+    // Explicit tables are unchanged.
+    auto alpha = function("alpha")->table();
+    ASSERT_TRUE(alpha);
+    EXPECT_FALSE(alpha->automatic);
+    EXPECT_EQ(200u, alpha->intervals);
+
+    // beta is called only with the membrane voltage, through rates.
+    auto beta = function("beta")->table();
+    ASSERT_TRUE(beta);
+    EXPECT_TRUE(beta->automatic);
+    EXPECT_EQ(-150., beta->from);
+    EXPECT_EQ(150., beta->to);
+    EXPECT_EQ(3000u, beta->intervals);
+
+    EXPECT_FALSE(function("q10")->table());
+    EXPECT_FALSE(function("shift")->table());
+}
@@ -0,0 +1,185 @@
+#include <set>
+#include <string>
+
+#include "expression.hpp"
+#include "optimizer.hpp"
+#include "parser.hpp"
+#include "scope.hpp"
+
+#include "common.hpp"
+
+using symbol_map = Scope<Symbol>::symbol_map;
+
+namespace {
+    Symbol* define_procedure(symbol_map& symbols, const char* src) {
+        auto proc = Parser(src).parse_procedure();
+        std::string name = proc->is_procedure()->name();
+
+        Symbol* weak = (symbols[name] = std::move(proc)).get();
+        weak->semantic(symbols);
+        return weak;
+    }
+
+    // Range variables depend on the instance, scalar parameters do not.
+    void define_range(symbol_map& symbols, const std::string& name) {
+        symbols[name] = make_symbol<VariableExpression>(Location(), name);
+    }
+
+    void define_scalar(symbol_map& symbols, const std::string& name) {
+        auto var = make_symbol<VariableExpression>(Location(), name);
+        var->is_variable()->range(rangeKind::scalar);
+        var->is_variable()->access(accessKind::read);
+        symbols[name] = std::move(var);
+    }
+
+    BlockExpression* body_of(Symbol* proc) {
+        return proc->is_procedure()->body();
+    }
+}
+
+TEST(optimizer, expand_integer_powers) {
+    const char* before_repn =
+        "{\n"
+        "    x = y^2\n"
+        "    x = y^3 + (y+z)^-2\n"
+        "    x = y^4\n"
+        "    x = y^5 + y^0.5 + y^z\n"
+        "}\n";
+
+    const char* after_repn =
+        "{\n"
+        "    x = y*y\n"
+        "    x = y*y*y + 1/((y+z)*(y+z))\n"
+        "    x = (y*y)*(y*y)\n"
+        "    x = y^5 + y^0.5 + y^z\n"
+        "}\n";
+
+    auto before = Parser{before_repn}.parse_block(false);
+    auto after = Parser{after_repn}.parse_block(false);
+    ASSERT_TRUE(before);
+    ASSERT_TRUE(after);
+
+    auto expanded = expand_integer_powers(before->is_block());
+    verbose_print("expanded: ", expanded);
+    EXPECT_EXPR_EQ(after, expanded);
+}
+
+TEST(optimizer, common_subexpressions) {
+    const char* before_src =
+    "PROCEDURE before {      \n"
+    "    LOCAL a, b          \n"
+    "    a = exp(x+y)*2      \n"
+    "    b = 3*exp(x+y)      \n"
+    "    x = a+b             \n"
+    "    g = exp(x+y)+a      \n"
+    "}                       \n";
+
+    const char* expected_src =
+    "PROCEDURE expected {    \n"
+    "    LOCAL cse0_         \n"
+    "    LOCAL a, b          \n"
+    "    cse0_ = exp(x+y)    \n"
+    "    a = cse0_*2         \n"
+    "    b = 3*cse0_         \n"
+    "    x = a+b             \n"
+    "    g = exp(x+y)+a      \n"
+    "}                       \n";
+
+    symbol_map symbols;
+    define_range(symbols, "g");
+    define_range(symbols, "x");
+    define_range(symbols, "y");
+
+    auto before = define_procedure(symbols, before_src);
+    auto expected = define_procedure(symbols, expected_src);
+
+    auto after = eliminate_common_subexpressions(body_of(before));
+    verbose_print("after: ", after);
+    EXPECT_EXPR_EQ(body_of(expected), after.get());
+}
+
+TEST(optimizer, common_subexpressions_in_branches) {
+    // Evaluations in a branch are not shared with evaluations outside of it,
+    // and an assignment in a branch prevents sharing with later evaluations.
+
+    const char* before_src =
+    "PROCEDURE before {      \n"
+    "    g = x*y+1           \n"
+    "    if (x>0) {          \n"
+    "        g = exp(x*z)    \n"
+    "        h = exp(x*z)    \n"
+    "        y = 2           \n"
+    "    }                   \n"
+    "    h = exp(x*z)+x*y    \n"
+    "}                       \n";
+
+    const char* expected_src =
+    "PROCEDURE expected {    \n"
+    "    LOCAL cse0_         \n"
+    "    g = x*y+1           \n"
+    "    if (x>0) {          \n"
+    "        cse0_ = exp(x*z)\n"
+    "        g = cse0_       \n"
+    "        h = cse0_       \n"
+    "        y = 2           \n"
+    "    }                   \n"
+    "    h = exp(x*z)+x*y    \n"
+    "}                       \n";
+
+    symbol_map symbols;
+    for (auto name: {"g", "h", "x", "y", "z"}) {
+        define_range(symbols, name);
+    }
+
+    auto before = define_procedure(symbols, before_src);
+    auto expected = define_procedure(symbols, expected_src);
+
+    auto after = eliminate_common_subexpressions(body_of(before));
+    verbose_print("after: ", after);
+    EXPECT_EXPR_EQ(body_of(expected), after.get());
+}
+
+TEST(optimizer, hoist_invariants) {
+    const char* before_src =
+    "PROCEDURE before {      \n"
+    "    LOCAL a, b, c       \n"
+    "    a = 2*p             \n"
+    "    b = a*x + exp(p/q)  \n"
+    "    c = 0               \n"
+    "    if (x>0) {          \n"
+    "        c = p*q         \n"
+    "    }                   \n"
+    "    g = b+c             \n"
+    "}                       \n";
+
+    const char* expected_src =
+    "PROCEDURE expected {    \n"
+    "    LOCAL a, b, c       \n"
+    "    LOCAL inv0_         \n"
+    "    a = 2*p             \n"
+    "    inv0_ = exp(p/q)    \n"
+    "    b = a*x + inv0_     \n"
+    "    c = 0               \n"
+    "    if (x>0) {          \n"
+    "        c = p*q         \n"
+    "    }                   \n"
+    "    g = b+c             \n"
+    "}                       \n";
+
+    symbol_map symbols;
+    define_range(symbols, "g");
+    define_range(symbols, "x");
+    define_scalar(symbols, "p");
+    define_scalar(symbols, "q");
+
+    auto before = define_procedure(symbols, before_src);
+    auto expected = define_procedure(symbols, expected_src);
+
+    auto after = hoist_invariants(body_of(before));
+    verbose_print("after: ", after.block);
+    EXPECT_EXPR_EQ(body_of(expected), after.block.get());
+
+    // The assignment in the branch of the if statement is left unchanged.
+    std::set<std::string> invariant = {"a", "inv0_"};
+    EXPECT_EQ(invariant, after.invariant_locals);
+}
@@ -247,6 +247,83 @@ TEST(Parser, function) {
     }
 }
 
+TEST(Parser, function_table) {
+    {
+        char str[] =
+            "FUNCTION minf(v) {\n"
+            "  TABLE FROM -100 TO 100 WITH 200\n"
+            "  minf = exp(v)\n"
+            "}";
+
+        std::unique_ptr<Symbol> sym;
+        EXPECT_TRUE(check_parse(sym, &Parser::parse_function, str));
+        if (sym) {
+            auto table = sym->is_function()->table();
+            ASSERT_TRUE(table);
+            EXPECT_EQ(-100., table->from);
+            EXPECT_EQ(100., table->to);
+            EXPECT_EQ(200u, table->intervals);
+            EXPECT_TRUE(table->depend.empty());
+            EXPECT_FALSE(table->automatic);
+        }
+    }
+    {
+        char str[] =
+            "FUNCTION minf(v) {\n"
+            "  LOCAL a\n"
+            "  TABLE DEPEND k, q FROM -1.5 TO 2 WITH 7\n"
+            "  a = k*q\n"
+            "  minf = a*exp(v)\n"
+            "}";
+
+        std::unique_ptr<Symbol> sym;
+        EXPECT_TRUE(check_parse(sym, &Parser::parse_function, str));
+        if (sym) {
+            auto table = sym->is_function()->table();
+            ASSERT_TRUE(table);
+            EXPECT_EQ(-1.5, table->from);
+            EXPECT_EQ(2., table->to);
+            EXPECT_EQ(7u, table->intervals);
+            EXPECT_EQ((std::vector<std::string>{"k", "q"}), table->depend);
+        }
+    }
+    {
+        char str[] =
+            "FUNCTION minf(v) {\n"
+            "  minf = exp(v)\n"
+            "}";
+
+        std::unique_ptr<Symbol> sym;
+        EXPECT_TRUE(check_parse(sym, &Parser::parse_function, str));
+        if (sym) {
+            EXPECT_FALSE(sym->is_function()->table());
+        }
+    }
+
+    const char* bad_functions[] = {
+        // More than one argument.
+        "FUNCTION f(v, w) {\n  TABLE FROM -100 TO 100 WITH 200\n  f = v*w\n}",
+        // Table of a named variable.
+        "FUNCTION f(v) {\n  TABLE minf FROM -100 TO 100 WITH 200\n  f = v\n}",
+        // Empty range, or no intervals.
+        "FUNCTION f(v) {\n  TABLE FROM 100 TO -100 WITH 200\n  f = v\n}",
+        "FUNCTION f(v) {\n  TABLE FROM -100 TO 100 WITH 0\n  f = v\n}",
+        // Missing WITH.
+        "FUNCTION f(v) {\n  TABLE FROM -100 TO 100\n  f = v\n}",
+        // Two tables.
+        "FUNCTION f(v) {\n  TABLE FROM -100 TO 100 WITH 200\n  TABLE FROM -1 TO 1 WITH 2\n  f = v\n}",
+        // Table in a nested block.
+        "FUNCTION f(v) {\n  if (v>0) {\n    TABLE FROM -100 TO 100 WITH 200\n  }\n  f = v\n}"
+    };
+    for (auto str: bad_functions) {
+        EXPECT_TRUE(check_parse_fail(&Parser::parse_function, str));
+    }
+
+    // Tables are supported only in functions.
+    EXPECT_TRUE(check_parse_fail(&Parser::parse_procedure,
+        "PROCEDURE rates(v) {\n  TABLE minf FROM -100 TO 100 WITH 200\n  minf = v\n}"));
+}
+
 TEST(Parser, parse_solve) {
     std::unique_ptr<SolveExpression> s;
 
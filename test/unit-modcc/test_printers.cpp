@@ -331,3 +331,38 @@ TEST(SimdPrinter, simd_if_else) {
 
     }
 }
+
+TEST(SimdPrinter, fast_maths) {
+    // With fast maths, the fast approximations of exp, log, exprelr and
+    // pow are used; other functions are unchanged.
+    const char* source = "y=exp(x)+log(a)*exprelr(b)+x^z+cos(c)";
+
+    std::vector<testcase> testcases = {
+        {"full", "assign(y, S::add(S::add(S::add(S::exp(x), S::mul(S::log(a), S::exprelr(b))), S::pow(x, z)), S::cos(c)))"},
+        {"fast", "assign(y, S::add(S::add(S::add(S::fast_exp(x), S::mul(S::fast_log(a), S::fast_exprelr(b))), S::fast_pow(x, z)), S::cos(c)))"}
+    };
+
+    Scope<Symbol>::symbol_map globals;
+    auto scope = std::make_shared<Scope<Symbol>>(globals);
+
+    for (auto var: {"x", "y", "z", "a", "b", "c"}) {
+        scope->add_local_symbol(var, make_symbol<LocalVariable>(Location(), var, localVariableKind::local));
+    }
+
+    auto e = parse_line_expression(source);
+    ASSERT_TRUE(e);
+    e->semantic(scope);
+    ASSERT_FALSE(e->has_error());
+
+    for (const auto& tc: testcases) {
+        SCOPED_TRACE(tc.source);
+        std::stringstream out;
+        auto printer = std::make_unique<SimdPrinter>(out);
+        printer->set_fast_maths(std::string(tc.source)=="fast");
+        e->accept(printer.get());
+        std::string text = out.str();
+
+        verbose_print(e->to_string(), " :--: ", text);
+        EXPECT_EQ(strip(tc.expected), strip(text));
+    }
+}
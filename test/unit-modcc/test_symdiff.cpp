@@ -87,7 +87,9 @@ TEST(constant_simplify, constants) {
         { "log(exp(2))+cos(0)", 3. },
         { "0/17-1",             -1. },
         { "2.5*(34/17-1.0e2)",  -245. },
-        { "-sin(0.523598775598298873077107230546583814)", -0.5 }
+        { "-sin(0.523598775598298873077107230546583814)", -0.5 },
+        { "min(3, 2)+max(-1, fabs(-4))", 6. },
+        { "exprelr(0)+exprelr(log(2))", 1.+log(2.) }
     };
 
     for (const auto& item: tests) {
@@ -111,7 +113,9 @@ TEST(constant_simplify, simplified_expr) {
         { "(0*x)+y/(z-(0*w))", "y/z" },
         { "y*exp(0)",          "y" },
         { "x^(2-1)",           "x" },
-        { "0-(y+0)",           "-y" }
+        { "0-(y+0)",           "-y" },
+        { "min(x, 2+1)",       "min(x, 3)" },
+        { "max(y*1, z)",       "max(y, z)" }
     };
 
     for (const auto& item: tests) {
@@ -158,6 +162,36 @@ TEST(constant_simplify, block_with_if) {
     EXPECT_EXPR_EQ(after, constant_simplify(before));
 }
 
+TEST(constant_simplify, block_with_comparisons) {
+    const char* before_repn =
+        "{\n"
+        "    if (3>=4) {\n"
+        "        y = 1\n"
+        "    }\n"
+        "    if (2>=2 && 0<1) {\n"
+        "        y = 2\n"
+        "    }\n"
+        "    if (x>=2*1) {\n"
+        "        y = 3\n"
+        "    }\n"
+        "}\n";
+
+    const char* after_repn =
+        "{\n"
+        "    y = 2\n"
+        "    if (x>=2) {\n"
+        "        y = 3\n"
+        "    }\n"
+        "}\n";
+
+    auto before = Parser{before_repn}.parse_block(false);
+    auto after = Parser{after_repn}.parse_block(false);
+    ASSERT_TRUE(before);
+    ASSERT_TRUE(after);
+
+    EXPECT_EXPR_EQ(after, constant_simplify(before));
+}
+
 TEST(symbolic_pdiff, expressions) {
     struct { const char* before; const char* after; } tests[] = {
         { "y+z*4",     "0" },
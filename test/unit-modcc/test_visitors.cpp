@@ -112,6 +112,44 @@ TEST(FlopVisitor, compound) {
     }
 }
 
+TEST(FlopVisitor, builtins) {
+    {
+        FlopVisitor visitor;
+        auto e = parse_expression("min(x, y)+max(x, 2*y)");
+        e->accept(&visitor);
+        EXPECT_EQ(visitor.flops.add, 3);
+        EXPECT_EQ(visitor.flops.mul, 1);
+    }
+
+    {
+        FlopVisitor visitor;
+        auto e = parse_expression("exprelr(x)+safeinv(y)");
+        e->accept(&visitor);
+        EXPECT_EQ(visitor.flops.add, 1);
+        EXPECT_EQ(visitor.flops.exp, 1);
+        EXPECT_EQ(visitor.flops.div, 2);
+    }
+}
+
+TEST(FlopVisitor, procedure_with_if) {
+    const char *expression =
+"PROCEDURE rates(v) {\n"
+"    if (v<0) {\n"
+"        minf = exp(v/10)\n"
+"    }\n"
+"    else {\n"
+"        minf = 1-exp(-v/10)\n"
+"    }\n"
+"}";
+    FlopVisitor visitor;
+    auto e = parse_procedure(expression);
+    e->accept(&visitor);
+    EXPECT_EQ(visitor.flops.add, 2);
+    EXPECT_EQ(visitor.flops.neg, 1);
+    EXPECT_EQ(visitor.flops.div, 2);
+    EXPECT_EQ(visitor.flops.exp, 2);
+}
+
 TEST(FlopVisitor, procedure) {
     const char *expression =
 "PROCEDURE trates(v) {\n"
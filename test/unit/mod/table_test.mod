@@ -0,0 +1,56 @@
+: Test mechanism for tabulated functions: the state s is evaluated by table
+: lookup, and the state e by exact evaluation of the same function; likewise
+: the states c and ce, of a function of the temperature.
+
+NEURON {
+    SUFFIX table_test
+    GLOBAL k
+}
+
+PARAMETER {
+    k = 10
+    celsius
+}
+
+STATE {
+    s
+    e
+    c
+    ce
+}
+
+BREAKPOINT {
+    SOLVE states
+}
+
+DERIVATIVE states {
+    s = tabulated(v)
+    e = exact(v)
+    c = tabulated_celsius(v)
+    ce = exact_celsius(v)
+}
+
+INITIAL {
+    s = tabulated(v)
+    e = exact(v)
+    c = tabulated_celsius(v)
+    ce = exact_celsius(v)
+}
+
+FUNCTION tabulated(x) {
+    TABLE DEPEND k FROM -100 TO 100 WITH 200
+    tabulated = exact(x)
+}
+
+FUNCTION exact(x) {
+    exact = exp(x/k)
+}
+
+FUNCTION tabulated_celsius(x) {
+    TABLE DEPEND k, celsius FROM -100 TO 100 WITH 200
+    tabulated_celsius = exact_celsius(x)
+}
+
+FUNCTION exact_celsius(x) {
+    exact_celsius = celsius*exp(x/k)
+}
@@ -0,0 +1,98 @@
+#include "../gtest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <arbor/arbexcept.hpp>
+
+#include "connection.hpp"
+
+using namespace arb;
+
+namespace {
+connection_table make_table(std::size_t n, float (*weight)(std::size_t), float (*delay)(std::size_t)) {
+    connection_table t;
+    t.resize(n);
+    for (std::size_t i = 0; i<n; ++i) {
+        t.cell[i] = i%7;
+        t.target[i] = i%3;
+        t.weight[i] = weight(i);
+        t.delay[i] = delay(i);
+    }
+    return t;
+}
+} // anonymous namespace
+
+TEST(connection_table, quantize_exact) {
+    // Weights are coded exactly; delays that are multiples of the quantum
+    // are unchanged.
+    auto t = make_table(1000,
+        [](std::size_t i) { return 0.5f*(i%5)-1.f; },
+        [](std::size_t i) { return 0.25f*(1+i%11); });
+    auto bytes = t.memory();
+
+    t.quantize_weights();
+    EXPECT_TRUE(t.quantized_weights());
+    EXPECT_FALSE(t.quantized_delays());
+    EXPECT_EQ(5u, t.weight_codebook.size());
+    EXPECT_TRUE(t.weight.empty());
+
+    t.quantize_delays(0.125);
+    EXPECT_TRUE(t.quantized_delays());
+    EXPECT_TRUE(t.delay.empty());
+    EXPECT_LT(t.memory(), bytes*4/5);
+
+    for (std::size_t i = 0; i<t.size(); ++i) {
+        EXPECT_EQ(0.5f*(i%5)-1.f, t.weight_of(i));
+        EXPECT_EQ(0.25*(1+i%11), t.delay_of(i));
+    }
+}
+
+TEST(connection_table, quantize_rounded) {
+    // Delays are rounded up; weights are unchanged.
+    const std::size_t n = 100000;
+    auto t = make_table(n,
+        [](std::size_t i) { return float(i)/n; },
+        [](std::size_t i) { return 0.1f+0.001f*(i%100); });
+    auto exact = make_table(n,
+        [](std::size_t i) { return float(i)/n; },
+        [](std::size_t i) { return 0.1f+0.001f*(i%100); });
+
+    t.quantize_delays(0.025);
+    EXPECT_FALSE(t.quantized_weights());
+    for (std::size_t i = 0; i<n; ++i) {
+        EXPECT_EQ(exact.weight[i], t.weight_of(i));
+        EXPECT_LE(exact.delay[i], t.delay_of(i));
+        EXPECT_GT(exact.delay[i]+0.025, t.delay_of(i));
+    }
+
+    // Quantizing delays again rounds the quantized delays.
+    t.quantize_delays(0.05);
+    for (std::size_t i = 0; i<n; ++i) {
+        EXPECT_LE(exact.delay[i], t.delay_of(i));
+    }
+}
+
+TEST(connection_table, quantize_errors) {
+    auto t = make_table(10,
+        [](std::size_t) { return 1.f; },
+        [](std::size_t i) { return 10.f*i; });
+
+    EXPECT_THROW(t.quantize_delays(-1), arbor_exception);
+    EXPECT_THROW(t.quantize_delays(0), arbor_exception);
+    EXPECT_THROW(t.quantize_delays(1e-3), arbor_exception);
+
+    // A failed quantization leaves the table unchanged.
+    EXPECT_FALSE(t.quantized_delays());
+    EXPECT_EQ(90., t.delay_of(9));
+
+    // Weights cannot be coded exactly with more than 2^16 distinct values.
+    const std::size_t n = 100000;
+    auto u = make_table(n,
+        [](std::size_t i) { return float(i)/n; },
+        [](std::size_t) { return 1.f; });
+    EXPECT_THROW(u.quantize_weights(), arbor_exception);
+    EXPECT_FALSE(u.quantized_weights());
+    EXPECT_EQ(float(n-1)/n, u.weight_of(n-1));
+}
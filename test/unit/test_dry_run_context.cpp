@@ -5,6 +5,7 @@
 
 #include <distributed_context.hpp>
 #include <arbor/spike.hpp>
+#include <communication/spike_codec.hpp>
 
 // Test that there are no errors constructing a distributed_context from a dry_run_context
 using distributed_context_handle = std::shared_ptr<arb::distributed_context>;
@@ -117,3 +118,72 @@ TEST(dry_run_context, gather_gids)
     EXPECT_EQ(part[3], gids.size()*3);
     EXPECT_EQ(part[4], gids.size()*4);
 }
+
+TEST(dry_run_context, alltoall_spikes)
+{
+    distributed_context_handle ctx = arb::make_dry_run_context(3, 4);
+    using svec = std::vector<arb::spike>;
+
+    // Spikes sent to domains 0, 1 and 2 respectively.
+    svec spikes = {
+        {{0u,0u}, 42.f},
+        {{1u,0u}, 42.f},
+        {{2u,0u}, 42.f},
+        {{3u,0u}, 42.f},
+    };
+
+    // Domain i sends to domain 0 what domain 0 sends to domain -i,
+    // translated by i tiles.
+    svec received_spikes = {
+        {{0u,0u}, 42.f},
+        {{5u,0u}, 42.f},
+        {{6u,0u}, 42.f},
+        {{7u,0u}, 42.f},
+    };
+
+    auto s = ctx->alltoall_spikes(spikes, {0u, 1u, 1u, 4u});
+    auto& part = s.partition();
+
+    EXPECT_EQ(s.values(), received_spikes);
+    EXPECT_EQ(part, (std::vector<unsigned>{0u, 1u, 4u, 4u}));
+}
+
+TEST(dry_run_context, alltoall_gids)
+{
+    distributed_context_handle ctx = arb::make_dry_run_context(2, 4);
+    using gvec = std::vector<arb::cell_gid_type>;
+
+    // Domain 0 requires gids 5 and 6 from domain 1, so domain 1 requires
+    // gids 1 and 2 from domain 0.
+    auto s = ctx->alltoall_gids({5, 6}, {0u, 0u, 2u});
+    auto& part = s.partition();
+
+    EXPECT_EQ(s.values(), (gvec{1, 2}));
+    EXPECT_EQ(part, (std::vector<unsigned>{0u, 0u, 2u}));
+}
+
+TEST(dry_run_context, gather_encoded_spikes)
+{
+    distributed_context_handle ctx = arb::make_dry_run_context(3, 4);
+    using svec = std::vector<arb::spike>;
+
+    svec spikes = {
+        {{0u,1u}, 0.5},
+        {{2u,0u}, 1.25},
+    };
+    std::vector<char> encoded;
+    arb::encode_spikes(spikes, 0.25, encoded);
+
+    auto s = arb::decode_gathered_spikes(ctx->gather_encoded_spikes(encoded));
+
+    svec gathered_spikes = {
+        {{0u,1u}, 0.5},
+        {{2u,0u}, 1.25},
+        {{4u,1u}, 0.5},
+        {{6u,0u}, 1.25},
+        {{8u,1u}, 0.5},
+        {{10u,0u}, 1.25},
+    };
+    EXPECT_EQ(s.values(), gathered_spikes);
+    EXPECT_EQ(s.partition(), (std::vector<unsigned>{0u, 2u, 4u, 6u}));
+}
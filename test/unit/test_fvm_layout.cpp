@@ -1128,3 +1128,69 @@ TEST(fvm_layout, iinterp) {
         EXPECT_EQ(-fc2, I.distal_coef);
     }
 }
+
+TEST(fvm_layout, discretization_cache) {
+    auto system = two_cell_system();
+    auto& descriptions = system.descriptions;
+    auto& builders = system.builders;
+
+    descriptions[0].decorations.place(builders[0].location({1, 0.4}), "expsyn");
+    descriptions[1].decorations.place(builders[1].location({2, 0.4}), "exp2syn");
+    descriptions[1].decorations.place(builders[1].location({3, 0.4}), "expsyn");
+    descriptions[1].decorations.place(builders[1].location({3, 1}), threshold_detector{10});
+
+    // A variant of cell 0 with different synapse parameters.
+    auto variant = descriptions[0];
+    variant.decorations.place(builders[0].location({1, 0.4}), mechanism_desc("expsyn").set("tau", 1.5));
+
+    cable_cell_global_properties gprop;
+    gprop.default_parameters = neuron_parameter_defaults;
+
+    auto two_cells = system.cells();
+    cable_cell variant_cell(variant);
+    std::vector<cable_cell> cells = {two_cells[0], two_cells[1], two_cells[0], variant_cell, two_cells[1], two_cells[0]};
+
+    fvm_cv_discretization D = fvm_cv_discretize(cells, gprop.default_parameters);
+    fvm_mechanism_data M = fvm_build_mechanism_data(gprop, cells, D);
+
+    // Combine the cached data of each cell, as fvm_lowered_cell_impl does.
+    fvm_discretization_cache cache;
+    fvm_discretization d;
+    for (auto& c: cells) {
+        append(d, *fvm_discretize_cell(c, gprop, &cache));
+    }
+    EXPECT_EQ(3u, cache.size());
+    EXPECT_EQ(3u, cache.hits());
+
+    EXPECT_EQ(D.geometry.cv_parent, d.D.geometry.cv_parent);
+    EXPECT_EQ(D.geometry.cell_cv_divs, d.D.geometry.cell_cv_divs);
+    EXPECT_EQ(D.face_conductance, d.D.face_conductance);
+    EXPECT_EQ(D.cv_area, d.D.cv_area);
+    EXPECT_EQ(D.cv_capacitance, d.D.cv_capacitance);
+
+    EXPECT_EQ(M.n_target, d.M.n_target);
+    EXPECT_EQ(M.target_divs, d.M.target_divs);
+    ASSERT_EQ(M.mechanisms.size(), d.M.mechanisms.size());
+    for (auto& [name, config]: M.mechanisms) {
+        SCOPED_TRACE(name);
+        const auto& cached = d.M.mechanisms.at(name);
+        EXPECT_EQ(config.cv, cached.cv);
+        EXPECT_EQ(config.multiplicity, cached.multiplicity);
+        EXPECT_EQ(config.norm_area, cached.norm_area);
+        EXPECT_EQ(config.target, cached.target);
+        EXPECT_EQ(config.param_values, cached.param_values);
+    }
+    ASSERT_EQ(M.ions.size(), d.M.ions.size());
+    for (auto& [name, config]: M.ions) {
+        SCOPED_TRACE(name);
+        const auto& cached = d.M.ions.at(name);
+        EXPECT_EQ(config.cv, cached.cv);
+        EXPECT_EQ(config.init_iconc, cached.init_iconc);
+        EXPECT_EQ(config.init_revpot, cached.init_revpot);
+    }
+
+    // Cached entries are shared.
+    EXPECT_EQ(fvm_discretize_cell(two_cells[1], gprop, &cache), fvm_discretize_cell(cells[4], gprop, &cache));
+    EXPECT_EQ(5u, cache.hits());
+    EXPECT_EQ(3u, cache.size());
+}
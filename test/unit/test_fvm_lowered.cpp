@@ -1,3 +1,4 @@
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -49,6 +50,8 @@ ACCESS_BIND(matrix fvm_cell::*, private_matrix_ptr, &fvm_cell::matrix_)
 
 ACCESS_BIND(std::vector<arb::mechanism_ptr> fvm_cell::*, private_mechanisms_ptr, &fvm_cell::mechanisms_)
 
+ACCESS_BIND(std::vector<std::unique_ptr<arb::multicore::mechanism>> arb::multicore::mechanism::*, private_views_ptr, &arb::multicore::mechanism::views_)
+
 arb::mechanism* find_mechanism(fvm_cell& fvcell, const std::string& name) {
     for (auto& mech: fvcell.*private_mechanisms_ptr) {
         if (mech->internal_name()==name) {
@@ -1328,3 +1331,216 @@ TEST(fvm_lowered, post_events_shared_state) {
     }
 
 }
+
+TEST(fvm_lowered, group_threads) {
+    // Splitting the cells of a group over threads should not change the result.
+
+    class group_recipe: public cable1d_recipe {
+    public:
+        group_recipe(const std::vector<cable_cell>& cells, unsigned max_group_threads):
+            cable1d_recipe(cells)
+        {
+            cell_gprop_.max_group_threads = max_group_threads;
+        }
+    };
+
+    const unsigned ncell = 256;
+    std::vector<cable_cell> cells;
+    for (unsigned i = 0; i<ncell; ++i) {
+        auto d = make_cell_ball_and_stick(false);
+        d.decorations.place(mlocation{0, 1}, i_clamp{1.+i%7, 20., 0.2+0.01*(i%11)});
+        d.decorations.place(mlocation{0, 0.5}, "expsyn");
+        d.decorations.place(mlocation{0, 0.05}, threshold_detector{-10});
+        cells.push_back(d);
+    }
+
+    std::vector<cell_gid_type> gids(ncell);
+    std::iota(gids.begin(), gids.end(), 0);
+
+    arb::proc_allocation resources;
+    resources.num_threads = 4;
+    auto ctx = make_context(resources);
+
+    // Check that the work is split in the lowered cell.
+    {
+        execution_context context(resources);
+        group_recipe rec(cells, 0);
+        std::vector<target_handle> targets;
+        std::vector<fvm_index_type> cell_to_intdom;
+        probe_association_map probe_map;
+
+        fvm_cell fvcell(context);
+        fvcell.initialize(gids, rec, cell_to_intdom, targets, probe_map);
+
+        EXPECT_EQ(5u, (fvcell.*private_matrix_ptr).state_.block_cell_divs.size());
+
+        auto hh = dynamic_cast<multicore::mechanism*>(find_mechanism(fvcell, "hh"));
+        ASSERT_TRUE(hh);
+        EXPECT_EQ(4u, (hh->*private_views_ptr).size());
+    }
+
+    struct result {
+        std::vector<spike> spikes;
+        std::vector<double> samples;
+    };
+
+    auto run = [&](unsigned max_group_threads) {
+        group_recipe rec(cells, max_group_threads);
+        for (auto gid: {0u, 100u, 255u}) {
+            rec.add_probe(gid, 0, cable_probe_membrane_voltage{mlocation{0, 0.5}});
+        }
+
+        partition_hint hint;
+        hint.cpu_group_size = ncell;
+        auto decomp = partition_load_balance(rec, ctx, {{cell_kind::cable, hint}});
+        simulation sim(rec, decomp, ctx);
+
+        result r;
+        sim.set_global_spike_callback(
+            [&](const std::vector<spike>& spikes) { r.spikes.insert(r.spikes.end(), spikes.begin(), spikes.end()); });
+        sim.add_sampler(all_probes, regular_schedule(0.5),
+            [&](probe_metadata, std::size_t n, const sample_record* records) {
+                for (std::size_t i = 0; i<n; ++i) {
+                    r.samples.push_back(*util::any_cast<const double*>(records[i].data));
+                }
+            });
+
+        pse_vector events;
+        for (cell_gid_type gid = 0; gid<ncell; gid += 3) {
+            events.push_back({{gid, 0}, 2.+0.1*(gid%10), 0.05});
+        }
+        sim.inject_events(events);
+
+        sim.run(30, 0.025);
+        return r;
+    };
+
+    auto serial = run(1);
+    auto threaded = run(0);
+
+    EXPECT_LT(0u, serial.spikes.size());
+    EXPECT_EQ(serial.spikes, threaded.spikes);
+    EXPECT_EQ(serial.samples, threaded.samples);
+}
+
+TEST(fvm_lowered, fused_mechanisms) {
+    // Fusing the updates of density mechanisms over tiles of CVs should not
+    // change the result.
+
+    class fused_recipe: public cable1d_recipe {
+    public:
+        fused_recipe(const std::vector<cable_cell>& cells, unsigned tile_cvs, unsigned max_group_threads):
+            cable1d_recipe(cells)
+        {
+            cell_gprop_.mechanism_tile_cvs = tile_cvs;
+            cell_gprop_.max_group_threads = max_group_threads;
+        }
+    };
+
+    using namespace arb::literals;
+
+    const unsigned ncell = 64;
+    std::vector<cable_cell> cells;
+    for (unsigned i = 0; i<ncell; ++i) {
+        auto d = make_cell_ball_and_stick(false);
+        d.decorations.paint("dend"_lab, "kdrmt");
+        if (i%3) d.decorations.paint("dend"_lab, "nax");
+        d.decorations.place(mlocation{0, 1}, i_clamp{1.+i%7, 20., 0.2+0.01*(i%11)});
+        d.decorations.place(mlocation{0, 0.5}, "expsyn");
+        d.decorations.place(mlocation{0, 0.05}, threshold_detector{-10});
+        cells.push_back(d);
+    }
+
+    std::vector<cell_gid_type> gids(ncell);
+    std::iota(gids.begin(), gids.end(), 0);
+
+    arb::proc_allocation resources;
+    resources.num_threads = 4;
+    auto ctx = make_context(resources);
+
+    // Check that the density mechanisms hh, kdrmt, nax and pas, which follow
+    // the point mechanism expsyn, are fused, and that the tiles divide their
+    // instances.
+    {
+        execution_context context(resources);
+        fused_recipe rec(cells, 37, 1);
+        std::vector<target_handle> targets;
+        std::vector<fvm_index_type> cell_to_intdom;
+        probe_association_map probe_map;
+
+        fvm_cell fvcell(context);
+        fvcell.initialize(gids, rec, cell_to_intdom, targets, probe_map);
+
+        EXPECT_EQ(4u, fvcell.pipeline().n_fused());
+        auto tiles = fvcell.pipeline().tile_counts();
+        ASSERT_EQ(1u, tiles.size());
+        EXPECT_LT(1u, tiles[0]);
+
+        // Every tile holds several somata, with one hh instance each, but
+        // tiles are cut at multiples of the SIMD width: the hh views, at
+        // most one per tile, divide its instances.
+        auto hh = dynamic_cast<multicore::mechanism*>(find_mechanism(fvcell, "hh"));
+        ASSERT_TRUE(hh);
+        auto& views = hh->*private_views_ptr;
+        EXPECT_LT(1u, views.size());
+        EXPECT_LE(views.size(), tiles[0]);
+
+        std::size_t n_instance = 0;
+        for (auto& view: views) {
+            EXPECT_LT(0u, view->size());
+            n_instance += view->size();
+        }
+        EXPECT_EQ(hh->size(), n_instance);
+    }
+
+    struct result {
+        std::vector<spike> spikes;
+        std::vector<double> samples;
+    };
+
+    auto run = [&](unsigned tile_cvs, unsigned max_group_threads) {
+        fused_recipe rec(cells, tile_cvs, max_group_threads);
+        for (auto gid: {0u, 31u, 63u}) {
+            rec.add_probe(gid, 0, cable_probe_membrane_voltage{mlocation{0, 0.5}});
+            rec.add_probe(gid, 1, cable_probe_density_state{mlocation{0, 0.75}, "kdrmt", "m"});
+        }
+
+        partition_hint hint;
+        hint.cpu_group_size = ncell;
+        auto decomp = partition_load_balance(rec, ctx, {{cell_kind::cable, hint}});
+        simulation sim(rec, decomp, ctx);
+
+        result r;
+        sim.set_global_spike_callback(
+            [&](const std::vector<spike>& spikes) { r.spikes.insert(r.spikes.end(), spikes.begin(), spikes.end()); });
+        sim.add_sampler(all_probes, regular_schedule(0.5),
+            [&](probe_metadata, std::size_t n, const sample_record* records) {
+                for (std::size_t i = 0; i<n; ++i) {
+                    r.samples.push_back(*util::any_cast<const double*>(records[i].data));
+                }
+            });
+
+        pse_vector events;
+        for (cell_gid_type gid = 0; gid<ncell; gid += 3) {
+            events.push_back({{gid, 0}, 2.0, 0.05});
+        }
+        sim.inject_events(events);
+
+        sim.run(30, 0.025);
+        return r;
+    };
+
+    auto unfused = run(0, 1);
+    EXPECT_LT(0u, unfused.spikes.size());
+
+    for (unsigned tile_cvs: {1u, 37u, 1000u}) {
+        SCOPED_TRACE(tile_cvs);
+        auto fused = run(tile_cvs, 1);
+        EXPECT_EQ(unfused.spikes, fused.spikes);
+        EXPECT_EQ(unfused.samples, fused.samples);
+
+        auto threaded = run(tile_cvs, 0);
+        EXPECT_EQ(unfused.spikes, threaded.spikes);
+        EXPECT_EQ(unfused.samples, threaded.samples);
+    }
+}
@@ -1,16 +1,22 @@
 #include "../gtest.h"
 
+#include <cmath>
+#include <memory>
+
 #include <arbor/arbexcept.hpp>
 #include <arbor/cable_cell.hpp>
 #include <arbor/domain_decomposition.hpp>
 #include <arbor/lif_cell.hpp>
 #include <arbor/load_balance.hpp>
 #include <arbor/recipe.hpp>
+#include <arbor/sample_buffer.hpp>
 #include <arbor/schedule.hpp>
 #include <arbor/simulation.hpp>
 #include <arbor/spike_source_cell.hpp>
 
 #include "lif_cell_group.hpp"
+#include "util/rangeutil.hpp"
+#include "util/span.hpp"
 
 using namespace arb;
 // Simple ring network of LIF neurons.
@@ -243,3 +249,187 @@ TEST(lif_cell_group, ring)
     }
 }
 
+
+TEST(lif_cell_group, batched_advance) {
+    // Cells are advanced together in SIMD lanes: compare spikes with those
+    // of a reference implementation that advances each cell in turn.
+
+    const unsigned n_cell = 37;
+
+    struct lif_recipe: public arb::recipe {
+        cell_size_type n;
+        lif_recipe(cell_size_type n): n(n) {}
+
+        cell_size_type num_cells() const override { return n; }
+        cell_kind get_cell_kind(cell_gid_type) const override { return cell_kind::lif; }
+        util::unique_any get_cell_description(cell_gid_type gid) const override {
+            lif_cell c;
+            c.tau_m = 5+gid%4;
+            c.V_th = 8+gid%3;
+            c.C_m = 15+gid%5;
+            c.t_ref = 1+0.5*(gid%3);
+            c.V_m = gid%2;
+            return c;
+        }
+    } rec(n_cell);
+
+    std::vector<cell_gid_type> gids(n_cell);
+    for (auto i: util::make_span(n_cell)) gids[i] = i;
+
+    // Events: a variable number per cell, on a 0.125 ms grid, with some
+    // coincident and some inside the refractory periods.
+    std::vector<pse_vector> lanes(n_cell);
+    for (auto i: util::make_span(n_cell)) {
+        for (unsigned k = 0; k<(i*7)%23; ++k) {
+            time_type t = 0.125*((k*k+3*i)%160);
+            lanes[i].push_back({{i, 0}, t, float(40+(k*i)%90)});
+            if (k%5==0) lanes[i].push_back({{i, 0}, t, 30.f});
+        }
+        util::sort_by(lanes[i], [](const spike_event& e) { return e.time; });
+    }
+
+    // Reference: advance each cell through its events in turn.
+    std::vector<spike> expected;
+    for (auto i: util::make_span(n_cell)) {
+        auto c = util::any_cast<lif_cell>(rec.get_cell_description(i));
+        time_type t = 0;
+        auto& lane = lanes[i];
+        for (std::size_t k = 0; k<lane.size(); ++k) {
+            if (lane[k].time<t) continue;
+            if (lane[k].time>=10) break;
+            auto time = lane[k].time;
+            float weight = lane[k].weight;
+            while (k+1<lane.size() && lane[k+1].time<=time) weight += lane[++k].weight;
+
+            c.V_m = c.V_m*std::exp(-(time-t)/c.tau_m)+weight/c.C_m;
+            t = time;
+            if (c.V_m>=c.V_th) {
+                expected.push_back({{i, 0}, t});
+                t += c.t_ref;
+                c.V_m = c.E_L;
+            }
+        }
+    }
+
+    lif_cell_group group(gids, rec);
+    group.advance(epoch(0, 10), 0.01, util::subrange_view(lanes, 0, n_cell));
+
+    EXPECT_LT(0u, expected.size());
+    EXPECT_EQ(expected, group.spikes());
+
+    // After reset, the group should reproduce the same spikes.
+    group.reset();
+    group.advance(epoch(0, 10), 0.01, util::subrange_view(lanes, 0, n_cell));
+    EXPECT_EQ(expected, group.spikes());
+}
+
+TEST(lif_cell_group, probe) {
+    // Sample membrane potential and refractory state of a cell with the
+    // default parameters: tau_m = 10 ms, C_m = 20 pF, V_th = 10 mV,
+    // E_L = 0 mV and t_ref = 2 ms.
+
+    struct lif_probe_recipe: public path_recipe {
+        lif_probe_recipe(): path_recipe(2, 1000, 0.1) {}
+
+        std::vector<probe_info> get_probes(cell_gid_type gid) const override {
+            return {lif_probe_voltage{}, {lif_probe_refractory{}, 7}};
+        }
+    } rec;
+
+    auto context = make_context();
+    auto decomp = partition_load_balance(rec, context);
+    simulation sim(rec, decomp, context);
+
+    auto metadata = sim.get_probe_metadata({0, 1});
+    ASSERT_EQ(1u, metadata.size());
+    EXPECT_EQ(7, metadata[0].tag);
+    EXPECT_TRUE(util::any_cast<const lif_probe_metadata*>(metadata[0].meta));
+
+    std::vector<std::vector<std::pair<time_type, double>>> samples(2);
+    sim.add_sampler(one_probe({0, 0}), explicit_schedule({0., 3., 5., 6., 7.5}),
+        [&](probe_metadata pm, std::size_t n, const sample_record* records) {
+            for (std::size_t i = 0; i<n; ++i) {
+                samples[0].push_back({records[i].time, *util::any_cast<const double*>(records[i].data)});
+            }
+        });
+    sim.add_sampler(one_probe({0, 1}), explicit_schedule({4.5, 6.}),
+        [&](probe_metadata pm, std::size_t n, const sample_record* records) {
+            for (std::size_t i = 0; i<n; ++i) {
+                samples[1].push_back({records[i].time, *util::any_cast<const double*>(records[i].data)});
+            }
+        },
+        sampling_policy::exact);
+
+    auto buffer = std::make_shared<sample_buffer>(10);
+    sim.add_sampler(one_probe({0, 0}), explicit_schedule({0., 3., 5., 6., 7.5}), buffer);
+
+    // A 5 mV jump at 1 ms, then a spike at 5 ms.
+    sim.inject_events({{{0, 0}, 1, 100}, {{0, 0}, 5, 1000}});
+    sim.run(10, 0.01);
+
+    std::vector<std::pair<time_type, double>> expected_voltage = {
+        {0., 0.}, {3., 5*std::exp(-0.2)}, {5., 5*std::exp(-0.4)}, {6., 0.}, {7.5, 0.}};
+    ASSERT_EQ(expected_voltage.size(), samples[0].size());
+    for (auto i: util::count_along(expected_voltage)) {
+        EXPECT_EQ(expected_voltage[i].first, samples[0][i].first);
+        EXPECT_DOUBLE_EQ(expected_voltage[i].second, samples[0][i].second);
+    }
+
+    ASSERT_EQ(1u, buffer->size());
+    const sample_column& col = (*buffer)[0];
+    EXPECT_EQ((cell_member_type{0, 0}), col.metadata().id);
+    ASSERT_EQ(samples[0].size(), col.size());
+    for (auto i: util::count_along(samples[0])) {
+        EXPECT_EQ(samples[0][i].first, col.time(i));
+        EXPECT_EQ(samples[0][i].second, *col.values(i));
+    }
+
+    std::vector<std::pair<time_type, double>> expected_refractory = {{4.5, 0.}, {6., 1.}};
+    EXPECT_EQ(expected_refractory, samples[1]);
+}
+
+TEST(lif_cell_group, binning) {
+    // Two sub-threshold events on a cell with default parameters (tau_m = 10 ms,
+    // C_m = 20 pF, V_th = 10 mV) give a spike when they are delivered together,
+    // or at the second event if they are delivered in turn.
+
+    struct lif_recipe: public arb::recipe {
+        cell_size_type num_cells() const override { return 1; }
+        cell_kind get_cell_kind(cell_gid_type) const override { return cell_kind::lif; }
+        util::unique_any get_cell_description(cell_gid_type) const override { return lif_cell(); }
+    } rec;
+
+    std::vector<pse_vector> lanes = {{{{0, 0}, 1.0, 120.f}, {{0, 0}, 1.4, 120.f}}};
+    auto events = util::subrange_view(lanes, 0, 1);
+
+    auto spike_times = [&](binning_kind kind, time_type interval) {
+        lif_cell_group group({0}, rec);
+        group.set_binning_policy(kind, interval);
+
+        std::vector<time_type> times;
+        for (int i = 0; i<2; ++i) {
+            group.reset();
+            group.advance(epoch(0, 10), 0.01, events);
+            times.push_back(group.spikes().empty()? -1: group.spikes().front().time);
+        }
+        // Binning state must not persist over reset.
+        EXPECT_EQ(times[0], times[1]);
+        return times[0];
+    };
+
+    EXPECT_EQ(1.4, spike_times(binning_kind::none, 0));
+    EXPECT_EQ(1.0, spike_times(binning_kind::regular, 0.5));
+    EXPECT_EQ(1.25, spike_times(binning_kind::regular, 0.25));
+    EXPECT_EQ(1.0, spike_times(binning_kind::following, 0.5));
+    EXPECT_EQ(1.4, spike_times(binning_kind::following, 0.3));
+
+    // Binned times are no earlier than the start of the epoch.
+    lif_cell_group group({0}, rec);
+    group.set_binning_policy(binning_kind::regular, 4);
+    std::vector<pse_vector> first = {{{{0, 0}, 1.0, 120.f}}}, second = {{{{0, 0}, 1.4, 120.f}}};
+    group.advance(epoch(0, 1.2), 0.01, util::subrange_view(first, 0, 1));
+    EXPECT_TRUE(group.spikes().empty());
+    group.advance(epoch(1, 10), 0.01, util::subrange_view(second, 0, 1));
+    ASSERT_EQ(1u, group.spikes().size());
+    EXPECT_EQ(1.2, group.spikes().front().time);
+}
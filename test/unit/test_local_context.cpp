@@ -93,3 +93,22 @@ TEST(local_context, gather_gids)
     EXPECT_EQ(part[0], 0u);
     EXPECT_EQ(part[1], gids.size());
 }
+
+TEST(local_context, alltoall_spikes)
+{
+    arb::local_context ctx;
+    using svec = std::vector<arb::spike>;
+
+    svec spikes = {
+        {{0u,3u}, 42.f},
+        {{1u,2u}, 42.f},
+    };
+
+    auto s = ctx.alltoall_spikes(spikes, {0u, 2u});
+
+    auto& part = s.partition();
+    EXPECT_EQ(s.values(), spikes);
+    EXPECT_EQ(part.size(), 2u);
+    EXPECT_EQ(part[0], 0u);
+    EXPECT_EQ(part[1], spikes.size());
+}
@@ -7,6 +7,7 @@
 
 #include "matrix.hpp"
 #include "backends/multicore/fvm.hpp"
+#include "threading/threading.hpp"
 #include "util/rangeutil.hpp"
 #include "util/span.hpp"
 
@@ -94,9 +95,7 @@ TEST(matrix, zero_diagonal)
     // elements should be ignored).
     // These submatrices should leave the rhs as-is when solved.
 
-    using util::assign;
-
-    // Three matrices, sizes 3, 3 and 2, with no branching.
+    // Three matrices, sizes 3, 2 and 2, with no branching.
     std::vector<index_type> p = {0, 0, 1, 3, 3, 5, 5};
     std::vector<index_type> c = {0, 3, 5, 7};
     std::vector<index_type> i = {0, 1, 2};
@@ -105,10 +104,16 @@ TEST(matrix, zero_diagonal)
     EXPECT_EQ(7u, m.size());
     EXPECT_EQ(3u, m.num_cells());
 
+    // The state holds the matrix in the layout of its solution units.
     auto& A = m.state_;
-    assign(A.d,   vvec({2,  3,  2, 0,  0,  4,  5}));
-    assign(A.u,   vvec({0, -1, -1, 0, -1,  0, -2}));
-    assign(A.rhs, vvec({3,  5,  7, 7,  8, 16, 32}));
+    auto assign_cv = [&](array& a, const vvec& v) {
+        for (auto i: util::make_span(v.size())) {
+            a[A.cv_slot[i]] = v[i];
+        }
+    };
+    assign_cv(A.d,   vvec({2,  3,  2, 0,  0,  4,  5}));
+    assign_cv(A.u,   vvec({0, -1, -1, 0, -1,  0, -2}));
+    assign_cv(A.rhs, vvec({3,  5,  7, 7,  8, 16, 32}));
 
     // Expected solution:
     std::vector<value_type> expected = {4, 5, 6, 7, 8, 9, 10};
@@ -185,3 +190,217 @@ TEST(matrix, zero_diagonal_assembled)
     EXPECT_TRUE(testing::seq_almost_eq<double>(expected, x));
 }
 
+
+TEST(matrix, thread_blocks)
+{
+    // Solution over blocks of cells in parallel should be identical
+    // to the serial solution.
+
+    using util::make_span;
+
+    // 300 cells of 7 CVs, each with a branch point at the second CV.
+    const index_type ncell = 300, ncv = 7;
+    std::vector<index_type> p, c = {0}, s;
+    for (auto i: make_span(ncell)) {
+        auto base = i*ncv;
+        for (index_type j: {-1, 0, 1, 2, 1, 4, 5}) {
+            p.push_back(j<0? base: base+j);
+        }
+        c.push_back(base+ncv);
+        s.push_back(i);
+    }
+
+    const std::size_t n = ncell*ncv;
+    vvec Cm(n), g(n), area(n, 1.0);
+    array dt(ncell, 1.0e-3), v(n), mg(n), cur(n);
+    for (auto i: make_span(n)) {
+        Cm[i] = 1+i%3;
+        g[i] = i%ncv? 1+i%5: 0;
+        v[i] = -65+i%11;
+        mg[i] = 1000*(1+i%7);
+        cur[i] = 100*(i%13)-600;
+    }
+    // One cell with zero dt.
+    dt[ncell/2] = 0;
+
+    matrix_type serial(p, c, Cm, g, area, s);
+    serial.assemble(dt, v, cur, mg);
+    array expected(n);
+    serial.solve(expected);
+
+    threading::task_system ts(4);
+    matrix_type blocked(p, c, Cm, g, area, s);
+    blocked.set_thread_blocks(&ts, 4);
+    EXPECT_EQ(5u, blocked.state_.block_cell_divs.size());
+
+    blocked.assemble(dt, v, cur, mg);
+    array x(n);
+    blocked.solve(x);
+
+    EXPECT_TRUE(util::equal(expected, x));
+}
+
+namespace {
+// Check the solution x of a system of cells against the solution of the
+// matrix of each cell on its own.
+void expect_cellwise_solution(const array& x,
+    const std::vector<index_type>& p, const std::vector<index_type>& c,
+    const vvec& Cm, const vvec& g, const vvec& area,
+    const array& dt, const array& v, const array& cur, const array& mg)
+{
+    using util::make_span;
+
+    for (auto i: make_span(c.size()-1)) {
+        auto first = c[i], last = c[i+1];
+        std::vector<index_type> pi = {0};
+        for (auto j: make_span(first+1, last)) {
+            pi.push_back(p[j]-first);
+        }
+
+        auto sub = [&](const auto& a) { return vvec(a.begin()+first, a.begin()+last); };
+        auto sub_array = [&](const array& a) { return array(a.begin()+first, a.begin()+last); };
+
+        matrix_type mi(pi, {0, last-first}, sub(Cm), sub(g), sub(area), {0});
+        mi.assemble(array(1, dt[i]), sub_array(v), sub_array(cur), sub_array(mg));
+        array xi(last-first);
+        mi.solve(xi);
+
+        EXPECT_TRUE(testing::seq_almost_eq<double>(xi, sub(x))) << "cell " << i;
+    }
+}
+}
+
+TEST(matrix, simd_batches)
+{
+    // Cells of the same structure are solved in interleaved batches: the
+    // solution should match that of each cell solved on its own.
+
+    using util::make_span;
+
+    // Cell structures, as parent of each CV relative to the first.
+    std::vector<std::vector<index_type>> shapes = {
+        {0, 0, 1, 2, 1, 4, 5},
+        {0, 0, 1, 2, 3},
+        {0, 0, 0, 0},
+        {0}
+    };
+
+    // Interleave cells of each structure, with some unique structures.
+    std::vector<unsigned> cell_shapes;
+    for (auto i: make_span(60)) {
+        cell_shapes.push_back(i%3? i%4: 0);
+    }
+
+    std::vector<index_type> p, c = {0}, s;
+    for (auto i: make_span(cell_shapes.size())) {
+        auto base = c.back();
+        for (auto j: shapes[cell_shapes[i]]) {
+            p.push_back(base+j);
+        }
+        // Make every tenth cell unique by extending it with a chain.
+        if (i%10==9) {
+            for (unsigned k = 0; k<=i/10; ++k) {
+                p.push_back(p.size()-1);
+            }
+        }
+        c.push_back(p.size());
+        s.push_back(i);
+    }
+
+    const index_type ncell = c.size()-1;
+    const std::size_t n = p.size();
+    vvec Cm(n), g(n), area(n, 1.0);
+    array v(n), mg(n), cur(n);
+    for (auto i: make_span(n)) {
+        Cm[i] = 1+i%3;
+        g[i] = 1+i%5;
+        v[i] = -65+i%11;
+        mg[i] = 1000*(1+i%7);
+        cur[i] = 100*(i%13)-600;
+    }
+    for (auto i: make_span(ncell)) {
+        g[c[i]] = 0;
+    }
+
+    array dt(ncell, 1.0e-3);
+    // Cells with zero dt, to be left unsolved.
+    dt[3] = 0;
+    dt[9] = 0;
+
+    matrix_type m(p, c, Cm, g, area, s);
+    m.assemble(dt, v, cur, mg);
+    array x(n);
+    m.solve(x);
+
+    unsigned W = matrix_type::state::simd_width;
+    if (W>1) {
+        EXPECT_LT(m.state_.unit_divs.size()-1, std::size_t(ncell));
+    }
+
+    expect_cellwise_solution(x, p, c, Cm, g, area, dt, v, cur, mg);
+}
+
+TEST(matrix, simd_batch_shapes)
+{
+    // Cells of different structure that share their tree from the root are
+    // batched, here unbranched cells of 36 to 40 CVs; a cell with the
+    // structure of a binary tree shares little of theirs, and is not.
+
+    using util::make_span;
+    using state = matrix_type::state;
+    const unsigned W = state::simd_width;
+
+    std::vector<index_type> p, c = {0}, s;
+    for (auto i: make_span(2*W+1)) {
+        auto base = c.back();
+        bool tree = i==W;
+        auto ncv = tree? 38: 36+i%5;
+        p.push_back(base);
+        for (auto j: make_span(1, ncv)) {
+            p.push_back(base+(tree? (j-1)/2: j-1));
+        }
+        c.push_back(p.size());
+        s.push_back(i);
+    }
+
+    const index_type ncell = c.size()-1;
+    const std::size_t n = p.size();
+    vvec Cm(n), g(n), area(n, 1.0);
+    array v(n), mg(n), cur(n);
+    for (auto i: make_span(n)) {
+        Cm[i] = 1+i%3;
+        g[i] = 1+i%5;
+        v[i] = -65+i%11;
+        mg[i] = 1000*(1+i%7);
+        cur[i] = 100*(i%13)-600;
+    }
+    for (auto i: make_span(ncell)) {
+        g[c[i]] = 0;
+    }
+    array dt(ncell, 1.0e-3);
+    dt[1] = 0;
+
+    matrix_type m(p, c, Cm, g, area, s);
+    m.assemble(dt, v, cur, mg);
+    array x(n);
+    m.solve(x);
+
+    const auto& st = m.state_;
+    if (W>1) {
+        EXPECT_LT(0, st.num_batches);
+        for (auto k: make_span(st.num_batches)) {
+            index_type min_cv = n, max_cv = 0;
+            for (auto j: make_span(st.unit_divs[k], st.unit_divs[k+1])) {
+                auto cell = st.unit_cells[j];
+                EXPECT_NE(index_type(W), cell);
+                min_cv = std::min(min_cv, c[cell+1]-c[cell]);
+                max_cv = std::max(max_cv, c[cell+1]-c[cell]);
+            }
+            EXPECT_GE(2*(st.unit_divs[k+1]-st.unit_divs[k]), index_type(W));
+            EXPECT_EQ(max_cv, st.unit_row_divs[k+1]-st.unit_row_divs[k]);
+            EXPECT_LE(4*max_cv, 5*min_cv);
+        }
+    }
+
+    expect_cellwise_solution(x, p, c, Cm, g, area, dt, v, cur, mg);
+}
@@ -0,0 +1,141 @@
+#include <cmath>
+#include <vector>
+
+#include <arbor/arbexcept.hpp>
+#include <arbor/mechanism.hpp>
+#include <arbor/mechcat.hpp>
+
+#include "backends/multicore/fvm.hpp"
+#include "backends/multicore/mechanism.hpp"
+#include "util/rangeutil.hpp"
+
+#include "common.hpp"
+#include "mech_private_field_access.hpp"
+#include "unit_test_catalogue.hpp"
+
+using namespace arb;
+
+using backend = multicore::backend;
+
+// The hh_mixed mechanism is the default hh mechanism, generated by modcc with
+// --mixed-precision: its STATE variables m, h and n are held in single
+// precision.
+
+namespace {
+struct hh_instance {
+    std::unique_ptr<backend::shared_state> state;
+    concrete_mech_ptr<backend> mech;
+
+    hh_instance(const mechanism_catalogue& cat, const std::string& name, const std::vector<fvm_value_type>& vinit) {
+        fvm_size_type ncv = vinit.size();
+        std::vector<fvm_index_type> cv_to_intdom(ncv, 0);
+        std::vector<fvm_gap_junction> gj = {};
+        std::vector<fvm_value_type> temp(ncv, 279.45);
+        std::vector<fvm_value_type> diam(ncv, 1.);
+        std::vector<fvm_index_type> src_to_spike = {};
+
+        mech = std::move(cat.instance<backend>(name).mech);
+        state = std::make_unique<backend::shared_state>(
+            1, 1, 0, cv_to_intdom, cv_to_intdom, gj, vinit, temp, diam, src_to_spike, mech->data_alignment());
+
+        fvm_ion_config ion_config;
+        mechanism_layout layout;
+        layout.weight.assign(ncv, 1.);
+        for (fvm_size_type i = 0; i<ncv; ++i) {
+            layout.cv.push_back(i);
+            ion_config.cv.push_back(i);
+        }
+        ion_config.init_revpot.assign(ncv, 0.);
+        ion_config.init_econc.assign(ncv, 0.);
+        ion_config.init_iconc.assign(ncv, 0.);
+        ion_config.reset_econc.assign(ncv, 0.);
+        ion_config.reset_iconc.assign(ncv, 0.);
+
+        state->add_ion("na", 1, ion_config);
+        state->add_ion("k", 1, ion_config);
+
+        mech->instantiate(0, *state, {}, layout);
+        state->reset();
+
+        // Reversal potentials of the default hh parameterization.
+        util::fill(state->ion_data.at("na").eX_, 50.);
+        util::fill(state->ion_data.at("k").eX_, -77.);
+
+        mech->initialize();
+    }
+
+    void advance(fvm_value_type dt) {
+        state->update_time_to(dt, state->time[0]+dt);
+        state->set_dt();
+        mech->update_current();
+        mech->update_state();
+        state->time = state->time_to;
+    }
+};
+}
+
+TEST(mech_mixed_precision, hh) {
+    auto cat = make_unit_test_catalogue(global_default_catalogue());
+
+    std::vector<fvm_value_type> vinit = {-80, -65, -40, -10, 0, 20, 35.5};
+    hh_instance dbl(cat, "hh", vinit);
+    hh_instance mix(cat, "hh_mixed", vinit);
+
+    auto expect_near_state = [&](const char* when) {
+        auto s_dbl = dbl.mech->get_state();
+        auto s_mix = mix.mech->get_state();
+        ASSERT_EQ(s_dbl.size(), s_mix.size());
+        ASSERT_EQ(3*vinit.size(), s_dbl.size());
+
+        // Gating variables are in [0, 1]; single precision arithmetic over
+        // a few steps should agree to a small multiple of float epsilon.
+        for (unsigned i = 0; i<s_dbl.size(); ++i) {
+            EXPECT_NEAR(s_dbl[i], s_mix[i], 1e-5) << when << ", state index " << i;
+            EXPECT_EQ(std::isnan(s_dbl[i]), std::isnan(s_mix[i]));
+        }
+    };
+
+    expect_near_state("after initialization");
+    for (int step = 0; step<20; ++step) {
+        dbl.advance(0.025);
+        mix.advance(0.025);
+    }
+    expect_near_state("after 20 steps");
+
+    // Currents are accumulated in double precision by both implementations.
+    for (unsigned i = 0; i<vinit.size(); ++i) {
+        EXPECT_NEAR(dbl.state->current_density[i], mix.state->current_density[i],
+                    1e-4*(1+std::fabs(dbl.state->current_density[i])));
+    }
+}
+
+TEST(mech_mixed_precision, state_access) {
+    auto cat = make_unit_test_catalogue(global_default_catalogue());
+
+    std::vector<fvm_value_type> vinit = {-65, -30, 10};
+    hh_instance mix(cat, "hh_mixed", vinit);
+
+    // Single precision state can not be referenced as double precision data.
+    auto mc = dynamic_cast<multicore::mechanism*>(mix.mech.get());
+    ASSERT_TRUE(mc);
+    EXPECT_THROW(mc->field_data("m"), arbor_exception);
+
+    // Parameters remain in double precision.
+    EXPECT_EQ(vinit.size(), mechanism_field(mix.mech.get(), "gnabar").size());
+
+    // State round-trips through get_state() and set_state(), rounded to
+    // single precision.
+    auto s = mix.mech->get_state();
+    ASSERT_EQ(3*vinit.size(), s.size());
+    for (auto& x: s) x = 0.5+x/4;
+
+    mix.mech->set_state(s);
+    auto t = mix.mech->get_state();
+    ASSERT_EQ(s.size(), t.size());
+    for (unsigned i = 0; i<s.size(); ++i) {
+        EXPECT_EQ(double(float(s[i])), t[i]);
+    }
+
+    s.pop_back();
+    EXPECT_THROW(mix.mech->set_state(s), arbor_internal_error);
+}
@@ -0,0 +1,99 @@
+#include <cmath>
+#include <vector>
+
+#include <arbor/mechanism.hpp>
+#include <arbor/version.hpp>
+
+#include "backends/multicore/fvm.hpp"
+
+#include "common.hpp"
+#include "mech_private_field_access.hpp"
+#include "unit_test_catalogue.hpp"
+
+using namespace arb;
+
+// The table_test mechanism sets state s from a function tabulated on
+// [-100, 100] at unit intervals, and state e from the function exp(v/k);
+// likewise states c and ce from celsius·exp(v/k), where the table depends on
+// the temperature. (The GPU back-end evaluates tabulated functions exactly.)
+
+template <typename backend>
+void run_table_test(double k, bool mixed_temperature = false) {
+    auto cat = make_unit_test_catalogue();
+
+    // One cell, with a CV for each voltage: at table points, between them,
+    // at the ends of the table, and outside the table.
+
+    std::vector<fvm_value_type> vinit = {-65, 42.37, -99.5, -100, 100, 150, -1000};
+
+    fvm_size_type ncell = 1;
+    fvm_size_type ncv = vinit.size();
+    std::vector<fvm_index_type> cv_to_intdom(ncv, 0);
+
+    std::vector<fvm_gap_junction> gj = {};
+    auto instance = cat.instance<backend>("table_test");
+    auto& table_test = instance.mech;
+
+    std::vector<fvm_value_type> temp(ncv, 300.);
+    if (mixed_temperature) temp.back() = 310.;
+    std::vector<fvm_value_type> diam(ncv, 1.);
+    std::vector<fvm_index_type> src_to_spike = {};
+
+    auto shared_state = std::make_unique<typename backend::shared_state>(
+        ncell, ncell, 0, cv_to_intdom, cv_to_intdom, gj, vinit, temp, diam, src_to_spike, table_test->data_alignment());
+
+    mechanism_layout layout;
+    mechanism_overrides overrides;
+    overrides.globals["k"] = k;
+
+    layout.weight.assign(ncv, 1.);
+    for (fvm_size_type i = 0; i<ncv; ++i) {
+        layout.cv.push_back(i);
+    }
+
+    table_test->instantiate(0, *shared_state, overrides, layout);
+    shared_state->reset();
+    table_test->initialize();
+
+    auto s = mechanism_field(table_test.get(), "s");
+    auto e = mechanism_field(table_test.get(), "e");
+    auto c = mechanism_field(table_test.get(), "c");
+    auto ce = mechanism_field(table_test.get(), "ce");
+
+    for (fvm_size_type i = 0; i<ncv; ++i) {
+        double v = vinit[i];
+        double exact = std::exp(v/k);
+        EXPECT_DOUBLE_EQ(exact, e[i]);
+
+        if (v==std::round(v) || v<-100 || v>100) {
+            EXPECT_DOUBLE_EQ(exact, s[i]) << "v: " << v;
+        }
+        else {
+            // Error of linear interpolation is bounded by h²/8·max|f''|.
+            EXPECT_NEAR(exact, s[i], std::exp((v+1)/k)/(8*k*k)) << "v: " << v;
+            EXPECT_NE(exact, s[i]) << "v: " << v;
+        }
+
+        // Instances at different temperatures evaluate the function exactly.
+        double celsius = temp[i]-273.15;
+        EXPECT_DOUBLE_EQ(celsius*exact, ce[i]);
+
+        if (mixed_temperature || v==std::round(v) || v<-100 || v>100) {
+            EXPECT_DOUBLE_EQ(ce[i], c[i]) << "v: " << v;
+        }
+        else {
+            EXPECT_NEAR(ce[i], c[i], celsius*std::exp((v+1)/k)/(8*k*k)) << "v: " << v;
+            EXPECT_NE(ce[i], c[i]) << "v: " << v;
+        }
+    }
+}
+
+TEST(mech_table, lookup) {
+    run_table_test<multicore::backend>(10);
+
+    // Tables are computed from the value of the global parameter k.
+    run_table_test<multicore::backend>(20);
+
+    // Tables that depend on the temperature are not used if it varies.
+    run_table_test<multicore::backend>(10, true);
+}
@@ -1,5 +1,7 @@
 #include "../gtest.h"
 
+#include <cstddef>
+#include <random>
 #include <vector>
 
 #include <arbor/event_generator.hpp>
@@ -273,3 +275,62 @@ TEST(merge_events, tourney_poisson)
     EXPECT_TRUE(std::is_sorted(lf.begin(), lf.end()));
     EXPECT_EQ(lf, expected);
 }
+
+TEST(merge_events, merge_sorted_runs)
+{
+    std::mt19937 gen;
+    std::uniform_real_distribution<time_type> time_dist(0, 10);
+
+    pse_vector buf;
+    std::vector<std::size_t> bounds;
+    for (unsigned nruns: {1u, 2u, 3u, 7u, 8u}) {
+        pse_vector events;
+        bounds.assign(1, 0);
+        for (unsigned r = 0; r<nruns; ++r) {
+            pse_vector run;
+            for (unsigned i = 0; i<r%4+1; ++i) {
+                run.push_back({{r, i}, time_dist(gen), 1});
+            }
+            util::sort(run);
+            util::append(events, run);
+            bounds.push_back(events.size());
+        }
+
+        auto expected = events;
+        util::sort(expected);
+
+        merge_sorted_runs(events, bounds, buf);
+        EXPECT_EQ(expected, events);
+        EXPECT_EQ((std::vector<std::size_t>{0, events.size()}), bounds);
+    }
+}
+
+// Reuse of a tournament tree and its storage over inputs of differing size.
+TEST(merge_events, tourney_reuse)
+{
+    impl::tourney_tree tree;
+    std::vector<event_span> spans;
+    pse_vector lf;
+
+    pse_vector evs[5] = {
+        {{{0, 0}, 1, 1}, {{0, 0}, 4, 1}},
+        {{{0, 0}, 2, 1}, {{0, 0}, 3, 1}},
+        {{{0, 0}, 0, 1}},
+        {},
+        {{{0, 0}, 5, 1}, {{0, 0}, 6, 1}, {{0, 0}, 7, 1}},
+    };
+
+    for (unsigned n: {5u, 2u, 3u, 1u}) {
+        pse_vector expected;
+        spans.clear();
+        for (unsigned i = 0; i<n; ++i) {
+            spans.push_back(util::range_pointer_view(evs[i]));
+            util::append(expected, evs[i]);
+        }
+        util::sort(expected);
+
+        lf.clear();
+        tree_merge_events(spans, lf, tree);
+        EXPECT_EQ(expected, lf);
+    }
+}
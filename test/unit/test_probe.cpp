@@ -1,6 +1,8 @@
 #include "../gtest.h"
 
 #include <cmath>
+#include <map>
+#include <memory>
 #include <vector>
 
 #include <arbor/cable_cell.hpp>
@@ -9,6 +11,7 @@
 #include <arbor/mechanism.hpp>
 #include <arbor/mechcat.hpp>
 #include <arbor/mechinfo.hpp>
+#include <arbor/sample_buffer.hpp>
 #include <arbor/sampling.hpp>
 #include <arbor/schedule.hpp>
 #include <arbor/simple_sampler.hpp>
@@ -1262,11 +1265,102 @@ void run_exact_sampling_probe_test(const context& ctx) {
 // Generate unit tests multicore_X and gpu_X for each entry X in PROBE_TESTS,
 // which establish the appropriate arbor context and then call run_X_probe_test.
 
+template <typename Backend>
+void run_sample_buffer_probe_test(const context& ctx) {
+    // Samples written into the columns of a sample buffer should match those
+    // passed to a sampler function, for scalar and vector probes, and for probe
+    // addresses that resolve to more than one concrete probe.
+
+    decor d;
+    d.set_default(cv_policy_fixed_per_branch(3));
+    d.place(mlocation{0, 0}, i_clamp(0, INFINITY, 0.3));
+    d.paint(reg::all(), "hh");
+    cable_cell cell(make_y_morphology(), {}, d);
+
+    cable1d_recipe rec(cell, false);
+    rec.add_probe(0, 0, cable_probe_membrane_voltage{mlocation{0, 0.3}});
+    rec.add_probe(0, 0, cable_probe_membrane_voltage_cell{});
+    rec.add_probe(0, 0, cable_probe_total_current_cell{});
+    rec.add_probe(0, 0, cable_probe_membrane_voltage{ls::terminal()});
+
+    const double t_end = 3, dt = 0.025;
+    auto sched = regular_schedule(0.1);
+
+    using sample_trace = std::vector<std::pair<time_type, std::vector<double>>>;
+    std::map<std::pair<cell_member_type, unsigned>, sample_trace> expected;
+    {
+        simulation sim(rec, partition_load_balance(rec, ctx), ctx);
+        sim.add_sampler(all_probes, sched,
+            [&](probe_metadata pm, std::size_t n, const sample_record* records) {
+                auto& trace = expected[{pm.id, pm.index}];
+                for (std::size_t i = 0; i<n; ++i) {
+                    if (auto p = any_cast<const double*>(records[i].data)) {
+                        trace.push_back({records[i].time, {*p}});
+                    }
+                    else if (auto p = any_cast<const cable_sample_range*>(records[i].data)) {
+                        trace.push_back({records[i].time, {p->first, p->second}});
+                    }
+                    else {
+                        FAIL() << "unexpected sample type";
+                    }
+                }
+            });
+        sim.run(t_end, dt);
+    }
+    ASSERT_EQ(5u, expected.size());
+
+    std::size_t n_notify = 0;
+    auto buffer = std::make_shared<sample_buffer>(100, [&n_notify](sample_buffer&) { ++n_notify; });
+    auto small = std::make_shared<sample_buffer>(4);
+
+    simulation sim(rec, partition_load_balance(rec, ctx), ctx);
+    sim.add_sampler(all_probes, sched, buffer);
+    sim.add_sampler(one_probe({0, 0}), sched, small);
+    EXPECT_THROW(sim.add_sampler(all_probes, sched, buffer), arbor_exception);
+    sim.run(t_end, dt);
+
+    EXPECT_EQ(sim.get_pipeline_stats().num_epochs, n_notify);
+
+    ASSERT_EQ(expected.size(), buffer->size());
+    unsigned k = 0;
+    for (auto& [key, trace]: expected) {
+        const sample_column& col = (*buffer)[k++];
+        EXPECT_EQ(key.first, col.metadata().id);
+        EXPECT_EQ(key.second, col.metadata().index);
+        EXPECT_EQ(&col, buffer->find(key.first, key.second));
+
+        ASSERT_EQ(trace.size(), col.size());
+        EXPECT_EQ(0u, col.dropped());
+        ASSERT_EQ(trace[0].second.size(), col.width());
+        for (auto i: util::count_along(trace)) {
+            EXPECT_EQ(trace[i].first, col.time(i));
+            EXPECT_EQ(trace[i].second, std::vector<double>(col.values(i), col.values(i)+col.width()));
+        }
+    }
+    EXPECT_EQ(nullptr, buffer->find({0, 4}));
+
+    // The small buffer keeps only the most recent samples.
+    auto& trace = expected[{{0, 0}, 0}];
+    ASSERT_EQ(1u, small->size());
+    const sample_column& col = (*small)[0];
+    ASSERT_EQ(4u, col.size());
+    EXPECT_EQ(trace.size()-4, col.dropped());
+    for (unsigned i = 0; i<4; ++i) {
+        auto& entry = trace[trace.size()-4+i];
+        EXPECT_EQ(entry.first, col.time(i));
+        EXPECT_EQ(entry.second[0], *col.values(i));
+    }
+
+    small->clear();
+    EXPECT_TRUE(col.empty());
+    EXPECT_EQ(0u, col.dropped());
+}
+
 #undef PROBE_TESTS
 #define PROBE_TESTS \
     v_i, v_cell, v_sampled, expsyn_g, expsyn_g_cell, ion_density, \
     axial_and_ion_current_sampled, partial_density, exact_sampling, \
-    multi, total_current
+    multi, total_current, sample_buffer
 
 #undef RUN_MULTICORE
 #define RUN_MULTICORE(x) \
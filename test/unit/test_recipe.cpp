@@ -295,4 +295,20 @@ TEST(recipe, connections)
 
         EXPECT_THROW(simulation(recipe_4, decomp_4, context), arb::bad_connection_target_lid);
     }
+    {
+        // Connections are checked in parallel: with several invalid cells,
+        // the error of the first local cell is reported.
+        conns_0 = {{{1, 0}, {0, 0}, 0.1, 0.1},
+                   {{1, 0}, {0, 5}, 0.2, 0.4}};
+
+        conns_1 = {{{0, 0}, {1, 0}, 0.1, 0.2},
+                   {{4, 0}, {1, 0}, 0.3, 0.1}};
+
+        auto recipe_6 = custom_recipe({cell_0, cell_1}, {1, 2}, {2, 1}, {conns_0, conns_1}, {{}, {}});
+        auto decomp_6 = partition_load_balance(recipe_6, context);
+
+        for (int i = 0; i<10; ++i) {
+            EXPECT_THROW(simulation(recipe_6, decomp_6, context), arb::bad_connection_target_lid);
+        }
+    }
 }
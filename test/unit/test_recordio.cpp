@@ -0,0 +1,260 @@
+#include "../gtest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <arbor/cable_cell.hpp>
+#include <arbor/common_types.hpp>
+#include <arbor/sample_buffer.hpp>
+#include <arbor/sampling.hpp>
+#include <arbor/spike.hpp>
+
+#include <arborio/recordio.hpp>
+
+using namespace arb;
+using namespace arborio;
+
+namespace {
+// Temporary file, removed on destruction.
+struct temp_file {
+    std::string path;
+
+    explicit temp_file(const std::string& name) {
+        path = (std::filesystem::temp_directory_path()/("arbor-test-"+std::to_string(::getpid())+"-"+name)).string();
+    }
+    ~temp_file() {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+};
+
+std::vector<spike> make_spikes(unsigned n, cell_gid_type gid_base) {
+    std::vector<spike> spikes;
+    for (unsigned i = 0; i<n; ++i) {
+        spikes.push_back({{gid_base+i%5, i%2}, 0.25*i});
+    }
+    return spikes;
+}
+
+// Write n scalar samples of probe {gid, 0}, and n samples of width 3 of
+// probe {gid, 1}, in calls of up to 4 samples.
+void write_probe_samples(record_writer& w, unsigned n, cell_gid_type gid) {
+    probe_metadata scalar{{gid, 0}, 10, 0, {}};
+    probe_metadata vector{{gid, 1}, 11, 0, {}};
+
+    for (unsigned first = 0; first<n; first += 4) {
+        std::vector<double> values;
+        std::vector<cable_sample_range> ranges;
+        std::vector<sample_record> scalar_records, vector_records;
+
+        unsigned m = std::min(4u, n-first);
+        values.reserve(4*m);
+        ranges.reserve(m);
+        for (unsigned i = first; i<first+m; ++i) {
+            values.push_back(gid+i);
+            scalar_records.push_back({0.1*i, static_cast<const double*>(&values.back())});
+            for (unsigned k = 0; k<3; ++k) {
+                values.push_back(gid+10*i+k);
+            }
+            const double* p = &values.back()-2;
+            ranges.push_back({p, p+3});
+            vector_records.push_back({0.1*i, static_cast<const cable_sample_range*>(&ranges.back())});
+        }
+        w.write_samples(scalar, m, scalar_records.data());
+        w.write_samples(vector, m, vector_records.data());
+    }
+}
+
+void check_probe_samples(const record_reader& r, std::size_t stream, unsigned n, cell_gid_type gid) {
+    ASSERT_LT(stream+1, r.streams().size());
+    EXPECT_EQ((cell_member_type{gid, 0}), r.streams()[stream].probe_id);
+    EXPECT_EQ(10, r.streams()[stream].tag);
+    EXPECT_EQ(1u, r.streams()[stream].width);
+    EXPECT_EQ((cell_member_type{gid, 1}), r.streams()[stream+1].probe_id);
+    EXPECT_EQ(3u, r.streams()[stream+1].width);
+
+    auto scalar = r.samples(stream);
+    auto vector = r.samples(stream+1);
+    ASSERT_EQ(n, scalar.times.size());
+    ASSERT_EQ(n, vector.times.size());
+    ASSERT_EQ(3*n, vector.values.size());
+    for (unsigned i = 0; i<n; ++i) {
+        EXPECT_EQ(0.1*i, scalar.times[i]);
+        EXPECT_EQ(gid+i, scalar.values[i]);
+        EXPECT_EQ(0.1*i, vector.times[i]);
+        for (unsigned k = 0; k<3; ++k) {
+            EXPECT_EQ(gid+10*i+k, vector.values[3*i+k]);
+        }
+    }
+}
+} // anonymous namespace
+
+TEST(recordio, round_trip) {
+    temp_file f("round_trip.arbrec");
+    auto spikes = make_spikes(50, 0);
+
+    {
+        // Small chunks and buffers exercise the hand-off between buffers.
+        record_writer w(f.path, 7, 64);
+        auto write_spikes = w.spike_writer();
+        write_spikes({spikes.begin(), spikes.begin()+20});
+        write_probe_samples(w, 30, 100);
+        w.flush();
+        write_spikes({spikes.begin()+20, spikes.end()});
+
+        // Samples held in a sample buffer.
+        sample_buffer buffer(10);
+        auto& col = *buffer.add_column({{200, 0}, 3, 0, {}}, 2);
+        for (unsigned i = 0; i<5; ++i) {
+            double* v = col.push(i);
+            v[0] = i;
+            v[1] = -1.*i;
+        }
+        w.sample_buffer_writer()(buffer);
+        EXPECT_TRUE(buffer[0].empty());
+        w.close();
+        EXPECT_THROW(w.write_spikes(spikes), record_error);
+    }
+
+    record_reader r(f.path);
+    EXPECT_TRUE(r.indexed());
+    EXPECT_EQ(spikes, r.spikes());
+    ASSERT_EQ(3u, r.streams().size());
+    check_probe_samples(r, 0, 30, 100);
+
+    auto s = r.samples(2);
+    EXPECT_EQ((cell_member_type{200, 0}), r.streams()[2].probe_id);
+    ASSERT_EQ(2u, s.width);
+    EXPECT_EQ((std::vector<time_type>{0, 1, 2, 3, 4}), s.times);
+    EXPECT_EQ((std::vector<double>{0, 0, 1, -1, 2, -2, 3, -3, 4, -4}), s.values);
+
+    // Spikes are written in chunks of at most 7 rows.
+    unsigned n_spike_chunks = 0;
+    for (auto& c: r.chunks()) {
+        if (c.kind==record_chunk_kind::spikes) {
+            ++n_spike_chunks;
+            EXPECT_LE(c.rows, 7u);
+        }
+    }
+    EXPECT_LE(8u, n_spike_chunks);
+
+    // Queries over a time window.
+    std::vector<spike> window;
+    for (auto& x: spikes) {
+        if (x.time>=2 && x.time<5) window.push_back(x);
+    }
+    EXPECT_EQ(window, r.spikes(2, 5));
+
+    auto scalar = r.samples(0, 1, 2);
+    ASSERT_EQ(10u, scalar.times.size());
+    EXPECT_EQ(0.1*10, scalar.times.front());
+    EXPECT_EQ(100+10, scalar.values.front());
+
+    EXPECT_THROW(r.samples(3), record_error);
+}
+
+TEST(recordio, recover_unindexed) {
+    temp_file f("unindexed.arbrec");
+    auto spikes = make_spikes(30, 0);
+    {
+        record_writer w(f.path, 4);
+        w.write_spikes(spikes);
+        write_probe_samples(w, 9, 7);
+    }
+
+    // Remove the index and trailer, and append a partial chunk, as if the
+    // writer were interrupted.
+    std::uint64_t index_offset;
+    {
+        std::ifstream in(f.path, std::ios::binary|std::ios::ate);
+        in.seekg(-16, std::ios::end);
+        in.read(reinterpret_cast<char*>(&index_offset), sizeof(index_offset));
+    }
+    std::filesystem::resize_file(f.path, index_offset+30);
+
+    record_reader r(f.path);
+    EXPECT_FALSE(r.indexed());
+    EXPECT_EQ(spikes, r.spikes());
+    check_probe_samples(r, 0, 9, 7);
+    EXPECT_EQ(spikes.size()-8, r.spikes(2).size());
+}
+
+TEST(recordio, merge) {
+    temp_file f0("rank0.arbrec"), f1("rank1.arbrec"), merged("merged.arbrec");
+
+    auto spikes0 = make_spikes(12, 0);
+    auto spikes1 = make_spikes(9, 10);
+    {
+        record_writer w(f0.path, 5);
+        w.write_spikes(spikes0);
+        write_probe_samples(w, 6, 0);
+    }
+    {
+        record_writer w(f1.path, 5);
+        w.write_spikes(spikes1);
+        write_probe_samples(w, 11, 10);
+    }
+    merge_records({f0.path, f1.path}, merged.path);
+
+    record_reader r(merged.path);
+    EXPECT_TRUE(r.indexed());
+    ASSERT_EQ(4u, r.streams().size());
+    check_probe_samples(r, 0, 6, 0);
+    check_probe_samples(r, 2, 11, 10);
+
+    auto expected = spikes0;
+    expected.insert(expected.end(), spikes1.begin(), spikes1.end());
+    EXPECT_EQ(expected, r.spikes());
+}
+
+TEST(recordio, errors) {
+    temp_file f("errors.arbrec");
+    {
+        std::ofstream out(f.path);
+        out << "not a record file";
+    }
+    EXPECT_THROW(record_reader r(f.path), record_error);
+    EXPECT_THROW(record_reader r(f.path+".missing"), record_error);
+
+    record_writer w(f.path);
+    probe_metadata meta{{0, 0}, 0, 0, {}};
+    const double v[2] = {1, 2};
+    const cable_sample_range range{v, v+2};
+    sample_record scalar{0, &v[0]}, vector{1, &range};
+    w.write_samples(meta, 1, &scalar);
+    EXPECT_THROW(w.write_samples(meta, 1, &vector), record_error);
+
+    int bad = 3;
+    sample_record other{2, &bad};
+    EXPECT_THROW(w.write_samples(meta, 1, &other), record_error);
+}
+
+// A failed write is reported by the writer, which is then closed or
+// destroyed cleanly: the device /dev/full fails every write.
+TEST(recordio, write_failure) {
+    const std::string full = "/dev/full";
+    if (!std::filesystem::exists(full)) return;
+
+    {
+        record_writer w(full);
+        w.write_spikes(make_spikes(10, 0));
+        EXPECT_THROW(w.close(), record_error);
+        EXPECT_THROW(w.write_spikes(make_spikes(10, 0)), record_error);
+    }
+
+    {
+        // Hand off every chunk: the failure surfaces in a write, after
+        // which the writer is destroyed without being closed.
+        record_writer w(full, 1, 1);
+        auto write = [&w] {
+            for (unsigned i = 0; i<100; ++i) w.write_spikes(make_spikes(10, 0));
+        };
+        EXPECT_THROW(write(), record_error);
+    }
+}
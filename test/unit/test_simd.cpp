@@ -588,10 +588,12 @@ typedef ::testing::Types<
 #ifdef __AVX2__
     simd<int, 4, simd_abi::avx2>,
     simd<double, 4, simd_abi::avx2>,
+    simd<float, 8, simd_abi::avx2>,
 #endif
 #ifdef __AVX512F__
     simd<int, 8, simd_abi::avx512>,
     simd<double, 8, simd_abi::avx512>,
+    simd<float, 16, simd_abi::avx512>,
 #endif
 #if defined(__ARM_NEON)
     simd<int, 2, simd_abi::neon>,
@@ -866,7 +868,212 @@ TYPED_TEST_P(simd_fp_value, log_special_values) {
     }
 }
 
-REGISTER_TYPED_TEST_CASE_P(simd_fp_value, fp_maths, exp_special_values, expm1_special_values, log_special_values);
+// The fast approximations should have a relative error below 1e-10 for
+// double precision (and are the full accuracy implementations otherwise)
+// where the expected result is normal. Subnormal expected results may be
+// flushed to zero.
+
+namespace {
+    template <typename FP, std::size_t N>
+    ::testing::AssertionResult fast_approx_eq(const FP (&expected)[N], const FP (&result)[N]) {
+        const FP relerr = std::is_same<FP, double>::value? 1e-10: 1e-5;
+
+        for (std::size_t j = 0; j<N; ++j) {
+            FP e = expected[j], r = result[j];
+            bool ok = std::isnormal(e)? std::abs(e-r)<=relerr*std::abs(e):
+                      std::abs(e)<std::numeric_limits<FP>::min()? std::abs(r)<std::numeric_limits<FP>::min():
+                      (bool)testing::almost_eq(e, r);
+            if (!ok) {
+                return ::testing::AssertionFailure()
+                    << "expected " << e << " but got " << r << " at index " << j;
+            }
+        }
+        return ::testing::AssertionSuccess();
+    }
+}
+
+TYPED_TEST_P(simd_fp_value, fast_maths) {
+    using simd = TypeParam;
+    using fp = typename simd::scalar_type;
+    constexpr unsigned N = simd::width;
+
+    std::minstd_rand rng(1015);
+
+    for (unsigned i = 0; i<nrounds; ++i) {
+        fp epsilon = std::numeric_limits<fp>::epsilon();
+        int min_exponent = std::numeric_limits<fp>::min_exponent;
+        int max_exponent = std::numeric_limits<fp>::max_exponent;
+
+        fp u[N], v[N], r[N];
+
+        // Logarithm:
+        fill_random(u, rng, -max_exponent*std::log(2.), max_exponent*std::log(2.));
+        for (auto& x: u) {
+            x = std::exp(x);
+            if (std::fpclassify(x)==FP_SUBNORMAL) x = 0;
+        }
+
+        fp log_u[N];
+        for (unsigned i = 0; i<N; ++i) log_u[i] = std::log(u[i]);
+        fast_log(simd(u)).copy_to(r);
+        EXPECT_TRUE(fast_approx_eq(log_u, r));
+
+        // Logarithm close to 1:
+        fill_random(u, rng, 0.5, 2.);
+
+        for (unsigned i = 0; i<N; ++i) log_u[i] = std::log(u[i]);
+        fast_log(simd(u)).copy_to(r);
+        EXPECT_TRUE(fast_approx_eq(log_u, r));
+
+        // Exponential functions (exp, expm1, exprelr):
+        fp exp_min_arg = min_exponent*std::log(2.);
+        fp exp_max_arg = max_exponent*std::log(2.);
+        fill_random(u, rng, exp_min_arg, exp_max_arg);
+
+        fp exp_u[N];
+        for (unsigned i = 0; i<N; ++i) exp_u[i] = std::exp(u[i]);
+        fast_exp(simd(u)).copy_to(r);
+        EXPECT_TRUE(fast_approx_eq(exp_u, r));
+
+        fp expm1_u[N];
+        for (unsigned i = 0; i<N; ++i) expm1_u[i] = std::expm1(u[i]);
+        fast_expm1(simd(u)).copy_to(r);
+        EXPECT_TRUE(fast_approx_eq(expm1_u, r));
+
+        fp exprelr_u[N];
+        for (unsigned i = 0; i<N; ++i) {
+            exprelr_u[i] = u[i]+fp(1)==fp(1)? fp(1): u[i]/(std::expm1(u[i]));
+        }
+        fast_exprelr(simd(u)).copy_to(r);
+        EXPECT_TRUE(fast_approx_eq(exprelr_u, r));
+
+        // expm1 and exprelr about zero, where the gating variable rates
+        // of typical mechanisms are evaluated.
+        fill_random(u, rng, -1, 1);
+        for (auto& x: u) x = std::ldexp(x, -int(std::abs(x)*std::numeric_limits<fp>::digits));
+
+        for (unsigned i = 0; i<N; ++i) expm1_u[i] = std::expm1(u[i]);
+        fast_expm1(simd(u)).copy_to(r);
+        EXPECT_TRUE(fast_approx_eq(expm1_u, r));
+
+        for (unsigned i = 0; i<N; ++i) {
+            exprelr_u[i] = u[i]+fp(1)==fp(1)? fp(1): u[i]/(std::expm1(u[i]));
+        }
+        fast_exprelr(simd(u)).copy_to(r);
+        EXPECT_TRUE(fast_approx_eq(exprelr_u, r));
+
+        fill_random(u, rng, -epsilon, epsilon);
+        for (unsigned i = 0; i<N; ++i) exprelr_u[i] = 1;
+        fast_exprelr(simd(u)).copy_to(r);
+        EXPECT_TRUE(fast_approx_eq(exprelr_u, r));
+
+        // Power function:
+
+        // Non-negative base, arbitrary exponent.
+        fill_random(u, rng, 0., std::exp(1));
+        fill_random(v, rng, exp_min_arg, exp_max_arg);
+        fp pow_u_pos_v[N];
+        for (unsigned i = 0; i<N; ++i) pow_u_pos_v[i] = std::pow(u[i], v[i]);
+        fast_pow(simd(u), simd(v)).copy_to(r);
+        EXPECT_TRUE(fast_approx_eq(pow_u_pos_v, r));
+
+        // Arbitrary base, integer exponent.
+        fill_random(u, rng, -4, 4);
+        int int_exponent[N];
+        fill_random(int_exponent, rng, -20, 20);
+        for (unsigned i = 0; i<N; ++i) v[i] = int_exponent[i];
+        fp pow_u_v_int[N];
+        for (unsigned i = 0; i<N; ++i) pow_u_v_int[i] = std::pow(u[i], v[i]);
+        fast_pow(simd(u), simd(v)).copy_to(r);
+        EXPECT_TRUE(fast_approx_eq(pow_u_v_int, r));
+    }
+
+    errno = 0;
+}
+
+TYPED_TEST_P(simd_fp_value, fast_special_values) {
+    using simd = TypeParam;
+    using fp = typename simd::scalar_type;
+    constexpr unsigned N = simd::width;
+
+    using limits = std::numeric_limits<fp>;
+
+    constexpr fp inf = limits::infinity();
+    constexpr fp eps = limits::epsilon();
+    constexpr fp largest = limits::max();
+    constexpr fp normal_least = limits::min();
+    constexpr fp qnan = limits::quiet_NaN();
+
+    const fp exp_minarg = std::log(normal_least);
+    const fp exp_maxarg = std::log(largest);
+
+    // Unary functions; subnormal arguments are omitted, as for log.
+
+    fp values[] = { inf, -inf, eps, -eps,
+                    eps/2, -eps/2, 0., -0.,
+                    1., -1., 2., -2.,
+                    normal_least, -normal_least, largest, -largest,
+                    exp_minarg, exp_maxarg, qnan, -qnan };
+
+    constexpr unsigned n_values = sizeof(values)/sizeof(fp);
+    constexpr unsigned n_packed = (n_values+N-1)/N;
+    fp data[n_packed][N];
+
+    std::fill((fp *)data, (fp *)data+N*n_packed, fp(0));
+    std::copy(std::begin(values), std::end(values), (fp *)data);
+
+    for (unsigned i = 0; i<n_packed; ++i) {
+        fp expected[N], result[N];
+        simd s(data[i]);
+
+        for (unsigned j = 0; j<N; ++j) expected[j] = std::exp(data[i][j]);
+        fast_exp(s).copy_to(result);
+        EXPECT_TRUE(fast_approx_eq(expected, result));
+
+        for (unsigned j = 0; j<N; ++j) expected[j] = std::expm1(data[i][j]);
+        fast_expm1(s).copy_to(result);
+        EXPECT_TRUE(fast_approx_eq(expected, result));
+
+        for (unsigned j = 0; j<N; ++j) expected[j] = std::log(data[i][j]);
+        fast_log(s).copy_to(result);
+        EXPECT_TRUE(fast_approx_eq(expected, result));
+
+        for (unsigned j = 0; j<N; ++j) {
+            fp x = data[i][j];
+            expected[j] = x+fp(1)==fp(1)? fp(1): x/std::expm1(x);
+        }
+        fast_exprelr(s).copy_to(result);
+        EXPECT_TRUE(fast_approx_eq(expected, result));
+    }
+
+    // Power function: pairs of base and exponent.
+
+    const fp two53 = std::ldexp(fp(1), 53);
+
+    fp bases[] =     { 0., 0.,  -0.,  -2., -2., -2.,  1.,   qnan, -1., 2.,  0.5, 2.,   inf, inf, -inf, -inf, qnan, 2.,   -3.,   -0.5,  10., 2.  };
+    fp exponents[] = { 2., -1., 2.,   3.,  -2., 0.5,  qnan, 0.,   inf, inf, inf, -inf, -1., 2.,  3.,   2.,   1.,   qnan, two53, 1e30, 30., 0.5 };
+    static_assert(sizeof(bases)==sizeof(exponents), "unmatched bases and exponents");
+
+    constexpr unsigned n_pow_values = sizeof(bases)/sizeof(fp);
+    constexpr unsigned n_pow_packed = (n_pow_values+N-1)/N;
+    fp x[n_pow_packed][N], y[n_pow_packed][N];
+
+    std::fill((fp *)x, (fp *)x+N*n_pow_packed, fp(1));
+    std::fill((fp *)y, (fp *)y+N*n_pow_packed, fp(1));
+    std::copy(std::begin(bases), std::end(bases), (fp *)x);
+    std::copy(std::begin(exponents), std::end(exponents), (fp *)y);
+
+    for (unsigned i = 0; i<n_pow_packed; ++i) {
+        fp expected[N], result[N];
+        for (unsigned j = 0; j<N; ++j) expected[j] = std::pow(x[i][j], y[i][j]);
+
+        fast_pow(simd(x[i]), simd(y[i])).copy_to(result);
+        EXPECT_TRUE(fast_approx_eq(expected, result));
+    }
+}
+
+REGISTER_TYPED_TEST_CASE_P(simd_fp_value, fp_maths, exp_special_values, expm1_special_values, log_special_values,
+                           fast_maths, fast_special_values);
 
 typedef ::testing::Types<
 
@@ -875,9 +1082,11 @@ typedef ::testing::Types<
 #endif
 #ifdef __AVX2__
     simd<double, 4, simd_abi::avx2>,
+    simd<float, 8, simd_abi::avx2>,
 #endif
 #ifdef __AVX512F__
     simd<double, 8, simd_abi::avx512>,
+    simd<float, 16, simd_abi::avx512>,
 #endif
 #ifdef __ARM_NEON
     simd<double, 2, simd_abi::neon>,
@@ -1199,6 +1408,9 @@ typedef ::testing::Types<
 
     simd_and_index<simd<int, 4, simd_abi::avx2>,
                    simd<int, 4, simd_abi::avx2>>,
+
+    simd_and_index<simd<float, 8, simd_abi::avx2>,
+                   simd<int, 8, simd_abi::default_abi>>,
 #endif
 
 #ifdef __AVX512F__
@@ -1207,6 +1419,9 @@ typedef ::testing::Types<
 
     simd_and_index<simd<int, 8, simd_abi::avx512>,
                    simd<int, 8, simd_abi::avx512>>,
+
+    simd_and_index<simd<float, 16, simd_abi::avx512>,
+                   simd<int, 16, simd_abi::default_abi>>,
 #endif
 #ifdef __ARM_NEON
     simd_and_index<simd<double, 2, simd_abi::neon>,
@@ -1231,6 +1446,126 @@ typedef ::testing::Types<
 
 INSTANTIATE_TYPED_TEST_CASE_P(S, simd_indirect, simd_indirect_test_types);
 
+// Conversion of values on loads and stores: SIMD values of float from and
+// to arrays of double, and vice versa.
+
+template <typename SI>
+struct simd_conversion: public ::testing::Test {};
+
+TYPED_TEST_CASE_P(simd_conversion);
+
+template <typename S>
+using other_fp = std::conditional_t<std::is_same<typename S::scalar_type, float>::value, double, float>;
+
+TYPED_TEST_P(simd_conversion, copy_from) {
+    using simd = typename TypeParam::simd;
+    using simd_index = typename TypeParam::simd_index;
+
+    constexpr unsigned N = simd::width;
+    using scalar = typename simd::scalar_type;
+    using other = other_fp<simd>;
+    using index = typename simd_index::scalar_type;
+
+    std::minstd_rand rng(1012);
+
+    constexpr std::size_t buflen = 1000;
+
+    for (unsigned i = 0; i<nrounds; ++i) {
+        other array[buflen];
+        index offset[N];
+        scalar test[N];
+
+        fill_random(array, rng);
+        fill_random(offset, rng, 0, (int)(buflen-N));
+
+        for (unsigned j = 0; j<N; ++j) {
+            test[j] = array[offset[0]+j];
+        }
+        simd s = simd_cast<simd>(indirect(array+offset[0], N));
+        EXPECT_TRUE(::testing::indexed_eq_n(N, test, s));
+
+        assign(s, indirect(array+offset[0], N));
+        EXPECT_TRUE(::testing::indexed_eq_n(N, test, s));
+
+        for (unsigned j = 0; j<N; ++j) {
+            test[j] = array[offset[j]];
+        }
+        s = simd_cast<simd>(indirect(array, simd_index(offset), N));
+        EXPECT_TRUE(::testing::indexed_eq_n(N, test, s));
+
+        for (unsigned j = 0; j<N; ++j) {
+            offset[j] = offset[0]+j;
+            test[j] = array[offset[j]];
+        }
+        s = simd_cast<simd>(indirect(array, simd_index(offset), N, index_constraint::contiguous));
+        EXPECT_TRUE(::testing::indexed_eq_n(N, test, s));
+    }
+}
+
+TYPED_TEST_P(simd_conversion, copy_to) {
+    using simd = typename TypeParam::simd;
+    using simd_mask = typename simd::simd_mask;
+
+    constexpr unsigned N = simd::width;
+    using scalar = typename simd::scalar_type;
+    using other = other_fp<simd>;
+
+    std::minstd_rand rng(1012);
+
+    for (unsigned i = 0; i<nrounds; ++i) {
+        scalar values[N];
+        other array[N], test[N];
+        bool mask[N];
+
+        fill_random(values, rng);
+        fill_random(array, rng);
+        fill_random(mask, rng);
+
+        simd s(values);
+        indirect(array, N) = s;
+        for (unsigned j = 0; j<N; ++j) {
+            test[j] = values[j];
+        }
+        EXPECT_TRUE(::testing::indexed_eq_n(N, test, array));
+
+        fill_random(array, rng);
+        for (unsigned j = 0; j<N; ++j) {
+            test[j] = mask[j]? other(values[j]): array[j];
+        }
+        indirect(array, N) = where(simd_mask(mask), s);
+        EXPECT_TRUE(::testing::indexed_eq_n(N, test, array));
+    }
+}
+
+REGISTER_TYPED_TEST_CASE_P(simd_conversion, copy_from, copy_to);
+
+typedef ::testing::Types<
+
+#ifdef __AVX2__
+    simd_and_index<simd<double, 4, simd_abi::avx2>,
+                   simd<int, 4, simd_abi::avx2>>,
+
+    simd_and_index<simd<float, 8, simd_abi::avx2>,
+                   simd<int, 8, simd_abi::default_abi>>,
+#endif
+
+#ifdef __AVX512F__
+    simd_and_index<simd<double, 8, simd_abi::avx512>,
+                   simd<int, 8, simd_abi::avx512>>,
+
+    simd_and_index<simd<float, 16, simd_abi::avx512>,
+                   simd<int, 16, simd_abi::default_abi>>,
+#endif
+
+    simd_and_index<simd<float, 4, simd_abi::generic>,
+                   simd<int, 4, simd_abi::generic>>,
+
+    simd_and_index<simd<double, 8, simd_abi::default_abi>,
+                   simd<int, 8, simd_abi::default_abi>>
+> simd_conversion_test_types;
+
+INSTANTIATE_TYPED_TEST_CASE_P(S, simd_conversion, simd_conversion_test_types);
+
 
 // SIMD cast tests
 
@@ -1275,7 +1610,29 @@ TYPED_TEST_P(simd_casting, cast) {
     }
 }
 
-REGISTER_TYPED_TEST_CASE_P(simd_casting, cast);
+TYPED_TEST_P(simd_casting, mask_cast) {
+    using mask_x = typename TypeParam::simd_first::simd_mask;
+    using mask_y = typename TypeParam::simd_second::simd_mask;
+
+    constexpr unsigned N = TypeParam::simd_first::width;
+
+    std::minstd_rand rng(1013);
+
+    for (unsigned i = 0; i<nrounds; ++i) {
+        bool x[N], y[N];
+
+        fill_random(x, rng);
+        fill_random(y, rng);
+
+        mask_x xm(x);
+        mask_y ym(y);
+
+        EXPECT_TRUE(testing::indexed_eq_n(N, x, simd_cast<mask_y>(xm)));
+        EXPECT_TRUE(testing::indexed_eq_n(N, y, simd_cast<mask_x>(ym)));
+    }
+}
+
+REGISTER_TYPED_TEST_CASE_P(simd_casting, cast, mask_cast);
 
 
 typedef ::testing::Types<
@@ -1299,6 +1656,11 @@ typedef ::testing::Types<
               simd<int, 2, simd_abi::neon>>,
 #endif
 
+#ifdef __AVX512F__
+    simd_pair<simd<double, 8, simd_abi::avx512>,
+              simd<float, 8, simd_abi::default_abi>>,
+#endif
+
     simd_pair<simd<double, 4, simd_abi::default_abi>,
               simd<float, 4, simd_abi::default_abi>>
 > simd_casting_test_types;
@@ -0,0 +1,569 @@
+#include "../gtest.h"
+
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <arbor/arbexcept.hpp>
+#include <arbor/cable_cell.hpp>
+#include <arbor/context.hpp>
+#include <arbor/domain_decomposition.hpp>
+#include <arbor/event_generator.hpp>
+#include <arbor/lif_cell.hpp>
+#include <arbor/load_balance.hpp>
+#include <arbor/recipe.hpp>
+#include <arbor/simulation.hpp>
+#include <arbor/spike_source_cell.hpp>
+
+#include "group_divisions.hpp"
+#include "util/rangeutil.hpp"
+#include "util/span.hpp"
+
+#include "../common_cells.hpp"
+
+using namespace arb;
+
+namespace {
+// A ring of LIF cells driven by a spike source, with gid 0 the source.
+class lif_ring_recipe: public recipe {
+public:
+    lif_ring_recipe(cell_size_type n, float delay): n_(n), delay_(delay) {}
+
+    cell_size_type num_cells() const override { return n_+1; }
+
+    cell_kind get_cell_kind(cell_gid_type gid) const override {
+        return gid? cell_kind::lif: cell_kind::spike_source;
+    }
+
+    std::vector<cell_connection> connections_on(cell_gid_type gid) const override {
+        if (!gid) return {};
+        cell_gid_type src = gid==1? n_: gid-1;
+        std::vector<cell_connection> conns = {cell_connection({src, 0}, {gid, 0}, 1000, delay_)};
+        if (gid==1) conns.push_back(cell_connection({0, 0}, {gid, 0}, 1000, delay_));
+        return conns;
+    }
+
+    util::unique_any get_cell_description(cell_gid_type gid) const override {
+        if (!gid) return spike_source_cell{explicit_schedule({1.})};
+        return lif_cell();
+    }
+
+    cell_size_type num_sources(cell_gid_type) const override { return 1; }
+    cell_size_type num_targets(cell_gid_type) const override { return 1; }
+
+private:
+    cell_size_type n_;
+    float delay_;
+};
+
+void sort_by_source(std::vector<spike>& spikes) {
+    util::sort(spikes, [](const spike& a, const spike& b) {
+        return a.source<b.source || (a.source==b.source && a.time<b.time);
+    });
+}
+
+// Two tiles of n cells, each a spike source driving a chain of LIF cells with
+// a short delay, where the last cell of each tile drives the first LIF cell
+// of the other tile with a long delay.
+class lif_tiles_recipe: public recipe {
+public:
+    lif_tiles_recipe(cell_size_type n, float short_delay, float long_delay):
+        n_(n), short_delay_(short_delay), long_delay_(long_delay) {}
+
+    cell_size_type num_cells() const override { return 2*n_; }
+
+    cell_kind get_cell_kind(cell_gid_type gid) const override {
+        return gid%n_? cell_kind::lif: cell_kind::spike_source;
+    }
+
+    std::vector<cell_connection> connections_on(cell_gid_type gid) const override {
+        auto lid = gid%n_;
+        if (!lid) return {};
+        std::vector<cell_connection> conns = {cell_connection({gid-1, 0}, {gid, 0}, 1000, short_delay_)};
+        if (lid==1) {
+            cell_gid_type src = (gid+n_)%(2*n_)+n_-2;
+            conns.push_back(cell_connection({src, 0}, {gid, 0}, 1000, long_delay_));
+        }
+        return conns;
+    }
+
+    util::unique_any get_cell_description(cell_gid_type gid) const override {
+        if (gid%n_==0) return spike_source_cell{explicit_schedule({1.})};
+        return lif_cell();
+    }
+
+    cell_size_type num_sources(cell_gid_type) const override { return 1; }
+    cell_size_type num_targets(cell_gid_type) const override { return 1; }
+
+private:
+    cell_size_type n_;
+    float short_delay_;
+    float long_delay_;
+};
+
+// A ring of four cable cells with synapses driven by Poisson generators,
+// two LIF cells driven by the first two cable cells and by explicit
+// generators, and a spike source driving the first cable cell.
+class mixed_recipe: public recipe {
+public:
+    explicit mixed_recipe(cell_size_type n_cable = 4): n_cable_(n_cable) {}
+
+    cell_size_type num_cells() const override { return n_cable_+3; }
+
+    cell_kind get_cell_kind(cell_gid_type gid) const override {
+        return gid<n_cable_? cell_kind::cable: gid<n_cable_+2? cell_kind::lif: cell_kind::spike_source;
+    }
+
+    util::unique_any get_cell_description(cell_gid_type gid) const override {
+        switch (get_cell_kind(gid)) {
+        case cell_kind::cable: {
+            auto c = make_cell_ball_and_stick(false);
+            c.decorations.place(mlocation{0, 0.5}, "expsyn");
+            c.decorations.place(mlocation{0, 0.5}, threshold_detector{-10});
+            return cable_cell(c);
+        }
+        case cell_kind::lif:
+            return lif_cell();
+        default:
+            return spike_source_cell{regular_schedule(2, 7)};
+        }
+    }
+
+    std::vector<cell_connection> connections_on(cell_gid_type gid) const override {
+        switch (get_cell_kind(gid)) {
+        case cell_kind::cable: {
+            std::vector<cell_connection> conns = {cell_connection({(gid+n_cable_-1)%n_cable_, 0}, {gid, 0}, 0.05, 4)};
+            if (!gid) conns.push_back(cell_connection({n_cable_+2, 0}, {gid, 0}, 0.1, 4));
+            return conns;
+        }
+        case cell_kind::lif:
+            return {cell_connection({gid-n_cable_, 0}, {gid, 0}, 1000, 4)};
+        default:
+            return {};
+        }
+    }
+
+    std::vector<event_generator> event_generators(cell_gid_type gid) const override {
+        switch (get_cell_kind(gid)) {
+        case cell_kind::cable:
+            return {poisson_generator({gid, 0}, 0.1, 0, 0.5, std::mt19937_64(gid))};
+        case cell_kind::lif:
+            return {explicit_generator(pse_vector{{{gid, 0}, 3, 1000}, {{gid, 0}, 23, 1000}})};
+        default:
+            return {};
+        }
+    }
+
+    cell_size_type num_sources(cell_gid_type) const override { return 1; }
+    cell_size_type num_targets(cell_gid_type) const override { return 1; }
+
+    std::any get_global_properties(cell_kind k) const override {
+        if (k!=cell_kind::cable) return {};
+        cable_cell_global_properties gprop;
+        gprop.default_parameters = neuron_parameter_defaults;
+        return gprop;
+    }
+
+private:
+    cell_size_type n_cable_;
+};
+
+std::vector<spike> run_ring(group_scheduling_kind policy, std::vector<double>* times = nullptr) {
+    lif_ring_recipe rec(20, 3);
+    auto ctx = make_context(proc_allocation(4, -1));
+    partition_hint_map hints = {{cell_kind::lif, partition_hint{3}}};
+    auto decomp = partition_load_balance(rec, ctx, hints);
+
+    simulation sim(rec, decomp, ctx);
+    sim.set_group_scheduling(policy);
+
+    std::vector<spike> spikes;
+    sim.set_global_spike_callback(
+        [&](const std::vector<spike>& s) { util::append(spikes, s); });
+    sim.run(100, 0.025);
+
+    if (times) *times = sim.group_advance_times();
+    sort_by_source(spikes);
+    return spikes;
+}
+
+// Run the ring with the given pipeline depth, in calls to run() up to each
+// of the supplied end times.
+std::vector<spike> run_ring_pipelined(unsigned depth, std::vector<time_type> tfinal, pipeline_stats* stats = nullptr) {
+    lif_ring_recipe rec(20, 3);
+    auto ctx = make_context(proc_allocation(4, -1));
+    auto decomp = partition_load_balance(rec, ctx);
+
+    simulation sim(rec, decomp, ctx);
+    sim.set_pipeline_depth(depth);
+
+    std::vector<spike> spikes;
+    sim.set_global_spike_callback(
+        [&](const std::vector<spike>& s) { util::append(spikes, s); });
+    for (auto t: tfinal) {
+        EXPECT_EQ(t, sim.run(t, 0.025));
+    }
+
+    if (stats) *stats = sim.get_pipeline_stats();
+    sort_by_source(spikes);
+    return spikes;
+}
+} // anonymous namespace
+
+TEST(simulation, balanced_group_divisions) {
+    using divs = std::vector<cell_size_type>;
+
+    EXPECT_EQ((divs{0, 0}), balanced_group_divisions({}, 4));
+    EXPECT_EQ((divs{0, 2, 4, 6, 8}), balanced_group_divisions(std::vector<double>(8, 0.), 4));
+    EXPECT_EQ((divs{0, 2, 4, 6, 8}), balanced_group_divisions(std::vector<double>(8, 1.), 4));
+    EXPECT_EQ((divs{0, 1, 2, 3, 4}), balanced_group_divisions({10, 1, 1, 1}, 4));
+    EXPECT_EQ((divs{0, 3, 4}), balanced_group_divisions({1, 1, 1, 3}, 2));
+    EXPECT_EQ((divs{0, 1, 2, 3}), balanced_group_divisions({1, 1, 2}, 4));
+}
+
+TEST(simulation, group_scheduling) {
+    std::vector<double> times;
+    auto expected = run_ring(group_scheduling_kind::each, &times);
+    EXPECT_FALSE(expected.empty());
+
+    // One spike source group and seven LIF groups of at most three cells.
+    ASSERT_EQ(8u, times.size());
+    for (double t: times) {
+        EXPECT_GT(t, 0.);
+    }
+
+    for (auto policy: {group_scheduling_kind::balanced, group_scheduling_kind::largest_first}) {
+        auto spikes = run_ring(policy);
+        ASSERT_EQ(expected.size(), spikes.size());
+        for (unsigned i = 0; i<spikes.size(); ++i) {
+            EXPECT_EQ(expected[i].source, spikes[i].source);
+            EXPECT_EQ(expected[i].time, spikes[i].time);
+        }
+    }
+}
+
+TEST(simulation, pipeline_depth) {
+    auto expected = run_ring_pipelined(2, {100});
+    EXPECT_FALSE(expected.empty());
+
+    for (unsigned depth: {1u, 2u, 3u, 5u}) {
+        SCOPED_TRACE(depth);
+        pipeline_stats stats;
+        auto spikes = run_ring_pipelined(depth, {100}, &stats);
+
+        ASSERT_EQ(expected.size(), spikes.size());
+        for (unsigned i = 0; i<spikes.size(); ++i) {
+            EXPECT_EQ(expected[i].source, spikes[i].source);
+            EXPECT_EQ(expected[i].time, spikes[i].time);
+        }
+
+        EXPECT_EQ(depth, stats.depth);
+        EXPECT_DOUBLE_EQ(3./depth, stats.epoch_length);
+        EXPECT_EQ(std::size_t(std::ceil(100/stats.epoch_length)), stats.num_epochs);
+        EXPECT_GT(stats.communication_time, 0.);
+        EXPECT_GE(stats.overlap(), 0.);
+        EXPECT_LE(stats.overlap(), 1.);
+
+        // Events in flight are carried over between calls to run().
+        auto split = run_ring_pipelined(depth, {10.3, 64, 64, 100});
+        ASSERT_EQ(expected.size(), split.size());
+        for (unsigned i = 0; i<split.size(); ++i) {
+            EXPECT_EQ(expected[i].source, split[i].source);
+            EXPECT_EQ(expected[i].time, split[i].time);
+        }
+    }
+
+    lif_ring_recipe rec(2, 3);
+    auto ctx = make_context();
+    simulation sim(rec, partition_load_balance(rec, ctx), ctx);
+    EXPECT_THROW(sim.set_pipeline_depth(0), arbor_exception);
+}
+
+TEST(simulation, delay_classes) {
+    const cell_size_type n = 10;
+    lif_tiles_recipe rec(n, 1, 20);
+
+    // Spikes of the first tile, and pipeline stats.
+    auto run_tiles = [&](const context& ctx, pipeline_stats& stats, spike_exchange_kind kind = spike_exchange_kind::gather) {
+        simulation sim(rec, partition_load_balance(rec, ctx), ctx);
+        sim.set_spike_exchange(kind);
+
+        std::vector<spike> spikes;
+        sim.set_local_spike_callback(
+            [&](const std::vector<spike>& s) {
+                for (auto& spk: s) {
+                    if (spk.source.gid<n) spikes.push_back(spk);
+                }
+            });
+        sim.run(150, 0.025);
+        stats = sim.get_pipeline_stats();
+        sort_by_source(spikes);
+        return spikes;
+    };
+
+    // On a single domain, all spikes are exchanged each epoch.
+    pipeline_stats stats;
+    auto expected = run_tiles(make_context(proc_allocation(2, -1)), stats);
+    EXPECT_EQ(stats.num_epochs, stats.num_exchanges);
+
+    // Several passes over the long connections.
+    ASSERT_LT(3*n, expected.size());
+
+    // In a dry run of two domains, the second tile is on another domain and
+    // the spikes of the first tile are exchanged every 40-2 epochs.
+    auto ctx = make_context(proc_allocation(2, -1), dry_run_info(2, n));
+    for (auto kind: {spike_exchange_kind::gather, spike_exchange_kind::sparse}) {
+        auto spikes = run_tiles(ctx, stats, kind);
+        EXPECT_EQ(300u, stats.num_epochs);
+        EXPECT_EQ(8u, stats.num_exchanges);
+
+        ASSERT_EQ(expected.size(), spikes.size());
+        for (unsigned i = 0; i<spikes.size(); ++i) {
+            EXPECT_EQ(expected[i].source, spikes[i].source);
+            EXPECT_EQ(expected[i].time, spikes[i].time);
+        }
+    }
+}
+
+TEST(simulation, sparse_exchange) {
+    const cell_size_type n = 10;
+    lif_tiles_recipe rec(n, 1, 20);
+    auto ctx = make_context(proc_allocation(2, -1), dry_run_info(2, n));
+
+    auto run_tiles = [&](spike_exchange_kind kind, std::size_t& num_spikes) {
+        simulation sim(rec, partition_load_balance(rec, ctx), ctx);
+        sim.set_spike_exchange(kind);
+        sim.run(150, 0.025);
+        num_spikes = sim.num_spikes();
+        return sim.get_pipeline_stats();
+    };
+
+    std::size_t gather_spikes, sparse_spikes;
+    auto gather = run_tiles(spike_exchange_kind::gather, gather_spikes);
+    auto sparse = run_tiles(spike_exchange_kind::sparse, sparse_spikes);
+
+    // Only the spikes of the last cell of each tile leave the domain, and
+    // the domain receives only those of the other tile.
+    EXPECT_EQ(gather_spikes, sparse_spikes);
+    EXPECT_GT(gather_spikes, 0u);
+    EXPECT_EQ(gather_spikes/2*sizeof(spike), gather.bytes_sent);
+    EXPECT_EQ(gather_spikes/2*sizeof(spike), gather.bytes_received);
+    EXPECT_GT(sparse.bytes_received, 0u);
+    EXPECT_LT(sparse.bytes_received*n/2, gather.bytes_received);
+    EXPECT_EQ(sparse.bytes_sent, sparse.bytes_received);
+}
+
+TEST(simulation, spike_encoding) {
+    const cell_size_type n = 10;
+    lif_tiles_recipe rec(n, 1, 20);
+    auto ctx = make_context(proc_allocation(2, -1), dry_run_info(2, n));
+
+    auto run_tiles = [&](spike_encoding_kind kind, time_type quantum, std::vector<spike>& spikes) {
+        simulation sim(rec, partition_load_balance(rec, ctx), ctx);
+        sim.set_spike_encoding(kind, quantum);
+        sim.set_global_spike_callback([&](const std::vector<spike>& s) { util::append(spikes, s); });
+        sim.run(150, 0.025);
+        return sim.get_pipeline_stats();
+    };
+
+    // Spike times are exact without a time quantum.
+    std::vector<spike> full_spikes, compact_spikes;
+    auto full = run_tiles(spike_encoding_kind::full, 0, full_spikes);
+    auto compact = run_tiles(spike_encoding_kind::compact, 0, compact_spikes);
+
+    EXPECT_FALSE(full_spikes.empty());
+    EXPECT_EQ(full_spikes, compact_spikes);
+    EXPECT_LT(compact.bytes_received, full.bytes_received);
+    EXPECT_EQ(compact.bytes_sent, compact.bytes_received);
+
+    // With a time quantum much smaller than dt, the spike times are rounded
+    // but the dynamics are unchanged.
+    std::vector<spike> quantised_spikes;
+    auto quantised = run_tiles(spike_encoding_kind::compact, 1e-6, quantised_spikes);
+
+    ASSERT_EQ(full_spikes.size(), quantised_spikes.size());
+    for (std::size_t i = 0; i<full_spikes.size(); ++i) {
+        EXPECT_EQ(full_spikes[i].source, quantised_spikes[i].source);
+        EXPECT_NEAR(full_spikes[i].time, quantised_spikes[i].time, 1e-5);
+    }
+    EXPECT_LT(quantised.bytes_received, compact.bytes_received);
+
+    EXPECT_THROW(simulation(rec, partition_load_balance(rec, ctx), ctx).set_spike_encoding(spike_encoding_kind::compact, -1), arbor_exception);
+}
+
+TEST(simulation, quantize_connections) {
+    const cell_size_type n = 10;
+    lif_tiles_recipe rec(n, 1, 20);
+    auto ctx = make_context(proc_allocation(2, -1), dry_run_info(2, n));
+
+    auto run_tiles = [&](bool weights, time_type quantum) {
+        std::vector<spike> spikes;
+        simulation sim(rec, partition_load_balance(rec, ctx), ctx);
+        if (weights) sim.quantize_connection_weights();
+        if (quantum>0) sim.quantize_connection_delays(quantum);
+        sim.set_global_spike_callback([&](const std::vector<spike>& s) { util::append(spikes, s); });
+        sim.run(150, 0.025);
+        sort_by_source(spikes);
+        return spikes;
+    };
+
+    // The weights and delays of the recipe are represented exactly.
+    auto exact = run_tiles(false, 0);
+    EXPECT_FALSE(exact.empty());
+    EXPECT_EQ(exact, run_tiles(true, 0));
+    EXPECT_EQ(exact, run_tiles(false, 0.025));
+    EXPECT_EQ(exact, run_tiles(true, 0.025));
+
+    // Delays rounded up to multiples of 0.3 ms delay the spikes of the
+    // driven cells: each source spikes no more often, and no earlier.
+    auto rounded = run_tiles(true, 0.3);
+    EXPECT_LT(rounded.size(), exact.size());
+    for (std::size_t i = 0, j = 0; i<rounded.size(); ++i, ++j) {
+        while (j<exact.size() && exact[j].source<rounded[i].source) ++j;
+        ASSERT_LT(j, exact.size());
+        EXPECT_EQ(exact[j].source, rounded[i].source);
+        EXPECT_LE(exact[j].time, rounded[i].time);
+    }
+
+    simulation sim(rec, partition_load_balance(rec, ctx), ctx);
+    EXPECT_THROW(sim.quantize_connection_delays(0), arbor_exception);
+    EXPECT_THROW(sim.quantize_connection_delays(1e-4), arbor_exception);
+}
+
+TEST(simulation, checkpoint) {
+    mixed_recipe rec;
+    auto ctx = make_context(proc_allocation(2, -1));
+    auto decomp = partition_load_balance(rec, ctx);
+
+    // Spikes after t_split of a simulation run to t_split and then to t_end.
+    const time_type t_split = 31.3, t_end = 80, dt = 0.025;
+    auto continue_run = [&](simulation& sim) {
+        std::vector<spike> spikes;
+        sim.set_global_spike_callback([&](const std::vector<spike>& s) { util::append(spikes, s); });
+        sim.run(t_end, dt);
+        sort_by_source(spikes);
+        return spikes;
+    };
+
+    simulation sim(rec, decomp, ctx);
+    sim.run(t_split, dt);
+
+    std::stringstream checkpoint;
+    sim.checkpoint(checkpoint);
+    std::string state = checkpoint.str();
+
+    auto expected = continue_run(sim);
+    ASSERT_FALSE(expected.empty());
+    for (cell_gid_type gid = 0; gid<rec.num_cells(); ++gid) {
+        SCOPED_TRACE(gid);
+        EXPECT_TRUE(util::any_of(expected, [gid](const spike& s) { return s.source.gid==gid; }));
+    }
+
+    // Restore into a new simulation, and into one that has run past t_split.
+    {
+        simulation restored(rec, decomp, ctx);
+        std::istringstream in(state);
+        restored.restore(in);
+        EXPECT_EQ(expected, continue_run(restored));
+    }
+    {
+        simulation restored(rec, decomp, ctx);
+        restored.run(50, dt);
+        std::istringstream in(state);
+        restored.restore(in);
+        EXPECT_EQ(expected, continue_run(restored));
+    }
+
+    // Checkpoints are checked against the simulation.
+    mixed_recipe other_rec(5);
+    simulation other(other_rec, partition_load_balance(other_rec, ctx), ctx);
+    std::istringstream in(state);
+    EXPECT_THROW(other.restore(in), bad_checkpoint);
+
+    std::istringstream truncated(state.substr(0, state.size()/2));
+    EXPECT_THROW(sim.restore(truncated), bad_checkpoint);
+
+    std::istringstream garbage("not a checkpoint");
+    EXPECT_THROW(sim.restore(garbage), bad_checkpoint);
+}
+
+TEST(simulation, parallel_setup) {
+    // Construction with one thread and with several gives the same model.
+    mixed_recipe rec(12);
+    auto run = [&](unsigned num_threads) {
+        auto ctx = make_context(proc_allocation(num_threads, -1));
+        simulation sim(rec, partition_load_balance(rec, ctx), ctx);
+
+        std::vector<std::string> phases;
+        for (auto& p: sim.setup_profile()) {
+            EXPECT_LE(0., p.time);
+            phases.push_back(p.name);
+        }
+        EXPECT_EQ((std::vector<std::string>{"communicator", "event_generators", "cell_groups"}), phases);
+
+        std::vector<spike> spikes;
+        sim.set_global_spike_callback([&](const std::vector<spike>& s) { util::append(spikes, s); });
+        sim.run(40, 0.025);
+        sort_by_source(spikes);
+        return spikes;
+    };
+
+    auto expected = run(1);
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(expected, run(4));
+}
+
+TEST(simulation, large_connection_table) {
+    // The communicator gathers the connections of the cells in chunks before
+    // it builds the connection table: here each LIF cell is driven by the
+    // spike source, gid 0, and a further connection from gid 1.
+    struct star_recipe: lif_ring_recipe {
+        using lif_ring_recipe::lif_ring_recipe;
+        std::vector<cell_connection> connections_on(cell_gid_type gid) const override {
+            if (!gid) return {};
+            return {cell_connection({0, 0}, {gid, 0}, 1000, 1), cell_connection({1, 0}, {gid, 0}, 0, 2)};
+        }
+    };
+
+    const cell_size_type n = 2500;
+    star_recipe rec(n, 1);
+    auto ctx = make_context(proc_allocation(2, -1));
+    simulation sim(rec, partition_load_balance(rec, ctx), ctx);
+
+    std::vector<unsigned> spike_count(n+1);
+    sim.set_global_spike_callback([&](const std::vector<spike>& spikes) {
+        for (auto& s: spikes) ++spike_count[s.source.gid];
+    });
+    sim.run(5, 0.025);
+    EXPECT_EQ(std::vector<unsigned>(n+1, 1), spike_count);
+
+    // An invalid connection of a cell with a high index is reported.
+    struct bad_recipe: star_recipe {
+        using star_recipe::star_recipe;
+        std::vector<cell_connection> connections_on(cell_gid_type gid) const override {
+            auto conns = star_recipe::connections_on(gid);
+            if (gid==2100) conns.push_back(cell_connection({5000, 0}, {gid, 0}, 1, 1));
+            return conns;
+        }
+    };
+    bad_recipe bad_rec(n, 1);
+    EXPECT_THROW(simulation(bad_rec, partition_load_balance(bad_rec, ctx), ctx), bad_connection_source_gid);
+
+    // The connections of each cell are queried once.
+    struct counting_recipe: star_recipe {
+        using star_recipe::star_recipe;
+        mutable std::vector<std::atomic<unsigned>> queries = std::vector<std::atomic<unsigned>>(num_cells());
+        std::vector<cell_connection> connections_on(cell_gid_type gid) const override {
+            ++queries[gid];
+            return star_recipe::connections_on(gid);
+        }
+    };
+    counting_recipe counting_rec(n, 1);
+    simulation(counting_rec, partition_load_balance(counting_rec, ctx), ctx);
+    for (auto gid: util::make_span(counting_rec.num_cells())) {
+        EXPECT_EQ(1u, counting_rec.queries[gid].load()) << "gid " << gid;
+    }
+}
@@ -0,0 +1,86 @@
+#include "../gtest.h"
+
+#include <cmath>
+#include <vector>
+
+#include <arbor/spike.hpp>
+
+#include "communication/gathered_vector.hpp"
+#include "communication/spike_codec.hpp"
+
+using namespace arb;
+using svec = std::vector<spike>;
+
+TEST(spike_codec, exact) {
+    svec spikes = {
+        {{0u, 0u}, 1.25},
+        {{0u, 1u}, 0.5},
+        {{3u, 0u}, 7.125},
+        {{200u, 2u}, 0.},
+        {{100000u, 0u}, 1e6},
+    };
+
+    std::vector<char> buf;
+    encode_spikes(spikes, 0, buf);
+    EXPECT_EQ(0., encoded_spike_quantum(buf.data()));
+    EXPECT_LT(buf.size(), spikes.size()*sizeof(spike));
+
+    svec decoded;
+    decode_spikes(buf.data(), buf.data()+buf.size(), decoded);
+    EXPECT_EQ(spikes, decoded);
+}
+
+TEST(spike_codec, quantised) {
+    const time_type quantum = 0.001;
+
+    // Times within 2^16 quanta of the earliest spike take 2 bytes.
+    svec spikes;
+    for (unsigned i = 0; i<100; ++i) {
+        spikes.push_back({{i, 0u}, 10+0.0173*i});
+    }
+
+    std::vector<char> buf;
+    encode_spikes(spikes, quantum, buf);
+    EXPECT_EQ(quantum, encoded_spike_quantum(buf.data()));
+    EXPECT_LT(buf.size(), spikes.size()*4+32);
+
+    svec decoded;
+    decode_spikes(buf.data(), buf.data()+buf.size(), decoded);
+    ASSERT_EQ(spikes.size(), decoded.size());
+    for (unsigned i = 0; i<spikes.size(); ++i) {
+        EXPECT_EQ(spikes[i].source, decoded[i].source);
+        EXPECT_LE(std::abs(spikes[i].time-decoded[i].time), quantum/2*(1+1e-9));
+    }
+    EXPECT_EQ(spikes.front().time, decoded.front().time);
+
+    // Times spanning more quanta take 4 bytes, or are sent exactly if
+    // they span more than 2^32 quanta.
+    for (time_type span: {1e3, 1e7}) {
+        svec wide = {{{0u, 0u}, 0.}, {{1u, 0u}, span}};
+        std::vector<char> wide_buf;
+        encode_spikes(wide, quantum, wide_buf);
+        EXPECT_EQ(span<1e6? quantum: 0., encoded_spike_quantum(wide_buf.data()));
+
+        svec wide_decoded;
+        decode_spikes(wide_buf.data(), wide_buf.data()+wide_buf.size(), wide_decoded);
+        EXPECT_EQ(wide, wide_decoded);
+    }
+}
+
+TEST(spike_codec, gathered) {
+    svec a = {{{1u, 0u}, 1.}, {{2u, 0u}, 2.}};
+    svec b = {};
+    svec c = {{{7u, 1u}, 3.}};
+
+    std::vector<char> buf;
+    std::vector<unsigned> partition = {0};
+    for (auto* spikes: {&a, &b, &c}) {
+        encode_spikes(*spikes, 0.01, buf);
+        partition.push_back(buf.size());
+    }
+    EXPECT_EQ(partition[1], partition[2]);
+
+    auto decoded = decode_gathered_spikes(gathered_vector<char>(std::move(buf), std::move(partition)));
+    EXPECT_EQ((svec{{{1u, 0u}, 1.}, {{2u, 0u}, 2.}, {{7u, 1u}, 3.}}), decoded.values());
+    EXPECT_EQ((std::vector<unsigned>{0u, 2u, 2u, 3u}), decoded.partition());
+}
@@ -68,7 +68,7 @@ TEST(task_system, test_copy) {
     ftor f;
     ts.async(f);
 
-    // Copy into new ftor and move ftor into a task (std::function<void()>)
+    // Copy into new ftor and move ftor into a task node
     EXPECT_EQ(1, nmove);
     EXPECT_EQ(1, ncopy);
     reset();
@@ -80,7 +80,7 @@ TEST(task_system, test_move) {
     ftor f;
     ts.async(std::move(f));
 
-    // Move into new ftor and move ftor into a task (std::function<void()>)
+    // Move into new ftor and move ftor into a task node
     EXPECT_LE(nmove, 2);
     EXPECT_LE(ncopy, 1);
     reset();
@@ -118,7 +118,7 @@ TEST(task_group, test_copy) {
     g.run(f);
     g.wait();
 
-    // Copy into "wrap" and move wrap into a task (std::function<void()>)
+    // Copy into "wrap" and move wrap into a task node
     EXPECT_EQ(1, nmove);
     EXPECT_EQ(1, ncopy);
     reset();
@@ -214,3 +214,122 @@ TEST(enumerable_thread_specific, test) {
 
     EXPECT_EQ(100000, sum);
 }
+
+TEST(task_node, storage) {
+    // Small callables are stored in the node, large ones on the heap: both
+    // are run and destroyed exactly once, and nodes are reused by a pool.
+    struct counted {
+        int* runs;
+        int* live;
+        char payload[8];
+
+        counted(int* r, int* l): runs(r), live(l) { ++*live; }
+        counted(const counted& c): runs(c.runs), live(c.live) { ++*live; }
+        ~counted() { --*live; }
+        void operator()() { ++*runs; }
+    };
+    struct large: counted {
+        using counted::counted;
+        char more[2*task_node::inline_size];
+    };
+
+    int runs = 0, live = 0;
+    task_pool pool;
+    void* first = nullptr;
+    {
+        auto t = task_node::make(counted(&runs, &live), &pool);
+        first = t.get();
+        (*t)();
+        EXPECT_EQ(1, live);
+    }
+    {
+        auto t = task_node::make(large(&runs, &live), &pool);
+        EXPECT_EQ(first, (void*)t.get());
+        (*t)();
+        EXPECT_EQ(1, live);
+    }
+    {
+        auto t = task_node::make(counted(&runs, &live));
+        (*t)();
+    }
+    EXPECT_EQ(3, runs);
+    EXPECT_EQ(0, live);
+}
+
+TEST(work_stealing_deque, push_pop_steal) {
+    // Small initial capacity to exercise growth.
+    work_stealing_deque q(2);
+    EXPECT_TRUE(q.empty());
+    EXPECT_FALSE(q.pop());
+    EXPECT_FALSE(q.steal());
+
+    std::vector<int> order;
+    for (int i = 0; i<10; ++i) {
+        q.push(task_node::make([&order, i] { order.push_back(i); }));
+    }
+    EXPECT_FALSE(q.empty());
+
+    // Owner pops most recent first; thieves take oldest first.
+    (*q.pop())();
+    (*q.steal())();
+    (*q.steal())();
+    (*q.pop())();
+    EXPECT_EQ((std::vector<int>{9, 0, 1, 8}), order);
+
+    int remaining = 0;
+    while (auto t = q.pop()) ++remaining;
+    EXPECT_EQ(6, remaining);
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(work_stealing_deque, concurrent_steal) {
+    const int n = 100000;
+    const int nthieves = 3;
+    work_stealing_deque q(16);
+
+    std::atomic<int> count{0};
+    std::atomic<bool> done{false};
+    std::vector<std::thread> thieves;
+    for (int i = 0; i<nthieves; ++i) {
+        thieves.emplace_back([&] {
+            while (!done) {
+                if (auto t = q.steal()) (*t)();
+            }
+        });
+    }
+
+    for (int i = 0; i<n; ++i) {
+        q.push(task_node::make([&count] { ++count; }));
+        if (i%3==0) {
+            if (auto t = q.pop()) (*t)();
+        }
+    }
+    while (auto t = q.pop()) (*t)();
+    while (count<n) {}
+    done = true;
+    for (auto& t: thieves) t.join();
+
+    EXPECT_EQ(n, count);
+}
+
+TEST(task_group, parallel_for_grain_size) {
+    task_system ts(4);
+    for (int grain: {1, 3, 64, 1000}) {
+        for (int n: {0, 1, 7, 100, 5000}) {
+            std::vector<int> v(n, 0);
+            parallel_for::apply(0, n, grain, &ts, [&](int i) { ++v[i]; });
+            for (int i = 0; i<n; i++) {
+                EXPECT_EQ(1, v[i]);
+            }
+        }
+    }
+}
+
+TEST(task_group, parallel_for_offset_range) {
+    task_system ts(3);
+    std::vector<int> v(100, -1);
+    parallel_for::apply(37, 91, 4, &ts, [&](int i) { v[i] = i; });
+    for (int i = 0; i<100; ++i) {
+        EXPECT_EQ(i>=37 && i<91? i: -1, v[i]);
+    }
+}
@@ -37,10 +37,12 @@
 #include "mechanisms/write_multiple_eX.hpp"
 #include "mechanisms/write_eX.hpp"
 #include "mechanisms/read_cai_init.hpp"
+#include "mechanisms/table_test.hpp"
 #include "mechanisms/write_cai_breakpoint.hpp"
 #include "mechanisms/test_ca.hpp"
 #include "mechanisms/test_kin1.hpp"
 #include "mechanisms/test_kinlva.hpp"
+#include "mechanisms/mixed/hh.hpp"
 
 #include "../gtest.h"
 
@@ -94,6 +96,8 @@ mechanism_catalogue make_unit_test_catalogue(const mechanism_catalogue& from) {
     ADD_MECH(cat, write_eX)
     ADD_MECH(cat, read_cai_init)
     ADD_MECH(cat, write_cai_breakpoint)
+    ADD_MECH(cat, table_test)
+    ADD_MECH(cat, hh_mixed)
 
     return cat;
 }
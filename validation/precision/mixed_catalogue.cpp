@@ -0,0 +1,41 @@
+#include <arbor/mechcat.hpp>
+
+#ifdef ARB_GPU_ENABLED
+#include "backends/gpu/fvm.hpp"
+#endif
+#include "backends/multicore/fvm.hpp"
+
+#include "mechanisms/exp2syn.hpp"
+#include "mechanisms/expsyn.hpp"
+#include "mechanisms/hh.hpp"
+#include "mechanisms/kamt.hpp"
+#include "mechanisms/kdrmt.hpp"
+#include "mechanisms/nax.hpp"
+
+#include "mixed_catalogue.hpp"
+
+#ifndef ARB_GPU_ENABLED
+#define ADD_MECH(c, x)\
+c.add(#x, mixed::mechanism_##x##_info());\
+c.register_implementation(#x, mixed::make_mechanism_##x<multicore::backend>());
+#else
+#define ADD_MECH(c, x)\
+c.add(#x, mixed::mechanism_##x##_info());\
+c.register_implementation(#x, mixed::make_mechanism_##x<multicore::backend>());\
+c.register_implementation(#x, mixed::make_mechanism_##x<gpu::backend>());
+#endif
+
+using namespace arb;
+
+mechanism_catalogue make_mixed_catalogue() {
+    mechanism_catalogue cat(global_default_catalogue());
+
+    ADD_MECH(cat, exp2syn_mixed)
+    ADD_MECH(cat, expsyn_mixed)
+    ADD_MECH(cat, hh_mixed)
+    ADD_MECH(cat, kamt_mixed)
+    ADD_MECH(cat, kdrmt_mixed)
+    ADD_MECH(cat, nax_mixed)
+
+    return cat;
+}
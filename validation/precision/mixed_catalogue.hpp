@@ -0,0 +1,8 @@
+#pragma once
+
+#include <arbor/mechcat.hpp>
+
+// The default catalogue, with the addition of mixed precision implementations
+// of default mechanisms, named with the suffix _mixed.
+
+arb::mechanism_catalogue make_mixed_catalogue();
@@ -0,0 +1,279 @@
+// Compare a simulation of a network of cells with mechanisms generated by
+// modcc in mixed precision against the same simulation with the double
+// precision mechanisms, and report the differences in the membrane voltage
+// traces and in spike times.
+
+#include <algorithm>
+#include <any>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <arbor/cable_cell.hpp>
+#include <arbor/context.hpp>
+#include <arbor/event_generator.hpp>
+#include <arbor/load_balance.hpp>
+#include <arbor/mechcat.hpp>
+#include <arbor/morph/morphology.hpp>
+#include <arbor/morph/segment_tree.hpp>
+#include <arbor/recipe.hpp>
+#include <arbor/simple_sampler.hpp>
+#include <arbor/simulation.hpp>
+
+#include <arborenv/concurrency.hpp>
+
+#include <tinyopt/tinyopt.h>
+
+#include "mixed_catalogue.hpp"
+
+struct options {
+    unsigned n_cell = 32;
+    double t_end = 200;
+    double dt = 0.025;
+    double sample_dt = 0.1;
+    unsigned n_thread = 0;
+    double max_v_error = -1;     // Negative: no tolerance check.
+    double max_spike_error = -1; // Negative: no tolerance check.
+};
+
+options parse_options(int argc, char** argv);
+
+using arb::cell_gid_type;
+using arb::cell_size_type;
+
+// Membrane voltage probes on each cell: centre of the soma, end of a dendrite.
+constexpr unsigned n_probe = 2;
+
+// A ring of cells, each with an hh soma and two dendrites with nax, kdrmt
+// and kamt channels. Each cell is driven by a current clamp with a
+// cell-dependent amplitude, by Poisson input on an exp2syn synapse, and by
+// the spikes of its predecessor in the ring on an expsyn synapse.
+//
+// If mixed is true, the mixed precision versions of these mechanisms are
+// used; pas is used in double precision in both cases, as it has no state.
+
+class precision_recipe: public arb::recipe {
+public:
+    precision_recipe(unsigned n_cell, bool mixed, const arb::mechanism_catalogue& cat):
+        n_cell_(n_cell), suffix_(mixed? "_mixed": "")
+    {
+        gprop_.default_parameters = arb::neuron_parameter_defaults;
+        gprop_.catalogue = &cat;
+
+        arb::segment_tree tree;
+        tree.append(arb::mnpos, {0, 0, 0, 6.3}, {12.6, 0, 0, 6.3}, 1);
+        tree.append(0, {12.6, 0, 0, 0.5}, {312.6, 0, 0, 0.3}, 3);
+        tree.append(0, {12.6, 0, 0, 0.5}, {12.6, 300, 0, 0.3}, 3);
+        morpho_ = arb::morphology(tree);
+    }
+
+    cell_size_type num_cells() const override { return n_cell_; }
+    cell_size_type num_sources(cell_gid_type) const override { return 1; }
+    cell_size_type num_targets(cell_gid_type) const override { return 2; }
+
+    arb::cell_kind get_cell_kind(cell_gid_type) const override {
+        return arb::cell_kind::cable;
+    }
+
+    std::any get_global_properties(arb::cell_kind) const override {
+        return gprop_;
+    }
+
+    arb::util::unique_any get_cell_description(cell_gid_type gid) const override {
+        using arb::reg::tagged;
+
+        arb::label_dict dict;
+        dict.set("soma", tagged(1));
+        dict.set("dend", tagged(3));
+
+        arb::decor decor;
+        decor.paint("\"soma\"", mech("hh"));
+        decor.paint("\"dend\"", "pas");
+        decor.paint("\"dend\"", mech("nax"));
+        decor.paint("\"dend\"", mech("kdrmt"));
+        decor.paint("\"dend\"", mech("kamt"));
+
+        decor.place(arb::mlocation{0, 0.5}, arb::i_clamp{5, 150, 0.05+0.15*(gid%7)/6.});
+        decor.place(arb::mlocation{0, 0.5}, arb::threshold_detector{-10});
+        decor.place(arb::mlocation{1, 0.3}, mech("expsyn"));
+        decor.place(arb::mlocation{2, 0.7}, mech("exp2syn"));
+        decor.set_default(arb::cv_policy_fixed_per_branch(20));
+
+        return arb::cable_cell(morpho_, dict, decor);
+    }
+
+    std::vector<arb::cell_connection> connections_on(cell_gid_type gid) const override {
+        cell_gid_type src = (gid+n_cell_-1)%n_cell_;
+        return {arb::cell_connection({src, 0}, {gid, 0}, 0.05, 5)};
+    }
+
+    std::vector<arb::event_generator> event_generators(cell_gid_type gid) const override {
+        std::mt19937_64 rng(gid);
+        return {arb::poisson_generator({gid, 1}, 0.01, 0, 0.05, rng)};
+    }
+
+    std::vector<arb::probe_info> get_probes(cell_gid_type) const override {
+        return {
+            arb::cable_probe_membrane_voltage{arb::mlocation{0, 0.5}},
+            arb::cable_probe_membrane_voltage{arb::mlocation{1, 1}}
+        };
+    }
+
+private:
+    cell_size_type n_cell_;
+    std::string suffix_;
+    arb::morphology morpho_;
+    arb::cable_cell_global_properties gprop_;
+
+    std::string mech(const std::string& name) const { return name+suffix_; }
+};
+
+struct run_result {
+    std::vector<arb::trace_vector<double>> traces; // By gid and probe index.
+    std::vector<std::vector<double>> spike_times;   // By gid.
+};
+
+run_result run(const options& opt, bool mixed, const arb::mechanism_catalogue& cat) {
+    arb::proc_allocation resources;
+    resources.num_threads = opt.n_thread? opt.n_thread: arbenv::thread_concurrency();
+    auto context = arb::make_context(resources);
+
+    precision_recipe rec(opt.n_cell, mixed, cat);
+    arb::simulation sim(rec, arb::partition_load_balance(rec, context), context);
+
+    run_result result;
+    result.traces.resize(opt.n_cell*n_probe);
+    result.spike_times.resize(opt.n_cell);
+
+    for (cell_gid_type gid = 0; gid<opt.n_cell; ++gid) {
+        for (unsigned p = 0; p<n_probe; ++p) {
+            sim.add_sampler(arb::one_probe({gid, p}), arb::regular_schedule(opt.sample_dt),
+                arb::make_simple_sampler(result.traces[gid*n_probe+p]));
+        }
+    }
+
+    sim.set_global_spike_callback(
+        [&result](const std::vector<arb::spike>& spikes) {
+            for (auto& s: spikes) {
+                result.spike_times[s.source.gid].push_back(s.time);
+            }
+        });
+
+    sim.run(opt.t_end, opt.dt);
+
+    for (auto& times: result.spike_times) {
+        std::sort(times.begin(), times.end());
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    try {
+        options opt = parse_options(argc, argv);
+        auto cat = make_mixed_catalogue();
+
+        auto ref = run(opt, false, cat);
+        auto mix = run(opt, true, cat);
+
+        // Voltage errors, over all samples of all probes.
+
+        double max_v_error = 0, sum_sq = 0;
+        std::size_t n_sample = 0;
+        for (std::size_t k = 0; k<ref.traces.size(); ++k) {
+            auto& a = ref.traces[k].get(0);
+            auto& b = mix.traces[k].get(0);
+            if (a.size()!=b.size()) {
+                throw std::runtime_error("sample count mismatch for probe "+std::to_string(k));
+            }
+            for (std::size_t i = 0; i<a.size(); ++i) {
+                double err = std::fabs(a[i].v-b[i].v);
+                max_v_error = std::max(max_v_error, err);
+                sum_sq += err*err;
+                ++n_sample;
+            }
+        }
+        double rms_v_error = n_sample? std::sqrt(sum_sq/n_sample): 0;
+
+        // Spike time errors, between spikes of the same cell in order, and
+        // the number of cells for which the spike counts differ.
+
+        std::size_t n_spike_ref = 0, n_spike_mix = 0;
+        unsigned count_mismatch = 0;
+        double max_spike_error = 0;
+        for (cell_gid_type gid = 0; gid<opt.n_cell; ++gid) {
+            auto& a = ref.spike_times[gid];
+            auto& b = mix.spike_times[gid];
+            n_spike_ref += a.size();
+            n_spike_mix += b.size();
+            count_mismatch += a.size()!=b.size();
+            for (std::size_t i = 0; i<std::min(a.size(), b.size()); ++i) {
+                max_spike_error = std::max(max_spike_error, std::fabs(a[i]-b[i]));
+            }
+        }
+
+        std::cout << std::setprecision(6)
+                  << "cells:                   " << opt.n_cell << "\n"
+                  << "samples:                 " << n_sample << "\n"
+                  << "max voltage error (mV):  " << max_v_error << "\n"
+                  << "rms voltage error (mV):  " << rms_v_error << "\n"
+                  << "spikes (double, mixed):  " << n_spike_ref << ", " << n_spike_mix << "\n"
+                  << "spike count mismatches:  " << count_mismatch << "\n"
+                  << "max spike time error (ms): " << max_spike_error << "\n";
+
+        bool fail = false;
+        if (opt.max_v_error>=0 && max_v_error>opt.max_v_error) {
+            std::cout << "FAIL: voltage error exceeds " << opt.max_v_error << " mV\n";
+            fail = true;
+        }
+        if (opt.max_spike_error>=0 && (count_mismatch || max_spike_error>opt.max_spike_error)) {
+            std::cout << "FAIL: spike times differ by more than " << opt.max_spike_error << " ms\n";
+            fail = true;
+        }
+        return fail? 1: 0;
+    }
+    catch (std::exception& e) {
+        std::cerr << "caught exception: " << e.what() << "\n";
+        return 2;
+    }
+}
+
+options parse_options(int argc, char** argv) {
+    using namespace to;
+    options opt;
+
+    char** arg = argv+1;
+    while (*arg) {
+        if (auto n = parse<unsigned>(arg, 'n', "cells")) {
+            opt.n_cell = n.value();
+        }
+        else if (auto t_end = parse<double>(arg, 't', "t-end")) {
+            opt.t_end = t_end.value();
+        }
+        else if (auto dt = parse<double>(arg, 'd', "dt")) {
+            opt.dt = dt.value();
+        }
+        else if (auto sample_dt = parse<double>(arg, 's', "sample-dt")) {
+            opt.sample_dt = sample_dt.value();
+        }
+        else if (auto threads = parse<unsigned>(arg, 'T', "threads")) {
+            opt.n_thread = threads.value();
+        }
+        else if (auto tol = parse<double>(arg, 'V', "max-voltage-error")) {
+            opt.max_v_error = tol.value();
+        }
+        else if (auto tol = parse<double>(arg, 'S', "max-spike-error")) {
+            opt.max_spike_error = tol.value();
+        }
+        else {
+            usage(argv[0], "[-n|--cells N] [-t|--t-end TIME] [-d|--dt TIME] [-s|--sample-dt TIME] [-T|--threads N] "
+                           "[-V|--max-voltage-error MV] [-S|--max-spike-error MS]");
+            std::exit(1);
+        }
+    }
+    return opt;
+}